@@ -29,8 +29,10 @@ Anemometer code contributed by Joao Bento.
 #include "indiweather.h"
 #include "connectionplugins/connectionserial.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <regex>
 
@@ -48,6 +50,11 @@ CloudWatcherController::CloudWatcherController(bool verbose) : verbose(verbose)
 {
 }
 
+CloudWatcherController::~CloudWatcherController()
+{
+    stopSampling();
+}
+
 const char *CloudWatcherController::getDeviceName()
 {
     return "AAG Cloud Watcher NG";
@@ -65,6 +72,8 @@ void CloudWatcherController::setAnemometerType(enum ANEMOMETER_TYPE type)
 
 bool CloudWatcherController::checkCloudWatcher()
 {
+    std::lock_guard<std::mutex> lock(commsMutex);
+
     sendCloudwatcherCommand("A!");
 
     char inputBuffer[BLOCK_SIZE * 2] = {0};
@@ -84,6 +93,13 @@ bool CloudWatcherController::checkCloudWatcher()
 }
 
 bool CloudWatcherController::getSwitchStatus(int *switchStatus)
+{
+    std::lock_guard<std::mutex> lock(commsMutex);
+
+    return readSwitchStatus(switchStatus);
+}
+
+bool CloudWatcherController::readSwitchStatus(int *switchStatus)
 {
     sendCloudwatcherCommand("F!");
 
@@ -114,118 +130,224 @@ bool CloudWatcherController::getSwitchStatus(int *switchStatus)
 
 bool CloudWatcherController::getAllData(CloudWatcherData *cwd)
 {
-    int skyTemperature[NUMBER_OF_READS] = {0};
-    int sensorTemperature[NUMBER_OF_READS] = {0};
-    int rainFrequency[NUMBER_OF_READS] = {0};
-    int internalSupplyVoltage[NUMBER_OF_READS] = {0};
-    int ambientTemperature[NUMBER_OF_READS] = {0};
-    int ldrValue[NUMBER_OF_READS] = {0};
-    int ldrFreqValue[NUMBER_OF_READS] = {0};
-    int rainSensorTemperature[NUMBER_OF_READS] = {0};
-    int windSpeed[NUMBER_OF_READS] = {0};
-    int humidity[NUMBER_OF_READS] = {0};
-    int pressure[NUMBER_OF_READS] = {0};
+    totalReadings++;
 
-    auto check = false;
+    if (samplerThread.joinable())
+    {
+        // The first aggregate may still be on its way right after startSampling()
+        std::unique_lock<std::mutex> lock(dataMutex);
+        dataCondition.wait_for(lock, std::chrono::seconds(READ_TIMEOUT), [this]
+        {
+            return latestValid;
+        });
 
-    totalReadings++;
+        if (!latestValid)
+            return false;
+
+        *cwd = latestData;
+        cwd->totalReadings = totalReadings;
+        return true;
+    }
 
-    timeval begin;
-    gettimeofday(&begin, nullptr);
+    clearSamples();
 
     for (int i = 0; i < NUMBER_OF_READS; i++)
     {
-        check = getIRSkyTemperature(skyTemperature[i]);
-
-        if (!check)
-        {
-            LOG_ERROR( "ERROR in getIRSkyTemperature" );
+        if (!sampleCycle(cwd))
             return false;
-        }
+    }
 
-        check = getIRSensorTemperature(sensorTemperature[i]);
+    cwd->totalReadings = totalReadings;
+    return true;
+}
 
-        if (!check)
+void CloudWatcherController::startSampling()
+{
+    stopSampling();
+
+    clearSamples();
+
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        latestValid = false;
+        samplerQuit = false;
+    }
+
+    samplerThread = std::thread(&CloudWatcherController::samplerLoop, this);
+}
+
+void CloudWatcherController::stopSampling()
+{
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+        samplerQuit = true;
+        latestValid = false;
+    }
+    dataCondition.notify_all();
+
+    if (samplerThread.joinable())
+        samplerThread.join();
+}
+
+void CloudWatcherController::samplerLoop()
+{
+    CloudWatcherData cwd {};
+
+    while (true)
+    {
+        bool check = sampleCycle(&cwd);
+
+        std::unique_lock<std::mutex> lock(dataMutex);
+        if (check)
         {
-            LOG_ERROR( "ERROR in getIRSensorTemperature" );
-            return false;
+            latestData = cwd;
+            latestValid = true;
         }
-
-        check = getRainFrequency(rainFrequency[i]);
-        if (!check)
+        else
         {
-            LOG_ERROR( "ERROR in getIRSensorTemperature" );
-            return false;
+            // Do not report a window that mixes samples from before and after the failure
+            latestValid = false;
+            clearSamples();
         }
+        dataCondition.notify_all();
 
-        check = getValues(&internalSupplyVoltage[i], &ambientTemperature[i], &ldrValue[i], &ldrFreqValue[i],
-                          &rainSensorTemperature[i]);
-
+        int pauseMs = SAMPLE_PAUSE_MS;
         if (!check)
+            pauseMs = SAMPLE_RETRY_MS;
+
+        dataCondition.wait_for(lock, std::chrono::milliseconds(pauseMs), [this]
         {
-            LOG_ERROR( "ERROR in getValues" );
-            return false;
-        }
+            return samplerQuit;
+        });
 
-        check = getWindSpeed(windSpeed[i]);
+        if (samplerQuit)
+            break;
+    }
+}
 
-        if (!check)
-        {
-            LOG_ERROR( "ERROR in getWindSpeed" );
-            return false;
-        }
+void CloudWatcherController::clearSamples()
+{
+    for (auto &oneSensor : statistics)
+        oneSensor.clear();
 
-        if (m_FirmwareVersion >= 5.6)
-        {
-            check = getHumidity(humidity[i]);
+    cycleHead = 0;
+}
 
-            if (!check)
-            {
-                LOG_ERROR( "ERROR in getHumidity" );
-                return false;
-            }
-        }
+bool CloudWatcherController::sampleCycle(CloudWatcherData *cwd)
+{
+    int sample[SAMPLE_COUNT] = {0};
 
-        if (m_FirmwareVersion >= 5.8)
-        {
+    auto check = false;
 
-            check = getPressure(pressure[i]);
+    auto cycleStart = std::chrono::steady_clock::now();
 
-            if (!check)
-            {
-                LOG_ERROR( "ERROR in getPressure" );
-                return false;
-            }
+    // Each query takes the port on its own, so switch and heater commands only wait for one exchange
+    auto locked = [this](const std::function<bool()> &query)
+    {
+        std::lock_guard<std::mutex> lock(commsMutex);
+        return query();
+    };
+
+    check = locked([&] { return getIRSkyTemperature(sample[SAMPLE_SKY]); });
+
+    if (!check)
+    {
+        LOG_ERROR( "ERROR in getIRSkyTemperature" );
+        return false;
+    }
+
+    check = locked([&] { return getIRSensorTemperature(sample[SAMPLE_SENSOR]); });
+
+    if (!check)
+    {
+        LOG_ERROR( "ERROR in getIRSensorTemperature" );
+        return false;
+    }
+
+    check = locked([&] { return getRainFrequency(sample[SAMPLE_RAIN]); });
+    if (!check)
+    {
+        LOG_ERROR( "ERROR in getRainFrequency" );
+        return false;
+    }
+
+    check = locked([&]
+    {
+        return getValues(&sample[SAMPLE_SUPPLY], &sample[SAMPLE_AMBIENT], &sample[SAMPLE_LDR], &sample[SAMPLE_LDR_FREQ],
+                         &sample[SAMPLE_RAIN_TEMPERATURE]);
+    });
+
+    if (!check)
+    {
+        LOG_ERROR( "ERROR in getValues" );
+        return false;
+    }
+
+    check = locked([&] { return getWindSpeed(sample[SAMPLE_WIND_SPEED]); });
+
+    if (!check)
+    {
+        LOG_ERROR( "ERROR in getWindSpeed" );
+        return false;
+    }
+
+    if (m_FirmwareVersion >= 5.6)
+    {
+        check = locked([&] { return getHumidity(sample[SAMPLE_HUMIDITY]); });
+
+        if (!check)
+        {
+            LOG_ERROR( "ERROR in getHumidity" );
+            return false;
         }
     }
 
-    timeval end;
-    gettimeofday(&end, nullptr);
+    if (m_FirmwareVersion >= 5.8)
+    {
 
-    float rc = float(end.tv_sec - begin.tv_sec) + float(end.tv_usec - begin.tv_usec) / 1000000.0;
+        check = locked([&] { return getPressure(sample[SAMPLE_PRESSURE]); });
 
-    cwd->readCycle = rc;
+        if (!check)
+        {
+            LOG_ERROR( "ERROR in getPressure" );
+            return false;
+        }
+    }
 
-    cwd->sky             = aggregateInts(skyTemperature, NUMBER_OF_READS);
-    cwd->sensor          = aggregateInts(sensorTemperature, NUMBER_OF_READS);
-    cwd->rain            = aggregateInts(rainFrequency, NUMBER_OF_READS);
-    cwd->supply          = aggregateInts(internalSupplyVoltage, NUMBER_OF_READS);
-    cwd->ambient         = aggregateInts(ambientTemperature, NUMBER_OF_READS);
-    cwd->ldr             = aggregateInts(ldrValue, NUMBER_OF_READS);
-    cwd->ldrFreq          = aggregateInts(ldrFreqValue, NUMBER_OF_READS);
-    cwd->rainTemperature = aggregateInts(rainSensorTemperature, NUMBER_OF_READS);
-    cwd->windSpeed       = aggregateInts(windSpeed, NUMBER_OF_READS);
+    for (int i = 0; i < SAMPLE_COUNT; i++)
+        statistics[i].push(sample[i]);
+
+    // Read cycle covers the whole window, as the 5 burst readings used to
+    cycleStarts[cycleHead] = cycleStart;
+    cycleHead = (cycleHead + 1) % NUMBER_OF_READS;
+    int windowStart = (statistics[SAMPLE_SKY].count() < NUMBER_OF_READS) ? 0 : cycleHead;
+
+    auto end = std::chrono::steady_clock::now();
+    cwd->readCycle = std::chrono::duration<float>(end - cycleStarts[windowStart]).count();
+
+    cwd->sky             = statistics[SAMPLE_SKY].aggregate();
+    cwd->skyMedian       = int(statistics[SAMPLE_SKY].median());
+    cwd->sensor          = statistics[SAMPLE_SENSOR].aggregate();
+    cwd->rain            = statistics[SAMPLE_RAIN].aggregate();
+    cwd->supply          = statistics[SAMPLE_SUPPLY].aggregate();
+    cwd->ambient         = statistics[SAMPLE_AMBIENT].aggregate();
+    cwd->ldr             = statistics[SAMPLE_LDR].aggregate();
+    cwd->ldrFreq         = statistics[SAMPLE_LDR_FREQ].aggregate();
+    cwd->rainTemperature = statistics[SAMPLE_RAIN_TEMPERATURE].aggregate();
+    cwd->windSpeed       = statistics[SAMPLE_WIND_SPEED].aggregate();
     if (m_FirmwareVersion >= 5.6)
-        cwd->humidity        = aggregateInts(humidity, NUMBER_OF_READS);
+        cwd->humidity        = statistics[SAMPLE_HUMIDITY].aggregate();
     else
         cwd->humidity = -1;
     if (m_FirmwareVersion >= 5.8)
-        cwd->pressure        = aggregateInts(pressure, NUMBER_OF_READS);
+        cwd->pressure        = statistics[SAMPLE_PRESSURE].aggregate();
     else
         cwd->pressure = -1;
-    cwd->totalReadings   = totalReadings;
 
-    check = getIRErrors(&cwd->firstByteErrors, &cwd->commandByteErrors, &cwd->secondByteErrors, &cwd->pecByteErrors);
+    check = locked([&]
+    {
+        return getIRErrors(&cwd->firstByteErrors, &cwd->commandByteErrors, &cwd->secondByteErrors, &cwd->pecByteErrors);
+    });
 
     if (!check)
     {
@@ -235,7 +357,7 @@ bool CloudWatcherController::getAllData(CloudWatcherData *cwd)
 
     cwd->internalErrors = cwd->firstByteErrors + cwd->commandByteErrors + cwd->secondByteErrors + cwd->pecByteErrors;
 
-    check = getPWMDutyCycle(cwd->rainHeater);
+    check = locked([&] { return getPWMDutyCycle(cwd->rainHeater); });
 
     if (!check)
     {
@@ -243,7 +365,7 @@ bool CloudWatcherController::getAllData(CloudWatcherData *cwd)
         return false;
     }
 
-    check = getSwitchStatus(&cwd->switchStatus);
+    check = locked([&] { return readSwitchStatus(&cwd->switchStatus); });
 
     if (!check)
     {
@@ -256,6 +378,8 @@ bool CloudWatcherController::getAllData(CloudWatcherData *cwd)
 
 bool CloudWatcherController::getConstants(CloudWatcherConstants *cwc)
 {
+    std::lock_guard<std::mutex> lock(commsMutex);
+
     bool r = getFirmwareVersion(m_FirmwareVersion);
 
     if (!r)
@@ -299,6 +423,8 @@ bool CloudWatcherController::getConstants(CloudWatcherConstants *cwc)
 
 bool CloudWatcherController::closeSwitch()
 {
+    std::lock_guard<std::mutex> lock(commsMutex);
+
     sendCloudwatcherCommand("G!");
 
     char inputBuffer[BLOCK_SIZE * 2] = {0};
@@ -320,6 +446,8 @@ bool CloudWatcherController::closeSwitch()
 
 bool CloudWatcherController::openSwitch()
 {
+    std::lock_guard<std::mutex> lock(commsMutex);
+
     sendCloudwatcherCommand("H!");
 
     char inputBuffer[BLOCK_SIZE * 2] = {0};
@@ -369,6 +497,8 @@ bool CloudWatcherController::setPWMDutyCycle(int pwmDutyCycle)
 
     message[4] = newPWM + '0';
 
+    std::lock_guard<std::mutex> lock(commsMutex);
+
     sendCloudwatcherCommand(message, 6);
 
     char inputBuffer[BLOCK_SIZE * 2] = {0};
@@ -787,64 +917,6 @@ bool CloudWatcherController::getIRErrors(int *firstAddressByteErrors, int *comma
     return true;
 }
 
-float CloudWatcherController::aggregateFloats(float values[], int numberOfValues)
-{
-    float average = 0.0;
-
-    for (int i = 0; i < numberOfValues; i++)
-    {
-        //    printMessage("%f\n", values[i]);
-
-        average += values[i];
-    }
-
-    average /= numberOfValues;
-
-    float stdD = 0.0;
-
-    for (int i = 0; i < numberOfValues; i++)
-    {
-        stdD += (values[i] - average) * (values[i] - average);
-    }
-
-    stdD /= numberOfValues;
-
-    stdD = sqrt(stdD);
-
-    //  printMessage("Average: %f, stdD: %f\n", average, stdD);
-
-    float newAverage  = 0.0;
-    int numberOfItems = 0;
-
-    for (int i = 0; i < numberOfValues; i++)
-    {
-        if (fabs(values[i] - average) <= stdD)
-        {
-            //      printMessage("%f\n", fabs(values[i] - average));
-            newAverage += values[i];
-            numberOfItems++;
-        }
-    }
-
-    newAverage /= numberOfItems;
-
-    printMessage("New average: %f\n", newAverage);
-
-    return newAverage;
-}
-
-int CloudWatcherController::aggregateInts(int values[], int numberOfValues)
-{
-    float newValues[numberOfValues];
-
-    for (int i = 0; i < numberOfValues; i++)
-    {
-        newValues[i] = (float)values[i];
-    }
-
-    return (int)aggregateFloats(newValues, numberOfValues);
-}
-
 void CloudWatcherController::trimString(char *str)
 {
     char *write_ptr = str;
@@ -971,4 +1043,87 @@ bool CloudWatcherController::matchBlock(const std::string &response, const std::
     }
 
     return false;
-}
\ No newline at end of file
+}
+
+/******************************************************************/
+/* ROLLING STATISTICS                                             */
+/******************************************************************/
+void RollingSensorStatistics::push(int value)
+{
+    if (samples == WINDOW)
+    {
+        int oldest = ring[head];
+        sum        -= oldest;
+        sumSquares -= int64_t(oldest) * oldest;
+
+        int *leaving = std::lower_bound(sorted, sorted + samples, oldest);
+        std::copy(leaving + 1, sorted + samples, leaving);
+        samples--;
+    }
+
+    int *entering = std::upper_bound(sorted, sorted + samples, value);
+    std::copy_backward(entering, sorted + samples, sorted + samples + 1);
+    *entering = value;
+    samples++;
+
+    ring[head] = value;
+    sum        += value;
+    sumSquares += int64_t(value) * value;
+    head = (head + 1) % WINDOW;
+}
+
+void RollingSensorStatistics::clear()
+{
+    head       = 0;
+    samples    = 0;
+    sum        = 0;
+    sumSquares = 0;
+}
+
+double RollingSensorStatistics::mean() const
+{
+    return samples > 0 ? double(sum) / samples : 0;
+}
+
+double RollingSensorStatistics::stddev() const
+{
+    if (samples == 0)
+        return 0;
+
+    // n * sum(x^2) - sum(x)^2 is exact in integers, so no cancellation error
+    int64_t scaledVariance = int64_t(samples) * sumSquares - sum * sum;
+    return sqrt(double(scaledVariance)) / samples;
+}
+
+double RollingSensorStatistics::median() const
+{
+    if (samples == 0)
+        return 0;
+
+    if (samples % 2)
+        return sorted[samples / 2];
+    return (double(sorted[samples / 2 - 1]) + sorted[samples / 2]) / 2;
+}
+
+int RollingSensorStatistics::aggregate() const
+{
+    double average = mean();
+    double stdD    = stddev();
+
+    double newAverage = 0.0;
+    int numberOfItems = 0;
+
+    for (int i = 0; i < samples; i++)
+    {
+        if (fabs(ring[i] - average) <= stdD)
+        {
+            newAverage += ring[i];
+            numberOfItems++;
+        }
+    }
+
+    if (numberOfItems == 0)
+        return int(average);
+
+    return int(newAverage / numberOfItems);
+}
@@ -24,7 +24,12 @@ Anemometer code contributed by Joao Bento.
 
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <thread>
 
 /**
  *  A struct to group and send all AAG Cloud Watcher constants
@@ -72,6 +77,7 @@ struct CloudWatcherData
     int rainTemperature; ///< Rain sensor temperature (used as ambient temperature in models where there is no ambient temperature sensor)
     int ldr;               ///< Ambient light sensor
     int ldrFreq;            ///< Ambient light sensor in K
+    int skyMedian;         ///< Median of the IR Sky Temperature readings
     float readCycle;       ///< Time used in the readings
     int totalReadings;     ///< Total number of readings taken by the Cloud Watcher Controller
     int internalErrors;    ///< Total number of internal errors
@@ -85,6 +91,70 @@ struct CloudWatcherData
     int pressure;          ///< atmospheric pressure
 };
 
+/**
+ * Rolling statistics over the last WINDOW samples of one sensor. Sum and sum
+ * of squares are updated as samples enter and leave the ring, so mean and
+ * standard deviation cost O(1) per sample. A sorted copy of the window is
+ * kept next to the ring, the leaving and entering samples are located by
+ * binary search, so the median costs O(log WINDOW) comparisons per sample.
+ */
+
+class RollingSensorStatistics
+{
+    public:
+        const static int WINDOW = 5;
+
+        /**
+        * Adds a sample, dropping the oldest one once the window is full.
+        * @param value the new sample
+        */
+        void push(int value);
+
+        /**
+        * Empties the window.
+        */
+        void clear();
+
+        /**
+        * @return the number of samples in the window (at most WINDOW)
+        */
+        int count() const
+        {
+            return samples;
+        }
+
+        /**
+        * @return the mean of the samples in the window
+        */
+        double mean() const;
+
+        /**
+        * @return the population standard deviation of the samples in the window
+        */
+        double stddev() const;
+
+        /**
+        * @return the median of the samples in the window, the mean of the two
+        * middle samples while the window holds an even number of them
+        */
+        double median() const;
+
+        /**
+        * Averages only the samples within [mean - stddev, mean + stddev], which is
+        * the aggregation the AAG documentation describes for its 5 readings.
+        * @return the aggregated value
+        */
+        int aggregate() const;
+
+    private:
+        int ring[WINDOW] = {0};
+        int sorted[WINDOW] = {0};
+        int head = 0;
+        int samples = 0;
+        int64_t sum = 0;
+        int64_t sumSquares = 0;
+};
+
 /**
  * A class  to communicate with the AAG Cloud Watcher. It is responsible to
  * send and recieve all the commands specified in the AAG Cloud Watcher
@@ -107,9 +177,9 @@ class CloudWatcherController
         CloudWatcherController(bool verbose);
 
         /**
-        * A destructor
+        * A destructor. Stops the sampling thread if running.
         */
-        virtual ~CloudWatcherController() = default;
+        virtual ~CloudWatcherController();
 
         const char *getDeviceName();
 
@@ -143,13 +213,27 @@ class CloudWatcherController
 
         /**
         * Gets all raw dynamic data from the AAG Cloud Watcher. It follows the
-        * procedure described in the AAG Documents (5 readings for some values). This
-        * function takes more than 2 seconds and less than 3 to complete.
+        * procedure described in the AAG Documents (5 readings for some values).
+        * While sampling is running this returns the latest rolling aggregate without
+        * touching the serial port. Otherwise it reads the 5 samples in place, which
+        * takes more than 2 seconds and less than 3 to complete.
         * @param cwd where the dynamic data of the AAG Cloud Watcher will be stored.
         * @return true if the data has been correctly gathered. false otherwise.
         */
         bool getAllData(CloudWatcherData * cwd);
 
+        /**
+        * Starts a thread that samples the sensors continuously and keeps the rolling
+        * aggregate used by getAllData(). getConstants() must have been called first
+        * so the firmware dependent sensors are known.
+        */
+        void startSampling();
+
+        /**
+        * Stops the sampling thread. Must be called before the port is closed.
+        */
+        void stopSampling();
+
         /**
         * Gets all constants from the AAG Cloud Watcher. Some of the constants are
         * retrieved from the device (from firmware version >3.0)
@@ -210,7 +294,17 @@ class CloudWatcherController
         /**
         * Number of reads to aggregate for the cloudwatcher data
         */
-        const static int NUMBER_OF_READS = 5;
+        const static int NUMBER_OF_READS = RollingSensorStatistics::WINDOW;
+
+        /**
+        * Pause between sampling cycles, leaves the port free for driver commands
+        */
+        const static int SAMPLE_PAUSE_MS = 100;
+
+        /**
+        * Pause before retrying after a failed sampling cycle
+        */
+        const static int SAMPLE_RETRY_MS = 1000;
 
         /**
         * Hard coded constant. May be changed with internal device constants.
@@ -280,6 +374,77 @@ class CloudWatcherController
         };
         int sqmSensorStatus = SQM_UNKNOWN;
 
+        /**
+        * The sensors read on every sampling cycle
+        */
+        enum
+        {
+            SAMPLE_SKY,
+            SAMPLE_SENSOR,
+            SAMPLE_RAIN,
+            SAMPLE_SUPPLY,
+            SAMPLE_AMBIENT,
+            SAMPLE_LDR,
+            SAMPLE_LDR_FREQ,
+            SAMPLE_RAIN_TEMPERATURE,
+            SAMPLE_WIND_SPEED,
+            SAMPLE_HUMIDITY,
+            SAMPLE_PRESSURE,
+            SAMPLE_COUNT
+        };
+
+        /**
+        * Rolling statistics of each sensor, indexed by the SAMPLE_ enum
+        */
+        RollingSensorStatistics statistics[SAMPLE_COUNT];
+
+        /**
+        * Start times of the sampling cycles in the window, oldest at cycleHead
+        */
+        std::chrono::steady_clock::time_point cycleStarts[NUMBER_OF_READS];
+        int cycleHead = 0;
+
+        /**
+        * Serializes command/answer exchanges between the sampling thread and callers,
+        * held for one exchange at a time
+        */
+        std::mutex commsMutex;
+
+        /**
+        * Guards latestData and latestValid
+        */
+        std::mutex dataMutex;
+        std::condition_variable dataCondition;
+        CloudWatcherData latestData {};
+        bool latestValid = false;
+
+        std::thread samplerThread;
+        bool samplerQuit = false;
+
+        /**
+        * Body of the sampling thread
+        */
+        void samplerLoop();
+
+        /**
+        * Empties the rolling statistics and the cycle start ring
+        */
+        void clearSamples();
+
+        /**
+        * Reads one sample of every sensor into the rolling statistics, then the error
+        * counters, heater PWM and switch status. Takes commsMutex for each query.
+        * @param cwd where the aggregate over the window will be stored
+        * @return true if succesfully read. false otherwise.
+        */
+        bool sampleCycle(CloudWatcherData *cwd);
+
+        /**
+        * Reads the switch status without taking commsMutex
+        * @see getSwitchStatus()
+        */
+        bool readSwitchStatus(int *switchStatus);
+
 
         /**
         * Print a buffer of chars. Just for debugging
@@ -348,26 +513,6 @@ class CloudWatcherController
         */
         bool getSerialNumber(int &serialNumber);
 
-        /**
-        * Performs an aggregation of the values stored in a float array. It computes
-        * average and standard deviation of the array and averages only the values
-        * within [average - deviation, average + deviation]
-        * @param values the values to be aggregated
-        * @param numberOfValues the size of values
-        * @return the aggregated value
-        */
-        float aggregateFloats(float values[], int numberOfValues);
-
-        /**
-        * Performs an aggregation of the values stored in a int array. It computes
-        * average and standard deviation of the array and averages only the values
-        * within [average - deviation, average + deviation]
-        * @param values the values to be aggregated
-        * @param numberOfValues the size of values
-        * @return the aggregated value
-        */
-        int aggregateInts(int values[], int numberOfValues);
-
         /**
         * Reads the current IR Sky Temperature value of the AAG Cloud Watcher
         * @param temp where the sensor value will be stored
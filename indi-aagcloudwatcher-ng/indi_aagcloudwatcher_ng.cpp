@@ -69,6 +69,9 @@ bool AAGCloudWatcher::Handshake()
         LOG_INFO("Connected to AAG Cloud Watcher");
         sendConstants();
 
+        // Sample continuously so updateWeather() only publishes the rolling aggregate
+        cwc->startSampling();
+
         if (m_FirmwareVersion >= 5.6)
         {
             // add humidity parameter, if not already present
@@ -88,6 +91,13 @@ bool AAGCloudWatcher::Handshake()
     }
 }
 
+bool AAGCloudWatcher::Disconnect()
+{
+    // The sampling thread reads the port, stop it before the port is closed
+    cwc->stopSampling();
+
+    return INDI::Weather::Disconnect();
+}
 
 /**********************************************************************
 ** Initialize all properties & set default values.
@@ -607,6 +617,7 @@ bool AAGCloudWatcher::sendData()
     nvp[RAW_SENSOR_RELATIVE_HUMIDITY].setValue(data.humidity);
     nvp[RAW_SENSOR_PRESSURE].setValue(data.pressure);
     nvp[RAW_SENSOR_TOTAL_READINGS].setValue(data.totalReadings);
+    nvp[RAW_SENSOR_SKY_MEDIAN].setValue(data.skyMedian);
     nvp.setState(IPS_OK);
     nvp.apply();
 
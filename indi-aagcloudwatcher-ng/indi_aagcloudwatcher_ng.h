@@ -53,6 +53,7 @@ class AAGCloudWatcher : public INDI::Weather
 
     protected:
         virtual bool Handshake() override;
+        virtual bool Disconnect() override;
         virtual IPState updateWeather() override;
 
     private:
@@ -93,7 +94,8 @@ class AAGCloudWatcher : public INDI::Weather
             RAW_SENSOR_WIND_SPEED,
             RAW_SENSOR_RELATIVE_HUMIDITY,
             RAW_SENSOR_PRESSURE,
-            RAW_SENSOR_TOTAL_READINGS
+            RAW_SENSOR_TOTAL_READINGS,
+            RAW_SENSOR_SKY_MEDIAN
         };
 
         enum
@@ -92,6 +92,7 @@ int main(int /*argc*/, char ** /*argv*/)
     if (check)
     {
         std::cout << "Sky: " << cwd.sky << "\n";
+        std::cout << "Sky Median: " << cwd.skyMedian << "\n";
         std::cout << "Sensor: " << cwd.sensor << "\n";
         std::cout << "Rain: " << cwd.rain << "\n";
         std::cout << "Supply: " << cwd.supply << "\n";
@@ -0,0 +1,381 @@
+/**
+This file is part of the AAG Cloud Watcher INDI Driver.
+
+Tests of the rolling sensor statistics, and of the controller against a
+simulated Cloud Watcher on a pseudo terminal.
+*/
+
+#include "CloudWatcherController_ng.h"
+
+#include <gtest/gtest.h>
+
+#include <pty.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The aggregation the driver used before the rolling statistics
+static float aggregateFloats(float values[], int numberOfValues)
+{
+    float average = 0.0;
+    for (int i = 0; i < numberOfValues; i++)
+        average += values[i];
+    average /= numberOfValues;
+
+    float stdD = 0.0;
+    for (int i = 0; i < numberOfValues; i++)
+        stdD += (values[i] - average) * (values[i] - average);
+    stdD /= numberOfValues;
+    stdD = sqrt(stdD);
+
+    float newAverage  = 0.0;
+    int numberOfItems = 0;
+    for (int i = 0; i < numberOfValues; i++)
+    {
+        if (fabs(values[i] - average) <= stdD)
+        {
+            newAverage += values[i];
+            numberOfItems++;
+        }
+    }
+
+    newAverage /= numberOfItems;
+    return newAverage;
+}
+
+static int aggregateWindow(const std::deque<int> &window, size_t begin, size_t end)
+{
+    float values[RollingSensorStatistics::WINDOW];
+    int n = end - begin;
+    for (int i = 0; i < n; i++)
+        values[i] = window[begin + i];
+    return (int)aggregateFloats(values, n);
+}
+
+// Median by sorting a copy of the window
+static double sortedMedian(const std::deque<int> &window, size_t begin, size_t end)
+{
+    std::vector<int> values(window.begin() + begin, window.begin() + end);
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : (double(values[n / 2 - 1]) + values[n / 2]) / 2;
+}
+
+TEST(RollingSensorStatistics, Window)
+{
+    RollingSensorStatistics rs;
+    ASSERT_EQ(rs.count(), 0);
+    ASSERT_EQ(rs.mean(), 0);
+    ASSERT_EQ(rs.stddev(), 0);
+
+    for (int v : {1, 2, 3, 4, 5})
+        rs.push(v);
+    ASSERT_EQ(rs.count(), 5);
+    ASSERT_DOUBLE_EQ(rs.mean(), 3);
+    ASSERT_DOUBLE_EQ(rs.stddev(), sqrt(2.0));
+    ASSERT_EQ(rs.aggregate(), 3);
+    ASSERT_DOUBLE_EQ(rs.median(), 3);
+
+    // The oldest sample leaves the window
+    rs.push(100);
+    ASSERT_EQ(rs.count(), 5);
+    ASSERT_DOUBLE_EQ(rs.mean(), (2 + 3 + 4 + 5 + 100) / 5.0);
+    ASSERT_EQ(rs.aggregate(), 3);
+    ASSERT_DOUBLE_EQ(rs.median(), 4);
+
+    rs.clear();
+    ASSERT_EQ(rs.count(), 0);
+    ASSERT_EQ(rs.median(), 0);
+    rs.push(-7);
+    ASSERT_EQ(rs.aggregate(), -7);
+    ASSERT_DOUBLE_EQ(rs.median(), -7);
+    rs.push(-4);
+    ASSERT_DOUBLE_EQ(rs.median(), -5.5);
+}
+
+TEST(RollingSensorStatistics, MatchesOldAggregation)
+{
+    srand(1);
+    RollingSensorStatistics rs;
+    std::deque<int> window;
+
+    for (int i = 0; i < 200000; i++)
+    {
+        // Raw sensor values as the device reports them, including large frequencies
+        int v = (i % 3 == 0) ? rand() % 20001 - 10000 : rand() % 200000;
+        rs.push(v);
+        window.push_back(v);
+        if (window.size() > RollingSensorStatistics::WINDOW)
+            window.pop_front();
+
+        ASSERT_EQ(rs.aggregate(), aggregateWindow(window, 0, window.size())) << "sample " << i;
+    }
+}
+
+TEST(RollingSensorStatistics, MedianMatchesSortedWindow)
+{
+    srand(2);
+    RollingSensorStatistics rs;
+    std::deque<int> window;
+
+    for (int i = 0; i < 200000; i++)
+    {
+        // A narrow range gives plenty of duplicates, a clear now and then refills the window
+        if (i % 1000 == 999)
+        {
+            rs.clear();
+            window.clear();
+        }
+        int v = (i % 2 == 0) ? rand() % 7 - 3 : rand() % 200000 - 100000;
+        rs.push(v);
+        window.push_back(v);
+        if (window.size() > RollingSensorStatistics::WINDOW)
+            window.pop_front();
+
+        ASSERT_DOUBLE_EQ(rs.median(), sortedMedian(window, 0, window.size())) << "sample " << i;
+    }
+}
+
+/*
+ * Cloud Watcher simulator on the master side of a pty. Every answer takes
+ * REPLY_DELAY_MS and the sky temperature changes on every read, with outliers.
+ */
+class CloudWatcherSimulator
+{
+    public:
+        static const int REPLY_DELAY_MS = 20;
+
+        CloudWatcherSimulator()
+        {
+            termios t;
+            cfmakeraw(&t);
+            EXPECT_EQ(openpty(&master, &slave, nullptr, &t, nullptr), 0);
+            thread = std::thread(&CloudWatcherSimulator::run, this);
+        }
+
+        ~CloudWatcherSimulator()
+        {
+            quit = true;
+            thread.join();
+            close(master);
+            close(slave);
+        }
+
+        std::deque<int> skyHistory()
+        {
+            std::lock_guard<std::mutex> lock(historyMutex);
+            return sky;
+        }
+
+        int slave = -1;
+
+    private:
+        static std::string block(const char *prefix, int v)
+        {
+            char b[32];
+            snprintf(b, sizeof b, "%s%*d", prefix, 15 - (int)strlen(prefix), v);
+            return b;
+        }
+
+        bool readByte(char *c)
+        {
+            while (!quit)
+            {
+                pollfd p { master, POLLIN, 0 };
+                if (poll(&p, 1, 50) > 0)
+                    return read(master, c, 1) == 1;
+            }
+            return false;
+        }
+
+        void run()
+        {
+            const std::string handshake = std::string("\x21\x11") + std::string(12, ' ') + "0";
+            char cmd[6];
+
+            while (readByte(&cmd[0]) && readByte(&cmd[1]))
+            {
+                // Only the PWM command carries arguments, "Pxxxx!"
+                if (cmd[0] == 'P')
+                {
+                    for (int i = 2; i < 6; i++)
+                        if (!readByte(&cmd[i]))
+                            return;
+                }
+
+                std::string r;
+                std::this_thread::sleep_for(std::chrono::milliseconds(REPLY_DELAY_MS));
+                switch (cmd[0])
+                {
+                    case 'A':
+                        r = std::string("!N CloudWatcher").substr(0, 15) + handshake;
+                        break;
+                    case 'B':
+                        r = std::string("!V") + std::string(9, ' ') + "3.00" + handshake;
+                        break;
+                    case 'S':
+                    {
+                        int k = skyCounter++;
+                        int v = -2000 + (k * 37) % 101 + ((k % 7 == 0) ? 500 : 0);
+                        {
+                            std::lock_guard<std::mutex> lock(historyMutex);
+                            sky.push_back(v);
+                        }
+                        r = block("!1", v) + handshake;
+                        break;
+                    }
+                    case 'T':
+                        r = block("!2", 1500) + handshake;
+                        break;
+                    case 'E':
+                        r = block("!R", 2800) + handshake;
+                        break;
+                    case 'C':
+                        r = block("!6", 900) + block("!4", 1000) + block("!5", 700) + handshake;
+                        break;
+                    case 'Q':
+                        r = block("!Q", pwm) + handshake;
+                        break;
+                    case 'P':
+                        pwm = atoi(std::string(cmd + 1, 4).c_str());
+                        r = block("!Q", pwm) + handshake;
+                        break;
+                    case 'D':
+                        r = block("!E1", 1) + block("!E2", 2) + block("!E3", 3) + block("!E4", 4) + handshake;
+                        break;
+                    case 'F':
+                        r = std::string(switchClosed ? "!X" : "!Y") + std::string(13, ' ') + handshake;
+                        break;
+                    case 'G':
+                        switchClosed = true;
+                        r = std::string("!X") + std::string(13, ' ') + handshake;
+                        break;
+                    case 'H':
+                        switchClosed = false;
+                        r = std::string("!Y") + std::string(13, ' ') + handshake;
+                        break;
+                    case 'K':
+                        r = block("!K", 42) + handshake;
+                        break;
+                    case 'M':
+                        r = std::string("!M") + std::string(13, '\x01') + handshake;
+                        break;
+                    default:
+                        ADD_FAILURE() << "unknown command " << cmd[0] << cmd[1];
+                        continue;
+                }
+                if (write(master, r.data(), r.size()) != (ssize_t)r.size())
+                    return;
+            }
+        }
+
+        int master = -1;
+        std::thread thread;
+        std::atomic<bool> quit { false };
+        std::mutex historyMutex;
+        std::deque<int> sky;
+        std::atomic<int> skyCounter { 0 };
+        int pwm = 123;
+        bool switchClosed = true;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+TEST(CloudWatcherController, Simulator)
+{
+    CloudWatcherSimulator sim;
+    CloudWatcherController cw(false);
+    cw.setPortFD(sim.slave);
+
+    ASSERT_TRUE(cw.checkCloudWatcher());
+    CloudWatcherConstants constants;
+    ASSERT_TRUE(cw.getConstants(&constants));
+    ASSERT_DOUBLE_EQ(constants.firmwareVersion, 3.0);
+    ASSERT_EQ(constants.internalSerialNumber, 42);
+
+    // Without the sampler getAllData reads a full window in place
+    CloudWatcherData d;
+    ASSERT_TRUE(cw.getAllData(&d));
+    std::deque<int> sky = sim.skyHistory();
+    ASSERT_EQ(d.sky, aggregateWindow(sky, sky.size() - 5, sky.size()));
+    ASSERT_EQ(d.skyMedian, int(sortedMedian(sky, sky.size() - 5, sky.size())));
+    ASSERT_EQ(d.rainHeater, 123);
+    ASSERT_EQ(d.internalErrors, 10);
+    ASSERT_EQ(d.switchStatus, 1);
+
+    size_t startIndex = sky.size();
+    cw.startSampling();
+
+    // The sampled aggregate must be one of the last windows the simulator produced
+    double maxCall = 0;
+    for (int k = 0; k < 10; k++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        auto start = std::chrono::steady_clock::now();
+        ASSERT_TRUE(cw.getAllData(&d));
+        if (k > 0)
+            maxCall = std::max(maxCall, secondsSince(start));
+
+        sky = sim.skyHistory();
+        bool found = false;
+        for (size_t end = sky.size(); end > startIndex && end + 3 > sky.size(); end--)
+            found = found || d.sky == aggregateWindow(sky, std::max(startIndex, end - 5), end);
+        ASSERT_TRUE(found) << "round " << k;
+    }
+    ASSERT_LT(maxCall, 0.01);
+
+    // Commands from the driver wait for at most the query in progress, not a whole sample cycle
+    double maxWait = 0;
+    int switchStatus = -1;
+    for (int k = 0; k < 10; k++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(37));
+        auto start = std::chrono::steady_clock::now();
+        switch (k % 4)
+        {
+            case 0:
+                ASSERT_TRUE(cw.openSwitch());
+                break;
+            case 1:
+                ASSERT_TRUE(cw.getSwitchStatus(&switchStatus));
+                ASSERT_EQ(switchStatus, 0);
+                break;
+            case 2:
+                ASSERT_TRUE(cw.closeSwitch());
+                break;
+            case 3:
+                ASSERT_TRUE(cw.setPWMDutyCycle(500 + k));
+                break;
+        }
+        maxWait = std::max(maxWait, secondsSince(start));
+    }
+    printf("max getAllData %.6f s, max command %.3f s (one exchange %.3f s)\n", maxCall, maxWait,
+           CloudWatcherSimulator::REPLY_DELAY_MS / 1000.0);
+    ASSERT_LT(maxWait, 3.5 * CloudWatcherSimulator::REPLY_DELAY_MS / 1000.0);
+
+    auto start = std::chrono::steady_clock::now();
+    cw.stopSampling();
+    ASSERT_LT(secondsSince(start), 1.0);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
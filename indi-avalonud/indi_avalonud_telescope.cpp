@@ -53,7 +53,7 @@ const int IPport = 5451;
 static char device_str[MAXINDIDEVICE] = "AvalonUD Telescope";
 
 
-static std::unique_ptr<AUDTELESCOPE> telescope(new AUDTELESCOPE());
+std::unique_ptr<AUDTELESCOPE> telescope(new AUDTELESCOPE());
 
 void ISInit()
 {
@@ -113,6 +113,10 @@ AUDTELESCOPE::AUDTELESCOPE() : GI(this)
     setVersion(AVALONUD_VERSION_MAJOR, AVALONUD_VERSION_MINOR);
 
     context = zmq_ctx_new();
+    dealer = NULL;
+    ioRunning = false;
+    ioNextId = 0;
+    statusEnabled = false;
     setTelescopeConnection( CONNECTION_NONE );
     SetTelescopeCapability( TELESCOPE_CAN_GOTO |
                             TELESCOPE_CAN_SYNC |
@@ -237,6 +241,11 @@ bool AUDTELESCOPE::initProperties()
     addConfigurationControl();
 
     pthread_mutex_init( &connectionmutex, NULL );
+    pthread_condattr_t attr;
+    pthread_condattr_init( &attr );
+    pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+    pthread_cond_init( &replycond, &attr );
+    pthread_condattr_destroy( &attr );
 
     return true;
 }
@@ -312,8 +321,6 @@ bool AUDTELESCOPE::updateProperties()
 bool AUDTELESCOPE::Connect()
 {
     char *answer;
-    char addr[1024];
-    int timeout = 500;
 
 
     if (isConnected())
@@ -323,10 +330,12 @@ bool AUDTELESCOPE::Connect()
 
     DEBUGF(INDI::Logger::DBG_SESSION, "Attempting to connect %s telescope...", IPaddress);
 
-    requester = zmq_socket(context, ZMQ_REQ);
-    zmq_setsockopt(requester, ZMQ_RCVTIMEO, &timeout, sizeof(timeout) );
-    snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-    zmq_connect(requester, addr);
+    if ( !startIO() )
+    {
+        DEBUGF(INDI::Logger::DBG_ERROR, "Failed to connect %s telescope", IPaddress);
+        free(IPaddress);
+        return false;
+    }
 
     answer = sendRequest("ASTRO_INFO");
     if ( answer )
@@ -345,7 +354,7 @@ bool AUDTELESCOPE::Connect()
                 !j.contains("highLevelSW") ||
                 !j.contains("highLevelSWVersion") )
         {
-            zmq_close(requester);
+            stopIO();
             DEBUGF(INDI::Logger::DBG_ERROR, "Communication with %s telescope failed", IPaddress);
             free(IPaddress);
             return false;
@@ -373,7 +382,7 @@ bool AUDTELESCOPE::Connect()
     }
     else
     {
-        zmq_close(requester);
+        stopIO();
         DEBUGF(INDI::Logger::DBG_ERROR, "Failed to connect %s telescope", IPaddress);
         free(IPaddress);
         return false;
@@ -388,7 +397,7 @@ bool AUDTELESCOPE::Connect()
     }
     else
     {
-        zmq_close(requester);
+        stopIO();
         DEBUGF(INDI::Logger::DBG_ERROR, "Failed to connect %s telescope", IPaddress);
         free(IPaddress);
         return false;
@@ -410,7 +419,7 @@ bool AUDTELESCOPE::Connect()
     }
     else
     {
-        zmq_close(requester);
+        stopIO();
         DEBUGF(INDI::Logger::DBG_ERROR, "Failed to connect %s telescope", IPaddress);
         free(IPaddress);
         return false;
@@ -428,7 +437,7 @@ bool AUDTELESCOPE::Connect()
                 !j.contains("latitude") ||
                 !j.contains("elevation") )
         {
-            zmq_close(requester);
+            stopIO();
             DEBUGF(INDI::Logger::DBG_ERROR, "Communication with %s telescope failed", IPaddress);
             free(IPaddress);
             return false;
@@ -440,7 +449,7 @@ bool AUDTELESCOPE::Connect()
     }
     else
     {
-        zmq_close(requester);
+        stopIO();
         DEBUGF(INDI::Logger::DBG_ERROR, "Failed to connect %s telescope", IPaddress);
         free(IPaddress);
         return false;
@@ -450,6 +459,15 @@ bool AUDTELESCOPE::Connect()
 
     slewState = IPS_IDLE;
 
+    // from now on the worker keeps a fresh ASTRO_STATUS snapshot for ReadScopeStatus
+    pthread_mutex_lock( &connectionmutex );
+    statusPeriod = getCurrentPollingPeriod();
+    statusFailures = 0;
+    statusWarned = false;
+    statusSeq = statusSeen = 0;
+    statusEnabled = true;
+    pthread_mutex_unlock( &connectionmutex );
+
     tid = SetTimer(getCurrentPollingPeriod());
 
     DEBUGF(INDI::Logger::DBG_SESSION, "Successfully connected %s telescope", IPaddress);
@@ -467,7 +485,7 @@ bool AUDTELESCOPE::Disconnect()
 
     DEBUG(INDI::Logger::DBG_SESSION, "Attempting to disconnect telescope...");
 
-    zmq_close(requester);
+    stopIO();
 
     RemoveTimer( tid );
 
@@ -644,18 +662,38 @@ bool AUDTELESCOPE::updateTime(ln_date *utc, double utc_offset)
 
 bool AUDTELESCOPE::ReadScopeStatus()
 {
-    char *answer;
-    int sts, pierside, exposureready, meridianflip;
+    std::string answer;
+    bool fresh;
+    int failures, sts, pierside, exposureready, meridianflip;
     double utc, lst, jd, ha, ra, dec, az, alt, meridianflipha;
 
 
-    answer = sendRequest("ASTRO_STATUS");
-    if ( answer )
+    // never touch the network here: take the latest status pushed by the worker
+    pthread_mutex_lock( &connectionmutex );
+    fresh = ( statusSeq != statusSeen );
+    if ( fresh )
+    {
+        answer.swap(statusAnswer);
+        statusSeen = statusSeq;
+    }
+    failures = statusFailures;
+    pthread_mutex_unlock( &connectionmutex );
+
+    if ( !fresh )
+    {
+        if ( failures >= 3 && !statusWarned )
+        {
+            DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
+            statusWarned = true;
+        }
+        return ( failures == 0 );
+    }
+    statusWarned = false;
+
     {
         json j;
 
         j = json::parse(answer, nullptr, false);
-        free(answer);
         if ( j.is_discarded() ||
                 !j.contains("UTC") ||
                 !j.contains("JD") ||
@@ -803,8 +841,6 @@ bool AUDTELESCOPE::ReadScopeStatus()
 
         return true;
     }
-
-    return false;
 }
 
 bool AUDTELESCOPE::meridianFlipEnable(int enable)
@@ -1395,6 +1431,10 @@ void AUDTELESCOPE::TimerHit()
     ReadScopeStatus();
     EqNP.apply();
 
+    pthread_mutex_lock( &connectionmutex );
+    statusPeriod = getCurrentPollingPeriod();
+    pthread_mutex_unlock( &connectionmutex );
+
     SetTimer(getCurrentPollingPeriod());
 }
 
@@ -1412,46 +1452,347 @@ const char *AUDTELESCOPE::getDefaultName()
     return device_str;
 }
 
+
+/****************************************************************
+** Command channel
+**
+** The mount server is a REP socket: the driver talks to it through
+** a DEALER owned by a worker thread. Each request travels as
+** [id][empty][body], REP echoes the id frame back unchanged, so
+** replies are matched to their caller and late answers to a timed
+** out request are simply dropped instead of wedging the socket.
+** The worker also polls ASTRO_STATUS on its own, so the INDI loop
+** only reads the last snapshot.
+*****************************************************************/
+#define COMMAND_TIMEOUT 500 // ms
+#define COMMAND_RETRIES 3
+#define RECONNECT_TIMEOUTS 3
+
+static long elapsedMs(const std::chrono::steady_clock::time_point &from, const std::chrono::steady_clock::time_point &to)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count();
+}
+
+bool AUDTELESCOPE::openDealer()
+{
+    char addr[1024];
+    int linger = 0, immediate = 1;
+
+    dealer = zmq_socket(context, ZMQ_DEALER);
+    if ( !dealer )
+        return false;
+    zmq_setsockopt(dealer, ZMQ_LINGER, &linger, sizeof(linger) );
+    // never queue requests toward a peer which is not connected: a stale
+    // slew delivered after a reconnection is worse than a lost one
+    zmq_setsockopt(dealer, ZMQ_IMMEDIATE, &immediate, sizeof(immediate) );
+#ifdef ZMQ_HEARTBEAT_IVL
+    int ivl = 1000, ttl = 3000;
+    zmq_setsockopt(dealer, ZMQ_HEARTBEAT_IVL, &ivl, sizeof(ivl) );
+    zmq_setsockopt(dealer, ZMQ_HEARTBEAT_TIMEOUT, &ttl, sizeof(ttl) );
+#endif
+    snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
+    if ( zmq_connect(dealer, addr) )
+    {
+        zmq_close(dealer);
+        dealer = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool AUDTELESCOPE::startIO()
+{
+    if ( pipe(iopipe) )
+        return false;
+    fcntl( iopipe[0], F_SETFL, O_NONBLOCK );
+    fcntl( iopipe[1], F_SETFL, O_NONBLOCK );
+
+    if ( !openDealer() )
+    {
+        close(iopipe[0]);
+        close(iopipe[1]);
+        return false;
+    }
+
+    statusEnabled = false;
+    statusId = 0;
+    ioTimeouts = 0;
+    ioStop = false;
+    ioRunning = true;
+    if ( pthread_create( &iothread, NULL, ioThreadHelper, this ) )
+    {
+        ioRunning = false;
+        zmq_close(dealer);
+        dealer = NULL;
+        close(iopipe[0]);
+        close(iopipe[1]);
+        return false;
+    }
+    return true;
+}
+
+void AUDTELESCOPE::stopIO()
+{
+    char c = 0;
+
+    if ( !ioRunning )
+        return;
+
+    pthread_mutex_lock( &connectionmutex );
+    ioStop = true;
+    statusEnabled = false;
+    pthread_mutex_unlock( &connectionmutex );
+    if ( write(iopipe[1], &c, 1) < 0 ) {}
+    pthread_join( iothread, NULL );
+
+    pthread_mutex_lock( &connectionmutex );
+    ioRunning = false;
+    ioQueue.clear();
+    pthread_cond_broadcast( &replycond );
+    pthread_mutex_unlock( &connectionmutex );
+
+    if ( dealer )
+        zmq_close(dealer);
+    dealer = NULL;
+    close(iopipe[0]);
+    close(iopipe[1]);
+}
+
+void *AUDTELESCOPE::ioThreadHelper(void *context)
+{
+    static_cast<AUDTELESCOPE *>(context)->ioThread();
+    return NULL;
+}
+
+// Reads one [id][empty][body] message from the DEALER and hands it to its owner
+void AUDTELESCOPE::dispatchReply()
+{
+    zmq_msg_t part;
+    uint32_t id = 0;
+    int index = 0, more;
+    std::string body;
+
+    do
+    {
+        zmq_msg_init(&part);
+        if ( zmq_msg_recv(&part, dealer, ZMQ_DONTWAIT) < 0 )
+        {
+            zmq_msg_close(&part);
+            return;
+        }
+        if ( index == 0 && zmq_msg_size(&part) == sizeof(id) )
+            memcpy( &id, zmq_msg_data(&part), sizeof(id) );
+        else if ( index == 2 )
+            body.assign( (const char *)zmq_msg_data(&part), zmq_msg_size(&part) );
+        more = zmq_msg_more(&part);
+        zmq_msg_close(&part);
+        index++;
+    }
+    while ( more );
+
+    if ( index != 3 || id == 0 )
+        return;
+
+    pthread_mutex_lock( &connectionmutex );
+    ioTimeouts = 0;
+    if ( id == statusId )
+    {
+        statusId = 0;
+        statusAnswer.swap(body);
+        statusSeq++;
+        statusFailures = 0;
+    }
+    else
+    {
+        auto it = ioPending.find(id);
+        if ( it != ioPending.end() )
+        {
+            it->second->answer.swap(body);
+            it->second->done = true;
+            pthread_cond_broadcast( &replycond );
+        }
+    }
+    pthread_mutex_unlock( &connectionmutex );
+}
+
+void AUDTELESCOPE::ioThread()
+{
+    std::chrono::steady_clock::time_point now, statusSent, statusNext;
+    zmq_pollitem_t items[2];
+    char drain[64];
+    bool blocked = false;
+    long wait;
+
+    statusNext = std::chrono::steady_clock::now();
+    while ( true )
+    {
+        pthread_mutex_lock( &connectionmutex );
+        if ( ioStop )
+        {
+            pthread_mutex_unlock( &connectionmutex );
+            break;
+        }
+
+        // drop the socket after repeated timeouts, the old one may sit on a half open connection
+        if ( ioTimeouts >= RECONNECT_TIMEOUTS )
+        {
+            ioTimeouts = 0;
+            statusId = 0;
+            if ( dealer )
+                zmq_close(dealer);
+            if ( !openDealer() )
+            {
+                ioTimeouts = RECONNECT_TIMEOUTS;
+                pthread_mutex_unlock( &connectionmutex );
+                usleep( COMMAND_TIMEOUT * 1000 );
+                continue;
+            }
+        }
+
+        // forward queued requests, those whose caller already gave up are discarded
+        blocked = false;
+        while ( !ioQueue.empty() )
+        {
+            auto &request = ioQueue.front();
+            if ( ioPending.find(request.first) == ioPending.end() )
+            {
+                ioQueue.pop_front();
+                continue;
+            }
+            if ( zmq_send(dealer, &request.first, sizeof(request.first), ZMQ_SNDMORE | ZMQ_DONTWAIT) < 0 )
+            {
+                blocked = true;
+                break;
+            }
+            zmq_send(dealer, "", 0, ZMQ_SNDMORE);
+            zmq_send(dealer, request.second.data(), request.second.size(), 0);
+            ioQueue.pop_front();
+        }
+
+        now = std::chrono::steady_clock::now();
+        if ( statusEnabled )
+        {
+            if ( statusId && elapsedMs(statusSent, now) >= COMMAND_TIMEOUT )
+            {
+                statusId = 0;
+                statusFailures++;
+                ioTimeouts++;
+            }
+            if ( !statusId && now >= statusNext )
+            {
+                uint32_t id = ++ioNextId;
+                if ( zmq_send(dealer, &id, sizeof(id), ZMQ_SNDMORE | ZMQ_DONTWAIT) >= 0 )
+                {
+                    zmq_send(dealer, "", 0, ZMQ_SNDMORE);
+                    zmq_send(dealer, "ASTRO_STATUS", 12, 0);
+                    statusId = id;
+                    statusSent = now;
+                }
+                else
+                    statusFailures++;
+                statusNext = now + std::chrono::milliseconds(statusPeriod);
+            }
+            wait = statusId ? COMMAND_TIMEOUT - elapsedMs(statusSent, now) : elapsedMs(now, statusNext);
+        }
+        else
+            wait = COMMAND_TIMEOUT;
+        pthread_mutex_unlock( &connectionmutex );
+
+        // while the peer is not reachable retry the queue shortly
+        if ( blocked )
+            wait = MIN(wait, 10);
+        if ( wait < 0 )
+            wait = 0;
+
+        items[0] = { dealer, 0, ZMQ_POLLIN, 0 };
+        items[1] = { NULL, iopipe[0], ZMQ_POLLIN, 0 };
+        if ( zmq_poll( items, 2, wait ) <= 0 )
+            continue;
+        if ( items[1].revents & ZMQ_POLLIN )
+            while ( read(iopipe[0], drain, sizeof(drain)) > 0 ) {}
+        if ( items[0].revents & ZMQ_POLLIN )
+        {
+            int events;
+            size_t len = sizeof(events);
+            do
+            {
+                dispatchReply();
+                events = 0;
+                zmq_getsockopt(dealer, ZMQ_EVENTS, &events, &len);
+            }
+            while ( events & ZMQ_POLLIN );
+        }
+    }
+}
+
+// Sends one request and waits up to timeout ms for its own reply;
+// returns 0 when the reply arrived, -1 otherwise
+int AUDTELESCOPE::exchange(const char *request, std::string &answer, int timeout)
+{
+    PendingRequest pending;
+    struct timespec deadline;
+    uint32_t id;
+    char c = 0;
+    int rc = 0;
+
+    clock_gettime( CLOCK_MONOTONIC, &deadline );
+    deadline.tv_sec += timeout / 1000;
+    deadline.tv_nsec += (long)(timeout % 1000) * 1000000L;
+    if ( deadline.tv_nsec >= 1000000000L )
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock( &connectionmutex );
+    if ( !ioRunning || ioStop )
+    {
+        pthread_mutex_unlock( &connectionmutex );
+        return -1;
+    }
+    pending.done = false;
+    id = ++ioNextId;
+    ioPending[id] = &pending;
+    ioQueue.emplace_back(id, request);
+    if ( write(iopipe[1], &c, 1) < 0 ) {}
+    while ( !pending.done && ioRunning && !ioStop && rc != ETIMEDOUT )
+        rc = pthread_cond_timedwait( &replycond, &connectionmutex, &deadline );
+    ioPending.erase(id);
+    if ( !pending.done )
+        ioTimeouts++;
+    pthread_mutex_unlock( &connectionmutex );
+
+    if ( !pending.done )
+        return -1;
+    answer.swap(pending.answer);
+    return 0;
+}
+
 char* AUDTELESCOPE::sendCommand(const char *fmt, ...)
 {
     va_list ap;
-    char buffer[4096], answer[4096], addr[1024];
-    int rc, retries;
-    zmq_pollitem_t item;
+    char buffer[4096];
+    std::string answer;
+    int retries;
 
     va_start( ap, fmt );
     vsnprintf( buffer, sizeof(buffer), fmt, ap );
     va_end( ap );
 
-    pthread_mutex_lock( &connectionmutex );
-    retries = 3;
+    retries = COMMAND_RETRIES;
     do
     {
-        zmq_send(requester, buffer, strlen(buffer), 0);
-        item = { requester, 0, ZMQ_POLLIN, 0 };
-        rc = zmq_poll( &item, 1, 500 ); // ms
-        if ( ( rc >= 0 ) && ( item.revents & ZMQ_POLLIN ) )
+        if ( !exchange(buffer, answer, COMMAND_TIMEOUT) )
         {
             // communication succeeded
-            rc = zmq_recv(requester, answer, sizeof(answer), 0);
-            if ( rc >= 0 )
-            {
-                pthread_mutex_unlock( &connectionmutex );
-                answer[MIN(rc, (int)sizeof(answer) - 1)] = '\0';
-                if ( !strncmp(answer, "OK", 2) )
-                    return NULL;
-                if ( !strncmp(answer, "ERROR:", 6) )
-                    return strdup(answer + 6);
-                return strdup("SYNTAXERROR");
-            }
+            if ( !strncmp(answer.c_str(), "OK", 2) )
+                return NULL;
+            if ( !strncmp(answer.c_str(), "ERROR:", 6) )
+                return strdup(answer.c_str() + 6);
+            return strdup("SYNTAXERROR");
         }
-        zmq_close(requester);
-        requester = zmq_socket(context, ZMQ_REQ);
-        snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-        zmq_connect(requester, addr);
     }
     while ( --retries );
-    pthread_mutex_unlock( &connectionmutex );
     DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
     return strdup("COMMUNICATIONERROR");
 }
@@ -1459,38 +1800,22 @@ char* AUDTELESCOPE::sendCommand(const char *fmt, ...)
 char* AUDTELESCOPE::sendCommandOnce(const char *fmt, ...)
 {
     va_list ap;
-    char buffer[4096], answer[4096], addr[1024];
-    int rc;
-    zmq_pollitem_t item;
+    char buffer[4096];
+    std::string answer;
 
     va_start( ap, fmt );
     vsnprintf( buffer, sizeof(buffer), fmt, ap );
     va_end( ap );
 
-    pthread_mutex_lock( &connectionmutex );
-    zmq_send(requester, buffer, strlen(buffer), 0);
-    item = { requester, 0, ZMQ_POLLIN, 0 };
-    rc = zmq_poll( &item, 1, 500 ); // ms
-    if ( ( rc >= 0 ) && ( item.revents & ZMQ_POLLIN ) )
+    if ( !exchange(buffer, answer, COMMAND_TIMEOUT) )
     {
         // communication succeeded
-        rc = zmq_recv(requester, answer, sizeof(answer), 0);
-        if ( rc >= 0 )
-        {
-            pthread_mutex_unlock( &connectionmutex );
-            answer[MIN(rc, (int)sizeof(answer) - 1)] = '\0';
-            if ( !strncmp(answer, "OK", 2) )
-                return NULL;
-            if ( !strncmp(answer, "ERROR:", 6) )
-                return strdup(answer + 6);
-            return strdup("SYNTAXERROR");
-        }
+        if ( !strncmp(answer.c_str(), "OK", 2) )
+            return NULL;
+        if ( !strncmp(answer.c_str(), "ERROR:", 6) )
+            return strdup(answer.c_str() + 6);
+        return strdup("SYNTAXERROR");
     }
-    zmq_close(requester);
-    requester = zmq_socket(context, ZMQ_REQ);
-    snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-    zmq_connect(requester, addr);
-    pthread_mutex_unlock( &connectionmutex );
     DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
     return strdup("COMMUNICATIONERROR");
 }
@@ -1498,39 +1823,22 @@ char* AUDTELESCOPE::sendCommandOnce(const char *fmt, ...)
 char* AUDTELESCOPE::sendRequest(const char *fmt, ...)
 {
     va_list ap;
-    char buffer[4096], answer[4096], addr[1024];
-    int rc, retries;
-    zmq_pollitem_t item;
+    char buffer[4096];
+    std::string answer;
+    int retries;
 
     va_start( ap, fmt );
     vsnprintf( buffer, sizeof(buffer), fmt, ap );
     va_end( ap );
 
-    pthread_mutex_lock( &connectionmutex );
-    retries = 3;
+    retries = COMMAND_RETRIES;
     do
     {
-        zmq_send(requester, buffer, strlen(buffer), 0);
-        item = { requester, 0, ZMQ_POLLIN, 0 };
-        rc = zmq_poll( &item, 1, 500 ); // ms
-        if ( ( rc >= 0 ) && ( item.revents & ZMQ_POLLIN ) )
-        {
-            // communication succeeded
-            rc = zmq_recv(requester, answer, sizeof(answer), 0);
-            if ( rc >= 0 )
-            {
-                pthread_mutex_unlock( &connectionmutex );
-                answer[MIN(rc, (int)sizeof(answer) - 1)] = '\0';
-                return strdup(answer);
-            }
-        }
-        zmq_close(requester);
-        requester = zmq_socket(context, ZMQ_REQ);
-        snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-        zmq_connect(requester, addr);
+        // communication succeeded
+        if ( !exchange(buffer, answer, COMMAND_TIMEOUT) )
+            return strdup(answer.c_str());
     }
     while ( --retries );
-    pthread_mutex_unlock( &connectionmutex );
     DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
     return strdup("COMMUNICATIONERROR");
 }
@@ -22,6 +22,8 @@
 #define AUDTELESCOPE_H
 
 #include <string>
+#include <deque>
+#include <map>
 
 #include <indidevapi.h>
 #include <inditelescope.h>
@@ -171,11 +173,42 @@ private:
     char* sendCommand(const char*,...);
     char* sendCommandOnce(const char*,...);
     char* sendRequest(const char*,...);
+    int exchange(const char*, std::string&, int);
 
-    void *context,*requester;
+    // Command channel: a worker thread owns a DEALER socket, tags every
+    // request with an id and routes the replies back to the waiting callers
+    struct PendingRequest
+    {
+        std::string answer;
+        bool done;
+    };
+    bool startIO();
+    void stopIO();
+    bool openDealer();
+    static void *ioThreadHelper(void*);
+    void ioThread();
+    void dispatchReply();
+
+    void *context,*dealer;
     char *lastErrorMsg;
 
+    pthread_t iothread;
+    int iopipe[2];
+    bool ioRunning,ioStop;
+    uint32_t ioNextId;
+    int ioTimeouts;
+    std::deque<std::pair<uint32_t,std::string>> ioQueue;
+    std::map<uint32_t,PendingRequest*> ioPending;
+
+    // Status telemetry polled by the worker, consumed by ReadScopeStatus
+    bool statusEnabled,statusWarned;
+    int statusPeriod,statusFailures;
+    uint32_t statusId;
+    unsigned int statusSeq,statusSeen;
+    std::string statusAnswer;
+
     pthread_mutex_t connectionmutex;
+    pthread_cond_t replycond;
 };
 
 #endif
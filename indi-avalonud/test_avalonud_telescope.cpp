@@ -0,0 +1,365 @@
+/*
+    Avalon Unified Driver Telescope command channel test
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+// Runs the command channel against a mount server mocked by a local REP socket on the
+// driver port. The mock echoes every request back, so a reply routed to the wrong caller
+// is caught, and it can stall a request or go away and come back. The REQ socket exchange
+// the driver used before is kept here as the reference.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <zmq.h>
+
+// The command channel is started by hand instead of through Connect
+#define private public
+#define protected public
+#include "indi_avalonud_telescope.h"
+#undef private
+#undef protected
+
+extern std::unique_ptr<AUDTELESCOPE> telescope;
+
+// Port of the mount server, as in the driver
+static const int IPport = 5451;
+
+// Mount server: echoes requests as OK:<request>, answers ASTRO_STATUS with a status whose
+// RA moves with every status request, and sleeps 0.8 s before answering SLOW requests
+class MountMock
+{
+    public:
+        MountMock()
+        {
+            context = zmq_ctx_new();
+            start();
+        }
+
+        ~MountMock()
+        {
+            stop();
+            zmq_ctx_term(context);
+        }
+
+        void start()
+        {
+            quit = false;
+            thread = std::thread(&MountMock::run, this);
+            // wait for the bind, the port may still be held by the previous socket
+            while (!bound && !failed)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            EXPECT_TRUE(bound);
+        }
+
+        // Like killing the server: pending requests are never answered
+        void stop()
+        {
+            quit = true;
+            if (thread.joinable())
+                thread.join();
+            bound = false;
+        }
+
+        static double statusRA(int seq)
+        {
+            return (seq % 24000) * 0.001;
+        }
+
+        std::atomic<int> requests { 0 };
+        std::atomic<int> statusRequests { 0 };
+
+    private:
+        void run()
+        {
+            void *rep = zmq_socket(context, ZMQ_REP);
+            int linger = 0;
+            char addr[64], buffer[4096];
+
+            zmq_setsockopt(rep, ZMQ_LINGER, &linger, sizeof(linger));
+            snprintf(addr, sizeof(addr), "tcp://127.0.0.1:%d", IPport);
+            for (int tries = 0; zmq_bind(rep, addr); tries++)
+            {
+                if (tries == 200)
+                {
+                    failed = true;
+                    zmq_close(rep);
+                    return;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            bound = true;
+
+            while (!quit)
+            {
+                zmq_pollitem_t item = { rep, 0, ZMQ_POLLIN, 0 };
+                if (zmq_poll(&item, 1, 20) <= 0)
+                    continue;
+                int n = zmq_recv(rep, buffer, sizeof(buffer) - 1, 0);
+                if (n < 0)
+                    continue;
+                buffer[std::min(n, (int)sizeof(buffer) - 1)] = '\0';
+
+                std::string reply;
+                if (!strcmp(buffer, "ASTRO_STATUS"))
+                {
+                    char status[512];
+                    snprintf(status, sizeof(status),
+                             "{\"UTC\":0,\"JD\":2460000.5,\"LST\":0,\"HA\":0,\"RA\":%.3f,\"Dec\":45,\"Az\":0,\"Alt\":45,"
+                             "\"globalStatus\":2,\"meridianFlip\":0,\"pierSide\":0,\"meridianFlipHA\":0,\"exposureReady\":0}",
+                             statusRA(statusRequests++));
+                    reply = status;
+                }
+                else
+                {
+                    requests++;
+                    if (!strncmp(buffer, "SLOW", 4))
+                        std::this_thread::sleep_for(std::chrono::milliseconds(800));
+                    reply = std::string("OK:") + buffer;
+                }
+                zmq_send(rep, reply.data(), reply.size(), 0);
+            }
+            zmq_close(rep);
+        }
+
+        void *context { nullptr };
+        std::thread thread;
+        std::atomic_bool quit { false };
+        std::atomic_bool bound { false };
+        std::atomic_bool failed { false };
+};
+
+// What sendRequest did before: one REQ socket shared under the connection mutex,
+// closed and reopened whenever an answer took longer than 500 ms
+static char *oldSendRequest(void *context, void *&requester, const char *request)
+{
+    char answer[4096], addr[1024];
+    int rc, retries = 3;
+    zmq_pollitem_t item;
+
+    do
+    {
+        zmq_send(requester, request, strlen(request), 0);
+        item = { requester, 0, ZMQ_POLLIN, 0 };
+        rc = zmq_poll( &item, 1, 500 ); // ms
+        if ( ( rc >= 0 ) && ( item.revents & ZMQ_POLLIN ) )
+        {
+            rc = zmq_recv(requester, answer, sizeof(answer), 0);
+            if ( rc >= 0 )
+            {
+                answer[MIN(rc, (int)sizeof(answer) - 1)] = '\0';
+                return strdup(answer);
+            }
+        }
+        zmq_close(requester);
+        requester = zmq_socket(context, ZMQ_REQ);
+        snprintf( addr, sizeof(addr), "tcp://127.0.0.1:%d", IPport );
+        zmq_connect(requester, addr);
+    }
+    while ( --retries );
+    return strdup("COMMUNICATIONERROR");
+}
+
+static double msSince(const std::chrono::steady_clock::time_point &start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+class CommandChannel : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            telescope->IPaddress = strdup("127.0.0.1");
+            ASSERT_TRUE(telescope->startIO());
+        }
+
+        void TearDown() override
+        {
+            telescope->stopIO();
+            free(telescope->IPaddress);
+        }
+
+        // Sends count numbered requests, returns how many replies do not echo their own request
+        template <typename Send>
+        int echo(const char *prefix, int count, Send send)
+        {
+            char request[64];
+            int mismatches = 0;
+            for (int i = 0; i < count; i++)
+            {
+                snprintf(request, sizeof(request), "%s %d", prefix, i);
+                char *answer = send(request);
+                if (strncmp(answer, "OK:", 3) || strcmp(answer + 3, request))
+                    mismatches++;
+                free(answer);
+            }
+            return mismatches;
+        }
+
+        MountMock mock;
+};
+
+TEST_F(CommandChannel, RepliesMatchTheirRequests)
+{
+    const int count = 3000;
+
+    void *requester = zmq_socket(telescope->context, ZMQ_REQ);
+    char addr[64];
+    snprintf(addr, sizeof(addr), "tcp://127.0.0.1:%d", IPport);
+    ASSERT_EQ(zmq_connect(requester, addr), 0);
+    auto start = std::chrono::steady_clock::now();
+    int oldMismatches = echo("PING", count, [&](const char *request)
+    {
+        return oldSendRequest(telescope->context, requester, request);
+    });
+    double usOld = msSince(start) * 1000 / count;
+    zmq_close(requester);
+
+    start = std::chrono::steady_clock::now();
+    int mismatches = echo("PING", count, [](const char *request)
+    {
+        return telescope->sendRequest("%s", request);
+    });
+    double usNew = msSince(start) * 1000 / count;
+
+    EXPECT_EQ(oldMismatches, 0);
+    EXPECT_EQ(mismatches, 0);
+    EXPECT_EQ(mock.requests.load(), 2 * count);
+
+    fprintf(stderr, "%d echoed requests: REQ socket %d mismatches, %.1f us/request; "
+            "DEALER worker %d mismatches, %.1f us/request\n", count, oldMismatches, usOld, mismatches, usNew);
+}
+
+TEST_F(CommandChannel, LateReplyIsDiscarded)
+{
+    auto start = std::chrono::steady_clock::now();
+    char *answer = telescope->sendCommandOnce("SLOW 1");
+    double msSlow = msSince(start);
+    ASSERT_NE(answer, nullptr);
+    EXPECT_STREQ(answer, "COMMUNICATIONERROR");
+    free(answer);
+    EXPECT_GE(msSlow, 450);
+    EXPECT_LT(msSlow, 700);
+
+    // The next request is answered only after the stalled one, but the stale reply is not its answer
+    start = std::chrono::steady_clock::now();
+    answer = telescope->sendRequest("PING after");
+    double msAfter = msSince(start);
+    EXPECT_STREQ(answer, "OK:PING after");
+    free(answer);
+
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    answer = telescope->sendRequest("PING later");
+    EXPECT_STREQ(answer, "OK:PING later");
+    free(answer);
+
+    fprintf(stderr, "Stalled request failed after %.0f ms, the next one got its own reply after %.0f ms\n",
+            msSlow, msAfter);
+}
+
+TEST_F(CommandChannel, StatusTickDoesNoIO)
+{
+    const int ticks = 40, periodMs = 50;
+
+    pthread_mutex_lock(&telescope->connectionmutex);
+    telescope->statusPeriod = periodMs;
+    telescope->statusFailures = 0;
+    telescope->statusSeq = telescope->statusSeen = 0;
+    telescope->statusEnabled = true;
+    pthread_mutex_unlock(&telescope->connectionmutex);
+    std::this_thread::sleep_for(std::chrono::milliseconds(4 * periodMs));
+
+    int requests = mock.requests.load(), fresh = 0;
+    double worst = 0, total = 0;
+    for (int i = 0; i < ticks; i++)
+    {
+        unsigned int seen = telescope->statusSeen;
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_TRUE(telescope->ReadScopeStatus());
+        double ms = msSince(start);
+        total += ms;
+        worst = std::max(worst, ms);
+        if (telescope->statusSeen != seen)
+        {
+            fresh++;
+            // The RA of the snapshot is one of the last two status replies
+            int last = mock.statusRequests.load() - 1;
+            double ra = telescope->EqNP[AXIS_RA].getValue();
+            EXPECT_TRUE(fabs(ra - MountMock::statusRA(last)) < 1e-9 || fabs(ra - MountMock::statusRA(last - 1)) < 1e-9) << ra;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(periodMs));
+    }
+
+    EXPECT_EQ(mock.requests.load(), requests);
+    EXPECT_GE(fresh, ticks - 2);
+    EXPECT_LT(worst, 5);
+
+    fprintf(stderr, "Status tick: %.3f ms average, %.3f ms worst, %d/%d fresh, %d commands sent\n",
+            total / ticks, worst, fresh, ticks, mock.requests.load() - requests);
+}
+
+TEST_F(CommandChannel, ServerRestartIsRecovered)
+{
+    mock.stop();
+    auto start = std::chrono::steady_clock::now();
+    char *answer = telescope->sendRequest("PING dead");
+    double msDead = msSince(start);
+    EXPECT_STREQ(answer, "COMMUNICATIONERROR");
+    free(answer);
+
+    mock.start();
+    start = std::chrono::steady_clock::now();
+    int calls = 0;
+    do
+    {
+        answer = telescope->sendRequest("PING back");
+        calls++;
+        bool back = !strcmp(answer, "OK:PING back");
+        free(answer);
+        if (back)
+            break;
+    }
+    while (calls < 20);
+    double msBack = msSince(start);
+    EXPECT_LT(calls, 20);
+
+    int mismatches = echo("P", 200, [](const char *request)
+    {
+        return telescope->sendRequest("%s", request);
+    });
+    EXPECT_EQ(mismatches, 0);
+
+    fprintf(stderr, "Server down: failed after %.0f ms; restarted: answered after %.0f ms and %d call(s), "
+            "then %d/200 mismatches\n", msDead, msBack, calls, mismatches);
+}
+
+int main(int argc, char **argv)
+{
+    // initProperties sets up the connection mutex
+    telescope->ISGetProperties(nullptr);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -11,6 +11,7 @@
 #include "DsiDevice.h"
 
 #include "DsiException.h"
+#include "DsiFieldRead.h"
 #include "Util.h"
 
 #include <cstring>
@@ -866,11 +867,23 @@ unsigned char *DSI::Device::downloadImage()
 
     framebuffer = new unsigned char[all_size];
 
+    if (log_commands)
+        std::cerr << "t_image_height  =" << t_image_height << std::endl
+                  << "t_image_width   =" << t_image_width << std::endl
+                  << "t_image_offset_x=" << t_image_offset_x << std::endl
+                  << "t_image_offset_y=" << t_image_offset_y << std::endl
+                  << "t_read_width    =" << t_read_width << std::endl
+                  << "t_read_height   =" << t_read_height << std::endl
+                  << "t_read_bpp      =" << t_read_bpp << std::endl;
+
     if (interlaced)
     {
         /* XXX: There has to be  a way to calculate a more optimal readout
                time here. */
-        status = libusb_bulk_transfer(handle, 0x86, even_data, even_size, &transferred, 60000 * MILLISEC);
+        FieldRead even_read(handle, even_data, even_size);
+        FieldRead odd_read(handle, odd_data, odd_size);
+
+        status = even_read.wait(&transferred);
         if (log_commands)
         {
             log_command_info(false, "r 86", (status > 0 ? status : 0), (char *)even_data, 0);
@@ -889,7 +902,11 @@ unsigned char *DSI::Device::downloadImage()
             throw device_read_error(ss.str());
         }
 
-        status = libusb_bulk_transfer(handle, 0x86, odd_data, odd_size, &transferred, 60000 * MILLISEC);
+        /* the odd field is still being transferred */
+        copy_field_rows(framebuffer, even_data, 0, 2, t_read_width, t_image_width, t_image_height, t_image_offset_x,
+                        t_image_offset_y);
+
+        status = odd_read.wait(&transferred);
         if (log_commands)
         {
             log_command_info(false, "r 86", (status > 0 ? status : 0), (char *)odd_data, 0);
@@ -907,13 +924,17 @@ unsigned char *DSI::Device::downloadImage()
             ss << std::dec << "read odd data, status = (" << status << ") " << strerror(-status);
             throw device_read_error(ss.str());
         }
+
+        copy_field_rows(framebuffer, odd_data, 1, 2, t_read_width, t_image_width, t_image_height, t_image_offset_x,
+                        t_image_offset_y);
     }
     else // progressive mode for DSI III (gs)
     {
         if ((!vdd_on) && (exposure_time >= VDD_TRH))
             command(DeviceCommand::SET_VDD_MODE, VddMode::ON.value());
 
-        status = libusb_bulk_transfer(handle, 0x86, odd_data, odd_size, &transferred, 60000 * MILLISEC);
+        FieldRead progressive_read(handle, odd_data, odd_size);
+        status = progressive_read.wait(&transferred);
         if (log_commands)
         {
             log_command_info(false, "r 86", (status > 0 ? status : 0), (char *)odd_data, 0);
@@ -930,6 +951,9 @@ unsigned char *DSI::Device::downloadImage()
             ss << std::dec << "read progressive data, status = (" << status << ") ";
             throw device_read_error(ss.str());
         }
+
+        copy_field_rows(framebuffer, odd_data, 0, 1, t_read_width, t_image_width, t_image_height, t_image_offset_x,
+                        t_image_offset_y);
     }
 
     /* Update temperature for devices with sensor (gs) */
@@ -945,76 +969,6 @@ unsigned char *DSI::Device::downloadImage()
     /* disable 2x2 binning after downloading image (gs) */
     disable2x2Binning();
 
-    unsigned char msb = 0, lsb = 0, is_odd = 0;
-    unsigned int x_ptr = 0, line_start = 0, y_ptr = 0, read_ptr = 0, write_ptr = 0;
-    char *even = (char *)even_data;
-    char *odd  = (char *)odd_data;
-
-    if (log_commands)
-        std::cerr << "t_image_height  =" << t_image_height << std::endl
-                  << "t_image_width   =" << t_image_width << std::endl
-                  << "t_image_offset_x=" << t_image_offset_x << std::endl
-                  << "t_image_offset_y=" << t_image_offset_y << std::endl
-                  << "t_read_width    =" << t_read_width << std::endl
-                  << "t_read_height   =" << t_read_height << std::endl
-                  << "t_read_bpp      =" << t_read_bpp << std::endl;
-
-    if (interlaced)
-    {
-        for (write_ptr = y_ptr = 0; y_ptr < t_image_height; y_ptr++)
-        {
-            line_start = t_read_width * ((y_ptr + t_image_offset_y) / 2);
-            is_odd     = (y_ptr + t_image_offset_y) % 2;
-
-            std::cerr << "starting image row " << y_ptr << ", write_ptr=" << write_ptr << ", line_start=" << line_start
-                      << ", is_odd=" << (is_odd == 0 ? 0 : 1) << ", read_ptr=" << (line_start + t_image_offset_x) * 2
-                      << std::endl;
-
-            for (x_ptr = 0; x_ptr < t_image_width; x_ptr++)
-            {
-                read_ptr = (line_start + x_ptr + t_image_offset_x) * 2;
-                if (is_odd == 1) // odd line
-                {
-                    msb = odd[read_ptr];
-                    lsb = odd[read_ptr + 1];
-                }
-                else
-                {
-                    // even line
-                    msb = even[read_ptr];
-                    lsb = even[read_ptr + 1];
-                }
-                framebuffer[write_ptr++] = msb;
-                framebuffer[write_ptr++] = lsb;
-            }
-        }
-    }
-    else
-    {
-        for (write_ptr = y_ptr = 0; y_ptr < t_image_height; y_ptr++)
-        {
-            line_start = t_read_width * (y_ptr + t_image_offset_y);
-
-            // std::cerr << "starting image row " << y_ptr
-            //      << ", write_ptr=" << write_ptr
-            //      << ", line_start=" << line_start
-            //      << ", read_ptr=" << (line_start+t_image_offset_x)*2
-            //      << std::endl;
-            for (x_ptr = 0; x_ptr < t_image_width; x_ptr++)
-            {
-                read_ptr = (line_start + x_ptr + t_image_offset_x) * 2;
-
-                msb = odd[read_ptr];
-                lsb = odd[read_ptr + 1];
-
-                framebuffer[write_ptr++] = msb;
-                framebuffer[write_ptr++] = lsb;
-            }
-        }
-    }
-
-    if (log_commands)
-        std::cerr << "write_ptr=" << write_ptr << std::endl;
 
     delete[] odd_data;
 
@@ -1332,11 +1286,27 @@ unsigned char *DSI::Device::getImage(DeviceCommand __command, int howlong)
         if (last_time == 0)
             last_time = get_sysclock_ms();
 
+        if (log_commands)
+            std::cerr << "t_image_height  =" << t_image_height << std::endl
+                      << "t_image_width   =" << t_image_width << std::endl
+                      << "t_image_offset_x=" << t_image_offset_x << std::endl
+                      << "t_image_offset_y=" << t_image_offset_y << std::endl
+                      << "t_read_width    =" << t_read_width << std::endl
+                      << "t_read_height   =" << t_read_height << std::endl
+                      << "t_read_bpp      =" << t_read_bpp << std::endl;
+
+        /* Both reads are queued up front, the even field is decoded while the
+           odd one is still being transferred. */
+        std::unique_ptr<FieldRead> even_read;
+        if (interlaced)
+            even_read.reset(new FieldRead(handle, even_data, even_size));
+        FieldRead odd_read(handle, odd_data, odd_size);
+
         if (interlaced)
         {
             /* XXX: There has to be  a way to calculate a more optimal readout
                time here. */
-            status = libusb_bulk_transfer(handle, 0x86, even_data, even_size, &transferred, 60000 * MILLISEC);
+            status = even_read->wait(&transferred);
             if (log_commands)
             {
                 log_command_info(false, "r 86", (status > 0 ? status : 0), (char *)even_data, 0);
@@ -1353,12 +1323,15 @@ unsigned char *DSI::Device::getImage(DeviceCommand __command, int howlong)
                 ss << std::dec << "read even data, status = (" << status << ") " << strerror(-status);
                 throw device_read_error(ss.str());
             }
+
+            copy_field_rows(framebuffer, even_data, 0, 2, t_read_width, t_image_width, t_image_height, t_image_offset_x,
+                            t_image_offset_y);
         }
 
-        status = libusb_bulk_transfer(handle, 0x86, odd_data, odd_size, &transferred, 60000 * MILLISEC);
+        status = odd_read.wait(&transferred);
         if (log_commands)
         {
-            log_command_info(false, "r 86", (status > 0 ? status : 0), (char *)even_data, 0);
+            log_command_info(false, "r 86", (status > 0 ? status : 0), (char *)odd_data, 0);
 
             std::cerr << std::dec << "read odd data, status = (" << status << ") " << (status > 0 ? "" : strerror(-status))
                       << std::endl
@@ -1373,6 +1346,13 @@ unsigned char *DSI::Device::getImage(DeviceCommand __command, int howlong)
             throw device_read_error(ss.str());
         }
 
+        if (interlaced)
+            copy_field_rows(framebuffer, odd_data, 1, 2, t_read_width, t_image_width, t_image_height, t_image_offset_x,
+                            t_image_offset_y);
+        else
+            copy_field_rows(framebuffer, odd_data, 0, 1, t_read_width, t_image_width, t_image_height, t_image_offset_x,
+                            t_image_offset_y);
+
         if (has_tempsensor)
         {
             rawtemp  = command(DeviceCommand::GET_TEMP);
@@ -1383,74 +1363,6 @@ unsigned char *DSI::Device::getImage(DeviceCommand __command, int howlong)
 
         disable2x2Binning();
 
-        unsigned char msb = 0, lsb = 0, is_odd = 0;
-        unsigned int x_ptr = 0, line_start = 0, y_ptr = 0, read_ptr = 0, write_ptr = 0;
-        char *even = (char *)even_data;
-        char *odd  = (char *)odd_data;
-
-        if (log_commands)
-            std::cerr << "t_image_height  =" << t_image_height << std::endl
-                      << "t_image_width   =" << t_image_width << std::endl
-                      << "t_image_offset_x=" << t_image_offset_x << std::endl
-                      << "t_image_offset_y=" << t_image_offset_y << std::endl
-                      << "t_read_width    =" << t_read_width << std::endl
-                      << "t_read_height   =" << t_read_height << std::endl
-                      << "t_read_bpp      =" << t_read_bpp << std::endl;
-
-        if (interlaced)
-        {
-            for (write_ptr = y_ptr = 0; y_ptr < t_image_height; y_ptr++)
-            {
-                line_start = t_read_width * ((y_ptr + t_image_offset_y) / 2);
-                is_odd     = (y_ptr + t_image_offset_y) % 2;
-
-                std::cerr << "starting image row " << y_ptr << ", write_ptr=" << write_ptr << ", line_start=" << line_start
-                          << ", is_odd=" << (is_odd == 0 ? 0 : 1) << ", read_ptr=" << (line_start + t_image_offset_x) * 2
-                          << std::endl;
-                for (x_ptr = 0; x_ptr < t_image_width; x_ptr++)
-                {
-                    read_ptr = (line_start + x_ptr + t_image_offset_x) * 2;
-                    if (is_odd == 1) // odd line
-                    {
-                        msb = odd[read_ptr];
-                        lsb = odd[read_ptr + 1];
-                    }
-                    else
-                    {
-                        // even line
-                        msb = even[read_ptr];
-                        lsb = even[read_ptr + 1];
-                    }
-                    framebuffer[write_ptr++] = msb;
-                    framebuffer[write_ptr++] = lsb;
-                }
-            }
-        }
-        else
-        {
-            for (write_ptr = y_ptr = 0; y_ptr < t_image_height; y_ptr++)
-            {
-                line_start = t_read_width * (y_ptr + t_image_offset_y);
-
-                //std::cerr << "starting image row " << y_ptr
-                //     << ", write_ptr=" << write_ptr
-                //     << ", line_start=" << line_start
-                //     << ", read_ptr=" << (line_start+t_image_offset_x)*2 << std::endl;
-                for (x_ptr = 0; x_ptr < t_image_width; x_ptr++)
-                {
-                    read_ptr = (line_start + x_ptr + t_image_offset_x) * 2;
-
-                    msb = odd[read_ptr];
-                    lsb = odd[read_ptr + 1];
-
-                    framebuffer[write_ptr++] = msb;
-                    framebuffer[write_ptr++] = lsb;
-                }
-            }
-        }
-
-        if (log_commands)
-            std::cerr << "write_ptr=" << write_ptr << std::endl;
 
         delete[] odd_data;
 
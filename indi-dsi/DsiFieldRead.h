@@ -0,0 +1,117 @@
+/*
+ * Copyright © 2008, Roland Roberts
+ *
+ */
+
+#ifndef __DsiFieldRead_hh
+#define __DsiFieldRead_hh
+
+#include <libusb.h>
+
+#include <cstddef>
+#include <cstring>
+
+/* Convenient mnemonic for libusb timeouts which are always in this unit. */
+#ifndef MILLISEC
+#define MILLISEC 2
+#endif
+
+namespace DSI
+{
+/* Bulk read of one image field. The transfer is queued on construction so a
+ * second field can stream in while the first one is decoded. */
+class FieldRead
+{
+    public:
+        FieldRead(libusb_device_handle *handle, unsigned char *data, unsigned int size)
+        {
+            transfer = libusb_alloc_transfer(0);
+            if (transfer == nullptr)
+            {
+                status = LIBUSB_ERROR_NO_MEM;
+                return;
+            }
+            libusb_fill_bulk_transfer(transfer, handle, 0x86, data, size, done, &completed, 60000 * MILLISEC);
+            status = libusb_submit_transfer(transfer);
+            if (status != 0)
+            {
+                libusb_free_transfer(transfer);
+                transfer = nullptr;
+            }
+        }
+
+        ~FieldRead()
+        {
+            if (transfer == nullptr)
+                return;
+            if (!completed)
+                libusb_cancel_transfer(transfer);
+            while (!completed)
+                libusb_handle_events_completed(nullptr, &completed);
+            libusb_free_transfer(transfer);
+        }
+
+        FieldRead(const FieldRead &) = delete;
+        FieldRead &operator=(const FieldRead &) = delete;
+
+        /* Waits for the field, returns what libusb_bulk_transfer would have */
+        int wait(int *transferred)
+        {
+            *transferred = 0;
+            if (transfer == nullptr)
+                return status;
+
+            while (!completed)
+            {
+                int rc = libusb_handle_events_completed(nullptr, &completed);
+                if (rc < 0 && rc != LIBUSB_ERROR_INTERRUPTED)
+                    return rc;
+            }
+
+            *transferred = transfer->actual_length;
+            switch (transfer->status)
+            {
+                case LIBUSB_TRANSFER_COMPLETED:
+                    return 0;
+                case LIBUSB_TRANSFER_TIMED_OUT:
+                    return LIBUSB_ERROR_TIMEOUT;
+                case LIBUSB_TRANSFER_STALL:
+                    return LIBUSB_ERROR_PIPE;
+                case LIBUSB_TRANSFER_NO_DEVICE:
+                    return LIBUSB_ERROR_NO_DEVICE;
+                case LIBUSB_TRANSFER_OVERFLOW:
+                    return LIBUSB_ERROR_OVERFLOW;
+                default:
+                    return LIBUSB_ERROR_IO;
+            }
+        }
+
+    private:
+        static void LIBUSB_CALL done(struct libusb_transfer *transfer)
+        {
+            *static_cast<int *>(transfer->user_data) = 1;
+        }
+
+        libusb_transfer *transfer { nullptr };
+        int completed { 0 };
+        int status { 0 };
+};
+
+/* Copies the image rows held by one field into the frame buffer. With step 2
+ * the field holds every other sensor line starting at line 'parity', with
+ * step 1 it holds all of them. Pixels are two bytes and keep their order. */
+inline void copy_field_rows(unsigned char *framebuffer, const unsigned char *field, unsigned int parity,
+                            unsigned int step, unsigned int read_width, unsigned int image_width,
+                            unsigned int image_height, unsigned int offset_x, unsigned int offset_y)
+{
+    size_t row_size = image_width * 2;
+
+    for (unsigned int y = (parity + offset_y) % step; y < image_height; y += step)
+    {
+        size_t line_start = read_width * ((y + offset_y) / step);
+        memcpy(framebuffer + y * row_size, field + (line_start + offset_x) * 2, row_size);
+    }
+}
+}
+
+#endif /* __DsiFieldRead_hh */
@@ -0,0 +1,352 @@
+/*
+ * Copyright © 2008, Roland Roberts
+ *
+ * Image field download test
+ */
+
+// Replays random field streams through a fake asynchronous libusb, once through the
+// synchronous reads and per-pixel loop downloadImage used before, once through FieldRead
+// and copy_field_rows. The fake streams the fields on a thread at a fixed USB rate.
+
+#include <gtest/gtest.h>
+
+#include "DsiFieldRead.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+
+class FakeUSB
+{
+    public:
+        ~FakeUSB()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quit = true;
+                cv.notify_all();
+            }
+            if (worker.joinable())
+                worker.join();
+        }
+
+        void load(const std::vector<unsigned char> &data)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stream = data;
+            pos = 0;
+        }
+
+        int submit(libusb_transfer *transfer)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!worker.joinable())
+                worker = std::thread(&FakeUSB::run, this);
+            queued.push_back(transfer);
+            pending.insert(transfer);
+            cv.notify_all();
+            return 0;
+        }
+
+        int cancel(libusb_transfer *transfer)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = std::find(queued.begin(), queued.end(), transfer);
+            if (it != queued.end())
+            {
+                // A transfer still waiting for the bus completes as cancelled right away
+                queued.erase(it);
+                cancelled++;
+                finish(transfer, LIBUSB_TRANSFER_CANCELLED, 0);
+                return 0;
+            }
+            if (transfer != inFlight)
+                return LIBUSB_ERROR_NOT_FOUND;
+            // One on the bus completes as cancelled when the bus lets go of it
+            cancelInFlight = true;
+            cancelled++;
+            return 0;
+        }
+
+        // Runs the callbacks of finished transfers on the calling thread, like libusb does
+        int handleEvents(int *completed)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (done.empty() && !*completed)
+                cv.wait(lock);
+            while (!done.empty())
+            {
+                libusb_transfer *transfer = done.front();
+                done.pop_front();
+                pending.erase(transfer);
+                lock.unlock();
+                transfer->callback(transfer);
+                lock.lock();
+            }
+            return 0;
+        }
+
+        void release(libusb_transfer *transfer)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (pending.count(transfer))
+                    freedPending++;
+            }
+            delete transfer;
+        }
+
+        // The synchronous read downloadImage used before
+        int bulkRead(unsigned char *data, int length, int *transferred)
+        {
+            std::this_thread::sleep_for(wireTime(length));
+            std::lock_guard<std::mutex> lock(mutex);
+            memcpy(data, stream.data() + pos, length);
+            pos += length;
+            *transferred = length;
+            return 0;
+        }
+
+        // The next transfer on the bus fails with a stall
+        bool stallNext { false };
+        int cancelled { 0 };
+        int freedPending { 0 };
+
+    private:
+        static std::chrono::microseconds wireTime(int length)
+        {
+            // 20 MB/s
+            return std::chrono::microseconds(length / 20);
+        }
+
+        void finish(libusb_transfer *transfer, libusb_transfer_status status, int length)
+        {
+            transfer->status = status;
+            transfer->actual_length = length;
+            done.push_back(transfer);
+            cv.notify_all();
+        }
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!quit)
+            {
+                if (queued.empty())
+                {
+                    cv.wait(lock);
+                    continue;
+                }
+                libusb_transfer *transfer = queued.front();
+                queued.pop_front();
+                if (stallNext)
+                {
+                    stallNext = false;
+                    finish(transfer, LIBUSB_TRANSFER_STALL, 0);
+                    continue;
+                }
+                inFlight = transfer;
+                lock.unlock();
+                std::this_thread::sleep_for(wireTime(transfer->length));
+                lock.lock();
+                inFlight = nullptr;
+                if (cancelInFlight)
+                {
+                    cancelInFlight = false;
+                    finish(transfer, LIBUSB_TRANSFER_CANCELLED, 0);
+                    continue;
+                }
+                memcpy(transfer->buffer, stream.data() + pos, transfer->length);
+                pos += transfer->length;
+                finish(transfer, LIBUSB_TRANSFER_COMPLETED, transfer->length);
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::thread worker;
+        bool quit { false };
+        libusb_transfer *inFlight { nullptr };
+        bool cancelInFlight { false };
+        std::deque<libusb_transfer *> queued, done;
+        std::set<libusb_transfer *> pending;
+        std::vector<unsigned char> stream;
+        size_t pos { 0 };
+};
+
+static FakeUSB *fake;
+
+extern "C" {
+libusb_transfer *libusb_alloc_transfer(int)
+{
+    return new libusb_transfer();
+}
+
+void libusb_free_transfer(libusb_transfer *transfer)
+{
+    fake->release(transfer);
+}
+
+int libusb_submit_transfer(libusb_transfer *transfer)
+{
+    return fake->submit(transfer);
+}
+
+int libusb_cancel_transfer(libusb_transfer *transfer)
+{
+    return fake->cancel(transfer);
+}
+
+int libusb_handle_events_completed(libusb_context *, int *completed)
+{
+    return fake->handleEvents(completed);
+}
+
+int libusb_bulk_transfer(libusb_device_handle *, unsigned char, unsigned char *data, int length, int *transferred,
+                         unsigned int)
+{
+    return fake->bulkRead(data, length, transferred);
+}
+}
+
+struct Geometry
+{
+    unsigned int read_width, height_even, height_odd, image_width, image_height, offset_x, offset_y;
+};
+
+// What downloadImage did before: read both fields, then copy pixel by pixel
+static void oldDownload(unsigned char *framebuffer, const Geometry &g)
+{
+    bool interlaced = g.height_even > 0;
+    std::vector<unsigned char> even(2 * g.read_width * g.height_even), odd(2 * g.read_width * g.height_odd);
+    int transferred;
+
+    if (interlaced)
+        libusb_bulk_transfer(nullptr, 0x86, even.data(), even.size(), &transferred, 60000 * MILLISEC);
+    libusb_bulk_transfer(nullptr, 0x86, odd.data(), odd.size(), &transferred, 60000 * MILLISEC);
+
+    unsigned int write_ptr = 0;
+    for (unsigned int y = 0; y < g.image_height; y++)
+    {
+        unsigned int line_start = interlaced ? g.read_width * ((y + g.offset_y) / 2) : g.read_width * (y + g.offset_y);
+        bool is_odd = interlaced ? (y + g.offset_y) % 2 : true;
+        for (unsigned int x = 0; x < g.image_width; x++)
+        {
+            unsigned int read_ptr = (line_start + x + g.offset_x) * 2;
+            const unsigned char *field = is_odd ? odd.data() : even.data();
+            framebuffer[write_ptr++] = field[read_ptr];
+            framebuffer[write_ptr++] = field[read_ptr + 1];
+        }
+    }
+}
+
+// What downloadImage does now: queue both fields, decode the even one while the odd one streams
+static void newDownload(unsigned char *framebuffer, const Geometry &g)
+{
+    std::vector<unsigned char> even(2 * g.read_width * g.height_even), odd(2 * g.read_width * g.height_odd);
+    int transferred;
+
+    if (g.height_even == 0)
+    {
+        DSI::FieldRead progressive_read(nullptr, odd.data(), odd.size());
+        ASSERT_EQ(progressive_read.wait(&transferred), 0);
+        DSI::copy_field_rows(framebuffer, odd.data(), 0, 1, g.read_width, g.image_width, g.image_height, g.offset_x,
+                             g.offset_y);
+        return;
+    }
+
+    DSI::FieldRead even_read(nullptr, even.data(), even.size());
+    DSI::FieldRead odd_read(nullptr, odd.data(), odd.size());
+    ASSERT_EQ(even_read.wait(&transferred), 0);
+    ASSERT_EQ(transferred, static_cast<int>(even.size()));
+    DSI::copy_field_rows(framebuffer, even.data(), 0, 2, g.read_width, g.image_width, g.image_height, g.offset_x,
+                         g.offset_y);
+    ASSERT_EQ(odd_read.wait(&transferred), 0);
+    ASSERT_EQ(transferred, static_cast<int>(odd.size()));
+    DSI::copy_field_rows(framebuffer, odd.data(), 1, 2, g.read_width, g.image_width, g.image_height, g.offset_x,
+                         g.offset_y);
+}
+
+class FieldDownload : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            fake = &usb;
+        }
+
+        void TearDown() override
+        {
+            EXPECT_EQ(usb.freedPending, 0);
+            fake = nullptr;
+        }
+
+        FakeUSB usb;
+};
+
+TEST_F(FieldDownload, FramesMatchThePerPixelLoop)
+{
+    // DSI Pro II frame at odd and even vertical offsets, a smaller interlaced frame and a
+    // progressive DSI III frame
+    const Geometry geometries[] =
+    {
+        { 768, 300, 300, 752, 582, 14, 13 },
+        { 768, 300, 300, 752, 582, 14, 14 },
+        { 512, 250, 250, 500, 497, 3, 0 },
+        { 1536, 0, 1050, 1360, 1024, 21, 9 },
+    };
+    std::mt19937 rng(41);
+
+    for (const Geometry &g : geometries)
+    {
+        std::vector<unsigned char> stream(2 * g.read_width * (g.height_even + g.height_odd));
+        for (unsigned char &c : stream)
+            c = rng();
+        std::vector<unsigned char> before(2 * g.image_width * g.image_height, 0), after(before.size(), 0);
+
+        usb.load(stream);
+        auto start = std::chrono::steady_clock::now();
+        oldDownload(before.data(), g);
+        double msBefore = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        usb.load(stream);
+        start = std::chrono::steady_clock::now();
+        newDownload(after.data(), g);
+        double msAfter = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        EXPECT_TRUE(before == after) << g.image_width << "x" << g.image_height << " at " << g.offset_x << "," << g.offset_y;
+        fprintf(stderr, "%ux%u at (%u,%u) %s: old %.2f ms, queued fields %.2f ms\n", g.image_width, g.image_height,
+                g.offset_x, g.offset_y, g.height_even ? "interlaced" : "progressive", msBefore, msAfter);
+    }
+}
+
+TEST_F(FieldDownload, ErrorOnTheFirstFieldReapsTheSecond)
+{
+    std::vector<unsigned char> stream(2 * 768 * 600, 0x5a);
+    std::vector<unsigned char> even(2 * 768 * 300), odd(2 * 768 * 300);
+    int transferred = -1;
+
+    usb.load(stream);
+    usb.stallNext = true;
+    {
+        DSI::FieldRead even_read(nullptr, even.data(), even.size());
+        DSI::FieldRead odd_read(nullptr, odd.data(), odd.size());
+        EXPECT_EQ(even_read.wait(&transferred), LIBUSB_ERROR_PIPE);
+        EXPECT_EQ(transferred, 0);
+        // downloadImage throws here, the odd field is still queued
+    }
+    EXPECT_EQ(usb.cancelled, 1);
+    // TearDown checks that no transfer was freed before its callback ran
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,271 @@
+/*
+    Weather Radio HTTP polling test
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+// Polls a local HTTP/1.1 mock station through the driver and compares it with the per-request
+// curl handle and the linear raw sensor lookup the driver used before.
+
+#include <gtest/gtest.h>
+
+#include <indiweather.h>
+#include <connectionplugins/connectiontcp.h>
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// Requests are sent through executeCommand directly, without the 5 s Arduino settling handshake
+#define private public
+#define protected public
+#include "weatherradio.h"
+#undef private
+#undef protected
+
+extern std::unique_ptr<WeatherRadio> station_ptr;
+
+// HTTP/1.1 station serving 6 devices with 8 sensors each, one connection at a time
+class StationMock
+{
+    public:
+        static constexpr int Devices = 6, Sensors = 8;
+
+        StationMock()
+        {
+            listener = socket(AF_INET, SOCK_STREAM, 0);
+            struct sockaddr_in address {};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            EXPECT_EQ(bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+            socklen_t length = sizeof(address);
+            getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length);
+            port = std::to_string(ntohs(address.sin_port));
+            listen(listener, 8);
+            thread = std::thread(&StationMock::run, this);
+        }
+
+        ~StationMock()
+        {
+            quit = true;
+            thread.join();
+            close(listener);
+        }
+
+        static std::string device(int d)
+        {
+            return "Device" + std::to_string(d);
+        }
+
+        static std::string sensor(int s)
+        {
+            return "Sensor" + std::to_string(s);
+        }
+
+        // Every value moves with the request count, so stale values are caught
+        static double value(int request, int d, int s)
+        {
+            return request + d * 0.25 + s * 0.03125;
+        }
+
+        std::string body(int request)
+        {
+            std::string json = "{";
+            for (int d = 0; d < Devices; d++)
+            {
+                json += (d ? ",\"" : "\"") + device(d) + "\":{\"init\":true";
+                for (int s = 0; s < Sensors; s++)
+                    json += ",\"" + sensor(s) + "\":" + std::to_string(value(request, d, s));
+                json += "}";
+            }
+            return json + "}\r\n";
+        }
+
+        std::string port;
+        std::atomic<int> connections { 0 };
+        std::atomic<int> requests { 0 };
+
+    private:
+        void run()
+        {
+            while (!quit)
+            {
+                struct pollfd fds = { listener, POLLIN, 0 };
+                if (poll(&fds, 1, 20) <= 0)
+                    continue;
+                int client = accept(listener, nullptr, nullptr);
+                if (client < 0)
+                    continue;
+                connections++;
+                serve(client);
+                close(client);
+            }
+        }
+
+        // Keep-alive: answer requests until the client closes
+        void serve(int client)
+        {
+            std::string input;
+            char buffer[1024];
+            while (!quit)
+            {
+                size_t end = input.find("\r\n\r\n");
+                if (end != std::string::npos)
+                {
+                    input.erase(0, end + 4);
+                    std::string content = body(requests++);
+                    std::string reply = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                                        std::to_string(content.size()) + "\r\n\r\n" + content;
+                    if (write(client, reply.data(), reply.size()) != static_cast<ssize_t>(reply.size()))
+                        return;
+                    continue;
+                }
+                struct pollfd fds = { client, POLLIN, 0 };
+                if (poll(&fds, 1, 20) <= 0)
+                    continue;
+                ssize_t n = read(client, buffer, sizeof(buffer));
+                if (n <= 0)
+                    return;
+                input.append(buffer, n);
+            }
+        }
+
+        int listener { -1 };
+        std::thread thread;
+        std::atomic_bool quit { false };
+};
+
+static size_t AppendBody(void *contents, size_t size, size_t nmemb, void *userp)
+{
+    static_cast<std::string *>(userp)->append(static_cast<char *>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+// What executeCommand did before: a new easy handle for every request
+static bool perRequestPoll(const std::string &url, std::string &response)
+{
+    CURL *curl = curl_easy_init();
+    if (curl == nullptr)
+        return false;
+    response.clear();
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, AppendBody);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_cleanup(curl);
+    return res == CURLE_OK;
+}
+
+// What findRawSensorProperty did before: scan the devices, then IUFindNumber
+static INumber *linearFindRawSensor(std::vector<INumberVectorProperty> &rawDevices, const std::string &device,
+                                    const std::string &sensor)
+{
+    for (auto &deviceProp : rawDevices)
+        if (strcmp(device.c_str(), deviceProp.name) == 0)
+            return IUFindNumber(&deviceProp, sensor.c_str());
+    return nullptr;
+}
+
+class WeatherRadioHTTP : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            strcpy(station_ptr->hostname, "127.0.0.1");
+            strcpy(station_ptr->port, mock.port.c_str());
+        }
+
+        StationMock mock;
+};
+
+TEST_F(WeatherRadioHTTP, ConnectionIsReused)
+{
+    const int polls = 300;
+    std::string url = "http://127.0.0.1:" + mock.port + "/w";
+    std::string response;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < polls; i++)
+        ASSERT_TRUE(perRequestPoll(url, response));
+    double msPerRequest = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / polls;
+    int perRequestConnections = mock.connections.load();
+    EXPECT_EQ(perRequestConnections, polls);
+
+    mock.connections = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < polls; i++)
+        ASSERT_TRUE(station_ptr->executeCommand(WeatherRadio::CMD_WEATHER));
+    double msReused = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / polls;
+    EXPECT_EQ(mock.connections.load(), 1);
+    EXPECT_EQ(mock.requests.load(), 2 * polls);
+
+    // The whole body arrived, not just its last chunk. The line end is cut off in place.
+    std::string body = mock.body(mock.requests.load() - 1);
+    EXPECT_GT(body.size(), 512u);
+    EXPECT_EQ(std::string(station_ptr->httpResponse.c_str()), body.substr(0, body.size() - 1));
+
+    fprintf(stderr, "%d polls, %d devices x %d sensors: per-request handle %.3f ms/request, %d connections; "
+            "reused handle %.3f ms/request, %d connection\n",
+            polls, StationMock::Devices, StationMock::Sensors, msPerRequest, perRequestConnections, msReused, mock.connections.load());
+}
+
+TEST_F(WeatherRadioHTTP, RawSensorIndexMatchesLinearScan)
+{
+    // The first poll creates the devices, the second one updates them through the index
+    ASSERT_TRUE(station_ptr->executeCommand(WeatherRadio::CMD_WEATHER));
+    ASSERT_TRUE(station_ptr->executeCommand(WeatherRadio::CMD_WEATHER));
+    int last = mock.requests.load() - 1;
+    ASSERT_EQ(station_ptr->rawDevices.size(), static_cast<size_t>(StationMock::Devices));
+
+    for (int d = 0; d < StationMock::Devices; d++)
+    {
+        for (int s = 0; s < StationMock::Sensors; s++)
+        {
+            INumber *indexed = station_ptr->findRawSensorProperty({StationMock::device(d), StationMock::sensor(s)});
+            INumber *scanned = linearFindRawSensor(station_ptr->rawDevices, StationMock::device(d), StationMock::sensor(s));
+            ASSERT_NE(indexed, nullptr);
+            EXPECT_EQ(indexed, scanned);
+            EXPECT_NEAR(indexed->value, StationMock::value(last, d, s), 1e-6);
+        }
+        EXPECT_EQ(station_ptr->findRawDeviceProperty(StationMock::device(d).c_str()), &station_ptr->rawDevices[d]);
+        EXPECT_EQ(station_ptr->findRawSensorProperty({StationMock::device(d), "init"}), nullptr);
+    }
+    EXPECT_EQ(station_ptr->findRawSensorProperty({"Unknown", StationMock::sensor(0)}), nullptr);
+    EXPECT_EQ(linearFindRawSensor(station_ptr->rawDevices, "Unknown", StationMock::sensor(0)), nullptr);
+    EXPECT_EQ(station_ptr->findRawDeviceProperty("Unknown"), nullptr);
+}
+
+int main(int argc, char **argv)
+{
+    station_ptr->ISGetProperties(nullptr);
+    // The driver only registers the serial connection, add the HTTP one
+    Connection::TCP *tcp = new Connection::TCP(station_ptr.get());
+    station_ptr->registerConnection(tcp);
+    station_ptr->setActiveConnection(tcp);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
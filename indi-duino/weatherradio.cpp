@@ -36,7 +36,6 @@
 #include "connectionplugins/connectionserial.h"
 #include "indicom.h"
 
-#include "curl/curl.h"
 
 #include "config.h"
 
@@ -70,7 +69,8 @@ std::unique_ptr<WeatherRadio> station_ptr(new WeatherRadio());
 ***************************************************************************************/
 static size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
 {
-    strcpy(static_cast<char *>(userp), static_cast<char *>(contents));
+    // the body may arrive in several chunks, none of them null terminated
+    static_cast<std::string *>(userp)->append(static_cast<char *>(contents), size * nmemb);
     return size * nmemb;
 }
 
@@ -91,6 +91,12 @@ WeatherRadio::WeatherRadio()
     commands[CMD_RESET]    = "r";
 }
 
+WeatherRadio::~WeatherRadio()
+{
+    if (curlHandle != nullptr)
+        curl_easy_cleanup(curlHandle);
+}
+
 /**************************************************************************************
 ** Initialize all properties & set default values.
 **************************************************************************************/
@@ -1006,13 +1012,12 @@ void WeatherRadio::handleWeatherData(JsonValue value)
     JsonIterator deviceIter;
     for (deviceIter = begin(value); deviceIter != end(value); ++deviceIter)
     {
-        char *name {new char[strlen(deviceIter->key) + 1] {0}};
-        strncpy(name, deviceIter->key, static_cast<size_t>(strlen(deviceIter->key)));
+        const char *name = deviceIter->key;
 
         JsonIterator sensorIter;
-        INumberVectorProperty *deviceProp = findRawDeviceProperty(name);
+        auto device = rawDeviceIndex.find(name);
 
-        if (deviceProp == nullptr)
+        if (device == rawDeviceIndex.end())
         {
             // new device found
             std::vector<std::pair<char*, double>> sensorData;
@@ -1052,26 +1057,28 @@ void WeatherRadio::handleWeatherData(JsonValue value)
                         IUFillNumber(&sensors[i], sensorData[i].first, sensorData[i].first, "%.2f", -2000.0, 2000.0, 1., sensorData[i].second);
                 }
                 // create a new number vector for the device
-                deviceProp = new INumberVectorProperty;
+                INumberVectorProperty *deviceProp = new INumberVectorProperty;
                 IUFillNumberVector(deviceProp, sensors, static_cast<int>(sensorData.size()), getDeviceName(), name, name, "Raw Sensors",
                                    IP_RO, 60, IPS_OK);
                 // make it visible
                 if (isConnected())
                     defineProperty(deviceProp);
-                rawDevices.push_back(*deviceProp);
+                addRawDevice(*deviceProp);
             }
         }
         else
         {
+            INumberVectorProperty *deviceProp = &rawDevices[device->second.index];
             deviceProp->s = IPS_IDLE;
             // read all sensor data
             for (sensorIter = begin(deviceIter->value); sensorIter != end(deviceIter->value); ++sensorIter)
             {
                 if (strcmp(sensorIter->key, "init") == 0 || sensorIter->value.getTag() != JSON_NUMBER)
                     continue;
-                INumber *sensor = IUFindNumber(deviceProp, sensorIter->key);
-                if (sensor != nullptr && sensorIter->value.isDouble())
+                auto sensorEntry = device->second.sensors.find(sensorIter->key);
+                if (sensorEntry != device->second.sensors.end() && sensorIter->value.isDouble())
                 {
+                    INumber *sensor = sensorEntry->second;
                     sensor->value = sensorIter->value.toNumber();
                     // update the weather parameter {name, sensorIter->key} to sensorIter->value.toNumber()
                     updateWeatherParameter({name, sensorIter->key}, sensorIter->value.toNumber());
@@ -1261,13 +1268,21 @@ bool WeatherRadio::saveConfigItems(FILE *fp)
 /**************************************************************************************
 ** access to device and sensor INDI properties
 ***************************************************************************************/
+void WeatherRadio::addRawDevice(const INumberVectorProperty &deviceProp)
+{
+    rawDevices.push_back(deviceProp);
+
+    raw_device_entry &entry = rawDeviceIndex[deviceProp.name];
+    entry.index = rawDevices.size() - 1;
+    for (int i = 0; i < deviceProp.nnp; i++)
+        entry.sensors[deviceProp.np[i].name] = &deviceProp.np[i];
+}
+
 INumberVectorProperty *WeatherRadio::findRawDeviceProperty(const char *name)
 {
-    for (size_t i = 0; i < rawDevices.size(); i++)
-    {
-        if (strcmp(name, rawDevices[i].name) == 0)
-            return &rawDevices[i];
-    }
+    auto device = rawDeviceIndex.find(name);
+    if (device != rawDeviceIndex.end())
+        return &rawDevices[device->second.index];
 
     // not found
     return nullptr;
@@ -1275,13 +1290,12 @@ INumberVectorProperty *WeatherRadio::findRawDeviceProperty(const char *name)
 
 INumber *WeatherRadio::findRawSensorProperty(WeatherRadio::sensor_name sensor)
 {
-    INumberVectorProperty *deviceProp = findRawDeviceProperty(sensor.device.c_str());
-
-    INumber *sensorProp = nullptr;
-    if (deviceProp != nullptr)
-        sensorProp = IUFindNumber(deviceProp, sensor.sensor.c_str());
+    auto device = rawDeviceIndex.find(sensor.device);
+    if (device == rawDeviceIndex.end())
+        return nullptr;
 
-    return sensorProp;
+    auto sensorEntry = device->second.sensors.find(sensor.sensor);
+    return sensorEntry != device->second.sensors.end() ? sensorEntry->second : nullptr;
 }
 
 /**************************************************************************************
@@ -1349,28 +1363,41 @@ bool WeatherRadio::executeCommand(wr_command cmd)
     // communication through HTTP, e.g. with a ESP8266 Arduino chip
     else if (getActiveConnection()->type() == Connection::Interface::CONNECTION_TCP)
     {
-        CURL *curl;
         CURLcode res;
         char requestURL[MAXRBUF];
 
         snprintf(requestURL, MAXRBUF, "http://%s:%s/%s", hostname, port, cmdstring.c_str());
 
-        curl = curl_easy_init();
-        if (curl)
+        // the handle keeps its connection cache, so subsequent requests reuse the open connection
+        if (curlHandle == nullptr)
         {
-            curl_easy_setopt(curl, CURLOPT_URL, requestURL);
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
-            res = curl_easy_perform(curl);
-            curl_easy_cleanup(curl);
+            curlHandle = curl_easy_init();
+            if (curlHandle != nullptr)
+            {
+                curl_easy_setopt(curlHandle, CURLOPT_WRITEFUNCTION, WriteCallback);
+                curl_easy_setopt(curlHandle, CURLOPT_WRITEDATA, &httpResponse);
+                curl_easy_setopt(curlHandle, CURLOPT_TCP_KEEPALIVE, 1L);
+            }
+        }
+        if (curlHandle != nullptr)
+        {
+            httpResponse.clear();
+            curl_easy_setopt(curlHandle, CURLOPT_URL, requestURL);
+            res = curl_easy_perform(curlHandle);
             if (res == CURLcode::CURLE_OK)
             {
-                std::stringstream rs (response);
-                std::string line;
-
                 // handle each line separately
-                while(std::getline(rs, line, '\n'))
-                    handleResponse(cmd, line.c_str(), line.length());
+                size_t start = 0;
+                while (start < httpResponse.length())
+                {
+                    size_t stop = httpResponse.find('\n', start);
+                    if (stop == std::string::npos)
+                        stop = httpResponse.length();
+                    else
+                        httpResponse[stop] = '\0';
+                    handleResponse(cmd, httpResponse.c_str() + start, static_cast<int>(stop - start));
+                    start = stop + 1;
+                }
 
                 return true;
             }
@@ -1402,7 +1429,8 @@ void WeatherRadio::handleResponse(wr_command cmd, const char *response, int leng
     if (length == 0 || strcmp(response, "\r\n") == 0 || (response[0] != '[' && response[0] != '{'))
         return;
 
-    char *source{new char[length + 1] {0}};
+    std::unique_ptr<char[]> buffer {new char[length + 1] {0}};
+    char *source = buffer.get();
     // duplicate the buffer since the parser will modify it
     strncpy(source, response, static_cast<size_t>(length));
 
@@ -1553,6 +1581,11 @@ bool WeatherRadio::Connect()
 
 bool WeatherRadio::Disconnect()
 {
+    if (curlHandle != nullptr)
+    {
+        curl_easy_cleanup(curlHandle);
+        curlHandle = nullptr;
+    }
     return INDI::Weather::Disconnect();
 }
 
@@ -25,7 +25,9 @@
 #include <map>
 #include <math.h>
 #include <memory>
+#include <unordered_map>
 
+#include "curl/curl.h"
 #include "gason/gason.h"
 
 #include "indiweather.h"
@@ -38,7 +40,7 @@ class WeatherRadio : public INDI::Weather
 {
   public:
     WeatherRadio();
-    ~WeatherRadio() override = default;
+    ~WeatherRadio() override;
 
     virtual void ISGetProperties(const char *dev) override;
     virtual bool ISNewNumber(const char *dev, const char *name, double values[], char *names[], int n) override;
@@ -129,6 +131,20 @@ protected:
     };
 
     std::vector<INumberVectorProperty> rawDevices;
+    /**
+     * @brief Index of a raw device in rawDevices and its sensors by JSON key.
+     * rawDevices may reallocate, the INumber arrays do not.
+     */
+    struct raw_device_entry
+    {
+        size_t index;
+        std::unordered_map<std::string, INumber *> sensors;
+    };
+    std::unordered_map<std::string, raw_device_entry> rawDeviceIndex;
+    /**
+     * @brief Add a new raw device property and index it by device and sensor name.
+     */
+    void addRawDevice(const INumberVectorProperty &deviceProp);
     /**
      * \brief Find the matching raw device INDI property vector.
     */
@@ -295,6 +311,9 @@ protected:
 
     // send a command to the serial device or by HTTP
     bool executeCommand(wr_command cmd);
+    // HTTP handle kept for the whole connection, so that requests reuse the TCP connection
+    CURL *curlHandle = nullptr;
+    std::string httpResponse;
     // handle one single response line
     void handleResponse(wr_command cmd, const char *response, int length);
     // handle a message from the weather station
@@ -17,6 +17,7 @@
  */
 
 #include <sys/time.h>
+#include <algorithm>
 #include <memory>
 #include <stdint.h>
 #include <arpa/inet.h>
@@ -612,23 +613,22 @@ void FFMVCCD::grabImage()
     dc1394video_frame_t *frame;
     uint32_t uheight, uwidth;
     int sub;
-    uint16_t val;
     struct timeval start, end;
 
-    std::unique_lock<std::mutex> guard(ccdBufferLock);
-    // Let's get a pointer to the frame buffer
-    uint8_t *image = PrimaryCCD.getFrameBuffer();
-
     // Get width and height
     int width  = PrimaryCCD.getSubW() / PrimaryCCD.getBinX();
     int height = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
+    size_t pixels = static_cast<size_t>(width) * height;
 
-    memset(image, 0, PrimaryCCD.getFrameBufferSize());
+    accumulator.assign(pixels, 0);
+    uint32_t *sum = accumulator.data();
 
     /*-----------------------------------------------------------------------
     *  stop data transmission
     *-----------------------------------------------------------------------*/
 
+    // The DMA ring keeps receiving the next sub while this one is summed, so
+    // frames go back to the ring as soon as they have been added.
     gettimeofday(&start, nullptr);
     for (sub = 0; sub < sub_count; ++sub)
     {
@@ -645,27 +645,22 @@ void FFMVCCD::grabImage()
             LOG_ERROR("Corrupt frame!");
             continue;
         }
-        // Fill buffer with random pattern
-        for (int i = 0; i < height; i++)
-        {
-            for (int j = 0; j < width; j++)
-            {
-                /* Detect unsigned overflow */
-                val = ((uint16_t *)image)[i * width + j] + ntohs(((uint16_t *)(frame->image))[i * width + j]);
-                if (val > ((uint16_t *)image)[i * width + j])
-                {
-                    ((uint16_t *)image)[i * width + j] = val;
-                }
-                else
-                {
-                    ((uint16_t *)image)[i * width + j] = 0xFFFF;
-                }
-            }
-        }
+
+        // Pixels are big-endian, 32-bit sums cannot overflow for any realistic sub count
+        const uint16_t *src = reinterpret_cast<const uint16_t *>(frame->image);
+        for (size_t i = 0; i < pixels; i++)
+            sum[i] += ntohs(src[i]);
 
         dc1394_capture_enqueue(dcam, frame);
     }
-    guard.unlock();
+
+    {
+        std::unique_lock<std::mutex> guard(ccdBufferLock);
+        uint16_t *image = reinterpret_cast<uint16_t *>(PrimaryCCD.getFrameBuffer());
+        for (size_t i = 0; i < pixels; i++)
+            image[i] = std::min<uint32_t>(sum[i], UINT16_MAX);
+    }
+
     err = dc1394_video_set_transmission(dcam, DC1394_OFF);
     gettimeofday(&end, nullptr);
     LOGF_DEBUG("Download took %d uS", (int)((end.tv_sec - start.tv_sec) * 1000000 + (end.tv_usec - start.tv_usec)));
@@ -23,6 +23,8 @@
 #include <indiccd.h>
 #include <dc1394/dc1394.h>
 
+#include <vector>
+
 using namespace std;
 
 class FFMVCCD : public INDI::CCD
@@ -66,6 +68,8 @@ class FFMVCCD : public INDI::CCD
     float max_exposure;
     float last_exposure_length;
     int sub_count;
+    // Sum of the sub exposures, saturated into the frame buffer once at the end
+    std::vector<uint32_t> accumulator;
 
     ISwitch GainS[2];
     ISwitchVectorProperty GainSP;
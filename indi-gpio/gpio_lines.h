@@ -0,0 +1,74 @@
+/*******************************************************************************
+  Copyright(c) 2024 Jasem Mutlaq <mutlaqja@ikarustech.com>
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// Line request and edge handling shared by the driver and its tests. The bulk and request
+// types are gpiod::line_bulk and gpiod::line_request in the driver, and fakes in test_gpio.
+namespace GPIOLines
+{
+
+/**
+ * \brief Request lines as outputs, starting at the given levels so connecting does not toggle them.
+ */
+template <typename Request, typename Bulk>
+void requestOutputs(Bulk &lines, const std::vector<int> &defaults)
+{
+    Request config;
+    config.consumer = "indi-gpio";
+    config.request_type = Request::DIRECTION_OUTPUT;
+    lines.request(config, defaults);
+}
+
+/**
+ * \brief Wait for edges on the input lines and report each one as (input index, level, timestamp)
+ * until quit is set. Errors from the lines are thrown to the caller.
+ */
+template <typename Bulk, typename Callback>
+void runEdgeLoop(Bulk &lines, const std::vector<uint8_t> &offsets, const std::atomic_bool &quit,
+                 std::chrono::milliseconds waitTime, Callback onEdge)
+{
+    while (!quit)
+    {
+        auto ready = lines.event_wait(waitTime);
+        for (auto &line : ready)
+        {
+            auto it = std::find(offsets.begin(), offsets.end(), line.offset());
+            if (it == offsets.end())
+                continue;
+            size_t index = std::distance(offsets.begin(), it);
+
+            // Replay every queued edge so pulses shorter than the wait are still reported.
+            for (const auto &event : line.event_read_multiple())
+            {
+                using Event = typename std::decay<decltype(event)>::type;
+                int value = (event.event_type == Event::RISING_EDGE) ? 1 : 0;
+                onEdge(index, value, event.timestamp);
+            }
+        }
+    }
+}
+
+}
@@ -17,8 +17,11 @@
 *******************************************************************************/
 
 #include "indi_gpio.h"
+#include "gpio_lines.h"
 #include "config.h"
 
+#include <chrono>
+
 static class Loader
 {
     public:
@@ -44,7 +47,9 @@ INDIGPIO::INDIGPIO() : INDI::InputInterface(this), INDI::OutputInterface(this)
 ////////////////////////////////////////////////////////////////////////////////////////
 INDIGPIO::~INDIGPIO()
 {
-
+    m_EventThreadQuit = true;
+    if (m_EventThread.joinable())
+        m_EventThread.join();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
@@ -90,10 +95,13 @@ bool INDIGPIO::updateProperties()
 
     if (isConnected())
     {
-    }
-    else
-    {
-
+        // Inputs are defined now, so publish their current state and start listening for edges.
+        UpdateDigitalInputs();
+        if (!m_InputLines.empty() && !m_EventThread.joinable())
+        {
+            m_EventThreadQuit = false;
+            m_EventThread = std::thread(&INDIGPIO::eventThread, this);
+        }
     }
 
 
@@ -182,6 +190,12 @@ bool INDIGPIO::Connect()
         }
     }
 
+    if (!requestLines())
+    {
+        m_GPIO.reset();
+        return false;
+    }
+
     SetTimer(getPollingPeriod());
     return true;
 }
@@ -193,10 +207,109 @@ bool INDIGPIO::Connect()
 ////////////////////////////////////////////////////////////////////////////////////////
 bool INDIGPIO::Disconnect()
 {
-    m_GPIO->reset();
+    m_EventThreadQuit = true;
+    if (m_EventThread.joinable())
+        m_EventThread.join();
+
+    releaseLines();
+    if (m_GPIO)
+        m_GPIO->reset();
     return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////////////
+///
+////////////////////////////////////////////////////////////////////////////////////////
+bool INDIGPIO::requestLines()
+{
+    try
+    {
+        if (!m_InputOffsets.empty())
+        {
+            m_InputLines = m_GPIO->get_lines(std::vector<unsigned int>(m_InputOffsets.begin(), m_InputOffsets.end()));
+            gpiod::line_request config;
+            config.consumer = "indi-gpio";
+            config.request_type = gpiod::line_request::EVENT_BOTH_EDGES;
+            m_InputLines.request(config);
+        }
+
+        if (!m_OutputOffsets.empty())
+        {
+            // Outputs start at the level their switch shows, so they can be driven right away.
+            std::vector<int> defaults;
+            for (size_t i = 0; i < m_OutputOffsets.size(); i++)
+                defaults.push_back(DigitalOutputsSP[i].findOnSwitchIndex() == 1 ? 1 : 0);
+            m_OutputLines = m_GPIO->get_lines(std::vector<unsigned int>(m_OutputOffsets.begin(), m_OutputOffsets.end()));
+            GPIOLines::requestOutputs<gpiod::line_request>(m_OutputLines, defaults);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        LOGF_ERROR("Failed to request GPIO lines: %s", e.what());
+        releaseLines();
+        return false;
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+///
+////////////////////////////////////////////////////////////////////////////////////////
+void INDIGPIO::releaseLines()
+{
+    try
+    {
+        if (!m_InputLines.empty())
+            m_InputLines.release();
+        if (!m_OutputLines.empty())
+            m_OutputLines.release();
+    }
+    catch (const std::exception &e)
+    {
+        LOGF_WARN("Failed to release GPIO lines: %s", e.what());
+    }
+
+    m_InputLines.clear();
+    m_OutputLines.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+///
+////////////////////////////////////////////////////////////////////////////////////////
+void INDIGPIO::eventThread()
+{
+    try
+    {
+        GPIOLines::runEdgeLoop(m_InputLines, m_InputOffsets, m_EventThreadQuit, std::chrono::milliseconds(EVENT_WAIT_MS),
+                               [this](size_t index, int value, std::chrono::nanoseconds timestamp)
+        {
+            LOGF_DEBUG("DI #%zu %s edge at %.6f s", index + 1, value ? "rising" : "falling",
+                       std::chrono::duration<double>(timestamp).count());
+            setDigitalInput(index, value);
+        });
+    }
+    catch (const std::exception &e)
+    {
+        LOGF_ERROR("Failed to read digital input events: %s", e.what());
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+///
+////////////////////////////////////////////////////////////////////////////////////////
+void INDIGPIO::setDigitalInput(size_t index, int value)
+{
+    std::lock_guard<std::mutex> lock(m_InputMutex);
+    if (DigitalInputsSP[index].findOnSwitchIndex() == value)
+        return;
+
+    DigitalInputsSP[index].reset();
+    DigitalInputsSP[index][value].setState(ISS_ON);
+    DigitalInputsSP[index].setState(IPS_OK);
+    DigitalInputsSP[index].apply();
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////////////
 ///
@@ -216,27 +329,15 @@ bool INDIGPIO::saveConfigItems(FILE *fp)
 ////////////////////////////////////////////////////////////////////////////////////////
 bool INDIGPIO::UpdateDigitalInputs()
 {
+    if (m_InputLines.empty())
+        return true;
+
+    // Edges are delivered by the event thread, this only reads the held request to resynchronize.
     try
     {
-        for (size_t i = 0; i < m_InputOffsets.size(); i++)
-        {
-            auto oldState = DigitalInputsSP[i].findOnSwitchIndex();
-            auto line = m_GPIO->get_line(m_InputOffsets[i]);
-
-            gpiod::line_request config;
-            config.consumer = "indi-gpio";
-            config.request_type = gpiod::line_request::DIRECTION_INPUT;
-            line.request(config);
-            auto newState = line.get_value();
-            line.release();
-            if (oldState != newState)
-            {
-                DigitalInputsSP[i].reset();
-                DigitalInputsSP[i][newState].setState(ISS_ON);
-                DigitalInputsSP[i].setState(IPS_OK);
-                DigitalInputsSP[i].apply();
-            }
-        }
+        auto values = m_InputLines.get_values();
+        for (size_t i = 0; i < values.size(); i++)
+            setDigitalInput(i, values[i]);
     }
     catch (const std::exception &e)
     {
@@ -259,29 +360,30 @@ bool INDIGPIO::UpdateAnalogInputs()
 ////////////////////////////////////////////////////////////////////////////////////////
 bool INDIGPIO::UpdateDigitalOutputs()
 {
-    // JM: Looks like we can't read outputs, they have to be set explicitly?
-    // Modern libgpiod 2.0+ has "as-is" direction so maybe that would work.
-    // try
-    // {
-    //     for (size_t i = 0; i < m_OutputOffsets.size(); i++)
-    //     {
-    //         auto oldState = DigitalOutputsSP[i].findOnSwitchIndex();
-    //         auto line = m_GPIO->get_line(m_OutputOffsets[i]);
-    //         auto newState = line.get_value();
-    //         if (oldState != newState)
-    //         {
-    //             DigitalOutputsSP[i].reset();
-    //             DigitalOutputsSP[i][newState].setState(ISS_ON);
-    //             DigitalOutputsSP[i].setState(IPS_OK);
-    //             DigitalOutputsSP[i].apply();
-    //         }
-    //     }
-    // }
-    // catch (const std::exception &e)
-    // {
-    //     LOGF_ERROR("Failed to read digital outputs: %s", e.what());
-    //     return false;
-    // }
+    if (m_OutputLines.empty())
+        return true;
+
+    // Outputs are held as outputs, so the request reads back the level being driven.
+    try
+    {
+        auto values = m_OutputLines.get_values();
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            auto oldState = DigitalOutputsSP[i].findOnSwitchIndex();
+            if (oldState != values[i])
+            {
+                DigitalOutputsSP[i].reset();
+                DigitalOutputsSP[i][values[i]].setState(ISS_ON);
+                DigitalOutputsSP[i].setState(IPS_OK);
+                DigitalOutputsSP[i].apply();
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        LOGF_ERROR("Failed to read digital outputs: %s", e.what());
+        return false;
+    }
     return true;
 }
 
@@ -292,21 +394,13 @@ bool INDIGPIO::CommandOutput(uint32_t index, OutputState command)
 {
     if (index >= m_OutputOffsets.size())
     {
-        LOGF_ERROR("Invalid output index %d. Valid range from 0 to %d.", m_OutputOffsets.size() - 1);
+        LOGF_ERROR("Invalid output index %d. Valid range from 0 to %d.", index, m_OutputOffsets.size() - 1);
         return false;
     }
 
     try
     {
-        // N.B. this was not tested!
-        auto offset = m_OutputOffsets[index];
-        auto line = m_GPIO->get_line(offset);
-        gpiod::line_request config;
-        config.consumer = "indi-gpio";
-        config.request_type = gpiod::line_request::DIRECTION_OUTPUT;
-        line.request(config);
-        line.set_value(command);
-        line.release();
+        m_OutputLines[index].set_value(command);
     }
     catch (const std::exception &e)
     {
@@ -325,7 +419,7 @@ void INDIGPIO::TimerHit()
     if (!isConnected())
         return;
 
-    UpdateDigitalInputs();
+    // Inputs are event driven, see eventThread()
     UpdateDigitalOutputs();
 
     SetTimer(getPollingPeriod());
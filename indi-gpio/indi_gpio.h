@@ -24,6 +24,10 @@
 
 #include <gpiod.hpp>
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 class INDIGPIO : public INDI::DefaultDevice, public INDI::InputInterface, public INDI::OutputInterface
 {
     public:
@@ -76,7 +80,35 @@ class INDIGPIO : public INDI::DefaultDevice, public INDI::InputInterface, public
         virtual void TimerHit() override;
 
     private:
+        /**
+         * \brief Request all configured inputs (both edges) and outputs (driven, starting at their
+         * switch state) in two bulk requests that are held until disconnect.
+         * \return True if successful, false otherwise.
+         */
+        bool requestLines();
+        void releaseLines();
+
+        /**
+         * \brief Wait for edge events on the input lines and publish changes as they arrive.
+         */
+        void eventThread();
+
+        /**
+         * \brief Set digital input to value and send it to clients only if it changed.
+         */
+        void setDigitalInput(size_t index, int value);
+
         INDI::PropertyText ChipNameTP {1};
         std::unique_ptr<gpiod::chip> m_GPIO;
         std::vector<uint8_t> m_InputOffsets, m_OutputOffsets;
+
+        // Line requests held for the life of the connection
+        gpiod::line_bulk m_InputLines, m_OutputLines;
+
+        std::thread m_EventThread;
+        std::atomic_bool m_EventThreadQuit {false};
+        std::mutex m_InputMutex;
+
+        // How long the event thread waits for an edge before checking for shutdown
+        static constexpr const uint32_t EVENT_WAIT_MS {250};
 };
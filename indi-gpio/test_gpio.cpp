@@ -0,0 +1,303 @@
+/*******************************************************************************
+  Copyright(c) 2024 Jasem Mutlaq <mutlaqja@ikarustech.com>
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+// Output requests and the edge loop of indi_gpio against a fake chip that behaves like the
+// kernel: edges queue per line until read, and only lines requested as outputs can be written.
+
+#include <gtest/gtest.h>
+#include <gpio_lines.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+
+struct FakeEvent
+{
+    enum : int
+    {
+        RISING_EDGE = 1,
+        FALLING_EDGE,
+    };
+    std::chrono::nanoseconds timestamp;
+    int event_type;
+};
+
+struct FakeRequest
+{
+    enum : int
+    {
+        DIRECTION_AS_IS = 1,
+        DIRECTION_INPUT,
+        DIRECTION_OUTPUT,
+        EVENT_BOTH_EDGES = 7,
+    };
+    std::string consumer;
+    int request_type {0};
+};
+
+struct FakeChip
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::map<unsigned int, std::vector<FakeEvent>> pending;
+    std::map<unsigned int, int> levels;
+    bool failed {false};
+
+    void edge(unsigned int offset, bool rising, int64_t ns)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending[offset].push_back({ std::chrono::nanoseconds(ns), rising ? FakeEvent::RISING_EDGE : FakeEvent::FALLING_EDGE });
+        cv.notify_all();
+    }
+
+    void fail()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        failed = true;
+        cv.notify_all();
+    }
+};
+
+struct FakeLine
+{
+    FakeChip *chip;
+    unsigned int line;
+    int direction {0};
+
+    unsigned int offset() const
+    {
+        return line;
+    }
+
+    std::vector<FakeEvent> event_read_multiple()
+    {
+        std::lock_guard<std::mutex> lock(chip->mutex);
+        std::vector<FakeEvent> events;
+        events.swap(chip->pending[line]);
+        return events;
+    }
+
+    void set_value(int value)
+    {
+        // The kernel refuses to set lines that are not requested as outputs
+        if (direction != FakeRequest::DIRECTION_OUTPUT)
+            throw std::runtime_error("line not requested as output");
+        std::lock_guard<std::mutex> lock(chip->mutex);
+        chip->levels[line] = value;
+    }
+};
+
+struct FakeBulk
+{
+    FakeChip *chip;
+    std::vector<FakeLine> lines;
+
+    FakeBulk(FakeChip &chip, const std::vector<unsigned int> &offsets) : chip(&chip)
+    {
+        for (auto offset : offsets)
+            lines.push_back({ &chip, offset });
+    }
+
+    FakeLine &operator[](size_t index)
+    {
+        return lines[index];
+    }
+
+    void request(const FakeRequest &config, const std::vector<int> &defaults = std::vector<int>())
+    {
+        std::lock_guard<std::mutex> lock(chip->mutex);
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+            lines[i].direction = config.request_type;
+            if (config.request_type == FakeRequest::DIRECTION_OUTPUT)
+                chip->levels[lines[i].line] = i < defaults.size() ? defaults[i] : 0;
+        }
+    }
+
+    std::vector<FakeLine> event_wait(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(chip->mutex);
+        auto ready = [this]()
+        {
+            std::vector<FakeLine> result;
+            for (auto &line : lines)
+                if (!chip->pending[line.line].empty())
+                    result.push_back(line);
+            return result;
+        };
+        chip->cv.wait_for(lock, timeout, [&]()
+        {
+            return chip->failed || !ready().empty();
+        });
+        if (chip->failed)
+            throw std::runtime_error("event wait failed");
+        return ready();
+    }
+};
+
+typedef std::tuple<size_t, int, int64_t> Edge;
+
+// Runs the edge loop on its own thread, as the driver does, collecting what it reports
+class EdgeThread
+{
+    public:
+        EdgeThread(FakeBulk &lines, const std::vector<uint8_t> &offsets)
+        {
+            thread = std::thread([this, &lines, offsets]()
+            {
+                try
+                {
+                    GPIOLines::runEdgeLoop(lines, offsets, quit, std::chrono::milliseconds(WAIT_MS),
+                                           [this](size_t index, int value, std::chrono::nanoseconds timestamp)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        edges.emplace_back(index, value, timestamp.count());
+                        cv.notify_all();
+                    });
+                }
+                catch (const std::exception &)
+                {
+                    threw = true;
+                }
+            });
+        }
+
+        ~EdgeThread()
+        {
+            stop();
+        }
+
+        std::vector<Edge> waitFor(size_t count)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait_for(lock, std::chrono::seconds(2), [&]()
+            {
+                return edges.size() >= count;
+            });
+            return edges;
+        }
+
+        void stop()
+        {
+            quit = true;
+            if (thread.joinable())
+                thread.join();
+        }
+
+        static constexpr int WAIT_MS {50};
+        std::atomic_bool quit {false};
+        std::atomic_bool threw {false};
+
+    private:
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<Edge> edges;
+};
+
+TEST(GPIO, OutputsAreDrivenFromSwitchState)
+{
+    FakeChip chip;
+    FakeBulk outputs(chip, { 5, 6, 13 });
+    GPIOLines::requestOutputs<FakeRequest>(outputs, { 1, 0, 1 });
+
+    EXPECT_EQ(chip.levels[5], 1);
+    EXPECT_EQ(chip.levels[6], 0);
+    EXPECT_EQ(chip.levels[13], 1);
+
+    outputs[0].set_value(0);
+    outputs[1].set_value(1);
+    EXPECT_EQ(chip.levels[5], 0);
+    EXPECT_EQ(chip.levels[6], 1);
+    EXPECT_EQ(chip.levels[13], 1);
+}
+
+TEST(GPIO, AsIsRequestCannotDriveOutputs)
+{
+    // What the driver used to request, writes are refused
+    FakeChip chip;
+    FakeBulk outputs(chip, { 5 });
+    FakeRequest config;
+    config.request_type = FakeRequest::DIRECTION_AS_IS;
+    outputs.request(config);
+    EXPECT_THROW(outputs[0].set_value(1), std::runtime_error);
+}
+
+TEST(GPIO, EdgeLoopReportsEveryQueuedEdge)
+{
+    FakeChip chip;
+    FakeBulk inputs(chip, { 17, 4, 22 });
+    EdgeThread thread(inputs, { 17, 4, 22 });
+
+    chip.edge(4, true, 100);
+    auto edges = thread.waitFor(1);
+    ASSERT_EQ(edges.size(), 1u);
+    EXPECT_EQ(edges[0], Edge(1, 1, 100));
+
+    // A pulse shorter than the wait is still reported as two edges, in order
+    {
+        std::lock_guard<std::mutex> lock(chip.mutex);
+        chip.pending[22].push_back({ std::chrono::nanoseconds(200), FakeEvent::RISING_EDGE });
+        chip.pending[22].push_back({ std::chrono::nanoseconds(201), FakeEvent::FALLING_EDGE });
+        chip.cv.notify_all();
+    }
+    edges = thread.waitFor(3);
+    ASSERT_EQ(edges.size(), 3u);
+    chip.edge(17, false, 300);
+    chip.edge(9, true, 400);
+    edges = thread.waitFor(4);
+    ASSERT_EQ(edges.size(), 4u);
+    EXPECT_EQ(edges[1], Edge(2, 1, 200));
+    EXPECT_EQ(edges[2], Edge(2, 0, 201));
+    EXPECT_EQ(edges[3], Edge(0, 0, 300));
+}
+
+TEST(GPIO, EdgeLoopStopsWithinOneWait)
+{
+    FakeChip chip;
+    FakeBulk inputs(chip, { 17 });
+    EdgeThread thread(inputs, { 17 });
+
+    auto start = std::chrono::steady_clock::now();
+    thread.stop();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    EXPECT_LE(elapsed.count(), 4 * EdgeThread::WAIT_MS);
+    EXPECT_FALSE(thread.threw);
+}
+
+TEST(GPIO, EdgeLoopThrowsOnLineError)
+{
+    FakeChip chip;
+    FakeBulk inputs(chip, { 17 });
+    EdgeThread thread(inputs, { 17 });
+
+    chip.fail();
+    for (int i = 0; i < 200 && !thread.threw; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_TRUE(thread.threw);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
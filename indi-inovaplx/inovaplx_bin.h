@@ -0,0 +1,77 @@
+/*
+   INDI Driver for i-Nova PLX series
+   Copyright 2013/2014 i-Nova Technologies - Ilia Platone
+
+   Copyright (C) 2017 Jasem Mutlaq (mutlaqja@ikarustech.com)
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <type_traits>
+#include <vector>
+
+/* Raw frames are 8 bit, or 16 bit big-endian */
+template <int Bpp>
+inline uint32_t rawPixel(const unsigned char *row, int x)
+{
+    return Bpp > 1 ? (row[2 * x] << 8) | row[2 * x + 1] : row[x];
+}
+
+/* Bins the region starting at (startX, startY) into outW x outH pixels of binX x binY.
+ * Each output row first sums its binY raw rows column by column, which keeps the inner
+ * loops contiguous, then adds binX columns per pixel and clamps once. BinX is the
+ * compile time bin factor, 0 when only binX is known. */
+template <int Bpp, int BinX>
+void binImage(const unsigned char *raw, int rawW, int startX, int startY, int outW, int outH, int binX,
+              int binY, unsigned char *image)
+{
+    typedef typename std::conditional<(Bpp > 1), uint16_t, uint8_t>::type Out;
+    const uint32_t maxValue = Bpp > 1 ? 0xffff : 0xff;
+    const int bx = BinX ? BinX : binX;
+    const int cols = outW * bx;
+    std::vector<uint32_t> colSum(cols);
+    Out *out = reinterpret_cast<Out *>(image);
+
+    for (int oy = 0; oy < outH; oy++)
+    {
+        const unsigned char *row = raw + ((startY + oy * binY) * rawW + startX) * Bpp;
+        for (int x = 0; x < cols; x++)
+            colSum[x] = rawPixel<Bpp>(row, x);
+        for (int yy = 1; yy < binY; yy++)
+        {
+            row += rawW * Bpp;
+            for (int x = 0; x < cols; x++)
+                colSum[x] += rawPixel<Bpp>(row, x);
+        }
+
+        for (int ox = 0; ox < outW; ox++)
+        {
+            uint32_t t = 0;
+            for (int xx = 0; xx < bx; xx++)
+                t += colSum[ox * bx + xx];
+            *out++ = static_cast<Out>(t < maxValue ? t : maxValue);
+        }
+    }
+}
+
+template <int Bpp>
+void binImage(const unsigned char *raw, int rawW, int startX, int startY, int outW, int outH, int binX,
+              int binY, unsigned char *image)
+{
+    switch (binX)
+    {
+        case 1:
+            binImage<Bpp, 1>(raw, rawW, startX, startY, outW, outH, binX, binY, image);
+            break;
+        case 2:
+            binImage<Bpp, 2>(raw, rawW, startX, startY, outW, outH, binX, binY, image);
+            break;
+        case 4:
+            binImage<Bpp, 4>(raw, rawW, startX, startY, outW, outH, binX, binY, image);
+            break;
+        default:
+            binImage<Bpp, 0>(raw, rawW, startX, startY, outW, outH, binX, binY, image);
+            break;
+    }
+}
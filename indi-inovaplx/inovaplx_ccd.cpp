@@ -9,6 +9,7 @@
 #include <sys/file.h>
 #include <memory>
 #include "inovaplx_ccd.h"
+#include "inovaplx_bin.h"
 
 int timerNS = -1;
 int timerWE = -1;
@@ -376,7 +377,6 @@ void INovaCCD::grabImage()
     if(image != nullptr)
     {
         int Bpp = iNovaSDK_GetDataWide() > 0 ? 2 : 1;
-        int p = 0;
 
         int binX = PrimaryCCD.getBinX();
         int binY = PrimaryCCD.getBinY();
@@ -389,38 +389,14 @@ void INovaCCD::grabImage()
         endX = (endX > maxW ? maxW : endX);
         endY = (endY > maxH ? maxH : endY);
 
-        for(int y = startY; y < endY; y += binY)
-        {
-            if(endY - y < binY)
-                break;
-            for(int x = startX * Bpp; x < endX * Bpp; x += Bpp * binX)
-            {
-                if(endX * Bpp - x < binX * Bpp)
-                    break;
-                int t = 0;
-                for(int yy = y; yy < y + binY; yy++)
-                {
-                    for(int xx = x; xx < x + Bpp * binX; xx += Bpp)
-                    {
-                        if(Bpp > 1)
-                        {
-                            t += RawData[1 + xx + yy * maxW * Bpp] + (RawData[xx + yy * maxW * Bpp] << 8);
-                            t = (t < 0xffff ? t : 0xffff);
-                        }
-                        else
-                        {
-                            t += RawData[xx + yy * maxW * Bpp];
-                            t = (t < 0xff ? t : 0xff);
-                        }
-                    }
-                }
-                image[p++] = (unsigned char)(t & 0xff);
-                if(Bpp > 1)
-                {
-                    image[p++] = (unsigned char)((t >> 8) & 0xff);
-                }
-            }
-        }
+        // Partial bins at the right and bottom edges are dropped
+        int outW = endX > startX ? (endX - startX) / binX : 0;
+        int outH = endY > startY ? (endY - startY) / binY : 0;
+
+        if(Bpp > 1)
+            binImage<2>(RawData, maxW, startX, startY, outW, outH, binX, binY, image);
+        else
+            binImage<1>(RawData, maxW, startX, startY, outW, outH, binX, binY, image);
         guard.unlock();
         // Let INDI::CCD know we're done filling the image buffer
         LOG_INFO("Download complete.");
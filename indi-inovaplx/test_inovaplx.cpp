@@ -0,0 +1,152 @@
+/*
+   Golden tests and timing of the iNova PLX frame binning, against the per pixel
+   loop grabImage used before binImage.
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "inovaplx_bin.h"
+
+/* The binning loop grabImage used before, returns the number of bytes written */
+static int oldBinImage(const unsigned char *RawData, int Bpp, int binX, int binY, int startX, int startY, int subW,
+                       int subH, int maxW, int maxH, unsigned char *image)
+{
+    int p = 0;
+    int endX = startX + subW;
+    int endY = startY + subH;
+    endX = (endX > maxW ? maxW : endX);
+    endY = (endY > maxH ? maxH : endY);
+
+    for(int y = startY; y < endY; y += binY)
+    {
+        if(endY - y < binY)
+            break;
+        for(int x = startX * Bpp; x < endX * Bpp; x += Bpp * binX)
+        {
+            if(endX * Bpp - x < binX * Bpp)
+                break;
+            int t = 0;
+            for(int yy = y; yy < y + binY; yy++)
+            {
+                for(int xx = x; xx < x + Bpp * binX; xx += Bpp)
+                {
+                    if(Bpp > 1)
+                    {
+                        t += RawData[1 + xx + yy * maxW * Bpp] + (RawData[xx + yy * maxW * Bpp] << 8);
+                        t = (t < 0xffff ? t : 0xffff);
+                    }
+                    else
+                    {
+                        t += RawData[xx + yy * maxW * Bpp];
+                        t = (t < 0xff ? t : 0xff);
+                    }
+                }
+            }
+            image[p++] = (unsigned char)(t & 0xff);
+            if(Bpp > 1)
+                image[p++] = (unsigned char)((t >> 8) & 0xff);
+        }
+    }
+    return p;
+}
+
+/* The ROI clipping of grabImage around binImage */
+static int newBinImage(const unsigned char *raw, int Bpp, int binX, int binY, int startX, int startY, int subW,
+                       int subH, int maxW, int maxH, unsigned char *image)
+{
+    int endX = startX + subW;
+    int endY = startY + subH;
+    endX = (endX > maxW ? maxW : endX);
+    endY = (endY > maxH ? maxH : endY);
+
+    int outW = endX > startX ? (endX - startX) / binX : 0;
+    int outH = endY > startY ? (endY - startY) / binY : 0;
+
+    if(Bpp > 1)
+        binImage<2>(raw, maxW, startX, startY, outW, outH, binX, binY, image);
+    else
+        binImage<1>(raw, maxW, startX, startY, outW, outH, binX, binY, image);
+    return outW * outH * Bpp;
+}
+
+/* Dark frames with some saturated pixels, so that both the sums and the clamping are exercised */
+static std::vector<unsigned char> makeFrame(int width, int height, bool bright)
+{
+    std::vector<unsigned char> raw(width * height * 2);
+    for(auto &c : raw)
+        c = bright ? rand() : (rand() % 4 == 0 ? 0xff : rand() % 64);
+    return raw;
+}
+
+static void compareBinning(int Bpp, bool bright)
+{
+    const int W = 37, H = 29;
+    std::vector<unsigned char> raw = makeFrame(W, H, bright);
+
+    for(int binX = 1; binX <= 4; binX++)
+        for(int binY = 1; binY <= 4; binY++)
+            for(int startX = 0; startX < W; startX += 3)
+                for(int startY = 0; startY < H; startY += 4)
+                    for(int subW : { 1, 5, 16, W })
+                        for(int subH : { 1, 7, H })
+                        {
+                            std::vector<unsigned char> expected(W * H * 2 + 16, 0xcd), image(expected.size(), 0xcd);
+                            int n = oldBinImage(raw.data(), Bpp, binX, binY, startX, startY, subW, subH, W, H,
+                                                expected.data());
+                            ASSERT_EQ(newBinImage(raw.data(), Bpp, binX, binY, startX, startY, subW, subH, W, H,
+                                                  image.data()), n);
+                            ASSERT_TRUE(image == expected) << Bpp * 8 << " bit, bin " << binX << "x" << binY
+                                                           << ", ROI " << subW << "x" << subH << " at (" << startX
+                                                           << "," << startY << ")";
+                        }
+}
+
+TEST(INovaBinImage, Golden8Bit)
+{
+    srand(1);
+    compareBinning(1, false);
+    compareBinning(1, true);
+}
+
+TEST(INovaBinImage, Golden16Bit)
+{
+    srand(2);
+    compareBinning(2, false);
+    compareBinning(2, true);
+}
+
+TEST(INovaBinImage, Throughput)
+{
+    const int W = 1392, H = 1040, rounds = 20;
+    std::vector<unsigned char> raw = makeFrame(W, H, true);
+    std::vector<unsigned char> image(W * H * 2);
+
+    for(int Bpp = 1; Bpp <= 2; Bpp++)
+        for(int bin : { 1, 2, 3, 4 })
+        {
+            double oldTime = 1e9, newTime = 1e9;
+            for(int r = 0; r < rounds; r++)
+            {
+                auto start = std::chrono::steady_clock::now();
+                oldBinImage(raw.data(), Bpp, bin, bin, 0, 0, W, H, W, H, image.data());
+                oldTime = std::min(oldTime, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+                start = std::chrono::steady_clock::now();
+                newBinImage(raw.data(), Bpp, bin, bin, 0, 0, W, H, W, H, image.data());
+                newTime = std::min(newTime, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
+            printf("%d bit %dx%d bin of %dx%d: old %.2f ms, binImage %.2f ms\n", Bpp * 8, bin, bin, W, H,
+                   oldTime * 1e3, newTime * 1e3);
+        }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
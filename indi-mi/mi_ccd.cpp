@@ -22,6 +22,7 @@
 */
 
 #include "mi_ccd.h"
+#include "mi_orient.h"
 
 #include "config.h"
 
@@ -591,26 +592,6 @@ float MICCD::calcTimeLeft()
     return ExposureRequest - timesince / 1000.0;
 }
 
-static void mirror_image(void *buf, size_t w, size_t d)
-{
-    size_t w2     = w * 2;
-    size_t half_d = d / 2;
-
-    for (size_t line = 1; line <= half_d; line++)
-    {
-        uint16_t *sa = (uint16_t *)((char *)buf + (line - 1) * w2);
-        uint16_t *da = (uint16_t *)((char *)buf + (d - line) * w2);
-        for (size_t index = 1; index <= w; index++)
-        {
-            uint16_t tmp = *sa;
-            *sa          = *da;
-            *da          = tmp;
-            ++sa;
-            ++da;
-        }
-    }
-}
-
 /* Downloads the image from the CCD. */
 int MICCD::grabImage()
 {
@@ -639,7 +620,7 @@ int MICCD::grabImage()
         }
         else
         {
-            mirror_image(image, width, height);
+            orient_image(reinterpret_cast<uint16_t *>(image), width, height, ORIENT_FLIP_V | ORIENT_FROM_CAMERA);
         }
     }
 
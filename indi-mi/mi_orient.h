@@ -0,0 +1,132 @@
+/*
+ Moravian Instruments INDI Driver
+
+ Copyright (C) 2014 Jasem Mutlaq (mutlaqja@ikarustech.com)
+ Copyright (C) 2014 Zhirong Li (lzr@qhyccd.com)
+ Copyright (C) 2015 Peter Polakovic (peter.polakovic@cloudmakers.eu)
+ Copyright (C) 2016 Jakub Smutny (linux@gxccd.com)
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/* Orientation applied to downloaded frames, the camera sends the bottom line first */
+enum
+{
+    ORIENT_FLIP_V     = 1 << 0,
+    ORIENT_FLIP_H     = 1 << 1,
+    ORIENT_ROTATE_180 = ORIENT_FLIP_V | ORIENT_FLIP_H,
+    ORIENT_SWAP_BYTES = 1 << 2
+};
+
+/* The camera sends little-endian pixels */
+static constexpr int ORIENT_FROM_CAMERA = __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ ? ORIENT_SWAP_BYTES : 0;
+
+#define ORIENT_MIN_PIXELS_PER_THREAD (1 << 20)
+
+template <bool swapBytes>
+static inline uint16_t pixel_order(uint16_t v)
+{
+    return swapBytes ? __builtin_bswap16(v) : v;
+}
+
+/* Exchange lines a and b, which may be the same line, in one pass */
+template <bool flipH, bool swapBytes>
+static void orient_lines(uint16_t *a, uint16_t *b, size_t w)
+{
+    if (a == b)
+    {
+        if (flipH)
+        {
+            for (size_t i = 0; i < w / 2; i++)
+            {
+                uint16_t tmp = a[i];
+                a[i]         = pixel_order<swapBytes>(a[w - 1 - i]);
+                a[w - 1 - i] = pixel_order<swapBytes>(tmp);
+            }
+            if (w % 2)
+                a[w / 2] = pixel_order<swapBytes>(a[w / 2]);
+        }
+        else if (swapBytes)
+        {
+            for (size_t i = 0; i < w; i++)
+                a[i] = pixel_order<swapBytes>(a[i]);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < w; i++)
+    {
+        size_t j     = flipH ? w - 1 - i : i;
+        uint16_t tmp = a[i];
+        a[i]         = pixel_order<swapBytes>(b[j]);
+        b[j]         = pixel_order<swapBytes>(tmp);
+    }
+}
+
+template <bool swapBytes>
+static void orient_range(uint16_t *buf, size_t w, size_t h, bool flipV, bool flipH, size_t first, size_t last)
+{
+    for (size_t line = first; line < last; line++)
+    {
+        uint16_t *a = buf + line * w;
+        uint16_t *b = flipV ? buf + (h - 1 - line) * w : a;
+        if (flipH)
+            orient_lines<true, swapBytes>(a, b, w);
+        else
+            orient_lines<false, swapBytes>(a, b, w);
+    }
+}
+
+/* Flips the frame in place and swaps the pixel bytes when asked to. Each line is read
+ * and written once, and large frames are split by line across at most maxThreads threads. */
+static void orient_image(uint16_t *buf, size_t w, size_t h, int orientation,
+                         unsigned int maxThreads = std::thread::hardware_concurrency())
+{
+    bool flipV     = orientation & ORIENT_FLIP_V;
+    bool flipH     = orientation & ORIENT_FLIP_H;
+    bool swapBytes = orientation & ORIENT_SWAP_BYTES;
+
+    if (!flipV && !flipH && !swapBytes)
+        return;
+
+    // With a vertical flip each job is a pair of lines, the middle line pairs with itself
+    size_t jobs = flipV ? (h + 1) / 2 : h;
+    auto orient = [ = ](size_t first, size_t last)
+    {
+        if (swapBytes)
+            orient_range<true>(buf, w, h, flipV, flipH, first, last);
+        else
+            orient_range<false>(buf, w, h, flipV, flipH, first, last);
+    };
+
+    size_t threads = std::min<size_t>(std::max(1u, maxThreads),
+                                      std::max<size_t>(1, w * h / ORIENT_MIN_PIXELS_PER_THREAD));
+    size_t chunk   = (jobs + threads - 1) / threads;
+
+    std::vector<std::thread> workers;
+    for (size_t first = chunk; first < jobs; first += chunk)
+        workers.emplace_back(orient, first, std::min(first + chunk, jobs));
+    orient(0, std::min(chunk, jobs));
+    for (auto &worker : workers)
+        worker.join();
+}
@@ -0,0 +1,176 @@
+/*
+ Tests of the orientation pass applied to Moravian Instruments frames, with the
+ throughput of the flips against the vertical mirror the driver used before.
+*/
+
+#include "mi_orient.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/* The vertical mirror grabImage used before orient_image */
+static void mirror_image(void *buf, size_t w, size_t d)
+{
+    size_t w2     = w * 2;
+    size_t half_d = d / 2;
+
+    for (size_t line = 1; line <= half_d; line++)
+    {
+        uint16_t *sa = (uint16_t *)((char *)buf + (line - 1) * w2);
+        uint16_t *da = (uint16_t *)((char *)buf + (d - line) * w2);
+        for (size_t index = 1; index <= w; index++)
+        {
+            uint16_t tmp = *sa;
+            *sa          = *da;
+            *da          = tmp;
+            ++sa;
+            ++da;
+        }
+    }
+}
+
+static std::vector<uint16_t> makeFrame(size_t w, size_t h)
+{
+    std::vector<uint16_t> frame(w * h);
+    for (size_t i = 0; i < frame.size(); i++)
+        frame[i] = i * 2654435761u >> 16;
+    return frame;
+}
+
+/* Checks every pixel of 'frame' against where orientation should have taken it from 'src' */
+static void checkOrientation(const std::vector<uint16_t> &src, const std::vector<uint16_t> &frame, size_t w,
+                             size_t h, int orientation)
+{
+    for (size_t y = 0; y < h; y++)
+    {
+        for (size_t x = 0; x < w; x++)
+        {
+            size_t sy  = (orientation & ORIENT_FLIP_V) ? h - 1 - y : y;
+            size_t sx  = (orientation & ORIENT_FLIP_H) ? w - 1 - x : x;
+            uint16_t v = src[sy * w + sx];
+            if (orientation & ORIENT_SWAP_BYTES)
+                v = (v >> 8) | (v << 8);
+            ASSERT_EQ(frame[y * w + x], v) << w << "x" << h << " orientation " << orientation << " at (" << x
+                                           << "," << y << ")";
+        }
+    }
+}
+
+static const size_t frameSizes[][2] = { { 1, 1 }, { 1, 6 }, { 6, 1 }, { 2, 2 }, { 3, 3 }, { 7, 5 }, { 8, 8 },
+                                        { 101, 63 }, { 640, 481 } };
+
+TEST(MIOrient, AllOrientations)
+{
+    for (auto &size : frameSizes)
+    {
+        size_t w = size[0], h = size[1];
+        std::vector<uint16_t> src = makeFrame(w, h);
+
+        // Every combination of flips, with and without the byte swap
+        for (int orientation = 0; orientation <= (ORIENT_ROTATE_180 | ORIENT_SWAP_BYTES); orientation++)
+        {
+            std::vector<uint16_t> frame = src;
+            orient_image(frame.data(), w, h, orientation);
+            checkOrientation(src, frame, w, h, orientation);
+        }
+    }
+}
+
+TEST(MIOrient, RotateTwiceRestores)
+{
+    std::vector<uint16_t> src = makeFrame(333, 211);
+    std::vector<uint16_t> frame = src;
+
+    orient_image(frame.data(), 333, 211, ORIENT_ROTATE_180 | ORIENT_SWAP_BYTES);
+    orient_image(frame.data(), 333, 211, ORIENT_ROTATE_180 | ORIENT_SWAP_BYTES);
+    ASSERT_TRUE(frame == src);
+}
+
+TEST(MIOrient, MatchesMirrorImage)
+{
+    for (auto &size : frameSizes)
+    {
+        size_t w = size[0], h = size[1];
+        std::vector<uint16_t> expected = makeFrame(w, h);
+        std::vector<uint16_t> frame    = expected;
+
+        mirror_image(expected.data(), w, h);
+        orient_image(frame.data(), w, h, ORIENT_FLIP_V);
+        ASSERT_TRUE(frame == expected) << w << "x" << h;
+    }
+}
+
+TEST(MIOrient, SplitAcrossThreads)
+{
+    // Large enough for four threads, with an odd height so that one job is the middle line alone
+    const size_t w = 2048, h = 2049;
+    std::vector<uint16_t> src = makeFrame(w, h);
+
+    for (unsigned int threads : { 1u, 2u, 3u, 4u })
+    {
+        for (int orientation : { (int)ORIENT_FLIP_V, (int)ORIENT_FLIP_H, (int)ORIENT_ROTATE_180,
+                                 ORIENT_FLIP_V | ORIENT_SWAP_BYTES, (int)ORIENT_SWAP_BYTES })
+        {
+            std::vector<uint16_t> frame = src;
+            orient_image(frame.data(), w, h, orientation, threads);
+            checkOrientation(src, frame, w, h, orientation);
+        }
+    }
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+TEST(MIOrient, Throughput)
+{
+    // A 60 MP frame, the size of the largest C5 sensor
+    const size_t w = 9576, h = 6388;
+    const int rounds = 3;
+    std::vector<uint16_t> frame = makeFrame(w, h);
+    const double gb = 2.0 * frame.size() * sizeof(uint16_t) / 1e9;
+
+    double mirror = 1e9;
+    for (int r = 0; r < rounds; r++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        mirror_image(frame.data(), w, h);
+        mirror = std::min(mirror, secondsSince(start));
+    }
+    printf("%zux%zu mirror_image: %.1f ms (%.1f GB/s)\n", w, h, mirror * 1e3, gb / mirror);
+
+    const struct
+    {
+        const char *name;
+        int orientation;
+    } passes[] =
+    {
+        { "flip V", ORIENT_FLIP_V },
+        { "flip V, swap bytes", ORIENT_FLIP_V | ORIENT_SWAP_BYTES },
+        { "flip H", ORIENT_FLIP_H },
+        { "rotate 180", ORIENT_ROTATE_180 },
+    };
+    for (const auto &pass : passes)
+    {
+        double best = 1e9;
+        for (int r = 0; r < rounds; r++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            orient_image(frame.data(), w, h, pass.orientation);
+            best = std::min(best, secondsSince(start));
+        }
+        printf("%zux%zu orient_image %s: %.1f ms (%.1f GB/s, %u threads)\n", w, h, pass.name, best * 1e3,
+               gb / best, std::thread::hardware_concurrency());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -26,12 +26,13 @@
  Boston, MA 02110-1301, USA.
 *******************************************************************************/
 #include "nex_dome.h"
+#include "nex_dome_parser.h"
 
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
 #include <memory>
-#include <regex>
+#include <sstream>
 #include <termios.h>
 
 #include <indicom.h>
@@ -591,7 +592,7 @@ bool NexDome::Sync(double az)
 ///////////////////////////////////////////////////////////////////////////////
 void NexDome::TimerHit()
 {
-    std::string response;
+    char response[ND::DRIVER_LEN] = {0};
 
     if (checkEvents(response))
         processEvent(response);
@@ -600,14 +601,14 @@ void NexDome::TimerHit()
     {
         std::string value;
         if (getParameter(ND::REPORT, ND::ROTATOR, value))
-            processEvent(value);
+            processEvent(value.c_str());
     }
 
     if (HasShutter() && getShutterState() == SHUTTER_MOVING)
     {
         std::string value;
         if (getParameter(ND::POSITION, ND::SHUTTER, value))
-            processEvent(value);
+            processEvent(value.c_str());
     }
 
 
@@ -821,13 +822,13 @@ bool NexDome::getStartupValues()
 
     // Rotator State
     if (getParameter(ND::REPORT, ND::ROTATOR, value))
-        processEvent(value);
+        processEvent(value.c_str());
 
     // Shutter State
     if (HasShutter())
     {
         if (getParameter(ND::REPORT, ND::SHUTTER, value))
-            processEvent(value);
+            processEvent(value.c_str());
     }
 
     if (InitPark())
@@ -917,53 +918,53 @@ bool NexDome::executeFactoryCommand(uint8_t command, ND::Targets target)
 bool NexDome::getParameter(ND::Commands command, ND::Targets target, std::string &value)
 {
     char res[ND::DRIVER_LEN] = {0};
+    char cmd[ND::DRIVER_LEN] = {0};
+    char key[ND::DRIVER_LEN] = {0};
+    char match[ND::DRIVER_LEN] = {0};
     bool response_found = false;
 
-    std::string verb = ND::CommandsMap.at(command) + "R";
-
-    std::ostringstream cmd;
-    // Magic start character
-    cmd << "@";
-    // Command verb
-    cmd << verb;
+    const std::string &verb = ND::CommandsMap.at(command);
     // Target (Rotator or Shutter)
-    cmd << ((target == ND::ROTATOR) ? "R" : "S");
+    char target_char = (target == ND::ROTATOR) ? 'R' : 'S';
 
-    if (sendCommand(cmd.str().c_str(), res))
-    {
-        std::string response(res);
+    // Magic start character, command verb with the read (R) suffix and the target
+    snprintf(cmd, ND::DRIVER_LEN, "@%sR%c", verb.c_str(), target_char);
+
+    // Firmware is exception since the response does not include the target
+    // for everything else, the echo back includes the target.
+    if (command != ND::SEMANTIC_VERSION)
+        snprintf(key, ND::DRIVER_LEN, "%sR%c", verb.c_str(), target_char);
+    else
+        snprintf(key, ND::DRIVER_LEN, "%sR", verb.c_str());
 
+    if (sendCommand(cmd, res))
+    {
         // Since we can get many unrelated responses from the firmware
         // i.e. events, we need to parse all responses, and see which
-        // one is related to our get command.
-        std::vector<std::string> all = split(response, "\r\n");
-
-        // Let's find our match using this regex
-        std::regex re;
-
-        // Firmware is exception since the response does not include the target
-        // for everything else, the echo back includes the target.
-        if (command != ND::SEMANTIC_VERSION)
-            re = (verb + ((target == ND::ROTATOR) ? "R" : "S") + "([^#]+)");
-        else
-            re = (verb + "([^#]+)");
-
-        std::smatch match;
-
-        // Not iterate over all responses
-        for (auto &oneEvent : all)
+        // one is related to our get command. Lines are split in place.
+        char *line = res;
+        while (line != nullptr)
         {
-            std::string trimmedEvent = trim(oneEvent);
+            char *next = strstr(line, "\r\n");
+            if (next != nullptr)
+            {
+                *next = '\0';
+                next += 2;
+            }
+
+            char *oneEvent = ND::trim(line);
 
             // If we find the match, tag it.
-            if (std::regex_search(trimmedEvent, match, re))
+            if (ND::matchEvent(oneEvent, key, strlen(key), match))
             {
-                value = match.str(1);
+                value = match;
                 response_found = true;
             }
             // Otherwise process the event
             else
-                processEvent(trimmedEvent);
+                processEvent(oneEvent);
+
+            line = next;
         }
     }
 
@@ -973,20 +974,22 @@ bool NexDome::getParameter(ND::Commands command, ND::Targets target, std::string
 //////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////
-bool NexDome::checkEvents(std::string &response)
+bool NexDome::checkEvents(char *response)
 {
     int nbytes_read = 0;
-    char res[ND::DRIVER_LEN] = {0};
 
-    int rc = tty_nread_section(PortFD, res, ND::DRIVER_LEN, ND::DRIVER_EVENT_CHAR, ND::DRIVER_EVENT_TIMEOUT, &nbytes_read);
+    int rc = tty_nread_section(PortFD, response, ND::DRIVER_LEN - 1, ND::DRIVER_EVENT_CHAR, ND::DRIVER_EVENT_TIMEOUT,
+                               &nbytes_read);
 
     if (rc != TTY_OK || nbytes_read < 3)
         return false;
 
-    std::string raw_response = res;
+    response[nbytes_read] = '\0';
 
     // Trim
-    response = trim(raw_response);
+    char *trimmed = ND::trim(response);
+    if (trimmed != response)
+        memmove(response, trimmed, strlen(trimmed) + 1);
 
     return true;
 }
@@ -994,32 +997,26 @@ bool NexDome::checkEvents(std::string &response)
 //////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////
-bool NexDome::processEvent(const std::string &event)
+bool NexDome::processEvent(const char *event)
 {
+    char value[ND::DRIVER_LEN] = {0};
+
     for (const auto &kv : ND::EventsMap)
     {
-        std::regex re(kv.second + "([^#]+)");
-        std::smatch match;
-        std::string value;
-
-        if (event == kv.second)
-            value = event;
-        else if (std::regex_search(event, match, re))
-            value = match.str(1);
-        else
+        if (!ND::matchEvent(event, kv.second.c_str(), kv.second.size(), value))
             continue;
 
-        LOGF_DEBUG("Processing event <%s> with value <%s>", event.c_str(), value.c_str());
+        LOGF_DEBUG("Processing event <%s> with value <%s>", event, value);
 
         switch (kv.first)
         {
             case ND::XBEE_STATE:
-                if (!m_ShutterConnected && value == "Online")
+                if (!m_ShutterConnected && strcmp(value, "Online") == 0)
                 {
                     m_ShutterConnected = true;
                     LOG_INFO("Shutter is connected.");
                 }
-                else if (m_ShutterConnected && value != "Online")
+                else if (m_ShutterConnected && strcmp(value, "Online") != 0)
                 {
                     m_ShutterConnected = false;
                     LOG_WARN("Lost connection to the shutter!");
@@ -1028,37 +1025,30 @@ bool NexDome::processEvent(const std::string &event)
 
             case ND::ROTATOR_POSITION:
             {
-                try
-                {
-                    // 153 = full_steps_circumference / 360 = 55080 / 360
-                    double newAngle = range360(std::stoi(value) / StepsPerDegree);
-                    if (std::abs(DomeAbsPosNP[0].getValue() - newAngle) > 0.001)
-                    {
-                        DomeAbsPosNP[0].setValue(newAngle);
-                        DomeAbsPosNP.apply();
-                    }
-                }
-                catch (...)
-                {
+                int32_t steps = 0;
+                if (!ND::parseInt(value, steps))
                     return false;
+
+                // 153 = full_steps_circumference / 360 = 55080 / 360
+                double newAngle = range360(steps / StepsPerDegree);
+                if (std::abs(DomeAbsPosNP[0].getValue() - newAngle) > 0.001)
+                {
+                    DomeAbsPosNP[0].setValue(newAngle);
+                    DomeAbsPosNP.apply();
                 }
             }
             return true;
 
             case ND::SHUTTER_POSITION:
             {
-                try
-                {
-                    int32_t position = std::stoi(value);
-                    if (std::abs(position - ShutterSyncNP[0].getValue()) > 0)
-                    {
-                        ShutterSyncNP[0].setValue(position);
-                        ShutterSyncNP.apply();
-                    }
-                }
-                catch (...)
-                {
+                int32_t position = 0;
+                if (!ND::parseInt(value, position))
                     return false;
+
+                if (std::abs(position - ShutterSyncNP[0].getValue()) > 0)
+                {
+                    ShutterSyncNP[0].setValue(position);
+                    ShutterSyncNP.apply();
                 }
             }
             return true;
@@ -1113,27 +1103,24 @@ bool NexDome::processEvent(const std::string &event)
 
             case ND::SHUTTER_BATTERY:
             {
-                try
-                {
-                    uint32_t battery_adu = std::stoul(value);
-                    double vref = battery_adu * ND::ADU_TO_VREF;
-                    if (std::fabs(vref - ShutterBatteryLevelNP[0].getValue()) > 0.01)
-                    {
-                        ShutterBatteryLevelNP[0].setValue(vref);
-                        // TODO: Must check if batter is OK, warning, or in critical level
-                        ShutterBatteryLevelNP.setState(IPS_OK);
-                        ShutterBatteryLevelNP.apply();
-                    }
-                }
-                catch(...)
-                {
+                unsigned long adu = 0;
+                if (!ND::parseULong(value, adu))
                     return false;
+
+                uint32_t battery_adu = adu;
+                double vref = battery_adu * ND::ADU_TO_VREF;
+                if (std::fabs(vref - ShutterBatteryLevelNP[0].getValue()) > 0.01)
+                {
+                    ShutterBatteryLevelNP[0].setValue(vref);
+                    // TODO: Must check if batter is OK, warning, or in critical level
+                    ShutterBatteryLevelNP.setState(IPS_OK);
+                    ShutterBatteryLevelNP.apply();
                 }
             }
             break;
 
             default:
-                LOGF_DEBUG("Unhandled event: %s", value.c_str());
+                LOGF_DEBUG("Unhandled event: %s", value);
                 break;
         }
     }
@@ -1144,101 +1131,101 @@ bool NexDome::processEvent(const std::string &event)
 //////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////
-bool NexDome::processRotatorReport(const std::string &report)
+bool NexDome::processRotatorReport(const char *report)
 {
-    std::regex re(R"((\d+),(\d+),(\d+),(\d+),(\d+))");
-    std::smatch match;
-    if (std::regex_search(report, match, re))
+    // position,at_home,circumference,home_position,dead_zone
+    const char *fields[5] = {nullptr};
+    if (ND::scanFields(report, false, fields, 5))
     {
-        try
+        unsigned long values[5] = {0};
+        for (int i = 0; i < 5; i++)
         {
-            uint32_t position = std::stoul(match.str(1));
-            uint32_t at_home = std::stoul(match.str(2));
-            uint32_t cirumference = std::stoul(match.str(3));
-            uint32_t home_position = std::stoul(match.str(4));
-            uint32_t dead_zone = std::stoul(match.str(5));
+            if (!ND::parseULong(fields[i], values[i]))
+                return false;
+        }
 
-            double newStepsPerDegree = cirumference / 360.0;
-            if (std::abs(newStepsPerDegree - StepsPerDegree) > 0.01)
-                StepsPerDegree = newStepsPerDegree;
+        uint32_t position = values[0];
+        uint32_t at_home = values[1];
+        uint32_t cirumference = values[2];
+        uint32_t home_position = values[3];
+        uint32_t dead_zone = values[4];
 
-            if (std::abs(position - RotatorSyncNP[0].getValue()) > 0)
-            {
-                RotatorSyncNP[0].setValue(position);
-                RotatorSyncNP.apply(nullptr);
-            }
+        double newStepsPerDegree = cirumference / 360.0;
+        if (std::abs(newStepsPerDegree - StepsPerDegree) > 0.01)
+            StepsPerDegree = newStepsPerDegree;
 
-            double posAngle = range360(position / StepsPerDegree);
-            if (std::fabs(posAngle - DomeAbsPosNP[0].getValue()) > 0.01)
-            {
-                DomeAbsPosNP[0].setValue(posAngle);
-                DomeAbsPosNP.apply();
-            }
+        if (std::abs(position - RotatorSyncNP[0].getValue()) > 0)
+        {
+            RotatorSyncNP[0].setValue(position);
+            RotatorSyncNP.apply(nullptr);
+        }
 
-            double homeAngle = range360(home_position / StepsPerDegree);
-            if (std::fabs(homeAngle - HomePositionNP[0].getValue()) > 0.01)
-            {
-                HomePositionNP[0].setValue(homeAngle);
-                HomePositionNP.apply(nullptr);
-            }
+        double posAngle = range360(position / StepsPerDegree);
+        if (std::fabs(posAngle - DomeAbsPosNP[0].getValue()) > 0.01)
+        {
+            DomeAbsPosNP[0].setValue(posAngle);
+            DomeAbsPosNP.apply();
+        }
 
-            double homeDiff = std::abs(homeAngle - posAngle);
-            if (GoHomeSP.getState() == IPS_BUSY &&
-                ((GoHomeSP[HOME_FIND].getState() == ISS_ON && at_home == 1) ||
-                 (GoHomeSP[HOME_GOTO].getState() == ISS_ON && homeDiff <= 0.1)))
-            {
-                LOG_INFO("Rotator reached home position.");
-                GoHomeSP.reset();
-                GoHomeSP.setState(IPS_OK);
-                GoHomeSP.apply();
-            }
+        double homeAngle = range360(home_position / StepsPerDegree);
+        if (std::fabs(homeAngle - HomePositionNP[0].getValue()) > 0.01)
+        {
+            HomePositionNP[0].setValue(homeAngle);
+            HomePositionNP.apply(nullptr);
+        }
 
-            if (dead_zone != static_cast<uint32_t>(RotatorSettingsNP[S_ZONE].getValue()))
-            {
-                RotatorSettingsNP[S_ZONE].setValue(dead_zone);
-                RotatorSettingsNP.apply();
-            }
+        double homeDiff = std::abs(homeAngle - posAngle);
+        if (GoHomeSP.getState() == IPS_BUSY &&
+            ((GoHomeSP[HOME_FIND].getState() == ISS_ON && at_home == 1) ||
+             (GoHomeSP[HOME_GOTO].getState() == ISS_ON && homeDiff <= 0.1)))
+        {
+            LOG_INFO("Rotator reached home position.");
+            GoHomeSP.reset();
+            GoHomeSP.setState(IPS_OK);
+            GoHomeSP.apply();
+        }
 
-            // update to fix issue with movement across 0 degrees
-            // for example, if the dead zone is 0.5 degrees, then NexDome won't move if going from 0.1 to 359.9 degrees.
-            // however driver expects response from rotator unless difference calculation is modified, and movement stalls
-            // e.g. the angles 0.1 and -0.1 should be compared instead
-            int a = position;
-            int b = m_TargetAZSteps;
+        if (dead_zone != static_cast<uint32_t>(RotatorSettingsNP[S_ZONE].getValue()))
+        {
+            RotatorSettingsNP[S_ZONE].setValue(dead_zone);
+            RotatorSettingsNP.apply();
+        }
 
-            if (getDomeState() == DOME_MOVING || getDomeState() == DOME_PARKING)
+        // update to fix issue with movement across 0 degrees
+        // for example, if the dead zone is 0.5 degrees, then NexDome won't move if going from 0.1 to 359.9 degrees.
+        // however driver expects response from rotator unless difference calculation is modified, and movement stalls
+        // e.g. the angles 0.1 and -0.1 should be compared instead
+        int a = position;
+        int b = m_TargetAZSteps;
+
+        if (getDomeState() == DOME_MOVING || getDomeState() == DOME_PARKING)
+        {
+            // if a > 0 and b < 360 and both within dead zone, make b negative equivalent angle
+            if(a >= 0 && a <= int(dead_zone) && b >= (int(cirumference) - int(dead_zone)))
             {
-                // if a > 0 and b < 360 and both within dead zone, make b negative equivalent angle
-                if(a >= 0 && a <= int(dead_zone) && b >= (int(cirumference) - int(dead_zone)))
-                {
-                    b -= int(cirumference);
-                }  // if opposite case then make a the negative angle equivalent
-                else if(b >= 0 && b <=int(dead_zone) && a >= (int(cirumference) - int(dead_zone)))
+                b -= int(cirumference);
+            }  // if opposite case then make a the negative angle equivalent
+            else if(b >= 0 && b <=int(dead_zone) && a >= (int(cirumference) - int(dead_zone)))
+            {
+                a -= int(cirumference);
+            }
+
+            // If we reach target position.  (now calculation is correct)
+            if (std::abs(a - b) <= int(dead_zone) )
+            {                    
+                if (getDomeState() == DOME_MOVING)
                 {
-                    a -= int(cirumference);
+                    LOG_INFO("Dome reached target position.");
+                    setDomeState(DOME_SYNCED);
                 }
-
-                // If we reach target position.  (now calculation is correct)
-                if (std::abs(a - b) <= int(dead_zone) )
-                {                    
-                    if (getDomeState() == DOME_MOVING)
-                    {
-                        LOG_INFO("Dome reached target position.");
-                        setDomeState(DOME_SYNCED);
-                    }
-                    else if (getDomeState() == DOME_PARKING)
-                    {
-                        LOG_INFO("Dome is parked.");
-                        SetParked(true);
-                        //setDomeState(DOME_PARKED);
-                    }
+                else if (getDomeState() == DOME_PARKING)
+                {
+                    LOG_INFO("Dome is parked.");
+                    SetParked(true);
+                    //setDomeState(DOME_PARKED);
                 }
             }
         }
-        catch(...)
-        {
-            return false;
-        }
     }
 
     return true;
@@ -1247,52 +1234,49 @@ bool NexDome::processRotatorReport(const std::string &report)
 //////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////
-bool NexDome::processShutterReport(const std::string &report)
+bool NexDome::processShutterReport(const char *report)
 {
-    std::regex re(R"((-?\d+),(\d+),(\d+),(\d+))");
-    std::smatch match;
-    if (std::regex_search(report, match, re))
+    // position,travel_limit,open_limit_switch,close_limit_switch
+    const char *fields[4] = {nullptr};
+    if (ND::scanFields(report, true, fields, 4))
     {
-        try
-        {
-            int32_t position = std::stoi(match.str(1));
-            int32_t travel_limit = std::stoi(match.str(2));
-            bool open_limit_switch = std::stoul(match.str(3)) == 1;
-            bool close_limit_switch = std::stoul(match.str(4)) == 1;
+        int32_t position = 0, travel_limit = 0;
+        unsigned long open_limit = 0, close_limit = 0;
+        if (!ND::parseInt(fields[0], position) || !ND::parseInt(fields[1], travel_limit) ||
+                !ND::parseULong(fields[2], open_limit) || !ND::parseULong(fields[3], close_limit))
+            return false;
 
-            if (std::abs(position - ShutterSyncNP[0].getValue()) > 0)
-            {
-                ShutterSyncNP[0].setValue(position);
-                ShutterSyncNP.apply();
-            }
+        bool open_limit_switch = open_limit == 1;
+        bool close_limit_switch = close_limit == 1;
 
-            INDI_UNUSED(travel_limit);
+        if (std::abs(position - ShutterSyncNP[0].getValue()) > 0)
+        {
+            ShutterSyncNP[0].setValue(position);
+            ShutterSyncNP.apply();
+        }
 
-            if (getShutterState() == SHUTTER_MOVING || getShutterState() == SHUTTER_UNKNOWN)
-            {
-                //if (position == travel_limit || open_limit_switch)
-                if (open_limit_switch)
-                {
-                    setShutterState(SHUTTER_OPENED);
-                    LOG_INFO("Shutter is fully opened.");
+        INDI_UNUSED(travel_limit);
 
-                    if (getDomeState() == DOME_UNPARKING)
-                        SetParked(false);
-                }
-                //else if (position == 0 || close_limit_switch)
-                else if (close_limit_switch)
-                {
-                    setShutterState(SHUTTER_CLOSED);
-                    LOG_INFO("Shutter is fully closed.");
-                }
+        if (getShutterState() == SHUTTER_MOVING || getShutterState() == SHUTTER_UNKNOWN)
+        {
+            //if (position == travel_limit || open_limit_switch)
+            if (open_limit_switch)
+            {
+                setShutterState(SHUTTER_OPENED);
+                LOG_INFO("Shutter is fully opened.");
 
+                if (getDomeState() == DOME_UNPARKING)
+                    SetParked(false);
+            }
+            //else if (position == 0 || close_limit_switch)
+            else if (close_limit_switch)
+            {
+                setShutterState(SHUTTER_CLOSED);
+                LOG_INFO("Shutter is fully closed.");
             }
 
         }
-        catch(...)
-        {
-            return false;
-        }
+
     }
 
     return true;
@@ -1375,42 +1359,3 @@ void NexDome::hexDump(char * buf, const char * data, int size)
     if (size > 0)
         buf[3 * size - 1] = '\0';
 }
-
-//////////////////////////////////////////////////////////////////////
-///
-//////////////////////////////////////////////////////////////////////
-std::vector<std::string> NexDome::split(const std::string &input, const std::string &regex)
-{
-    // passing -1 as the submatch index parameter performs splitting
-    std::regex re(regex);
-    std::sregex_token_iterator
-    first{input.begin(), input.end(), re, -1},
-          last;
-    return {first, last};
-}
-
-//////////////////////////////////////////////////////////////////////
-///
-//////////////////////////////////////////////////////////////////////
-std::string &NexDome::ltrim(std::string &str, const std::string &chars)
-{
-    str.erase(0, str.find_first_not_of(chars));
-    return str;
-}
-
-//////////////////////////////////////////////////////////////////////
-///
-//////////////////////////////////////////////////////////////////////
-std::string &NexDome::rtrim(std::string &str, const std::string &chars)
-{
-    str.erase(str.find_last_not_of(chars) + 1);
-    return str;
-}
-
-//////////////////////////////////////////////////////////////////////
-///
-//////////////////////////////////////////////////////////////////////
-std::string &NexDome::trim(std::string &str, const std::string &chars)
-{
-    return ltrim(rtrim(str, chars), chars);
-}
@@ -127,24 +127,19 @@ class NexDome : public INDI::Dome
         /// Settings
         ///////////////////////////////////////////////////////////////////////////////
         bool executeFactoryCommand(uint8_t command, ND::Targets target);
-        bool processRotatorReport(const std::string &report);
-        bool processShutterReport(const std::string &report);
+        bool processRotatorReport(const char *report);
+        bool processShutterReport(const char *report);
 
         ///////////////////////////////////////////////////////////////////////////////
         /// Utility Functions
         ///////////////////////////////////////////////////////////////////////////////
         bool setParameter(ND::Commands command, ND::Targets target, int32_t value = -1e6);
         bool getParameter(ND::Commands command, ND::Targets target, std::string &value);
-        bool checkEvents(std::string &response);
-        bool processEvent(const std::string &event);
+        bool checkEvents(char *response);
+        bool processEvent(const char *event);
         bool sendCommand(const char * cmd, char * res = nullptr, int cmd_len = -1, int res_len = -1);
         void hexDump(char * buf, const char * data, int size);
 
-        std::string &ltrim(std::string &str, const std::string &chars = "\t\n\v\f\r ");
-        std::string &rtrim(std::string &str, const std::string &chars = "\t\n\v\f\r ");
-        std::string &trim(std::string &str, const std::string &chars = "\t\n\v\f\r ");
-        std::vector<std::string> split(const std::string &input, const std::string &regex);
-
         ///////////////////////////////////////////////////////////////////////////////
         /// Private Members
         ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,147 @@
+/*******************************************************************************
+ Copyright(c) 2019 Jasem Mutlaq. All rights reserved.
+
+ NexDome Driver for Firmware v3+
+
+ Change Log:
+
+ 2019.10.07: Driver is completely re-written to work with Firmware v3 since
+ Firmware v1 is obsolete from NexDome.
+ 2017.01.01: Driver for Firmware v1 is developed by Rozeware Development Ltd.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include "nex_dome_parser.h"
+#include "nex_dome_constants.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <algorithm>
+
+namespace ND
+{
+
+//////////////////////////////////////////////////////////////////////////////
+/// Same as searching the event for "<keyword>([^#]+)" or the event being the
+/// keyword itself: value receives what follows the leftmost occurrence of the
+/// keyword up to the next '#'.
+//////////////////////////////////////////////////////////////////////////////
+bool matchEvent(const char *event, const char *keyword, size_t length, char *value)
+{
+    if (strcmp(event, keyword) == 0)
+    {
+        strncpy(value, event, DRIVER_LEN - 1);
+        value[DRIVER_LEN - 1] = '\0';
+        return true;
+    }
+
+    for (const char *found = strstr(event, keyword); found != nullptr; found = strstr(found + 1, keyword))
+    {
+        size_t size = std::min<size_t>(strcspn(found + length, "#"), DRIVER_LEN - 1);
+        if (size == 0)
+            continue;
+
+        memcpy(value, found + length, size);
+        value[size] = '\0';
+        return true;
+    }
+
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+/// Trims in place, returns the first character that is kept
+//////////////////////////////////////////////////////////////////////
+char *trim(char *str, const char *chars)
+{
+    str += strspn(str, chars);
+
+    size_t length = strlen(str);
+    while (length > 0 && strchr(chars, str[length - 1]) != nullptr)
+        str[--length] = '\0';
+
+    return str;
+}
+
+//////////////////////////////////////////////////////////////////////
+/// std::stoi without the exceptions: false if there are no digits or
+/// the value does not fit.
+//////////////////////////////////////////////////////////////////////
+bool parseInt(const char *str, int32_t &value)
+{
+    char *end = nullptr;
+    errno = 0;
+    long result = strtol(str, &end, 10);
+    if (end == str || errno == ERANGE || result < INT32_MIN || result > INT32_MAX)
+        return false;
+
+    value = result;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+/// std::stoul without the exceptions.
+//////////////////////////////////////////////////////////////////////
+bool parseULong(const char *str, unsigned long &value)
+{
+    char *end = nullptr;
+    errno = 0;
+    unsigned long result = strtoul(str, &end, 10);
+    if (end == str || errno == ERANGE)
+        return false;
+
+    value = result;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////
+/// Finds the leftmost run of count comma separated numbers in report,
+/// like searching for "(\d+),(\d+),..." where the first number may be
+/// negative if is_signed. fields receives the start of each number.
+//////////////////////////////////////////////////////////////////////
+bool scanFields(const char *report, bool is_signed, const char **fields, int count)
+{
+    for (const char *start = report; *start != '\0'; start++)
+    {
+        const char *p = start;
+        int i = 0;
+        for (; i < count; i++)
+        {
+            fields[i] = p;
+            if (i == 0 && is_signed && *p == '-')
+                p++;
+            if (!isdigit(static_cast<uint8_t>(*p)))
+                break;
+            while (isdigit(static_cast<uint8_t>(*p)))
+                p++;
+            if (i < count - 1)
+            {
+                if (*p != ',')
+                    break;
+                p++;
+            }
+        }
+
+        if (i == count)
+            return true;
+    }
+
+    return false;
+}
+
+}
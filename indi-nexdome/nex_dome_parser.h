@@ -0,0 +1,40 @@
+/*******************************************************************************
+ Copyright(c) 2019 Jasem Mutlaq. All rights reserved.
+
+ NexDome Driver for Firmware v3+
+
+ Change Log:
+
+ 2019.10.07: Driver is completely re-written to work with Firmware v3 since
+ Firmware v1 is obsolete from NexDome.
+ 2017.01.01: Driver for Firmware v1 is developed by Rozeware Development Ltd.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ND
+{
+// Parsing of the firmware replies and events, kept apart from the driver so that it can be tested on its own.
+bool matchEvent(const char *event, const char *keyword, size_t length, char *value);
+char *trim(char *str, const char *chars = "\t\n\v\f\r ");
+bool parseInt(const char *str, int32_t &value);
+bool parseULong(const char *str, unsigned long &value);
+bool scanFields(const char *report, bool is_signed, const char **fields, int count);
+}
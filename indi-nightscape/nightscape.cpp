@@ -375,6 +375,8 @@ bool NightscapeCCD::StartExposure(float duration)
     dn->setImgSize(m->getRawImgSize(zonestart, zonelen, framediv));
     dn->setFrameYBinning(framediv);
     dn->setFrameXBinning(PrimaryCCD.getBinX());
+    dn->setCookTarget(PrimaryCCD.getFrameBuffer(), PrimaryCCD.getFrameBufferSize(), PrimaryCCD.getSubX(),
+                      PrimaryCCD.getSubW(), PrimaryCCD.getBinX(), &ccdBufferLock);
     m->sendzone(zonestart, zonelen, framediv);
     INDI::CCDChip::CCD_FRAME ft = PrimaryCCD.getFrameType();
     if (ft == INDI::CCDChip::DARK_FRAME || ft == INDI::CCDChip::BIAS_FRAME) dark = true;
@@ -467,6 +469,7 @@ void NightscapeCCD::TimerHit()
                     /* We're done exposing */
                     InExposure = false;
                     LOG_INFO( "Exposure done, starting readout...");
+                    gettimeofday(&ReadoutStart, nullptr);
 
                     // Set exposure left to zero
                     PrimaryCCD.setExposureLeft(0);
@@ -574,8 +577,12 @@ void NightscapeCCD::grabImage()
     // Get width and height
     //int width  = PrimaryCCD.getSubW() / PrimaryCCD.getBinX() * PrimaryCCD.getBPP() / 8;
     //int height = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
-    memset(image, 0, PrimaryCCD.getFrameBufferSize());
-    dn->copydownload(image, PrimaryCCD.getSubX(), PrimaryCCD.getSubW(), PrimaryCCD.getBinX(), 1, 1);
+    // Normally the lines were already cooked into the frame buffer while downloading
+    if (!dn->isCooked())
+    {
+        memset(image, 0, PrimaryCCD.getFrameBufferSize());
+        dn->copydownload(image, PrimaryCCD.getSubX(), PrimaryCCD.getSubW(), PrimaryCCD.getBinX(), 1, 1);
+    }
     guard.unlock();
     //IDLog("copied..\n");
 
@@ -584,7 +591,9 @@ void NightscapeCCD::grabImage()
     //    for (int j = 0; j < width; j++)
     //        image[i * width + j] = rand() % 255;
     dn->freeBuf();
-    LOGF_DEBUG( "Download %d lines complete.", dn->getActWriteLines());
+    // time elapsed since the end of the exposure
+    LOGF_DEBUG( "Download %d lines complete, %.0f ms after exposure end.", dn->getActWriteLines(),
+                -CalcTimeLeft(ReadoutStart, 0) * 1000);
 
     // Let INDI::CCD know we're done filling the image buffer
     ExposureComplete(&PrimaryCCD);
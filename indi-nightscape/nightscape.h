@@ -97,6 +97,7 @@ class NightscapeCCD : public INDI::CCD
     int oldstat { 0};
     // Struct to keep timing
     struct timeval ExpStart { 0, 0 };
+    struct timeval ReadoutStart { 0, 0 };
 
     float ExposureRequest { 0 };
     float TemperatureRequest { 0 };
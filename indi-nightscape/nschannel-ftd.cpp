@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include "nschannel-ftd.h"
 #include  "nsdebug.h"
+#include <errno.h>
+#include <time.h>
 
 
 static const char* status_string(FT_STATUS res)
@@ -36,6 +38,8 @@ int NsChannelFTD::close()
 {
     FT_Close(ftdic);
     FT_Close(ftdid);
+    pthread_cond_destroy(&rxevent.eCondVar);
+    pthread_mutex_destroy(&rxevent.eMutex);
     opened = 0;
     return 0;
 }
@@ -114,6 +118,14 @@ int  NsChannelFTD::opendownload(void)
         DO_ERR( "unable to set rts on data channel: %d (%s)\n", rc2, status_string(rc2));
         return (-1);
     }
+    pthread_mutex_init(&rxevent.eMutex, NULL);
+    pthread_cond_init(&rxevent.eCondVar, NULL);
+    rc2 = FT_SetEventNotification(ftdid, FT_EVENT_RXCHAR, (PVOID)&rxevent);
+    if (rc2  != FT_OK)
+    {
+        DO_ERR( "unable to set rx event on data channel: %d (%s)\n", rc2, status_string(rc2));
+        return (-1);
+    }
     return maxxfer;
 }
 
@@ -275,6 +287,42 @@ int NsChannelFTD::readData(unsigned char *buf, size_t size)
     }
 }
 
+int NsChannelFTD::readDataTimeout(unsigned char *buf, size_t size, int timeoutms)
+{
+    FT_STATUS rc2;
+    DWORD rxbytes = 0;
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeoutms / 1000;
+    deadline.tv_nsec += (timeoutms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    // the driver signals rxevent under its mutex, so check the queue while holding it
+    pthread_mutex_lock(&rxevent.eMutex);
+    while ((rc2 = FT_GetQueueStatus(ftdid, &rxbytes)) == FT_OK && rxbytes == 0)
+    {
+        if (pthread_cond_timedwait(&rxevent.eCondVar, &rxevent.eMutex, &deadline) == ETIMEDOUT)
+        {
+            rc2 = FT_GetQueueStatus(ftdid, &rxbytes);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&rxevent.eMutex);
+    if (rc2 != FT_OK)
+    {
+        DO_ERR( "unable to get data queue status: %d (%s)\n", (int)rc2, status_string(rc2));
+        return -1;
+    }
+    if (rxbytes == 0)
+        return 0;
+    return readData(buf, size);
+}
+
 int NsChannelFTD::purgeData(void)
 {
     FT_STATUS rc2;
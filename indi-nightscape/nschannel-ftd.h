@@ -26,6 +26,7 @@ class NsChannelFTD : public NsChannel {
 		int readCommand(unsigned char * buf, size_t n);
 		int writeCommand(const unsigned char * buf, size_t n);
 		int readData(unsigned char * buf, size_t n);
+		int readDataTimeout(unsigned char * buf, size_t n, int timeoutms);
 		int purgeData(void);
 		int setDataRts(void);
 		int resetcontrol (void);
@@ -37,6 +38,8 @@ class NsChannelFTD : public NsChannel {
 		int scan(void);
 	private:
 		FT_HANDLE ftdic, ftdid;
+		// signalled by the driver when bytes arrive on the data channel
+		EVENT_HANDLE rxevent;
     struct ftdi_device_list * devs;
 		int thedev;
 	
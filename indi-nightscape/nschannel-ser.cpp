@@ -4,6 +4,7 @@
 
 #include <errno.h>
 #include <fcntl.h> 
+#include <poll.h>
 #include <string.h>
 #include <termios.h>
 #include <unistd.h>
@@ -183,6 +184,17 @@ int NsChannelSER::readData(unsigned char *buf, size_t size) {
   }
 }
 
+int NsChannelSER::readDataTimeout(unsigned char *buf, size_t size, int timeoutms) {
+	struct pollfd pfd = { ftdid, POLLIN, 0 };
+	int rc2 = poll(&pfd, 1, timeoutms);
+	if (rc2 < 0) {
+		DO_ERR( "unable to wait for data: %d (%s)\n", rc2, strerror(errno));
+		return -1;
+	}
+	if (rc2 == 0) return 0;
+	return readData(buf, size);
+}
+
 int NsChannelSER::purgeData(void) {
 	int rc2;
 	rc2= tcflush(ftdid,TCIOFLUSH);
@@ -39,6 +39,7 @@ class NsChannelSER : public NsChannel {
 		int readCommand(unsigned char * buf, size_t n);
 		int writeCommand(const unsigned char * buf, size_t n);
 		int readData(unsigned char * buf, size_t n);
+		int readDataTimeout(unsigned char * buf, size_t n, int timeoutms);
 		int purgeData(void);
 		int setDataRts(void);
 		int resetcontrol (void);
@@ -2,6 +2,7 @@
 
 #include "nschannel-u.h"
 #include  "nsdebug.h"
+#include <chrono>
 
 struct ftdi_context * NsChannelU::getDataChannel(void) {
 		return &data_channel;	
@@ -265,6 +266,15 @@ int NsChannelU::readData(unsigned char *buf, size_t size) {
   }
 }
 
+int NsChannelU::readDataTimeout(unsigned char *buf, size_t size, int timeoutms) {
+  // an idle FT2232 still answers every bulk read with a status packet once per
+  // latency period (2 ms), so ftdi_read_data itself blocks between empty returns
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutms);
+  int rc;
+  while ((rc = readData(buf, size)) == 0 && std::chrono::steady_clock::now() < deadline);
+  return rc;
+}
+
 int NsChannelU::purgeData(void) {
   struct ftdi_context * ftdid = &data_channel;
 	int rc2;
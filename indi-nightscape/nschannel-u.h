@@ -26,6 +26,7 @@ class NsChannelU : public NsChannel {
 		int readCommand(unsigned char * buf, size_t n);
 		int writeCommand(const unsigned char * buf, size_t n);
 		int readData(unsigned char * buf, size_t n);
+		int readDataTimeout(unsigned char * buf, size_t n, int timeoutms);
 		int purgeData(void);
 		int setDataRts(void);
 		int resetcontrol (void);
@@ -25,6 +25,8 @@ class NsChannel {
 		virtual int readCommand(unsigned char * buf, size_t n) = 0;
 		virtual int writeCommand(const unsigned char * buf, size_t n) = 0;
 		virtual int readData(unsigned char * buf, size_t n)= 0;
+		// blocks until the data channel delivers bytes or timeoutms elapses, 0 on timeout
+		virtual int readDataTimeout(unsigned char * buf, size_t n, int timeoutms)= 0;
 		virtual int purgeData(void)= 0;
 		virtual int setDataRts(void)= 0;
 		virtual int resetcontrol (void)= 0;
@@ -8,6 +8,9 @@
 #include "nsdebug.h"
 #include <math.h>
 
+// how long the reader waits on an idle data channel before giving up on the frame
+#define DOWNLOAD_IDLE_TIMEOUT_MS 1500
+
 void NsDownload::setFrameYBinning(int binning) {
 			ctx->imgp->ybinning = binning;	
 
@@ -97,10 +100,14 @@ void NsDownload::freeBuf() {
 	retrBuf = NULL;
 }
 
+// both waits check interrupted under their own mutex, so notify each one while holding it
 void NsDownload::setInterrupted(){
-	std::unique_lock<std::mutex> ulock(mutx);
 	interrupted = 1;
+	std::unique_lock<std::mutex> ulock(mutx);
 	go_download.notify_all();
+	ulock.unlock();
+	std::unique_lock<std::mutex> clock(cookmutx);
+	go_cook.notify_all();
 }
 
 void NsDownload::setZeroReads(int zeroes){
@@ -116,21 +123,13 @@ int NsDownload::downloader()
 			//struct ftdi_transfer_control * ctl;
 
       int rc2;
-      int hardloop = 20; 
-      int sleepage = 1000;
-    
 			int download =1;
 			if (rd->nread > rd->bufsiz) {
             DO_ERR("image too large %d\n", rd->nread);
 		     		return (-1);
 			}
-    	while((rc2 = cn->readData(rd->buffer+rd->nread, cn->getMaxXfer())) == 0 && hardloop > 0) {
-				if (hardloop % 5  == 0) DO_INFO("W%d\n",hardloop);
-    		usleep(sleepage);
-				sleepage *= 2;
-				if (sleepage > 100000) sleepage = 100000;
-				hardloop--;
-			}
+			// block until the camera sends more data, so it is picked up as soon as it arrives
+			rc2 = cn->readDataTimeout(rd->buffer+rd->nread, cn->getMaxXfer(), DOWNLOAD_IDLE_TIMEOUT_MS);
       /* ctl = ftdi_read_data_submit(ftdid, rd->buffer+rd->nread,  maxxfer);
       if (ctl == NULL) {
       	DO_ERR( "unable to submit read: %d (%s)\n", rc2, ftdi_get_error_string(ftdid));
@@ -302,11 +301,34 @@ void NsDownload::writedownload(int pad, int cooked)
 
 
 
-void NsDownload::copydownload(unsigned char *buf, int xstart, int xlen, int xbin, int pad, int cooked)
+// average xbin pixel groups of one raw line into dbufp
+void NsDownload::cookline(const unsigned char * lbufp, unsigned char * dbufp, int xlen, int binning)
 {
 	unsigned char linebuf[KAF8300_MAX_X*2];
-	bool forwards = true;
-	bool rms = false;
+	int linelen = 0;
+
+	if (binning <= 1) {
+		memcpy (dbufp, lbufp, xlen * 2);
+		return;
+	}
+	for (int len = xlen * 2; len > 0; len -= 2 * binning) {
+		long pxav = 0;
+		for (int a = 0; a < binning; a++) {
+			short px;
+			memcpy(&px, lbufp + a * 2, 2);
+			pxav += px;
+		}
+		pxav /= binning;
+		short pxa = pxav;
+		memcpy (linebuf + linelen, &pxa, 2);
+		linelen += 2;
+		lbufp += 2 * binning;
+	}
+	memcpy (dbufp, linebuf, (xlen*2)/binning);
+}
+
+void NsDownload::copydownload(unsigned char *buf, int xstart, int xlen, int xbin, int pad, int cooked)
+{
 	int binning = xbin;
 	uint8_t * dbufp = buf;
 	uint8_t * bufp;
@@ -326,60 +348,14 @@ void NsDownload::copydownload(unsigned char *buf, int xstart, int xlen, int xbin
 		}
 		memcpy (dbufp, retrBuf->buffer, nwrite);
 	} else {
-		//int actlines = nwrite / (KAF8300_MAX_X*2);
-	  //int rem = nwrite % (KAF8300_MAX_X*2);
 	  nwrite = retrBuf->nread;
 		int nwriteleft = nwrite;
-		if (forwards) {
-			bufp = retrBuf->buffer;
-			//dbufp =  (dbufp +(KAF8300_ACTIVE_X*2*IMG_Y)) - (KAF8300_ACTIVE_X*2);
-		} else {
-			bufp = (retrBuf->buffer + nwrite) - (KAF8300_MAX_X*2);
-			dbufp =  (dbufp +(KAF8300_ACTIVE_X*2*IMG_MAX_Y)) - (KAF8300_ACTIVE_X*2);
-		}
+		bufp = retrBuf->buffer;
 		writelines = 0;
 	  while (nwriteleft >= (KAF8300_MAX_X*2)) {
-	  //swab (bufp + (KAF8300_POSTAMBLE*2),  linebuf, KAF8300_ACTIVE_X*2 );
-	   //memcpy (dbufp, linebuf, KAF8300_ACTIVE_X*2);
-	    if (binning > 1) {
-	    	uint8_t * lbufp = bufp + (KAF8300_POSTAMBLE*2) + xstart*2;
-	    	int len = xlen * 2;
-	    	int linelen = 0;
-	    	while (len > 0) {
-	    		short px[4];
-	    		long long pxsq =0;
-	    		long pxav =0;
-	    		short pxa;
-	    		memcpy(px, lbufp,binning * 2);
-	    		for (int a = 0; a < binning; a++) {
-	    			pxav += px[a];
-	    			pxsq	+= px[a]*px[a];
-	    		}
-	    		pxav /= binning;
-	    		pxsq /= binning;
-	    		if(rms) {
-	    			pxa = round(sqrt((double)	pxsq));
-	    			
-	    		} else {
-	    			pxa = pxav;	
-	    		}
-	    		memcpy (linebuf + linelen, &pxa, 2);
-	    		linelen += 2;
-	    		lbufp += 2*binning;
-	    		len -= 2* binning;
-				}
-				memcpy (dbufp, linebuf, (xlen*2)/binning);
-
-	    } else {
-	  		memcpy (dbufp, bufp + (KAF8300_POSTAMBLE*2) + xstart*2, xlen * 2 ); //KAF8300_ACTIVE_X*2 );
-	  	}
-			if (forwards) { 
-				bufp +=  KAF8300_MAX_X*2;
-				dbufp +=(xlen*2)/binning;
-			} else {
-				bufp -=  KAF8300_MAX_X*2;
-				dbufp-=(xlen*2)/binning;
-			}
+	  	cookline(bufp + (KAF8300_POSTAMBLE*2) + xstart*2, dbufp, xlen, binning);
+			bufp +=  KAF8300_MAX_X*2;
+			dbufp +=(xlen*2)/binning;
 			nwriteleft -= KAF8300_MAX_X*2;
 			writelines++;
 	  }
@@ -387,6 +363,107 @@ void NsDownload::copydownload(unsigned char *buf, int xstart, int xlen, int xbin
 	}	 
 }
 
+void NsDownload::setCookTarget(unsigned char *buf, size_t bufsz, int xstart, int xlen, int xbin, std::mutex *buflock)
+{
+	std::unique_lock<std::mutex> ulock(cookmutx);
+	cookbuf = buf;
+	cookbuflock = buflock;
+	cooksz = bufsz;
+	cookxstart = xstart;
+	cookxlen = xlen;
+	cookxbin = xbin < 1 ? 1 : xbin;
+	cooked = false;
+}
+
+bool NsDownload::isCooked()
+{
+	std::unique_lock<std::mutex> ulock(cookmutx);
+	return cooked;
+}
+
+// the reader thread hands the raw frame to the cook thread as it arrives
+void NsDownload::beginstream()
+{
+	std::unique_lock<std::mutex> ulock(cookmutx);
+	cooked = false;
+	streambuf = rd->buffer;
+	streamed = 0;
+	streamdone = false;
+	streaming = (cookbuf != NULL && cookthread != NULL && !interrupted);
+	go_cook.notify_all();
+}
+
+void NsDownload::publishstream()
+{
+	std::unique_lock<std::mutex> ulock(cookmutx);
+	if (!streaming) return;
+	streamed = rd->nread;
+	go_cook.notify_all();
+}
+
+void NsDownload::endstream()
+{
+	std::unique_lock<std::mutex> ulock(cookmutx);
+	if (!streaming) return;
+	streamdone = true;
+	go_cook.notify_all();
+	// wait for the last lines so the frame is complete when the download is reported done
+	while (streaming && !interrupted) go_cook.wait(ulock);
+}
+
+void NsDownload::cookrun()
+{
+	const int rawlinesz = KAF8300_MAX_X*2;
+	int lines = 0;
+	bool zeroed = false;
+
+	std::unique_lock<std::mutex> ulock(cookmutx);
+	while (!interrupted) {
+		if (!streaming || (zeroed && !streamdone && streamed / rawlinesz <= lines)) {
+			go_cook.wait(ulock);
+			continue;
+		}
+		const unsigned char * raw = streambuf;
+		unsigned char * dst = cookbuf;
+		size_t dstsz = cooksz;
+		int xstart = cookxstart;
+		int xlen = cookxlen;
+		int xbin = cookxbin;
+		std::mutex * buflock = cookbuflock;
+		int avail = streamed / rawlinesz;
+		bool done = streamdone;
+		int outlinesz = (xlen*2)/xbin;
+		if (outlinesz > 0 && avail > (int)(dstsz / outlinesz)) avail = dstsz / outlinesz;
+		ulock.unlock();
+
+		// the frame buffer belongs to the driver, write it only under its lock
+		std::unique_lock<std::mutex> block;
+		if (buflock) block = std::unique_lock<std::mutex>(*buflock);
+		if (!zeroed) {
+			memset(dst, 0, dstsz);
+			zeroed = true;
+		}
+		for (; lines < avail; lines++) {
+			cookline(raw + (lines * rawlinesz) + (KAF8300_POSTAMBLE*2) + xstart*2, dst + (lines * outlinesz), xlen, xbin);
+		}
+		if (block) block.unlock();
+
+		ulock.lock();
+		if (done) {
+			DO_INFO( "cooked %d lines\n", lines);
+			writelines = lines;
+			cooked = true;
+			streaming = false;
+			lines = 0;
+			zeroed = false;
+			go_cook.notify_all();
+		}
+	}
+	streaming = false;
+	go_cook.notify_all();
+	DO_DBG("%s\n", "cook thread done");
+}
+
 int NsDownload::purgedownload() 
 {
 		int rc2;
@@ -470,6 +547,7 @@ void NsDownload::trun()
 			in_download = 1;
 			ctx->imgseq++;
 			zeroes = 0;
+			beginstream();
 		}
 	  while (in_download && !interrupted) {
 	  	//int rc2= cn->setDataRts();;
@@ -483,10 +561,12 @@ void NsDownload::trun()
 	  		down = downloader();
 	  	if (down < 0) {
 	  		DO_ERR( "unable to read download: %d\n", down);
+	  		endstream();
 	  		do_download = 0;
 	  		in_download = 0;
 	  		continue;
 	  	}
+	  	publishstream();
 	  	if (rd->nread < rd->imgsz) {
 	  		if (down == 0 && rd->nread > 0) {
     			zeroes++;
@@ -512,7 +592,8 @@ void NsDownload::trun()
 	    }
 	    //IDLog("retr %p buf %p \n", retrBuf, rb.buffer);
 	    if(write_it) writedownload(pad, 0);
-			
+
+	    endstream();
 	  	do_download = 0;
 	  	in_download = 0;
 	  }
@@ -532,10 +613,14 @@ void NsDownload::startThread(void) {
       sch_params.sched_priority = 3;
     	downthread = new std::thread (&NsDownload::trun, this); //(&NsDownload::trun, this);
 			pthread_setschedparam(downthread->native_handle(), SCHED_FIFO, &sch_params);		
+			cookthread = new std::thread (&NsDownload::cookrun, this);
 
 }
 
 void NsDownload::stopThread(void) {
 	setInterrupted();
 	downthread->join();
+	cookthread->join();
+	delete cookthread;
+	cookthread = nullptr;
 }
@@ -6,6 +6,8 @@
 #include <pthread.h>
 #include <thread>         // std::thread
 #include <condition_variable>
+#include <mutex>
+#include <atomic>
 
 typedef struct ns_readdata {
 	int nread;
@@ -104,6 +106,10 @@ class NsDownload {
 		void freeBuf();
 		void setInterrupted();
 		void copydownload(unsigned char *buf, int xstart, int xlen, int xbin, int pad, int cooked);
+		// cook lines into buf while the rest of the frame is still downloading,
+		// holding buflock (if any) whenever buf is written
+		void setCookTarget(unsigned char *buf, size_t bufsz, int xstart, int xlen, int xbin, std::mutex *buflock = nullptr);
+		bool isCooked();
 		void writedownload(int pad, int cooked);
 		void setZeroReads(int zeroes);
 	private:
@@ -111,6 +117,11 @@ class NsDownload {
 	  void fitsheader(int x, int y, char * fbase, struct img_params * ip);
 		int fulldownload(); 
 		bool getDoDownload();
+		void cookline(const unsigned char * lbufp, unsigned char * dbufp, int xlen, int binning);
+		void cookrun();
+		void beginstream();
+		void publishstream();
+		void endstream();
 		struct download_params dp;
 		struct img_params ip;
 	  ns_readdata_t  rdd;
@@ -121,7 +132,8 @@ class NsDownload {
 		volatile int readdone;
 		volatile int do_download;
 		volatile int in_download;
-		volatile int interrupted;
+		// read under both mutx and cookmutx, so set it through setInterrupted
+		std::atomic<int> interrupted { 0 };
 
 		NsChannel * cn;
 		int write_it;
@@ -136,5 +148,21 @@ class NsDownload {
 		ns_readdata_t * retrBuf;
 		int zero_reads { 1 };
 		int writelines{0};
+
+		// streaming cook state, protected by cookmutx
+		std::thread * cookthread { nullptr };
+		std::condition_variable go_cook;
+		std::mutex cookmutx;
+		unsigned char * cookbuf { nullptr };
+		std::mutex * cookbuflock { nullptr };
+		size_t cooksz { 0 };
+		int cookxstart { 0 };
+		int cookxlen { 0 };
+		int cookxbin { 1 };
+		const unsigned char * streambuf { nullptr };
+		int streamed { 0 };
+		bool streaming { false };
+		bool streamdone { false };
+		bool cooked { false };
 };
 #endif
\ No newline at end of file
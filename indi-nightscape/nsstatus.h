@@ -5,6 +5,7 @@
 #include "nsdebug.h"
 
 #include <condition_variable>
+#include <atomic>
 #include "nsmsg.h"
 #include "nschannel.h"
 #include "nsdownload.h"
@@ -40,7 +41,7 @@ class NsStatus {
 		volatile int status;
 		int old_status;
 		volatile int do_status { 0 };
-		volatile int interrupted;
+		std::atomic<int> interrupted { 0 };
 
 		std::thread * statThread;
 		std::condition_variable go_status;
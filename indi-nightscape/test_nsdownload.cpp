@@ -0,0 +1,265 @@
+/*
+ * Loopback tests of the Nightscape download and cook threads: a fake data
+ * channel plays a raw frame from memory, the way the camera sends it.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "nsdownload.h"
+#include "kaf_constants.h"
+
+class LoopbackChannel : public NsChannel
+{
+	public:
+		LoopbackChannel(int lines, int delayus) {
+			maxxfer = DEFAULT_CHUNK_SIZE;
+			delay = delayus;
+			frame.resize(lines * KAF8300_MAX_X * 2);
+			for (size_t i = 0; i < frame.size(); i++)
+				frame[i] = (i * 2654435761u) >> 13;
+			holdat = frame.size();
+		}
+
+		int readCommand(unsigned char *, size_t) { return 0; }
+		int writeCommand(const unsigned char *, size_t n) { return n; }
+		int readData(unsigned char * buf, size_t n) {
+			std::unique_lock<std::mutex> ulock(mutx);
+			size_t len = std::min(n, holdat - sent);
+			if (len > 0 && delay > 0) {
+				ulock.unlock();
+				std::this_thread::sleep_for(std::chrono::microseconds(delay));
+				ulock.lock();
+			}
+			memcpy(buf, frame.data() + sent, len);
+			sent += len;
+			return len;
+		}
+		int readDataTimeout(unsigned char * buf, size_t n, int timeoutms) {
+			std::unique_lock<std::mutex> ulock(mutx);
+			waits++;
+			if (!more.wait_for(ulock, std::chrono::milliseconds(timeoutms), [this] { return sent < holdat; }))
+				return 0;
+			ulock.unlock();
+			return readData(buf, n);
+		}
+		int purgeData(void) { return 0; }
+		int setDataRts(void) { return 0; }
+		int resetcontrol (void) { return 0; }
+
+		size_t getSent() {
+			std::unique_lock<std::mutex> ulock(mutx);
+			return sent;
+		}
+
+		int getWaits() {
+			std::unique_lock<std::mutex> ulock(mutx);
+			return waits;
+		}
+
+		// the camera stops sending after the first bytes of the frame, until release()
+		void hold(size_t bytes) {
+			std::unique_lock<std::mutex> ulock(mutx);
+			holdat = bytes;
+		}
+
+		void release() {
+			std::unique_lock<std::mutex> ulock(mutx);
+			holdat = frame.size();
+			more.notify_all();
+		}
+
+		std::vector<unsigned char> frame;
+
+	protected:
+		int opencontrol (void) { return 0; }
+		int opendownload(void) { return 0; }
+		int scan(void) { return 0; }
+
+	private:
+		std::mutex mutx;
+		std::condition_variable more;
+		size_t sent { 0 };
+		size_t holdat;
+		int waits { 0 };
+		int delay;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void streamFrame(int xbin)
+{
+	const int lines = 200;
+	const int xstart = 0;
+	const int xlen = KAF8300_ACTIVE_X;
+	LoopbackChannel cn(lines, 200);
+	NsDownload dn(&cn);
+
+	std::vector<unsigned char> cooked(lines * (xlen * 2) / xbin, 0xAA);
+	dn.setNumExp(99999);
+	dn.setImgSize(cn.frame.size());
+	dn.setCookTarget(cooked.data(), cooked.size(), xstart, xlen, xbin);
+	dn.startThread();
+	dn.doDownload();
+
+	auto start = std::chrono::steady_clock::now();
+	while ((dn.inDownload() || !dn.isCooked()) && secondsSince(start) < 10)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	ASSERT_FALSE(dn.inDownload());
+	ASSERT_TRUE(dn.isCooked());
+	ASSERT_EQ(dn.getActWriteLines(), lines);
+	ASSERT_EQ(dn.getBufImageSize(), cn.frame.size());
+	ASSERT_EQ(memcmp(dn.getBuf(), cn.frame.data(), cn.frame.size()), 0);
+
+	// the lines cooked while the frame arrived match cooking the whole frame afterwards
+	std::vector<unsigned char> copied(cooked.size(), 0x55);
+	dn.copydownload(copied.data(), xstart, xlen, xbin, 1, 1);
+	ASSERT_EQ(cooked, copied);
+
+	dn.stopThread();
+	dn.freeBuf();
+}
+
+TEST(NsDownload, StreamedCook)
+{
+	streamFrame(1);
+}
+
+TEST(NsDownload, StreamedCookBinned)
+{
+	streamFrame(2);
+}
+
+TEST(NsDownload, PausedFrameResumesAtOnce)
+{
+	// the camera pauses half way through the frame, the reader blocks instead of polling
+	const int lines = 200;
+	LoopbackChannel cn(lines, 0);
+	NsDownload dn(&cn);
+	std::vector<unsigned char> cooked(lines * KAF8300_ACTIVE_X * 2);
+	size_t half = cn.frame.size() / 2;
+	cn.hold(half);
+	dn.setNumExp(99999);
+	dn.setImgSize(cn.frame.size());
+	dn.setCookTarget(cooked.data(), cooked.size(), 0, KAF8300_ACTIVE_X, 1);
+	dn.startThread();
+	dn.doDownload();
+
+	auto start = std::chrono::steady_clock::now();
+	while (cn.getSent() < half && secondsSince(start) < 10)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	ASSERT_EQ(cn.getSent(), half);
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	int waits = cn.getWaits();
+
+	start = std::chrono::steady_clock::now();
+	cn.release();
+	while (cn.getSent() == half && secondsSince(start) < 10)
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	double resumed = secondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	while ((dn.inDownload() || !dn.isCooked()) && secondsSince(start) < 10)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	ASSERT_TRUE(dn.isCooked());
+	ASSERT_EQ(dn.getActWriteLines(), lines);
+	printf("300 ms pause: %d blocking reads, resumed %.2f ms after the data came\n", waits, resumed * 1e3);
+	// the reads before the pause, plus the one that blocks through it
+	ASSERT_LE(waits, (int)(half / cn.getMaxXfer()) + 2);
+	ASSERT_LT(resumed, 0.005);
+
+	dn.stopThread();
+	dn.freeBuf();
+}
+
+TEST(NsDownload, CookWaitsForTheFrameBufferLock)
+{
+	const int lines = 200;
+	LoopbackChannel cn(lines, 200);
+	NsDownload dn(&cn);
+	std::mutex buflock;
+	std::vector<unsigned char> cooked(lines * KAF8300_ACTIVE_X * 2, 0xAA);
+	dn.setNumExp(99999);
+	dn.setImgSize(cn.frame.size());
+	dn.setCookTarget(cooked.data(), cooked.size(), 0, KAF8300_ACTIVE_X, 1, &buflock);
+
+	// the driver holds the frame buffer while the whole frame arrives
+	std::unique_lock<std::mutex> guard(buflock);
+	dn.startThread();
+	dn.doDownload();
+	auto start = std::chrono::steady_clock::now();
+	while (cn.getSent() < cn.frame.size() && secondsSince(start) < 10)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	ASSERT_FALSE(dn.isCooked());
+	ASSERT_EQ(std::count(cooked.begin(), cooked.end(), 0xAA), (long)cooked.size());
+	guard.unlock();
+
+	start = std::chrono::steady_clock::now();
+	while ((dn.inDownload() || !dn.isCooked()) && secondsSince(start) < 10)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	ASSERT_TRUE(dn.isCooked());
+	std::vector<unsigned char> copied(cooked.size(), 0x55);
+	dn.copydownload(copied.data(), 0, KAF8300_ACTIVE_X, 1, 1, 1);
+	ASSERT_EQ(cooked, copied);
+
+	dn.stopThread();
+	dn.freeBuf();
+}
+
+TEST(NsDownload, InterruptWhileIdle)
+{
+	LoopbackChannel cn(10, 0);
+	NsDownload dn(&cn);
+	dn.setNumExp(99999);
+	dn.setImgSize(cn.frame.size());
+	dn.startThread();
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	auto start = std::chrono::steady_clock::now();
+	dn.stopThread();
+	ASSERT_LT(secondsSince(start), 0.5);
+}
+
+TEST(NsDownload, InterruptWhileStreaming)
+{
+	// a frame that takes seconds to arrive, interrupted part way through
+	const int lines = 2000;
+	LoopbackChannel cn(lines, 20000);
+	NsDownload dn(&cn);
+
+	std::vector<unsigned char> cooked(lines * KAF8300_ACTIVE_X * 2);
+	dn.setNumExp(99999);
+	dn.setImgSize(cn.frame.size());
+	dn.setCookTarget(cooked.data(), cooked.size(), 0, KAF8300_ACTIVE_X, 1);
+	dn.startThread();
+	dn.doDownload();
+
+	auto start = std::chrono::steady_clock::now();
+	while (cn.getSent() < cn.frame.size() / 10 && secondsSince(start) < 10)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	ASSERT_LT(cn.getSent(), cn.frame.size());
+
+	// both the reader and the cook thread wake up and finish
+	start = std::chrono::steady_clock::now();
+	dn.stopThread();
+	double stopped = secondsSince(start);
+	printf("stopped mid frame after %zu of %zu bytes in %.1f ms\n", cn.getSent(), cn.frame.size(), stopped * 1e3);
+	ASSERT_LT(stopped, 0.5);
+	ASSERT_FALSE(dn.isCooked());
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
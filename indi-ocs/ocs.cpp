@@ -57,6 +57,11 @@ OCS::OCS() : INDI::Dome(), WI(this)
     SlowTimer.callOnTimeout(std::bind(&OCS::SlowTimerHit, this));
 }
 
+OCS::~OCS()
+{
+    StopSlowPolling();
+}
+
 /*******************************************************
  * INDI is asking us for our default device name.
  * Must match Ekos selection menu and ParkData.xml names
@@ -94,6 +99,7 @@ bool OCS::Handshake()
             LOG_DEBUG("OCS handshake established");
             handshake_status = true;
             GetCapabilites();
+            StartSlowPolling();
             SlowTimer.start(60000);
         }
         else {
@@ -378,8 +384,10 @@ void OCS::GetCapabilites()
         LOG_INFO("OCS does not have weather sensor(s), disabling tab");
     }
 
-    // Call the slow property update once as this is startup and we want to populate now
-    SlowTimerHit();
+    // Run the slow property update once as this is startup and we want to populate now
+    SlowStatus status;
+    PollSlowStatus(status);
+    ApplySlowStatus(status);
 }
 
 /**********************************************************************
@@ -723,6 +731,7 @@ bool OCS::updateProperties()
 
         // As we're disconnected, stop calling one minute updates
         SlowTimer.stop();
+        StopSlowPolling();
     }
 
     return true;
@@ -733,6 +742,17 @@ bool OCS::updateProperties()
 *************************************************************/
 void OCS::TimerHit()
 {
+    // Apply the latest slow status poll, if one completed since the last tick
+    {
+        std::unique_lock<std::mutex> guard(slow_poll_lock);
+        if (slow_status_ready) {
+            SlowStatus status = slow_status;
+            slow_status_ready = false;
+            guard.unlock();
+            ApplySlowStatus(status);
+        }
+    }
+
     // Get the roof/shutter status
     char roof_status_response[RB_MAX_LEN] = {0};
     int roof_status_error_or_fail  = getCommandSingleCharErrorOrLongResponse(PortFD, roof_status_response,
@@ -794,8 +814,9 @@ void OCS::TimerHit()
             sprintf(last_shutter_status, "%s", roof_message);
         }
 
-        IUSaveText(&ShutterStatusT[0], roof_message);
-        IDSetText(&ShutterStatusTP, nullptr);
+        if (SaveTextIfChanged(&ShutterStatusT[0], roof_message)) {
+            IDSetText(&ShutterStatusTP, nullptr);
+        }
     }
 
     // Dome updates
@@ -852,8 +873,9 @@ void OCS::TimerHit()
                 }
                 sprintf(dome_message, "Idle");
             }
-            IUSaveText(&DomeStatusT[0], dome_message);
-            IDSetText(&DomeStatusTP, nullptr);
+            if (SaveTextIfChanged(&DomeStatusT[0], dome_message)) {
+                IDSetText(&DomeStatusTP, nullptr);
+            }
         } else {
             LOGF_WARN("Communication error on get Dome status %s, this update aborted, will try again...", OCS_get_dome_status);
         }
@@ -865,15 +887,15 @@ void OCS::TimerHit()
                                                                    OCS_get_dome_azimuth);
         if (dome_position_error_or_fail > 1 && position != conversion_error) {
             // DomeAbsPosN->value = position;
-            DomeAbsPosNP[0].setValue(position);
-            DomeAbsPosNP.apply();
+            if (DomeAbsPosNP[0].getValue() != position) {
+                DomeAbsPosNP[0].setValue(position);
+                DomeAbsPosNP.apply();
+            }
         } else {
             LOGF_WARN("Communication error on get Dome position %s, this update aborted, will try again...", OCS_get_dome_azimuth);
         }
     }
 
-    IDSetText(&Status_ItemsTP, nullptr);
-
     // Timer loop control
     if (!isConnected())
         return; //  No need to reset timer if we are not connected anymore
@@ -886,417 +908,300 @@ void OCS::TimerHit()
 ****************************************/
 void OCS::SlowTimerHit()
 {
-    // Status tab
-    char power_status_response[RB_MAX_LEN] = {0};
-    int power_status_error_or_fail  = getCommandSingleCharErrorOrLongResponse(PortFD, power_status_response,
-                                                                              OCS_get_power_status);
-    if (power_status_error_or_fail > 1) {
-        IUSaveText(&Status_ItemsT[STATUS_MAINS], power_status_response);
-        IDSetText(&Status_ItemsTP, nullptr);
-    } else {
-        LOGF_WARN("Communication error on get Power Status %s, this update aborted, will try again...", OCS_get_power_status);
+    // The queries run on the slow poll thread so the main loop is not blocked on serial I/O
+    std::lock_guard<std::mutex> guard(slow_poll_lock);
+    slow_poll_requested = true;
+    slow_poll_cv.notify_one();
+}
+
+void OCS::StartSlowPolling()
+{
+    StopSlowPolling();
+    slow_poll_quit = false;
+    slow_poll_requested = false;
+    slow_status_ready = false;
+    slow_poll_thread = std::thread(&OCS::SlowPollThread, this);
+}
+
+void OCS::StopSlowPolling()
+{
+    {
+        std::lock_guard<std::mutex> guard(slow_poll_lock);
+        slow_poll_quit = true;
+    }
+    slow_poll_cv.notify_one();
+    if (slow_poll_thread.joinable()) {
+        slow_poll_thread.join();
     }
+}
 
-    char safety_status_response[RB_MAX_LEN] = {0};
-    int safety_status_error_or_fail  = getCommandSingleCharErrorOrLongResponse(PortFD, safety_status_response,
-                                                                                     OCS_get_safety_status);
-    if (safety_status_error_or_fail > 1) {
-        IUSaveText(&Status_ItemsT[STATUS_OCS_SAFETY], safety_status_response);
-        IDSetText(&Status_ItemsTP, nullptr);
-    } else {
-        LOGF_WARN("Communication error on get OCS Safety Status %s, this update aborted, will try again...", OCS_get_safety_status);
+void OCS::SlowPollThread()
+{
+    std::unique_lock<std::mutex> guard(slow_poll_lock);
+    while (true) {
+        slow_poll_cv.wait(guard, [this] { return slow_poll_quit || slow_poll_requested; });
+        if (slow_poll_quit) {
+            break;
+        }
+        slow_poll_requested = false;
+
+        guard.unlock();
+        SlowStatus status;
+        PollSlowStatus(status);
+        guard.lock();
+
+        slow_status = status;
+        slow_status_ready = true;
     }
+}
 
-    char MCU_temp_response[RB_MAX_LEN] = {0};
-    int MCU_temp_status_error_or_fail  = getCommandSingleCharErrorOrLongResponse(PortFD, MCU_temp_response,
-                                                                                 OCS_get_MCU_temperature);
-    if (MCU_temp_status_error_or_fail > 1) {
-        IUSaveText(&Status_ItemsT[STATUS_MCU_TEMPERATURE], MCU_temp_response);
-        IDSetText(&Status_ItemsTP, nullptr);
-    } else {
-        LOGF_WARN("Communication error on get MCU temperature %s, this update aborted, will try again...", OCS_get_thermostat_status);
+/*************************************************************
+* Roof/shutter last error responses and how they are reported
+**************************************************************/
+struct RoofErrorMessage {
+    const char *response;
+    bool is_error;          // warnings leave the shutter state alone
+    const char *message;
+};
+
+static const RoofErrorMessage roof_error_messages[] = {
+    {"Error: Open safety interlock", true, "Roof/shutter error - Open safety interlock"},
+    {"Error: Close safety interlock", true, "Roof/shutter error - Close safety interlock"},
+    {"Error: Open unknown error", true, "Roof/shutter error - Open unknown"},
+    {"Error: Open limit sw fail", true, "Roof/shutter error - Open limit switch fail"},
+    {"Error: Open over time", true, "Roof/shutter error - Open max time exceeded"},
+    {"Error: Open under time", true, "Roof/shutter error - Open min time not reached"},
+    {"Error: Close unknown error", true, "Roof/shutter error - Close unknow"},
+    {"Error: Close limit sw fail", true, "Roof/shutter error - Close limit switch"},
+    {"Error: Close over time", true, "Roof/shutter error - Close max time exceeded"},
+    {"Error: Close under tim", true, "Roof/shutter error - Close min time not reached"},
+    {"Error: Limit switch malfunction", true, "Roof/shutter error - Both open & close limit switches active together"},
+    {"Error: Closed/opened limit sw on", true, "Roof/shutter error - Closed/opened limit switch on"},
+    {"Warning: Already closed", false, "Roof/shutter warning - Roof/shutter is already closed"},
+    {"Error: Close location unknown", true, "Roof/shutter error - Close location unknown"},
+    {"Error: Motion direction unknown", true, "Roof/shutter error - Motion direction unknown"},
+    {"Error: Close already in motion", true, "Roof/shutter error - Close already in motion"},
+    {"Error: Opened/closed limit sw on", true, "Roof/shutter error - Opened/closed limit switch on"},
+    {"Warning: Already open", false, "Roof/shutter warning - Roof/shutter is already open"},
+    {"Error: Open location unknow", true, "Roof/shutter error - Open location unknow"},
+    {"Error: Open already in motion", true, "Roof/shutter error - Open already in motion"},
+    {"Error: Close mount not parked", true, "Roof/shutter error - Timeout waiting for mount to park before closing"},
+};
+
+/**************************************************************
+* Query all slow status items - runs on the slow poll thread,
+* must not touch properties
+***************************************************************/
+void OCS::PollSlowStatus(SlowStatus &status)
+{
+    // Flush before the first query of the batch and again only after a failed
+    // query, instead of once per query
+    bool flush_needed = true;
+    auto query = [&](char *response, const char *command) {
+        int error_or_fail = getCommandResponse(PortFD, response, command, flush_needed);
+        flush_needed = (error_or_fail <= 1);
+        return error_or_fail;
+    };
+
+    // Status tab
+    struct {
+        const char *command;
+        const char *label;
+        char *response;
+        bool *ok;
+    } status_queries[] = {
+        {OCS_get_power_status, "Power Status", status.mains, &status.mains_ok},
+        {OCS_get_safety_status, "OCS Safety Status", status.safety, &status.safety_ok},
+        {OCS_get_MCU_temperature, "MCU temperature", status.mcu_temperature, &status.mcu_temperature_ok},
+    };
+    for (auto &status_query : status_queries) {
+        *status_query.ok = query(status_query.response, status_query.command) > 1;
+        if (!*status_query.ok) {
+            LOGF_WARN("Communication error on get %s %s, this update aborted, will try again...", status_query.label, status_query.command);
+        }
     }
 
     // Get the last roof error (if any)
     // This is here because although the 1 second polled get roof status would return any error flagged
     // at the time it could miss a transient condition that has been cleared in-between poll periods.
     // Last roof error holds the condition until cleared by a shutter/roof action.
-    char roof_error_response[RB_MAX_LEN] = {0};
-    int roof_error_error_or_fail  = getCommandSingleCharErrorOrLongResponse(PortFD, roof_error_response,
-                                                                            OCS_get_roof_last_error);
-    if (roof_error_error_or_fail > 1) {
-        if (strcmp(roof_error_response, "Error: Open safety interlock") == 0 &&
-                strcmp(roof_error_response, last_shutter_error) != 0) {
-            indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-            if (getShutterState() != SHUTTER_ERROR) {
-                setShutterState(SHUTTER_ERROR);
-            }
-            LOG_WARN("Roof/shutter error - Open safety interlock");
-        } else if (strcmp(roof_error_response, "Error: Close safety interlock") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-            indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-            if (getShutterState() != SHUTTER_ERROR) {
-                setShutterState(SHUTTER_ERROR);
-            }
-            LOG_WARN("Roof/shutter error - Close safety interlock");
-        } else if (strcmp(roof_error_response, "Error: Open unknown error") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-            indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-            if (getShutterState() != SHUTTER_ERROR) {
-                setShutterState(SHUTTER_ERROR);
-            }
-            LOG_WARN("Roof/shutter error - Open unknown");
-        } else if (strcmp(roof_error_response, "Error: Open limit sw fail") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-            indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-            if (getShutterState() != SHUTTER_ERROR) {
-                setShutterState(SHUTTER_ERROR);
-            }
-            LOG_WARN("Roof/shutter error - Open limit switch fail");
-        } else if (strcmp(roof_error_response, "Error: Open over time") == 0 &&
-            strcmp(roof_error_response, last_shutter_error) != 0) {
-            indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-            if (getShutterState() != SHUTTER_ERROR) {
-                setShutterState(SHUTTER_ERROR);
-            }
-            LOG_WARN("Roof/shutter error - Open max time exceeded");
-        } else if (strcmp(roof_error_response, "Error: Open under time") == 0 &&
-            strcmp(roof_error_response, last_shutter_error) != 0) {
-            indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-            if (getShutterState() != SHUTTER_ERROR) {
-                setShutterState(SHUTTER_ERROR);
-            }
-            LOG_WARN("Roof/shutter error - Open min time not reached");
-        } else if (strcmp(roof_error_response, "Error: Close unknown error") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-            indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-            if (getShutterState() != SHUTTER_ERROR) {
-                setShutterState(SHUTTER_ERROR);
-            }
-            LOG_WARN("Roof/shutter error - Close unknow");
-        } else if (strcmp(roof_error_response, "Error: Close limit sw fail") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-            indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-            if (getShutterState() != SHUTTER_ERROR) {
-                setShutterState(SHUTTER_ERROR);
-            }
-            LOG_WARN("Roof/shutter error - Close limit switch");
-        } else if (strcmp(roof_error_response, "Error: Close over time") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-            indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-            if (getShutterState() != SHUTTER_ERROR) {
-                setShutterState(SHUTTER_ERROR);
-            }
-            LOG_WARN("Roof/shutter error - Close max time exceeded");
-        } else if (strcmp(roof_error_response, "Error: Close under tim") == 0 &&
-            strcmp(roof_error_response, last_shutter_error) != 0) {
-            indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-            LOG_WARN("Roof/shutter error - Close min time not reached");
-            if (getShutterState() != SHUTTER_ERROR) {
-                setShutterState(SHUTTER_ERROR);
-            }
-        } else if (strcmp(roof_error_response, "Error: Limit switch malfunction") == 0 &&
-                strcmp(roof_error_response, last_shutter_error) != 0) {
-            indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-            if (getShutterState() != SHUTTER_ERROR) {
-                setShutterState(SHUTTER_ERROR);
-            }
-            LOG_WARN("Roof/shutter error - Both open & close limit switches active together");
-        } else if (strcmp(roof_error_response, "Error: Closed/opened limit sw on") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-               indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-               if (getShutterState() != SHUTTER_ERROR) {
-                   setShutterState(SHUTTER_ERROR);
-               }
-               LOG_WARN("Roof/shutter error - Closed/opened limit switch on");
-        } else if (strcmp(roof_error_response, "Warning: Already closed") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-               indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-               LOG_WARN("Roof/shutter warning - Roof/shutter is already closed");
-        } else if (strcmp(roof_error_response, "Error: Close location unknown") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-               indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-               if (getShutterState() != SHUTTER_ERROR) {
-                   setShutterState(SHUTTER_ERROR);
-               }
-               LOG_WARN("Roof/shutter error - Close location unknown");
-        } else if (strcmp(roof_error_response, "Error: Motion direction unknown") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-               indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-               if (getShutterState() != SHUTTER_ERROR) {
-                   setShutterState(SHUTTER_ERROR);
-               }
-               LOG_WARN("Roof/shutter error - Motion direction unknown");
-        } else if (strcmp(roof_error_response, "Error: Close already in motion") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-               indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-               if (getShutterState() != SHUTTER_ERROR) {
-                   setShutterState(SHUTTER_ERROR);
-               }
-               LOG_WARN("Roof/shutter error - Close already in motion");
-        } else if (strcmp(roof_error_response, "Error: Opened/closed limit sw on") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-               indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-               if (getShutterState() != SHUTTER_ERROR) {
-                   setShutterState(SHUTTER_ERROR);
-               }
-               LOG_WARN("Roof/shutter error - Opened/closed limit switch on");
-        } else if (strcmp(roof_error_response, "Warning: Already open") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-               indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-               LOG_WARN("Roof/shutter warning - Roof/shutter is already open");
-        } else if (strcmp(roof_error_response, "Error: Open location unknow") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-               indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-               if (getShutterState() != SHUTTER_ERROR) {
-                   setShutterState(SHUTTER_ERROR);
-               }
-               LOG_WARN("Roof/shutter error - Open location unknow");
-        } else if (strcmp(roof_error_response, "Error: Open already in motion") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-               indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-               if (getShutterState() != SHUTTER_ERROR) {
-                   setShutterState(SHUTTER_ERROR);
-               }
-               LOG_WARN("Roof/shutter error - Open already in motion");
-        } else if (strcmp(roof_error_response, "Error: Close mount not parked") == 0 &&
-                   strcmp(roof_error_response, last_shutter_error) != 0) {
-               indi_strlcpy(last_shutter_error,roof_error_response, RB_MAX_LEN);
-               if (getShutterState() != SHUTTER_ERROR) {
-                   setShutterState(SHUTTER_ERROR);
-               }
-               LOG_WARN("Roof/shutter error - Timeout waiting for mount to park before closing");
-        }
-        IUSaveText(&Status_ItemsT[STATUS_ROOF_LAST_ERROR], last_shutter_error);
-    } else if (roof_error_error_or_fail == 1) {
+    int roof_error_error_or_fail = query(status.roof_last_error, OCS_get_roof_last_error);
+    status.roof_last_error_ok = roof_error_error_or_fail > 1;
+    if (roof_error_error_or_fail == 1) {
         LOGF_WARN("Communication error on get Roof/Shutter last error %s, this update aborted, will try again...", OCS_get_roof_last_error);
     }
 
     // Thermostat tab
     if (thermostat_controls_enabled) {
-        // Get the Obsy Thermostat readings
-        char thermostat_status_response[RB_MAX_LEN] = {0};
-        int thermostat_status_error_or_fail  = getCommandSingleCharErrorOrLongResponse(PortFD, thermostat_status_response,
-                                                                                       OCS_get_thermostat_status);
-        if (thermostat_status_error_or_fail > 1) {
-            char *split;
-            split = strtok(thermostat_status_response, ",");
-            IUSaveText(&Thermostat_StatusT[THERMOSTAT_TEMERATURE], split);
-            split = strtok(NULL, ",");
-            IUSaveText(&Thermostat_StatusT[THERMOSTAT_HUMIDITY], split);
-            IDSetText(&Thermostat_StatusTP, nullptr);
-        } else {
+        status.thermostat_ok = query(status.thermostat, OCS_get_thermostat_status) > 1;
+        if (!status.thermostat_ok) {
             LOGF_WARN("Communication error on get Thermostat Status %s, this update aborted, will try again...", OCS_get_thermostat_status);
         }
 
-        // Get the Thermostat setpoints
-        char heat_response[RB_MAX_LEN] = {0};
-        int heat_int_response = 0;
-        int heat_setpoint_error_or_fail = getCommandIntFromCharResponse(PortFD, heat_response, &heat_int_response,
-                                                                        OCS_get_thermostat_heat_setpoint);
-        if (heat_setpoint_error_or_fail >= 0 && heat_int_response != conversion_error) { // errors are negative
-            Thermostat_setpointN[THERMOSTAT_HEAT_SETPOINT].value = heat_int_response;
-        } else {
-            LOGF_WARN("Communication error on get Thermostat Heat Setpoint %d, this update aborted, will try again...", heat_int_response);
+        struct {
+            const char *command;
+            const char *label;
+        } setpoint_queries[THERMOSTAT_SETPOINT_COUNT] = {
+            {OCS_get_thermostat_heat_setpoint, "Heat"},
+            {OCS_get_thermostat_cool_setpoint, "Cool"},
+            {OCS_get_thermostat_humidity_setpoint, "Humidity"},
+        };
+        for (int setpoint = 0; setpoint < THERMOSTAT_SETPOINT_COUNT; setpoint++) {
+            char setpoint_response[RB_MAX_LEN] = {0};
+            status.setpoints[setpoint] = conversion_error;
+            if (query(setpoint_response, setpoint_queries[setpoint].command) >= 1) { // errors are negative
+                status.setpoints[setpoint] = charToInt(setpoint_response);
+            }
+            if (status.setpoints[setpoint] == conversion_error) {
+                LOGF_WARN("Communication error on get Thermostat %s Setpoint %s, this update aborted, will try again...", setpoint_queries[setpoint].label, setpoint_response);
+            }
         }
+    }
 
-        char cool_response[RB_MAX_LEN] = {0};
-        int cool_int_response = 0;
-        int cool_setpoint_error_or_fail = getCommandIntFromCharResponse(PortFD, cool_response, &cool_int_response,
-                                                                        OCS_get_thermostat_cool_setpoint);
-        if (cool_setpoint_error_or_fail >= 0 && cool_int_response != conversion_error) { // errors are negative
-            Thermostat_setpointN[THERMOSTAT_COOL_SETPOINT].value = cool_int_response;
-        } else {
-            LOGF_WARN("Communication error on get Thermostat Cool Setpoint %d, this update aborted, will try again...", cool_int_response);
+    // Thermostat, Power and Lights relay status'
+    struct {
+        bool enabled;
+        const int *relays;
+        int count;
+        int *states;
+    } relay_groups[] = {
+        {thermostat_controls_enabled, thermostat_relays, THERMOSTAT_RELAY_COUNT, status.thermostat_relays},
+        {power_tab_enabled, power_device_relays, POWER_DEVICE_COUNT, status.power_relays},
+        {lights_tab_enabled, light_relays, LIGHT_COUNT, status.light_relays},
+    };
+    for (auto &group : relay_groups) {
+        for (int relay = 0; relay < group.count; relay++) {
+            group.states[relay] = RELAY_UNKNOWN;
+            if (!group.enabled || group.relays[relay] <= 0) {
+                continue;
+            }
+            char relay_response[RB_MAX_LEN] = {0};
+            char relay_command[RB_MAX_LEN] = {0};
+            sprintf(relay_command, "%s%d%s", OCS_get_relay_part, group.relays[relay], OCS_command_terminator);
+            if (query(relay_response, relay_command) > 1) {
+                if (strcmp(relay_response, "ON") == 0) {
+                    group.states[relay] = RELAY_ON;
+                } else if (strcmp(relay_response, "OFF") == 0) {
+                    group.states[relay] = RELAY_OFF;
+                }
+            }
         }
+    }
+}
 
-        char humidity_response[RB_MAX_LEN] = {0};
-        int humidity_int_response = 0;
-        int humidity_setpoint_error_or_fail = getCommandIntFromCharResponse(PortFD, humidity_response, &humidity_int_response,
-                                                                            OCS_get_thermostat_humidity_setpoint);
-        if (humidity_setpoint_error_or_fail >= 0 && humidity_int_response != conversion_error) { // errors are negative
-            Thermostat_setpointN[THERMOSTAT_HUMIDITY_SETPOINT].value = humidity_int_response;
-        } else {
-            LOGF_WARN("Communication error on get Thermostat Humidity Setpoint %d, this update aborted, will try again...", humidity_int_response);
-        }
-        IDSetNumber(&Thermostat_setpointsNP, nullptr);
-
-        // Get the Thermostat relay status'
-        for (int relay = 0; relay < THERMOSTAT_RELAY_COUNT; relay++) {
-            if (thermostat_relays[relay] > 0) {
-                char thermo_relay_response[RB_MAX_LEN] = {0};
-                char thermo_relay_command[RB_MAX_LEN] = {0};
-                sprintf(thermo_relay_command, "%s%d%s", OCS_get_relay_part, thermostat_relays[relay], OCS_command_terminator);
-                int thermo_relay_error_or_fail = getCommandSingleCharErrorOrLongResponse(PortFD, thermo_relay_response,
-                                                                                         thermo_relay_command);
-                if (thermo_relay_error_or_fail > 1) {
-                    if (relay == THERMOSTAT_HEAT_RELAY) {
-                        if (strcmp(thermo_relay_response, "ON") == 0) {
-                            Thermostat_heat_relayS[ON_SWITCH].s = ISS_ON;
-                            Thermostat_heat_relayS[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(thermo_relay_response, "OFF") == 0) {
-                            Thermostat_heat_relayS[ON_SWITCH].s = ISS_OFF;
-                            Thermostat_heat_relayS[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&Thermostat_heat_relaySP, nullptr);
-                    } else if (relay == THERMOSTAT_COOL_RELAY) {
-                        if (strcmp(thermo_relay_response, "ON") == 0) {
-                            Thermostat_cool_relayS[ON_SWITCH].s = ISS_ON;
-                            Thermostat_cool_relayS[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(thermo_relay_response, "OFF") == 0) {
-                            Thermostat_cool_relayS[ON_SWITCH].s = ISS_OFF;
-                            Thermostat_cool_relayS[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&Thermostat_cool_relaySP, nullptr);
-                    } else if (relay == THERMOSTAT_HUMIDITY_RELAY) {
-                        if (strcmp(thermo_relay_response, "ON") == 0) {
-                            Thermostat_humidity_relayS[ON_SWITCH].s = ISS_ON;
-                            Thermostat_humidity_relayS[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(thermo_relay_response, "OFF") == 0) {
-                            Thermostat_humidity_relayS[ON_SWITCH].s = ISS_OFF;
-                            Thermostat_humidity_relayS[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&Thermostat_humidity_relaySP, nullptr);
+/******************************************************************
+* Apply a slow status snapshot, only sending properties that change
+*******************************************************************/
+void OCS::ApplySlowStatus(const SlowStatus &status)
+{
+    // Status tab
+    bool status_items_changed = false;
+    if (status.mains_ok) {
+        status_items_changed |= SaveTextIfChanged(&Status_ItemsT[STATUS_MAINS], status.mains);
+    }
+    if (status.safety_ok) {
+        status_items_changed |= SaveTextIfChanged(&Status_ItemsT[STATUS_OCS_SAFETY], status.safety);
+    }
+    if (status.mcu_temperature_ok) {
+        status_items_changed |= SaveTextIfChanged(&Status_ItemsT[STATUS_MCU_TEMPERATURE], status.mcu_temperature);
+    }
+
+    if (status.roof_last_error_ok) {
+        for (const auto &roof_error : roof_error_messages) {
+            if (strcmp(status.roof_last_error, roof_error.response) == 0) {
+                if (strcmp(roof_error.response, last_shutter_error) != 0) {
+                    indi_strlcpy(last_shutter_error, roof_error.response, RB_MAX_LEN);
+                    if (roof_error.is_error && getShutterState() != SHUTTER_ERROR) {
+                        setShutterState(SHUTTER_ERROR);
                     }
+                    LOGF_WARN("%s", roof_error.message);
                 }
+                break;
             }
         }
+        status_items_changed |= SaveTextIfChanged(&Status_ItemsT[STATUS_ROOF_LAST_ERROR], last_shutter_error);
+    }
+    if (status_items_changed) {
+        IDSetText(&Status_ItemsTP, nullptr);
     }
 
-    // Power tab
-    if (power_tab_enabled) {
-        // Get the Power relay status'
-        for (int relay = 0; relay < POWER_DEVICE_COUNT; relay++) {
-            if (power_device_relays[relay] > 0) {
-                char power_relay_response[RB_MAX_LEN] = {0};
-                char power_relay_command[RB_MAX_LEN] = {0};
-                sprintf(power_relay_command, "%s%d%s", OCS_get_relay_part, power_device_relays[relay], OCS_command_terminator);
-                int power_relay_error_or_fail = getCommandSingleCharErrorOrLongResponse(PortFD, power_relay_response,
-                                                                                        power_relay_command);
-                if (power_relay_error_or_fail > 1) {
-                    if (relay == POWER_DEVICE1) {
-                        if (strcmp(power_relay_response, "ON") == 0) {
-                            Power_Device1S[ON_SWITCH].s = ISS_ON;
-                            Power_Device1S[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(power_relay_response, "OFF") == 0) {
-                            Power_Device1S[ON_SWITCH].s = ISS_OFF;
-                            Power_Device1S[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&Power_Device1SP, nullptr);
-                    } else if (relay == POWER_DEVICE2) {
-                        if (strcmp(power_relay_response, "ON") == 0) {
-                            Power_Device2S[ON_SWITCH].s = ISS_ON;
-                            Power_Device2S[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(power_relay_response, "OFF") == 0) {
-                            Power_Device2S[ON_SWITCH].s = ISS_OFF;
-                            Power_Device2S[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&Power_Device2SP, nullptr);
-                    } else if (relay == POWER_DEVICE3) {
-                        if (strcmp(power_relay_response, "ON") == 0) {
-                            Power_Device3S[ON_SWITCH].s = ISS_ON;
-                            Power_Device3S[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(power_relay_response, "OFF") == 0) {
-                            Power_Device3S[ON_SWITCH].s = ISS_OFF;
-                            Power_Device3S[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&Power_Device3SP, nullptr);
-                    } else if (relay == POWER_DEVICE4) {
-                        if (strcmp(power_relay_response, "ON") == 0) {
-                            Power_Device4S[ON_SWITCH].s = ISS_ON;
-                            Power_Device4S[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(power_relay_response, "OFF") == 0) {
-                            Power_Device4S[ON_SWITCH].s = ISS_OFF;
-                            Power_Device4S[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&Power_Device4SP, nullptr);
-                    } else if (relay == POWER_DEVICE5) {
-                        if (strcmp(power_relay_response, "ON") == 0) {
-                            Power_Device5S[ON_SWITCH].s = ISS_ON;
-                            Power_Device5S[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(power_relay_response, "OFF") == 0) {
-                            Power_Device5S[ON_SWITCH].s = ISS_OFF;
-                            Power_Device5S[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&Power_Device5SP, nullptr);
-                    } else if (relay == POWER_DEVICE6) {
-                        if (strcmp(power_relay_response, "ON") == 0) {
-                            Power_Device6S[ON_SWITCH].s = ISS_ON;
-                            Power_Device6S[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(power_relay_response, "OFF") == 0) {
-                            Power_Device6S[ON_SWITCH].s = ISS_OFF;
-                            Power_Device6S[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&Power_Device6SP, nullptr);
-                    }
-                }
+    // Thermostat tab
+    if (thermostat_controls_enabled) {
+        if (status.thermostat_ok) {
+            char thermostat_status[RB_MAX_LEN];
+            indi_strlcpy(thermostat_status, status.thermostat, RB_MAX_LEN);
+            char *split = strtok(thermostat_status, ",");
+            bool thermostat_changed = split && SaveTextIfChanged(&Thermostat_StatusT[THERMOSTAT_TEMERATURE], split);
+            split = strtok(NULL, ",");
+            thermostat_changed |= split && SaveTextIfChanged(&Thermostat_StatusT[THERMOSTAT_HUMIDITY], split);
+            if (thermostat_changed) {
+                IDSetText(&Thermostat_StatusTP, nullptr);
+            }
+        }
+
+        bool setpoints_changed = false;
+        for (int setpoint = 0; setpoint < THERMOSTAT_SETPOINT_COUNT; setpoint++) {
+            if (status.setpoints[setpoint] != conversion_error &&
+                    Thermostat_setpointN[setpoint].value != status.setpoints[setpoint]) {
+                Thermostat_setpointN[setpoint].value = status.setpoints[setpoint];
+                setpoints_changed = true;
             }
         }
+        if (setpoints_changed) {
+            IDSetNumber(&Thermostat_setpointsNP, nullptr);
+        }
     }
 
-    // Lights tab
-    if (lights_tab_enabled) {
-        // Get the Lights relay status'
-        for (int relay = 0; relay < LIGHT_COUNT; relay++) {
-            if (light_relays[relay] > 0) {
-                char light_relay_response[RB_MAX_LEN] = {0};
-                char light_relay_command[RB_MAX_LEN] = {0};
-                sprintf(light_relay_command, "%s%d%s", OCS_get_relay_part, light_relays[relay], OCS_command_terminator);
-                int light_relay_error_or_fail = getCommandSingleCharErrorOrLongResponse(PortFD, light_relay_response,
-                                                                                        light_relay_command);
-                if (light_relay_error_or_fail > 1) {
-                    if (relay == LIGHT_WRW_RELAY) {
-                        if (strcmp(light_relay_response, "ON") == 0) {
-                            LIGHT_WRWS[ON_SWITCH].s = ISS_ON;
-                            LIGHT_WRWS[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(light_relay_response, "OFF") == 0) {
-                            LIGHT_WRWS[ON_SWITCH].s = ISS_OFF;
-                            LIGHT_WRWS[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&LIGHT_WRWSP, nullptr);
-                    } else if (relay == LIGHT_WRR_RELAY) {
-                        if (strcmp(light_relay_response, "ON") == 0) {
-                            LIGHT_WRRS[ON_SWITCH].s = ISS_ON;
-                            LIGHT_WRRS[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(light_relay_response, "OFF") == 0) {
-                            LIGHT_WRRS[ON_SWITCH].s = ISS_OFF;
-                            LIGHT_WRRS[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&LIGHT_WRRSP, nullptr);
-                    } else if (relay == LIGHT_ORW_RELAY) {
-                        if (strcmp(light_relay_response, "ON") == 0) {
-                            LIGHT_ORWS[ON_SWITCH].s = ISS_ON;
-                            LIGHT_ORWS[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(light_relay_response, "OFF") == 0) {
-                            LIGHT_ORWS[ON_SWITCH].s = ISS_OFF;
-                            LIGHT_ORWS[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&LIGHT_ORWSP, nullptr);
-                    } else if (relay == LIGHT_ORR_RELAY) {
-                        if (strcmp(light_relay_response, "ON") == 0) {
-                            LIGHT_ORRS[ON_SWITCH].s = ISS_ON;
-                            LIGHT_ORRS[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(light_relay_response, "OFF") == 0) {
-                            LIGHT_ORRS[ON_SWITCH].s = ISS_OFF;
-                            LIGHT_ORRS[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&LIGHT_ORRSP, nullptr);
-                    } else if (relay == LIGHT_OUTSIDE_RELAY) {
-                        if (strcmp(light_relay_response, "ON") == 0) {
-                            LIGHT_OUTSIDES[ON_SWITCH].s = ISS_ON;
-                            LIGHT_OUTSIDES[OFF_SWITCH].s = ISS_OFF;
-                        } else if (strcmp(light_relay_response, "OFF") == 0) {
-                            LIGHT_OUTSIDES[ON_SWITCH].s = ISS_OFF;
-                            LIGHT_OUTSIDES[OFF_SWITCH].s = ISS_ON;
-                        }
-                        IDSetSwitch(&LIGHT_OUTSIDESP, nullptr);
-                    }
-                }
+    // Relays, in the order of the relay enums of each tab
+    struct {
+        const int *states;
+        int count;
+        ISwitch *toggles[POWER_DEVICE_COUNT];
+        ISwitchVectorProperty *properties[POWER_DEVICE_COUNT];
+    } relay_groups[] = {
+        {status.thermostat_relays, THERMOSTAT_RELAY_COUNT,
+            {Thermostat_heat_relayS, Thermostat_cool_relayS, Thermostat_humidity_relayS},
+            {&Thermostat_heat_relaySP, &Thermostat_cool_relaySP, &Thermostat_humidity_relaySP}},
+        {status.power_relays, POWER_DEVICE_COUNT,
+            {Power_Device1S, Power_Device2S, Power_Device3S, Power_Device4S, Power_Device5S, Power_Device6S},
+            {&Power_Device1SP, &Power_Device2SP, &Power_Device3SP, &Power_Device4SP, &Power_Device5SP, &Power_Device6SP}},
+        {status.light_relays, LIGHT_COUNT,
+            {LIGHT_WRWS, LIGHT_WRRS, LIGHT_ORWS, LIGHT_ORRS, LIGHT_OUTSIDES},
+            {&LIGHT_WRWSP, &LIGHT_WRRSP, &LIGHT_ORWSP, &LIGHT_ORRSP, &LIGHT_OUTSIDESP}},
+    };
+    for (auto &group : relay_groups) {
+        for (int relay = 0; relay < group.count; relay++) {
+            if (SaveRelayIfChanged(group.toggles[relay], group.states[relay])) {
+                IDSetSwitch(group.properties[relay], nullptr);
             }
         }
     }
 }
 
+bool OCS::SaveTextIfChanged(IText *text, const char *value)
+{
+    if (text->text != nullptr && strcmp(text->text, value) == 0) {
+        return false;
+    }
+    IUSaveText(text, value);
+    return true;
+}
+
+bool OCS::SaveRelayIfChanged(ISwitch *toggle, int state)
+{
+    if (state == RELAY_UNKNOWN) {
+        return false;
+    }
+    ISState on_state = (state == RELAY_ON) ? ISS_ON : ISS_OFF;
+    ISState off_state = (state == RELAY_ON) ? ISS_OFF : ISS_ON;
+    if (toggle[ON_SWITCH].s == on_state && toggle[OFF_SWITCH].s == off_state) {
+        return false;
+    }
+    toggle[ON_SWITCH].s = on_state;
+    toggle[OFF_SWITCH].s = off_state;
+    return true;
+}
+
 /*****************************************************************
 * Poll Weather properties for updates - period set by Weather poll
 ******************************************************************/
@@ -1612,6 +1517,9 @@ bool OCS::Connect()
 ************************************************************/
 bool OCS::Disconnect()
 {
+    // The slow poll thread uses the port, stop it before the port is closed
+    SlowTimer.stop();
+    StopSlowPolling();
     bool status = INDI::Dome::Disconnect();
     return status;
 }
@@ -2024,10 +1932,9 @@ bool OCS::sendOCSCommandBlind(const char *cmd)
 
     DEBUGF(INDI::Logger::DBG_DEBUG, "CMD <%s>", cmd);
 
-    flushIO(PortFD);
     /* Add mutex */
     std::unique_lock<std::mutex> guard(ocsCommsLock);
-    tcflush(PortFD, TCIFLUSH);
+    flushIO(PortFD);
 
     if ((error_type = tty_write_string(PortFD, cmd, &nbytes_write)) != TTY_OK) {
         LOGF_ERROR("CHECK CONNECTION: Error sending command %s", cmd);
@@ -2049,10 +1956,9 @@ bool OCS::sendOCSCommand(const char *cmd)
 
     DEBUGF(INDI::Logger::DBG_DEBUG, "CMD <%s>", cmd);
 
-    flushIO(PortFD);
     /* Add mutex */
     std::unique_lock<std::mutex> guard(ocsCommsLock);
-    tcflush(PortFD, TCIFLUSH);
+    flushIO(PortFD);
 
     if ((error_type = tty_write_string(PortFD, cmd, &nbytes_write)) != TTY_OK)
         return error_type;
@@ -2081,9 +1987,9 @@ int OCS::getCommandSingleCharResponse(int fd, char *data, const char *cmd)
 
     DEBUGF(INDI::Logger::DBG_DEBUG, "CMD <%s>", cmd);
 
-    flushIO(fd);
     /* Add mutex */
     std::unique_lock<std::mutex> guard(ocsCommsLock);
+    flushIO(fd);
 
     if ((error_type = tty_write_string(fd, cmd, &nbytes_write)) != TTY_OK)
         return error_type;
@@ -2120,10 +2026,9 @@ int OCS::getCommandDoubleResponse(int fd, double *value, char *data, const char
 
     DEBUGF(INDI::Logger::DBG_DEBUG, "CMD <%s>", cmd);
 
-    flushIO(fd);
     /* Add mutex */
     std::unique_lock<std::mutex> guard(ocsCommsLock);
-    tcflush(fd, TCIFLUSH);
+    flushIO(fd);
 
     if ((error_type = tty_write_string(fd, cmd, &nbytes_write)) != TTY_OK)
         return error_type;
@@ -2171,10 +2076,9 @@ int OCS::getCommandIntResponse(int fd, int *value, char *data, const char *cmd)
 
     DEBUGF(INDI::Logger::DBG_DEBUG, "CMD <%s>", cmd);
 
-    flushIO(fd);
     /* Add mutex */
     std::unique_lock<std::mutex> guard(ocsCommsLock);
-    tcflush(fd, TCIFLUSH);
+    flushIO(fd);
 
     if ((error_type = tty_write_string(fd, cmd, &nbytes_write)) != TTY_OK)
         return error_type;
@@ -2214,6 +2118,15 @@ int OCS::getCommandIntResponse(int fd, int *value, char *data, const char *cmd)
  * Send command to OCS that expects a char[] return (could be a single char)
  * *************************************************************************/
 int OCS::getCommandSingleCharErrorOrLongResponse(int fd, char *data, const char *cmd)
+{
+    return getCommandResponse(fd, data, cmd, true);
+}
+
+/*******************************************************************
+ * As getCommandSingleCharErrorOrLongResponse, but lets the caller skip
+ * the full flush so a batch of queries only needs to flush once
+ * *****************************************************************/
+int OCS::getCommandResponse(int fd, char *data, const char *cmd, bool flush)
 {
     char *term;
     int error_type;
@@ -2221,10 +2134,13 @@ int OCS::getCommandSingleCharErrorOrLongResponse(int fd, char *data, const char
 
     DEBUGF(INDI::Logger::DBG_DEBUG, "CMD <%s>", cmd);
 
-    flushIO(fd);
     /* Add mutex */
     std::unique_lock<std::mutex> guard(ocsCommsLock);
-    tcflush(fd, TCIFLUSH);
+    if (flush) {
+        flushIO(fd);
+    } else {
+        tcflush(fd, TCIFLUSH);
+    }
 
     if ((error_type = tty_write_string(fd, cmd, &nbytes_write)) != TTY_OK)
         return error_type;
@@ -2275,15 +2191,13 @@ int OCS::getCommandIntFromCharResponse(int fd, char *data, int *response, const
 }
 
 
-/**********************
- * Flush the comms port
- * ********************/
+/****************************************************
+ * Flush the comms port, caller must hold ocsCommsLock
+ * **************************************************/
 int OCS::flushIO(int fd)
 {
-    tcflush(fd, TCIOFLUSH);
     int error_type = 0;
     int nbytes_read;
-    std::unique_lock<std::mutex> guard(ocsCommsLock);
     tcflush(fd, TCIOFLUSH);
     do {
         char discard_data[RB_MAX_LEN] = {0};
@@ -25,6 +25,10 @@
 #include "indipropertyswitch.h"
 #include "inditimer.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #define RB_MAX_LEN 64
 #define CMD_MAX_LEN 32
 enum ResponseErrors {RES_ERR_FORMAT = -1001};
@@ -416,7 +420,7 @@ class OCS : public INDI::Dome, public INDI::WeatherInterface
 {
   public:
     OCS();
-    virtual ~OCS() override = default;
+    virtual ~OCS() override;
     const char *getDefaultName() override;
     virtual bool initProperties() override;
     virtual void ISGetProperties(const char *dev) override;
@@ -439,9 +443,10 @@ class OCS : public INDI::Dome, public INDI::WeatherInterface
 
     bool sendOCSCommand(const char *cmd);
     bool sendOCSCommandBlind(const char *cmd);
-    int flushIO(int fd);
+    int flushIO(int fd); //Caller must hold ocsCommsLock
     int getCommandSingleCharResponse(int fd, char *data, const char *cmd); //Reimplemented from getCommandString
     int getCommandSingleCharErrorOrLongResponse(int fd, char *data, const char *cmd); //Reimplemented from getCommandString
+    int getCommandResponse(int fd, char *data, const char *cmd, bool flush); //As above, flushIO only if flush is set, for batched queries
     int getCommandDoubleResponse(int fd, double *value, char *data,
                                  const char *cmd); //Reimplemented from getCommandString Will return a double, and raw value.
     int getCommandIntResponse(int fd, int *value, char *data, const char *cmd);
@@ -694,5 +699,48 @@ private:
     // Debug only
     // ITextVectorProperty Arbitary_CommandTP;
     // IText Arbitary_CommandT[1];
+
+    // Slow (once per minute) status polling
+    //--------------------------------------
+    // Relay states in a snapshot, RELAY_UNKNOWN if the query failed
+    enum {
+        RELAY_UNKNOWN = -1,
+        RELAY_OFF,
+        RELAY_ON
+    };
+
+    struct SlowStatus {
+        char mains[RB_MAX_LEN] {};
+        char safety[RB_MAX_LEN] {};
+        char mcu_temperature[RB_MAX_LEN] {};
+        char roof_last_error[RB_MAX_LEN] {};
+        char thermostat[RB_MAX_LEN] {};
+        bool mains_ok = false;
+        bool safety_ok = false;
+        bool mcu_temperature_ok = false;
+        bool roof_last_error_ok = false;
+        bool thermostat_ok = false;
+        int setpoints[THERMOSTAT_SETPOINT_COUNT] {};
+        int thermostat_relays[THERMOSTAT_RELAY_COUNT] {};
+        int power_relays[POWER_DEVICE_COUNT] {};
+        int light_relays[LIGHT_COUNT] {};
+    };
+
+    // Queries run on slow_poll_thread, the result is applied to properties from TimerHit
+    void SlowPollThread();
+    void PollSlowStatus(SlowStatus &status);
+    void ApplySlowStatus(const SlowStatus &status);
+    void StartSlowPolling();
+    void StopSlowPolling();
+    bool SaveTextIfChanged(IText *text, const char *value);
+    bool SaveRelayIfChanged(ISwitch *toggle, int state);
+
+    std::thread slow_poll_thread;
+    std::mutex slow_poll_lock;
+    std::condition_variable slow_poll_cv;
+    bool slow_poll_requested = false;
+    bool slow_poll_quit = false;
+    bool slow_status_ready = false;
+    SlowStatus slow_status;
 };
 
@@ -0,0 +1,306 @@
+/*******************************************************************************
+ OCS slow status polling test
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+// Runs the slow status cycle against a simulated OCS on a pty. Reports the serial time of a
+// cycle against the same queries flushed one by one, as the poll used to send them, and counts
+// the property updates a cycle sends to clients.
+
+#include <gtest/gtest.h>
+
+#include <indidome.h>
+#include <indiweather.h>
+#include <connectionplugins/connectiontcp.h>
+#include <connectionplugins/connectionserial.h>
+#include <indipropertyswitch.h>
+#include <inditimer.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fcntl.h>
+#include <map>
+#include <mutex>
+#include <poll.h>
+#include <stdlib.h>
+#include <string>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// The slow status cycle is driven by hand instead of waiting for the minute timer
+#define private public
+#define protected public
+#include "ocs.h"
+#undef private
+#undef protected
+
+extern std::unique_ptr<OCS> ocs;
+
+static const char *DeviceName = "OCS";
+
+// OCS on the master side of a pty: thermostat, two power devices and two lights, no weather
+class OCSSimulator
+{
+    public:
+        OCSSimulator()
+        {
+            master = posix_openpt(O_RDWR | O_NOCTTY);
+            EXPECT_GE(master, 0);
+            grantpt(master);
+            unlockpt(master);
+            struct termios tio;
+            tcgetattr(master, &tio);
+            cfmakeraw(&tio);
+            tcsetattr(master, TCSANOW, &tio);
+            slave = ptsname(master);
+
+            replies = {
+                {":IP#", "OCS#"}, {":IN#", "3.10#"}, {":IT#", "5,5#"},
+                {":GT#", "21.5,45#"}, {":It#", "1,2,3#"},
+                {":GH#", "18#"}, {":GV#", "25#"}, {":GD#", "60#"},
+                {":Ip#", "4,5,-1,-1,-1,-1#"}, {":IL#", "6,7,-1,-1,-1#"},
+                {":GP#", "OK#"}, {":Gs#", "SAFE#"}, {":GX9F#", "32.5#"},
+                {":RSL#", "None#"}, {":RS#", "i,CLOSED#"},
+            };
+            for (const char *weather : { ":G1#", ":G2#", ":G3#", ":Gb#", ":Gh#", ":Gw#", ":GR#", ":GC#", ":GQ#" })
+                replies[weather] = "N/A#";
+            for (int device = 1; device <= 6; device++)
+                replies[":Ip" + std::to_string(device) + "#"] = "Device " + std::to_string(device) + "#";
+            for (int relay = 1; relay <= 7; relay++)
+                setRelay(relay, relay % 2);
+
+            thread = std::thread(&OCSSimulator::run, this);
+        }
+
+        ~OCSSimulator()
+        {
+            quit = true;
+            thread.join();
+            close(master);
+        }
+
+        void setRelay(int relay, bool on)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            replies[":GR" + std::to_string(relay) + "#"] = on ? "ON#" : "OFF#";
+        }
+
+        void setReply(const std::string &command, const std::string &reply)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            replies[command] = reply;
+        }
+
+        std::vector<std::string> takeCommands()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<std::string> taken;
+            taken.swap(commands);
+            return taken;
+        }
+
+        std::string slave;
+
+    private:
+        void run()
+        {
+            std::string command;
+            char c;
+            while (!quit)
+            {
+                struct pollfd fds = { master, POLLIN, 0 };
+                if (poll(&fds, 1, 20) <= 0 || read(master, &c, 1) != 1)
+                    continue;
+                if (c == ':')
+                    command.clear();
+                command += c;
+                if (c != '#')
+                    continue;
+
+                // Unknown commands get no reply and time out in the driver
+                std::string reply;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    commands.push_back(command);
+                    auto it = replies.find(command);
+                    if (it != replies.end())
+                        reply = it->second;
+                }
+                if (!reply.empty() && write(master, reply.data(), reply.size()) != static_cast<ssize_t>(reply.size()))
+                    ADD_FAILURE() << "simulator write failed";
+                command.clear();
+            }
+        }
+
+        int master { -1 };
+        std::thread thread;
+        std::atomic_bool quit { false };
+        std::mutex mutex;
+        std::map<std::string, std::string> replies;
+        std::vector<std::string> commands;
+};
+
+// Collects what the driver sends to clients on stdout
+class ClientTraffic
+{
+    public:
+        ClientTraffic()
+        {
+            fflush(stdout);
+            saved = dup(STDOUT_FILENO);
+            int fds[2];
+            EXPECT_EQ(pipe(fds), 0);
+            dup2(fds[1], STDOUT_FILENO);
+            close(fds[1]);
+            reader = fds[0];
+            thread = std::thread([this]()
+            {
+                char buffer[4096];
+                ssize_t n;
+                while ((n = read(reader, buffer, sizeof(buffer))) > 0)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    output.append(buffer, n);
+                    cv.notify_all();
+                }
+            });
+        }
+
+        ~ClientTraffic()
+        {
+            fflush(stdout);
+            dup2(saved, STDOUT_FILENO);
+            close(saved);
+            thread.join();
+            close(reader);
+        }
+
+        // Property updates sent since the last call
+        int takeUpdates()
+        {
+            // A marker written after the updates tells us the reader has caught up
+            printf("<traffic-mark/>\n");
+            fflush(stdout);
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait_for(lock, std::chrono::seconds(2), [this]()
+            {
+                return output.find("<traffic-mark/>") != std::string::npos;
+            });
+            int updates = 0;
+            for (const char *tag : { "<setTextVector", "<setNumberVector", "<setSwitchVector" })
+                for (size_t pos = output.find(tag); pos != std::string::npos; pos = output.find(tag, pos + 1))
+                    updates++;
+            output.clear();
+            return updates;
+        }
+
+    private:
+        int saved { -1 };
+        int reader { -1 };
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::string output;
+};
+
+static void newSwitch(const char *name, const char *element)
+{
+    ISState states[] = { ISS_ON };
+    char *names[] = { const_cast<char *>(element) };
+    ISNewSwitch(DeviceName, name, states, names, 1);
+}
+
+// One slow status cycle as the poll thread and TimerHit run it, returning the serial time in ms
+static double slowCycle(OCS::SlowStatus &status)
+{
+    auto start = std::chrono::steady_clock::now();
+    ocs->PollSlowStatus(status);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    ocs->ApplySlowStatus(status);
+    return ms;
+}
+
+TEST(OCS, SlowStatusCycle)
+{
+    OCSSimulator sim;
+    ClientTraffic traffic;
+
+    ISGetProperties(nullptr);
+
+    char *port[] = { const_cast<char *>(sim.slave.c_str()) };
+    char *portNames[] = { const_cast<char *>("PORT") };
+    ISNewText(DeviceName, "DEVICE_PORT", port, portNames, 1);
+
+    newSwitch("CONNECTION", "CONNECT");
+    ASSERT_TRUE(ocs->isConnected());
+    ASSERT_TRUE(ocs->thermostat_controls_enabled);
+    ASSERT_TRUE(ocs->power_tab_enabled);
+    ASSERT_TRUE(ocs->lights_tab_enabled);
+    traffic.takeUpdates();
+    sim.takeCommands();
+
+    // Nothing changed since the poll run on connect: the cycle sends nothing
+    OCS::SlowStatus status;
+    double msBatched = slowCycle(status);
+    int unchangedUpdates = traffic.takeUpdates();
+    std::vector<std::string> cycle = sim.takeCommands();
+    EXPECT_EQ(unchangedUpdates, 0);
+    EXPECT_TRUE(status.mains_ok && status.safety_ok && status.mcu_temperature_ok && status.thermostat_ok);
+    EXPECT_EQ(std::string(ocs->Status_ItemsT[OCS::STATUS_MAINS].text), "OK");
+
+    // Every query is answered, so the batch flushes only once
+    ASSERT_EQ(cycle.size(), 15u);
+
+    // The same queries flushed one by one, as the poll used to send them
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &command : cycle)
+    {
+        char response[RB_MAX_LEN] = {0};
+        EXPECT_GT(ocs->getCommandSingleCharErrorOrLongResponse(ocs->PortFD, response, command.c_str()), 1) << command;
+    }
+    double msFlushed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    traffic.takeUpdates();
+
+    // One relay and the thermostat reading change: exactly those two properties are sent
+    sim.setRelay(4, true);
+    sim.setReply(":GT#", "22.0,45#");
+    slowCycle(status);
+    int changedUpdates = traffic.takeUpdates();
+    EXPECT_EQ(changedUpdates, 2);
+    EXPECT_EQ(ocs->Power_Device1S[OCS::ON_SWITCH].s, ISS_ON);
+    EXPECT_EQ(std::string(ocs->Thermostat_StatusT[OCS::THERMOSTAT_TEMERATURE].text), "22.0");
+
+    // The old poll sent the status items three times, the thermostat status and setpoints,
+    // and every defined relay on every cycle
+    int resentUpdates = 3 + 2 + 3 + 2 + 2;
+
+    fprintf(stderr, "Slow status cycle, %zu queries: %.2f ms batched, %.2f ms flushed per query\n",
+            cycle.size(), msBatched, msFlushed);
+    fprintf(stderr, "Property updates per cycle: %d unchanged, %d after two changes, %d resent by the old poll\n",
+            unchangedUpdates, changedUpdates, resentUpdates);
+
+    newSwitch("CONNECTION", "DISCONNECT");
+    EXPECT_FALSE(ocs->isConnected());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
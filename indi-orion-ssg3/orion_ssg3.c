@@ -49,6 +49,10 @@
 #define ICX419_PIXEL_SIZE_X 8.6
 #define ICX419_PIXEL_SIZE_Y 8.4
 
+#define ORION_SSG3_ROWS_IN_FLIGHT 16 /* Row transfers kept queued during download */
+#define ORION_SSG3_ROW_TIMEOUT 5000 /* ms */
+#define ORION_SSG3_MAX_ROW_FAILURES 10
+
 #define countof(x) (sizeof(x)/sizeof(x[0]))
 static const struct orion_ssg3_model ssg3_models[] = {
     {
@@ -205,6 +209,10 @@ int orion_ssg3_open(struct orion_ssg3 *ssg3, struct orion_ssg3_info *info)
     ssg3->x_count = ICX419_EFFECTIVE_X_COUNT;
     ssg3->y1 = ICX419_EFFECTIVE_Y_START;
     ssg3->y_count = ICX419_EFFECTIVE_Y_COUNT;
+    ssg3->row_bufs = NULL;
+    ssg3->row_bufs_sz = 0;
+    ssg3->row_map = NULL;
+    ssg3->row_map_rows = 0;
 
 	rc = libusb_open(info->dev, &ssg3->devh);
 	if (rc) {
@@ -236,6 +244,12 @@ int orion_ssg3_close(struct orion_ssg3 *ssg3)
 	    libusb_close(ssg3->devh);
         ssg3->devh = NULL;
     }
+    free(ssg3->row_bufs);
+    ssg3->row_bufs = NULL;
+    ssg3->row_bufs_sz = 0;
+    free(ssg3->row_map);
+    ssg3->row_map = NULL;
+    ssg3->row_map_rows = 0;
 
 	return 0;
 }
@@ -455,71 +469,190 @@ int orion_ssg3_subframe(struct orion_ssg3 *ssg3, uint16_t x1, uint16_t x_count,
     return rc;
 }
 
+/**
+ * Build the de-interlace map for the current number of rows.
+ * The SSG3 has an interlace CCD, so the horizontal lines don't come out in order. Instead,
+ * they are split into an even and odd field. We get the even lines first and then the odd
+ * lines. row_map[y] is the download row holding frame line y, and the second half of
+ * row_map lists the frame lines ordered by when their download row arrives.
+ */
+static int orion_ssg3_update_row_map(struct orion_ssg3 *ssg3)
+{
+    int rows = ssg3->y_count;
+    int *map;
+    int *order;
+    int y, even, odd, k;
+
+    if (ssg3->row_map && ssg3->row_map_rows == rows) {
+        return 0;
+    }
+
+    map = realloc(ssg3->row_map, 2 * rows * sizeof(int));
+    if (!map) {
+        return -ENOMEM;
+    }
+    ssg3->row_map = map;
+    ssg3->row_map_rows = rows;
+
+    for (y = 0; y < rows; y++) {
+        if (y % 2 == 0) {
+            map[y] = (y / 2);
+        } else {
+            map[y] = (rows / 2) + (y / 2);
+        }
+    }
+
+    /* Both fields are in ascending download order, merge them */
+    order = map + rows;
+    for (even = 0, odd = 1, k = 0; even < rows || odd < rows;) {
+        if (odd >= rows || (even < rows && map[even] <= map[odd])) {
+            order[k++] = even;
+            even += 2;
+        } else {
+            order[k++] = odd;
+            odd += 2;
+        }
+    }
+
+    return 0;
+}
+
+/* The raw pixel data is sent big-endian */
+static void orion_ssg3_swap_row(uint16_t *dst, const uint16_t *src, int count)
+{
+    int x;
+
+    for (x = 0; x < count; x++) {
+        dst[x] = be16toh(src[x]);
+    }
+}
+
+static void LIBUSB_CALL orion_ssg3_row_done(struct libusb_transfer *xfer)
+{
+    *(int *) xfer->user_data = 1;
+}
+
 /**
  * Download an image
+ * Rows are read with a window of queued bulk transfers so the camera never waits on the
+ * host between lines. Each row is de-interlaced and byte swapped into the frame as soon
+ * as it arrives, while the following rows are still being transferred.
  * @param ssg3: The ssg3 structure used to communicate with the camera
  * @param buf: The buffer to store the frame in
  * @param len: The number of bytes available in buf
  */
 int orion_ssg3_image_download(struct orion_ssg3 *ssg3, uint8_t *buf, int len)
 {
+    struct libusb_transfer *xfers[ORION_SSG3_ROWS_IN_FLIGHT];
+    int done[ORION_SSG3_ROWS_IN_FLIGHT];
+    struct libusb_transfer *xfer;
     int line_sz;
-    int got;
-    uint16_t *tmp;
-    int x, y;
     uint16_t *frame;
     int rc = 0;
     int i;
     int fail_cnt;
     int needed;
     int total;
+    int received; /* Rows received so far, in download order */
+    int submitted; /* Transfers submitted, each one uses slot submitted % ORION_SSG3_ROWS_IN_FLIGHT */
+    int in_flight;
+    int oldest;
+    int emitted;
+    int *order;
 
     frame = (uint16_t *) buf;
     
     needed = ssg3->x_count * ssg3->y_count * 2; /* 2 bytes/pixel */
-    if (needed < len) {
+    if (len < needed) {
         return -ENOSPC;
     }
 
-    tmp = malloc(needed);
-    if (!tmp) {
-        return -ENOMEM;
+    line_sz = ssg3->x_count * 2; /* 2 bytes/pixel */
+
+    if (ssg3->row_bufs_sz < (size_t) line_sz * ORION_SSG3_ROWS_IN_FLIGHT) {
+        uint8_t *row_bufs = realloc(ssg3->row_bufs, line_sz * ORION_SSG3_ROWS_IN_FLIGHT);
+        if (!row_bufs) {
+            return -ENOMEM;
+        }
+        ssg3->row_bufs = row_bufs;
+        ssg3->row_bufs_sz = line_sz * ORION_SSG3_ROWS_IN_FLIGHT;
     }
 
-    line_sz = ssg3->x_count * 2; /* 2 bytes/pixel */
+    rc = orion_ssg3_update_row_map(ssg3);
+    if (rc) {
+        return rc;
+    }
+    order = ssg3->row_map + ssg3->y_count;
 
-    for (i = 0, fail_cnt = 0, total = 0; i < ssg3->y_count && fail_cnt < 10;) {
-        rc = libusb_bulk_transfer(ssg3->devh, ORION_SSG3_BULK_EP, &(((unsigned char *) tmp)[i * line_sz]), line_sz, &got, 5000);
-        if (!rc) {
-            total += got;
-            i++;
-            fail_cnt = 0;
-        } else {
-            fail_cnt++;
+    for (i = 0; i < ORION_SSG3_ROWS_IN_FLIGHT; i++) {
+        xfers[i] = libusb_alloc_transfer(0);
+        if (!xfers[i]) {
+            rc = -ENOMEM;
         }
     }
 
-    fprintf(stderr, "needed = %d, total = %d, len = %d\n", needed, total, len);
+    received = submitted = in_flight = emitted = 0;
+    fail_cnt = total = 0;
+
+    while (!rc && received < ssg3->y_count) {
+        /* Keep the window full. A failed transfer leaves no data, so the next one
+           to succeed carries the row it was waiting for. */
+        while (in_flight < ORION_SSG3_ROWS_IN_FLIGHT && received + in_flight < ssg3->y_count) {
+            i = submitted % ORION_SSG3_ROWS_IN_FLIGHT;
+            libusb_fill_bulk_transfer(xfers[i], ssg3->devh, ORION_SSG3_BULK_EP, &ssg3->row_bufs[i * line_sz],
+                    line_sz, orion_ssg3_row_done, &done[i], ORION_SSG3_ROW_TIMEOUT);
+            done[i] = 0;
+            rc = libusb_submit_transfer(xfers[i]);
+            if (rc) {
+                rc = -libusb_to_errno(rc);
+                break;
+            }
+            submitted++;
+            in_flight++;
+        }
+        if (!in_flight) {
+            break;
+        }
 
-    /* The SSG3 has an interlace CCD, so the horizontal lines don't come out in order. Instead,
-       they are split into an even and odd field. We get the even lines first and then the odd
-       lines. This loop below de-interlaces the image to put the lines in the correct order
-       in the frame buffer. */
-    for (y = 0; y < ssg3->y_count; y++) {
-        int download_y; /* The y line in the download buffer */
-        if (y % 2 == 0) {
-            download_y = (y / 2);
-        } else {
-            download_y = (ssg3->y_count / 2) + (y / 2);
+        /* Transfers on one endpoint complete in order, wait for the oldest */
+        oldest = (submitted - in_flight) % ORION_SSG3_ROWS_IN_FLIGHT;
+        xfer = xfers[oldest];
+        while (!done[oldest]) {
+            libusb_handle_events_completed(NULL, &done[oldest]);
         }
+        in_flight--;
 
-        for (x = 0; x < ssg3->x_count; x++) {
-            /* The raw pixel data is sent big-endian */
-            frame[x + y * ssg3->x_count] = be16toh(tmp[x + download_y * ssg3->x_count]);
+        if (xfer->status != LIBUSB_TRANSFER_COMPLETED) {
+            if (++fail_cnt >= ORION_SSG3_MAX_ROW_FAILURES) {
+                rc = -EIO;
+            }
+            continue;
         }
+        fail_cnt = 0;
+        total += xfer->actual_length;
+
+        /* Place the row in every frame line it belongs to */
+        while (emitted < ssg3->y_count && ssg3->row_map[order[emitted]] == received) {
+            orion_ssg3_swap_row(&frame[order[emitted] * ssg3->x_count], (const uint16_t *) xfer->buffer,
+                    ssg3->x_count);
+            emitted++;
+        }
+        received++;
+    }
+
+    /* Reap anything still queued before the transfers go away */
+    for (; in_flight > 0; in_flight--) {
+        oldest = (submitted - in_flight) % ORION_SSG3_ROWS_IN_FLIGHT;
+        libusb_cancel_transfer(xfers[oldest]);
+        while (!done[oldest]) {
+            libusb_handle_events_completed(NULL, &done[oldest]);
+        }
+    }
+    for (i = 0; i < ORION_SSG3_ROWS_IN_FLIGHT; i++) {
+        libusb_free_transfer(xfers[i]);
     }
 
-    free(tmp);
+    fprintf(stderr, "needed = %d, total = %d, len = %d\n", needed, total, len);
 
     return rc;
 }
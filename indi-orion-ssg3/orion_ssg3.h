@@ -52,6 +52,10 @@ struct orion_ssg3 {
     uint16_t y1;
     uint16_t y_count;
     struct timeval exp_done_time;
+    uint8_t *row_bufs; /* Receive buffers for the queued row transfers, kept between exposures */
+    size_t row_bufs_sz;
+    int *row_map; /* Download row of each frame row, followed by the frame rows in arrival order */
+    int row_map_rows;
 };
 
 enum {
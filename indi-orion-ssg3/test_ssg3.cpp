@@ -0,0 +1,428 @@
+/**
+ * Orion StarShoot G3 image download test
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Replays random field streams through a fake asynchronous libusb, once through the
+// synchronous row reads and de-interlace pass orion_ssg3_image_download used before, once
+// through the driver. Every transfer costs a host turnaround counted from its submission,
+// plus an optional readout time per row.
+
+#include <gtest/gtest.h>
+
+#include "orion_ssg3.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <endian.h>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+class FakeUSB
+{
+    public:
+        ~FakeUSB()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quit = true;
+                cv.notify_all();
+            }
+            if (worker.joinable())
+                worker.join();
+        }
+
+        void load(const std::vector<unsigned char> &data)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stream = data;
+            pos = 0;
+            serviced = 0;
+        }
+
+        int submit(libusb_transfer *transfer)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!worker.joinable())
+                worker = std::thread(&FakeUSB::run, this);
+            submittedAt[transfer] = Clock::now();
+            queued.push_back(transfer);
+            cv.notify_all();
+            return 0;
+        }
+
+        int cancel(libusb_transfer *transfer)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = std::find(queued.begin(), queued.end(), transfer);
+            if (it != queued.end())
+            {
+                // A transfer still waiting for the bus completes as cancelled right away
+                queued.erase(it);
+                cancelled++;
+                finish(transfer, LIBUSB_TRANSFER_CANCELLED);
+                return 0;
+            }
+            if (transfer != inFlight)
+                return LIBUSB_ERROR_NOT_FOUND;
+            // One on the bus completes as cancelled when the bus lets go of it
+            cancelInFlight = true;
+            cancelled++;
+            return 0;
+        }
+
+        // Runs the callbacks of finished transfers on the calling thread, like libusb does
+        int handleEvents(int *completed)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (done.empty() && !*completed)
+                cv.wait(lock);
+            while (!done.empty())
+            {
+                libusb_transfer *transfer = done.front();
+                done.pop_front();
+                submittedAt.erase(transfer);
+                lock.unlock();
+                transfer->callback(transfer);
+                lock.lock();
+            }
+            return 0;
+        }
+
+        void release(libusb_transfer *transfer)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (submittedAt.count(transfer))
+                    freedPending++;
+            }
+            delete transfer;
+        }
+
+        // The synchronous row read orion_ssg3_image_download used before
+        int bulkRead(unsigned char *data, int length, int *transferred)
+        {
+            std::this_thread::sleep_for(Turnaround + rowTime);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (fails())
+            {
+                *transferred = 0;
+                return LIBUSB_ERROR_TIMEOUT;
+            }
+            memcpy(data, stream.data() + pos, length);
+            pos += length;
+            *transferred = length;
+            return 0;
+        }
+
+        static constexpr std::chrono::microseconds Turnaround { 125 };
+        std::chrono::microseconds rowTime { 0 };
+        // Transfer number that times out, or the first of them with failAllFrom
+        int failAt { -1 };
+        bool failAllFrom { false };
+        int cancelled { 0 };
+        int freedPending { 0 };
+
+    private:
+        bool fails()
+        {
+            int n = serviced++;
+            return failAt >= 0 && (n == failAt || (failAllFrom && n > failAt));
+        }
+
+        void finish(libusb_transfer *transfer, libusb_transfer_status status)
+        {
+            transfer->status = status;
+            if (status != LIBUSB_TRANSFER_COMPLETED)
+                transfer->actual_length = 0;
+            done.push_back(transfer);
+            cv.notify_all();
+        }
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!quit)
+            {
+                if (queued.empty())
+                {
+                    cv.wait(lock);
+                    continue;
+                }
+                libusb_transfer *transfer = queued.front();
+                queued.pop_front();
+                Clock::time_point ready = submittedAt[transfer] + Turnaround;
+                inFlight = transfer;
+                lock.unlock();
+                std::this_thread::sleep_until(ready);
+                std::this_thread::sleep_for(rowTime);
+                lock.lock();
+                inFlight = nullptr;
+                if (cancelInFlight)
+                {
+                    cancelInFlight = false;
+                    finish(transfer, LIBUSB_TRANSFER_CANCELLED);
+                    continue;
+                }
+                if (fails())
+                {
+                    finish(transfer, LIBUSB_TRANSFER_TIMED_OUT);
+                    continue;
+                }
+                memcpy(transfer->buffer, stream.data() + pos, transfer->length);
+                pos += transfer->length;
+                transfer->actual_length = transfer->length;
+                finish(transfer, LIBUSB_TRANSFER_COMPLETED);
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::thread worker;
+        bool quit { false };
+        libusb_transfer *inFlight { nullptr };
+        bool cancelInFlight { false };
+        std::deque<libusb_transfer *> queued, done;
+        std::map<libusb_transfer *, Clock::time_point> submittedAt;
+        std::vector<unsigned char> stream;
+        size_t pos { 0 };
+        int serviced { 0 };
+};
+
+constexpr std::chrono::microseconds FakeUSB::Turnaround;
+
+static FakeUSB *fake;
+
+extern "C" {
+libusb_transfer *libusb_alloc_transfer(int)
+{
+    return new libusb_transfer();
+}
+
+void libusb_free_transfer(libusb_transfer *transfer)
+{
+    fake->release(transfer);
+}
+
+int libusb_submit_transfer(libusb_transfer *transfer)
+{
+    return fake->submit(transfer);
+}
+
+int libusb_cancel_transfer(libusb_transfer *transfer)
+{
+    return fake->cancel(transfer);
+}
+
+int libusb_handle_events_completed(libusb_context *, int *completed)
+{
+    return fake->handleEvents(completed);
+}
+
+int libusb_bulk_transfer(libusb_device_handle *, unsigned char, unsigned char *data, int length, int *transferred,
+                         unsigned int)
+{
+    return fake->bulkRead(data, length, transferred);
+}
+
+// Not used by the download
+int libusb_init(libusb_context **)
+{
+    return 0;
+}
+
+ssize_t libusb_get_device_list(libusb_context *, libusb_device ***)
+{
+    return 0;
+}
+
+void libusb_free_device_list(libusb_device **, int)
+{
+}
+
+int libusb_get_device_descriptor(libusb_device *, struct libusb_device_descriptor *)
+{
+    return LIBUSB_ERROR_NOT_SUPPORTED;
+}
+
+libusb_device *libusb_ref_device(libusb_device *dev)
+{
+    return dev;
+}
+
+int libusb_open(libusb_device *, libusb_device_handle **)
+{
+    return LIBUSB_ERROR_NOT_SUPPORTED;
+}
+
+void libusb_close(libusb_device_handle *)
+{
+}
+
+int libusb_set_configuration(libusb_device_handle *, int)
+{
+    return 0;
+}
+
+int libusb_claim_interface(libusb_device_handle *, int)
+{
+    return 0;
+}
+
+int libusb_release_interface(libusb_device_handle *, int)
+{
+    return 0;
+}
+
+int libusb_control_transfer(libusb_device_handle *, uint8_t, uint8_t, uint16_t, uint16_t, unsigned char *, uint16_t,
+                            unsigned int)
+{
+    return LIBUSB_ERROR_NOT_SUPPORTED;
+}
+}
+
+// What orion_ssg3_image_download did before: read every row into a temporary frame, then
+// de-interlace and byte swap it
+static int oldDownload(int x_count, int y_count, uint16_t *frame)
+{
+    int line_sz = x_count * 2;
+    std::vector<uint16_t> tmp(x_count * y_count);
+    int transferred;
+    int fail_cnt = 0;
+
+    for (int i = 0; i < y_count;)
+    {
+        if (libusb_bulk_transfer(nullptr, 0x82, reinterpret_cast<unsigned char *>(tmp.data()) + i * line_sz, line_sz,
+                                 &transferred, 5000) == 0)
+        {
+            i++;
+            fail_cnt = 0;
+        }
+        else if (++fail_cnt >= 10)
+            return -1;
+    }
+
+    for (int y = 0; y < y_count; y++)
+    {
+        int dy = (y % 2 == 0) ? y / 2 : y_count / 2 + y / 2;
+        for (int x = 0; x < x_count; x++)
+            frame[x + y * x_count] = be16toh(tmp[x + dy * x_count]);
+    }
+    return 0;
+}
+
+class ImageDownload : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            fake = &usb;
+            memset(&ssg3, 0, sizeof(ssg3));
+        }
+
+        void TearDown() override
+        {
+            orion_ssg3_close(&ssg3);
+            EXPECT_EQ(usb.freedPending, 0);
+            fake = nullptr;
+        }
+
+        // Downloads the same random stream both ways, returns the times in ms
+        void compare(int x_count, int y_count, double &msOld, double &msNew)
+        {
+            std::vector<unsigned char> stream(x_count * y_count * 2);
+            for (unsigned char &c : stream)
+                c = rng();
+            std::vector<uint16_t> before(x_count * y_count), after(before.size());
+
+            usb.load(stream);
+            auto start = Clock::now();
+            ASSERT_EQ(oldDownload(x_count, y_count, before.data()), 0);
+            msOld = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+            ssg3.x_count = x_count;
+            ssg3.y_count = y_count;
+            usb.load(stream);
+            start = Clock::now();
+            ASSERT_EQ(orion_ssg3_image_download(&ssg3, reinterpret_cast<uint8_t *>(after.data()), after.size() * 2), 0);
+            msNew = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+            EXPECT_TRUE(before == after) << x_count << "x" << y_count << " fail at " << usb.failAt;
+        }
+
+        FakeUSB usb;
+        struct orion_ssg3 ssg3;
+        std::mt19937 rng { 42 };
+};
+
+TEST_F(ImageDownload, MatchesTheOldDownload)
+{
+    double msOld, msNew;
+
+    // Full frame and a short odd-height subframe, each with and without a timed out row
+    const int cases[][3] = { { 752, 582, -1 }, { 752, 582, 37 }, { 100, 7, -1 }, { 100, 7, 3 } };
+    for (const auto &c : cases)
+    {
+        usb.failAt = c[2];
+        compare(c[0], c[1], msOld, msNew);
+        fprintf(stderr, "%dx%d, row %d times out: old %.2f ms, queued rows %.2f ms\n", c[0], c[1], c[2], msOld, msNew);
+    }
+
+    usb.failAt = -1;
+    usb.rowTime = std::chrono::microseconds(100);
+    compare(752, 582, msOld, msNew);
+    fprintf(stderr, "752x582, 100 us readout per row: old %.2f ms, queued rows %.2f ms\n", msOld, msNew);
+}
+
+TEST_F(ImageDownload, TenFailuresInARowAbort)
+{
+    std::vector<uint16_t> frame(752 * 582);
+
+    usb.load(std::vector<unsigned char>(frame.size() * 2));
+    usb.failAt = 20;
+    usb.failAllFrom = true;
+    // Slow rows keep the window queued behind the failing one
+    usb.rowTime = std::chrono::microseconds(100);
+    ssg3.x_count = 752;
+    ssg3.y_count = 582;
+    EXPECT_EQ(orion_ssg3_image_download(&ssg3, reinterpret_cast<uint8_t *>(frame.data()), frame.size() * 2), -EIO);
+    // The rest of the window is cancelled and reaped before the transfers are freed
+    EXPECT_EQ(usb.cancelled, 15);
+}
+
+TEST_F(ImageDownload, BufferMustHoldTheFrame)
+{
+    std::vector<uint16_t> frame(100 * 8);
+
+    usb.load(std::vector<unsigned char>(frame.size() * 2));
+    ssg3.x_count = 100;
+    ssg3.y_count = 7;
+    EXPECT_EQ(orion_ssg3_image_download(&ssg3, reinterpret_cast<uint8_t *>(frame.data()), 100 * 7 * 2 - 2), -ENOSPC);
+    // A larger buffer than needed is fine
+    EXPECT_EQ(orion_ssg3_image_download(&ssg3, reinterpret_cast<uint8_t *>(frame.data()), frame.size() * 2), 0);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
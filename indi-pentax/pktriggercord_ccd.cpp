@@ -25,7 +25,9 @@
 #define MINISO 100
 #define MAXISO 102400
 
-#define TMPFILEBASE (char *)"/tmp/indipentax.tmp"
+// Seconds past the exposure to wait for the camera to fill its buffer
+#define BUFFER_WAIT_MARGIN 60
+#define BUFFER_POLL_US 10000
 
 PkTriggerCordCCD::PkTriggerCordCCD(const char * name)
 {
@@ -43,6 +45,7 @@ PkTriggerCordCCD::PkTriggerCordCCD(const char * name)
 
 PkTriggerCordCCD::~PkTriggerCordCCD()
 {
+    releaseImage();
 }
 
 const char *PkTriggerCordCCD::getDefaultName()
@@ -258,6 +261,8 @@ bool PkTriggerCordCCD::Connect()
         }
         return false;
     }
+    // Download images in large SCSI reads, libpktriggercord drops back to 64 KB blocks if the host refuses them
+    pslr_set_download_block_size(device, PSLR_MAX_DOWNLOAD_BLOCK_SIZE);
     InExposure = false;
     InDownload = false;
     LOG_INFO("Connected to Pentax camera in MSC mode.");
@@ -313,27 +318,48 @@ bool PkTriggerCordCCD::shutterPress(pslr_rational_t shutter_speed)
     LOG_DEBUG("Shutter pressed.");
     pslr_get_status(device, &status);
 
-    user_file_format_t ufft = *pslr_get_user_file_format_t(uff);
-    char * output_file = TMPFILEBASE;
-    int fd = open_file(output_file, 1, ufft);
+    pslr_buffer_type imagetype;
+    if (uff == USER_FILE_FORMAT_PEF)
+        imagetype = PSLR_BUF_PEF;
+    else if (uff == USER_FILE_FORMAT_DNG)
+        imagetype = PSLR_BUF_DNG;
+    else
+        imagetype = pslr_get_jpeg_buffer_type(device, quality);
+
+    releaseImage();
 
+    // The camera reports PSLR_READ_ERROR until the image is in its buffer, any other error is fatal
+    struct timeval wait_start, wait_now;
+    gettimeofday(&wait_start, nullptr);
+    double wait_limit = static_cast<double>(shutter_speed.nom) / shutter_speed.denom + BUFFER_WAIT_MARGIN;
     int cnt = 0;
-    while ( save_buffer(device, 0, fd, &status, uff, quality ) )
+    int ret;
+    while ( (ret = pslr_get_buffer(device, 0, imagetype, status.jpeg_resolution, &imageData, &imageSize)) == PSLR_READ_ERROR )
     {
-        LOGF_DEBUG("Saved buffer (%d)", cnt++);
+        gettimeofday(&wait_now, nullptr);
+        if ((wait_now.tv_sec - wait_start.tv_sec) + (wait_now.tv_usec - wait_start.tv_usec) / 1e6 > wait_limit)
+            break;
+        LOGF_DEBUG("Waiting for buffer (%d)", cnt++);
+        usleep(BUFFER_POLL_US);
     }
 
-    pslr_delete_buffer(device, 0);
-    if (fd != 1)
+    if (ret == PSLR_OK)
     {
-        close(fd);
+        LOGF_DEBUG("Downloaded %u bytes.", imageSize);
     }
+    else
+    {
+        LOGF_ERROR("Failed to download image from camera (error %d).", ret);
+        releaseImage();
+    }
+
+    pslr_delete_buffer(device, 0);
     if (need_bulb_new_cleanup)
     {
         bulb_new_cleanup(device);
     }
 
-    return 1;
+    return ret == PSLR_OK;
 }
 
 
@@ -557,12 +583,18 @@ void PkTriggerCordCCD::TimerHit()
         if ( shutter_result.wait_for(span) != std::future_status::timeout)
         {
             bool result = shutter_result.get();
-            INDI_UNUSED(result);
             InDownload = false;
             InExposure = false;
 
-            grabImage();
-            ExposureComplete(&PrimaryCCD);
+            if (result)
+            {
+                grabImage();
+                ExposureComplete(&PrimaryCCD);
+            }
+            else
+            {
+                PrimaryCCD.setExposureFailed();
+            }
         }
         else if (InDownload && isDebug())
         {
@@ -575,24 +607,20 @@ void PkTriggerCordCCD::TimerHit()
     return;
 }
 
+void PkTriggerCordCCD::releaseImage()
+{
+    free(imageData);
+    imageData = nullptr;
+    imageSize = 0;
+}
+
 bool PkTriggerCordCCD::grabImage()
 {
-    //set correct tmpfile location
-    char tmpfile[256];
-    if (uff == USER_FILE_FORMAT_JPEG)
+    if (imageData == nullptr)
     {
-        snprintf(tmpfile, 256, "%s-0001.jpg", TMPFILEBASE);
-    }
-    else if (uff == USER_FILE_FORMAT_DNG)
-    {
-        snprintf(tmpfile, 256, "%s-0001.dng", TMPFILEBASE);
-    }
-    else
-    {
-        snprintf(tmpfile, 256, "%s-0001.pef", TMPFILEBASE);
+        LOG_ERROR("Exposure failed to download image.");
+        return false;
     }
-    LOGF_DEBUG("Reading temp file from: %s", tmpfile);
-
 
     // fits handling code
     // if (transferFormatS[0].s == ISS_ON)
@@ -605,10 +633,10 @@ bool PkTriggerCordCCD::grabImage()
 
         if (uff == USER_FILE_FORMAT_JPEG)
         {
-            if (read_jpeg(tmpfile, &memptr, &memsize, &naxis, &w, &h))
+            if (read_jpeg_planes_mem(imageData, imageSize, &memptr, &memsize, &naxis, &w, &h))
             {
                 LOG_ERROR("Exposure failed to parse jpeg.");
-                unlink(tmpfile);
+                releaseImage();
                 return false;
             }
 
@@ -622,10 +650,10 @@ bool PkTriggerCordCCD::grabImage()
         {
             char bayer_pattern[8] = {};
 
-            if (read_libraw(tmpfile, &memptr, &memsize, &naxis, &w, &h, &bpp, bayer_pattern))
+            if (read_libraw_mem(imageData, imageSize, &memptr, &memsize, &naxis, &w, &h, &bpp, bayer_pattern))
             {
                 LOG_ERROR("Exposure failed to parse raw image.");
-                unlink(tmpfile);
+                releaseImage();
                 return false;
             }
 
@@ -660,18 +688,17 @@ bool PkTriggerCordCCD::grabImage()
             prefix = std::regex_replace(prefix, std::regex("XXX"), string(ts));
             char newname[255];
             snprintf(newname, 255, "%s.%s", prefix.c_str(), getFormatFileExtension(uff));
-            if (std::rename(tmpfile, newname))
+            FILE* f = fopen(newname, "wb");
+            if (f == nullptr || fwrite(imageData, 1, imageSize, f) != imageSize)
             {
-                LOGF_ERROR("File system error prevented saving original image to %s.  Saved to %s instead.", newname, tmpfile);
+                LOGF_ERROR("File system error prevented saving original image to %s.", newname);
             }
             else
             {
                 LOGF_INFO("Saved original image to %s.", newname);
             }
-        }
-        else
-        {
-            std::remove(tmpfile);
+            if (f != nullptr)
+                fclose(f);
         }
 
     }
@@ -680,27 +707,12 @@ bool PkTriggerCordCCD::grabImage()
     {
         PrimaryCCD.setImageExtension(getFormatFileExtension(uff));
 
-        FILE* f = fopen(tmpfile, "r");
-        fseek(f, 0, SEEK_END);
-        size_t size = ftell(f);
-        rewind(f);
-
-        PrimaryCCD.setFrameBufferSize(size);
-        char * memptr = (char *)PrimaryCCD.getFrameBuffer();
-        size_t readSize = fread(memptr, sizeof(char), size, f);
-        if (readSize != size)
-        {
-            LOGF_ERROR("Error, %u bytes of data read instead of %u.", readSize, size);
-        }
-        PrimaryCCD.setFrameBuffer((unsigned char *)memptr);
-        fclose(f);
-        LOG_DEBUG("Copied to frame buffer.  Leaving temp file for debug purposes.");
-        if (!isDebug())
-        {
-            std::remove(tmpfile);
-        }
+        PrimaryCCD.setFrameBufferSize(imageSize);
+        memcpy(PrimaryCCD.getFrameBuffer(), imageData, imageSize);
+        LOG_DEBUG("Copied to frame buffer.");
     }
 
+    releaseImage();
     return true;
 }
 
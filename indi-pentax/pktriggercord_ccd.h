@@ -125,6 +125,11 @@ protected:
 
     bool shutterPress(pslr_rational_t shutter_speed);
     std::future<bool> shutter_result;
+
+    // Image downloaded by shutterPress, consumed by grabImage
+    uint8_t *imageData {nullptr};
+    uint32_t imageSize {0};
+    void releaseImage();
 };
 
 #endif // PKTRIGGERCORD_CCD_H
@@ -0,0 +1,236 @@
+/*
+ Pentax CCD Driver for Indi - image decoding tests
+
+ Checks that the in-memory decoders used for images downloaded with
+ pslr_get_buffer produce the same pixels as the file based decoders
+ the driver used with its temporary file, and reports the latency of both.
+
+ JPEG payloads are generated here. Recorded camera payloads (*.pef, *.dng,
+ *.jpg) are also checked when PENTAX_TEST_PAYLOADS names a directory holding them.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+#include <jpeglib.h>
+#include <sharedblob.h>
+
+#include "gphoto_readimage.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static std::vector<uint8_t> encodeJpeg(int w, int h, int components)
+{
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    unsigned char *out = nullptr;
+    unsigned long outSize = 0;
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    jpeg_mem_dest(&cinfo, &out, &outSize);
+
+    cinfo.image_width      = w;
+    cinfo.image_height     = h;
+    cinfo.input_components = components;
+    cinfo.in_color_space   = components == 3 ? JCS_RGB : JCS_GRAYSCALE;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 95, (boolean)TRUE);
+    jpeg_start_compress(&cinfo, (boolean)TRUE);
+
+    std::vector<uint8_t> row(w * components);
+    while (cinfo.next_scanline < cinfo.image_height)
+    {
+        int y = cinfo.next_scanline;
+        for (int x = 0; x < w; x++)
+            for (int c = 0; c < components; c++)
+                row[x * components + c] = static_cast<uint8_t>((x * (c + 1) + y * 3 + ((x ^ y) & 0x1f)) & 0xff);
+        JSAMPROW row_pointer[1] = { row.data() };
+        jpeg_write_scanlines(&cinfo, row_pointer, 1);
+    }
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    std::vector<uint8_t> payload(out, out + outSize);
+    free(out);
+    return payload;
+}
+
+static std::string writeTemp(const std::vector<uint8_t> &payload, const char *extension)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/tmp/indipentax.test-%d.%s", getpid(), extension);
+    FILE *f = fopen(name, "wb");
+    EXPECT_NE(f, nullptr);
+    if (f)
+    {
+        EXPECT_EQ(fwrite(payload.data(), 1, payload.size(), f), payload.size());
+        fclose(f);
+    }
+    return name;
+}
+
+static std::vector<uint8_t> readFile(const std::string &name)
+{
+    std::vector<uint8_t> payload;
+    FILE *f = fopen(name.c_str(), "rb");
+    if (f == nullptr)
+        return payload;
+    fseek(f, 0, SEEK_END);
+    payload.resize(ftell(f));
+    fseek(f, 0, SEEK_SET);
+    if (fread(payload.data(), 1, payload.size(), f) != payload.size())
+        payload.clear();
+    fclose(f);
+    return payload;
+}
+
+struct Decoded
+{
+    uint8_t *mem { nullptr };
+    size_t size { 0 };
+    int naxis { 0 }, w { 0 }, h { 0 }, bpp { 8 };
+    char bayer[8] {};
+
+    ~Decoded()
+    {
+        IDSharedBlobFree(mem);
+    }
+};
+
+static void expectSame(const Decoded &a, const Decoded &b)
+{
+    ASSERT_EQ(a.w, b.w);
+    ASSERT_EQ(a.h, b.h);
+    ASSERT_EQ(a.naxis, b.naxis);
+    ASSERT_EQ(a.bpp, b.bpp);
+    ASSERT_EQ(a.size, b.size);
+    ASSERT_STREQ(a.bayer, b.bayer);
+    ASSERT_EQ(memcmp(a.mem, b.mem, a.size), 0);
+}
+
+// Old path: write the downloaded payload to a file, then decode the file
+static void decodeViaFile(const std::vector<uint8_t> &payload, const char *extension, bool raw, Decoded &out)
+{
+    std::string name = writeTemp(payload, extension);
+    int ret = raw ? read_libraw(name.c_str(), &out.mem, &out.size, &out.naxis, &out.w, &out.h, &out.bpp, out.bayer)
+              : read_jpeg(name.c_str(), &out.mem, &out.size, &out.naxis, &out.w, &out.h);
+    unlink(name.c_str());
+    ASSERT_EQ(ret, 0);
+}
+
+static void decodeInMemory(std::vector<uint8_t> &payload, bool raw, Decoded &out)
+{
+    int ret = raw ? read_libraw_mem(payload.data(), payload.size(), &out.mem, &out.size, &out.naxis, &out.w, &out.h,
+                                    &out.bpp, out.bayer)
+              : read_jpeg_planes_mem(payload.data(), payload.size(), &out.mem, &out.size, &out.naxis, &out.w, &out.h);
+    ASSERT_EQ(ret, 0);
+}
+
+static void checkPayload(std::vector<uint8_t> &payload, const char *extension, bool raw, const char *label)
+{
+    const int rounds = 3;
+    double fileMs = 0, memMs = 0;
+
+    for (int i = 0; i < rounds; i++)
+    {
+        Decoded viaFile, inMemory;
+
+        auto start = Clock::now();
+        decodeViaFile(payload, extension, raw, viaFile);
+        fileMs += elapsedMs(start);
+
+        start = Clock::now();
+        decodeInMemory(payload, raw, inMemory);
+        memMs += elapsedMs(start);
+
+        expectSame(viaFile, inMemory);
+    }
+
+    printf("%-28s %9zu bytes  file %8.2f ms  memory %8.2f ms\n", label, payload.size(), fileMs / rounds, memMs / rounds);
+}
+
+TEST(PentaxReadImage, JpegRgbPlanes)
+{
+    std::vector<uint8_t> payload = encodeJpeg(640, 427, 3);
+    checkPayload(payload, "jpg", false, "generated rgb 640x427");
+
+    // The planar layout must hold the same samples as the interleaved decoder
+    Decoded planes, interleaved;
+    decodeInMemory(payload, false, planes);
+    ASSERT_EQ(read_jpeg_mem(payload.data(), payload.size(), &interleaved.mem, &interleaved.size, &interleaved.naxis,
+                            &interleaved.w, &interleaved.h), 0);
+    ASSERT_EQ(planes.size, interleaved.size);
+    size_t pixels = static_cast<size_t>(planes.w) * planes.h;
+    for (size_t i = 0; i < pixels; i++)
+        for (int c = 0; c < 3; c++)
+            ASSERT_EQ(planes.mem[c * pixels + i], interleaved.mem[i * 3 + c]) << "pixel " << i << " colour " << c;
+}
+
+TEST(PentaxReadImage, JpegGrey)
+{
+    std::vector<uint8_t> payload = encodeJpeg(641, 401, 1);
+    checkPayload(payload, "jpg", false, "generated grey 641x401");
+}
+
+TEST(PentaxReadImage, JpegLatency)
+{
+    std::vector<uint8_t> payload = encodeJpeg(6000, 4000, 3);
+    checkPayload(payload, "jpg", false, "generated rgb 6000x4000");
+}
+
+TEST(PentaxReadImage, RecordedPayloads)
+{
+    const char *dir = getenv("PENTAX_TEST_PAYLOADS");
+    if (dir == nullptr)
+        GTEST_SKIP() << "PENTAX_TEST_PAYLOADS not set";
+
+    DIR *d = opendir(dir);
+    ASSERT_NE(d, nullptr) << dir;
+
+    int checked = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != nullptr)
+    {
+        std::string name = entry->d_name;
+        size_t dot = name.rfind('.');
+        if (dot == std::string::npos)
+            continue;
+        std::string extension = name.substr(dot + 1);
+        for (auto &c : extension)
+            c = tolower(c);
+
+        bool raw = (extension == "pef" || extension == "dng");
+        if (!raw && extension != "jpg")
+            continue;
+
+        std::vector<uint8_t> payload = readFile(std::string(dir) + "/" + name);
+        ASSERT_FALSE(payload.empty()) << name;
+        SCOPED_TRACE(name);
+        checkPayload(payload, extension.c_str(), raw, name.c_str());
+        checked++;
+    }
+    closedir(d);
+
+    if (checked == 0)
+        GTEST_SKIP() << "no .pef, .dng or .jpg payloads in " << dir;
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -884,16 +884,11 @@ int QSICCD::grabImage()
     int x, y, z;
     try
     {
-        bool imageReady = false;
-        QSICam.get_ImageReady(&imageReady);
-        while (!imageReady)
-        {
-            usleep(500);
-            QSICam.get_ImageReady(&imageReady);
-        }
+        QSICam.WaitForImageReady();
 
+        // Size first: TransferImage hands the pending image over to our buffer
         QSICam.get_ImageArraySize(x, y, z);
-        QSICam.get_ImageArray(image);
+        QSICam.TransferImage(image);
         imageWidth  = x;
         imageHeight = y;
     }
@@ -1216,18 +1211,21 @@ void QSICCD::TimerHit()
 
     if (InExposure)
     {
-        bool imageReady;
-
         timeleft = CalcTimeLeft(ExpStart, ExposureRequest);
 
         if (timeleft < 1)
         {
-            QSICam.get_ImageReady(&imageReady);
-
-            while (!imageReady)
+            try
             {
-                usleep(100);
-                QSICam.get_ImageReady(&imageReady);
+                QSICam.WaitForImageReady();
+            }
+            catch (std::runtime_error &err)
+            {
+                LOGF_ERROR("get_ImageReady() failed. %s.", err.what());
+                InExposure = false;
+                PrimaryCCD.setExposureFailed();
+                SetTimer(getCurrentPollingPeriod());
+                return;
             }
 
             /* We're done exposing */
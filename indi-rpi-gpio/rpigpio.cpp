@@ -23,6 +23,7 @@
 #include <config.h>
 #include <pigpiod_if2.h>
 #include <rpigpio.h>
+#include <timerwave.h>
 
 static class Loader
 {
@@ -42,6 +43,15 @@ IndiRpiGpio::IndiRpiGpio()
     std::fill_n(m_type, n_dev_type, 0);
     std::fill_n(timer_counter, n_gpio_pin, 0);
     std::fill_n(timer_isexp, n_gpio_pin, 0);
+    std::fill_n(m_wave_id, n_gpio_pin, -1);
+    std::fill_n(m_wave_cb, n_gpio_pin, -1);
+    for(int i=0; i<n_gpio_pin;i++)
+    {
+        m_wave_start_tick[i] = 0;
+        m_wave_exposing[i] = false;
+        m_wave_done[i] = 0;
+        m_wave_last_us[i] = 0;
+    }
 
     for(int i=0; i<n_gpio_pin;i++)
     {
@@ -675,6 +685,21 @@ bool IndiRpiGpio::saveConfigItems(FILE *fp)
 
 void IndiRpiGpio::TimerChange(int i, bool isInit, bool abort)
 {
+    if (isInit)
+    {
+        // A new sequence replaces one still playing on this port
+        if (m_wave_id[i] >= 0)
+            ReleaseTimerWave(i, true);
+        // Prefer playing the whole sequence as a wave; software timers are the fallback
+        if (StartTimerWave(i))
+            return;
+    }
+    else if (m_wave_id[i] >= 0)
+    {
+        StopTimerWave(i, abort);
+        return;
+    }
+
     unsigned user_gpio = m_gpio_pin[i];
     gpio_write(m_piId, user_gpio, (ActiveS[i][0].s == ISS_ON)? PI_LOW: PI_HIGH);
     stopTimer(i);
@@ -752,8 +777,153 @@ void IndiRpiGpio::TimerCallback(int i)
         DEBUGF(INDI::Logger::DBG_SESSION, "Timer callback: Invalid callback received for Id %d", i);
         return;
     }
+    if (m_wave_id[i] >= 0)
+    {
+        PollTimerWave(i);
+        return;
+    }
     // Timer ended
     DEBUGF(INDI::Logger::DBG_SESSION, "Timer callback: Timer ended for id %d", i);
     TimerChange(i);  // Handle end of timer
     return;
 }
+
+bool IndiRpiGpio::StartTimerWave(int i)
+{
+    const int ip = i+1; // Port number
+    const uint32_t exposure_us = lround(TimerOnN[i][0].value * 1000000);
+    const uint32_t delay_us = lround(TimerOnN[i][2].value * 1000000);
+    const uint32_t count = TimerOnN[i][1].value;
+
+    auto shot = buildTimerShot(m_gpio_pin[i], ActiveS[i][0].s == ISS_ON, exposure_us, delay_us);
+    if (shot.empty())
+        return false;
+
+    // The daemon transmits one wave at a time
+    if (wave_tx_busy(m_piId) == 1)
+    {
+        DEBUGF(INDI::Logger::DBG_WARNING, "Port %d wave generator busy with another sequence, using software timer", ip);
+        return false;
+    }
+
+    std::vector<gpioPulse_t> pulses;
+    for (const auto &pulse : shot)
+        pulses.push_back({pulse.gpioOn, pulse.gpioOff, pulse.usDelay});
+
+    wave_add_new(m_piId);
+    if (wave_add_generic(m_piId, pulses.size(), pulses.data()) < 0)
+    {
+        DEBUGF(INDI::Logger::DBG_WARNING, "Port %d failed to add %d pulses, using software timer", ip, pulses.size());
+        return false;
+    }
+    int wave_id = wave_create(m_piId);
+    if (wave_id < 0)
+    {
+        DEBUGF(INDI::Logger::DBG_WARNING, "Port %d failed to create wave: %d, using software timer", ip, wave_id);
+        return false;
+    }
+    auto chain = buildTimerChain(wave_id, count);
+    if (chain.empty())
+    {
+        wave_delete(m_piId, wave_id);
+        return false;
+    }
+
+    m_wave_done[i] = 0;
+    m_wave_reported[i] = 0;
+    m_wave_exposing[i] = false;
+    m_wave_cb[i] = callback_ex(m_piId, m_gpio_pin[i], EITHER_EDGE, TimerWaveEdge, this);
+
+    int rc = wave_chain(m_piId, chain.data(), chain.size());
+    if (rc < 0)
+    {
+        DEBUGF(INDI::Logger::DBG_WARNING, "Port %d failed to start wave chain: %d, using software timer", ip, rc);
+        if (m_wave_cb[i] >= 0)
+            callback_cancel(m_wave_cb[i]);
+        m_wave_cb[i] = -1;
+        wave_delete(m_piId, wave_id);
+        return false;
+    }
+
+    m_wave_id[i] = wave_id;
+    startTimer(i, wave_poll_ms);
+    DEBUGF(INDI::Logger::DBG_SESSION, "Timer SEQ START: Port %d wave %d: Count %u Exposure %u us Delay %u us", ip, wave_id, count, exposure_us, delay_us);
+    return true;
+}
+
+void IndiRpiGpio::StopTimerWave(int i, bool abort)
+{
+    const int ip = i+1; // Port number
+
+    ReleaseTimerWave(i, abort);
+
+    DEBUGF(INDI::Logger::DBG_SESSION, "Timer SEQ END: Port %d Exposures %d", ip, m_wave_done[i].load());
+    OnOffS[i][0].s = ISS_ON;
+    OnOffS[i][1].s = ISS_OFF;
+    OnOffSP[i].s = IPS_IDLE;
+    IDSetSwitch(&OnOffSP[i], nullptr);
+    TimerOnNP[i].s = IPS_IDLE;
+    IDSetNumber(&TimerOnNP[i], nullptr);
+}
+
+// Stop and free the wave started by StartTimerWave and return the pin to idle, without reporting
+void IndiRpiGpio::ReleaseTimerWave(int i, bool abort)
+{
+    const int ip = i+1; // Port number
+
+    stopTimer(i);
+    // Only stop the transmitter if it is still playing our wave
+    if (abort && wave_tx_busy(m_piId) == 1 && wave_tx_at(m_piId) == m_wave_id[i])
+    {
+        wave_tx_stop(m_piId);
+        DEBUGF(INDI::Logger::DBG_DEBUG, "Timer SEQ ABORT: Port %d after %d exposures", ip, m_wave_done[i].load());
+    }
+    if (m_wave_cb[i] >= 0)
+        callback_cancel(m_wave_cb[i]);
+    m_wave_cb[i] = -1;
+    wave_delete(m_piId, m_wave_id[i]);
+    m_wave_id[i] = -1;
+    gpio_write(m_piId, m_gpio_pin[i], (ActiveS[i][0].s == ISS_ON)? PI_LOW: PI_HIGH);
+}
+
+void IndiRpiGpio::PollTimerWave(int i)
+{
+    const int ip = i+1; // Port number
+
+    // Exposure lengths are measured from the daemon's edge ticks, not from the poll
+    int done = m_wave_done[i];
+    while (m_wave_reported[i] < done)
+    {
+        m_wave_reported[i]++;
+        DEBUGF(INDI::Logger::DBG_SESSION, "Timer END: Port %d Expose %d of %0.0f: Duration %0.3f ms", ip, m_wave_reported[i], TimerOnN[i][1].value, m_wave_last_us[i] / 1000.0);
+    }
+
+    if (wave_tx_busy(m_piId) == 1)
+    {
+        startTimer(i, wave_poll_ms);
+        return;
+    }
+    StopTimerWave(i, false);
+}
+
+void IndiRpiGpio::TimerWaveEdge(int, unsigned user_gpio, unsigned level, uint32_t tick, void *userdata)
+{
+    IndiRpiGpio *self = static_cast<IndiRpiGpio *>(userdata);
+    int i = self->FindPinIndex(user_gpio);
+    // level 2 is a watchdog timeout, not an edge
+    if (i < 0 || level > 1)
+        return;
+
+    bool active = (level == PI_HIGH) == (self->ActiveS[i][0].s == ISS_ON);
+    if (active)
+    {
+        self->m_wave_start_tick[i] = tick;
+        self->m_wave_exposing[i] = true;
+    }
+    else if (self->m_wave_exposing[i])
+    {
+        self->m_wave_exposing[i] = false;
+        self->m_wave_last_us[i] = tick - self->m_wave_start_tick[i];
+        self->m_wave_done[i]++;
+    }
+}
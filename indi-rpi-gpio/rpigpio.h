@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <algorithm>
 #include <chrono>
+#include <atomic>
 #include <inditimer.h>
 
 #include <defaultdevice.h>
@@ -50,6 +51,7 @@
     static const bool dev_timer[n_dev_type] = { false, false, false, true };
     static const uint32_t max_tick = 4294967295;
     static const int32_t max_timer_ms = 50000;
+    static const int wave_poll_ms = 250;
     static const char PIN_TAB[] = "GPIO Config";
     static const char TIMER_TAB[] = "Timer Config";
     
@@ -106,6 +108,21 @@ private:
     bool timer_isexp[n_gpio_pin];
     int timer_counter[n_gpio_pin];
     void TimerChange(int id, bool isInit=false, bool abort=false);
+
+// Hardware timed sequences played by the pigpio daemon as a wave chain
+    int m_wave_id[n_gpio_pin];
+    int m_wave_cb[n_gpio_pin];
+    // Written by TimerWaveEdge on the pigpio callback thread
+    std::atomic<uint32_t> m_wave_start_tick[n_gpio_pin];
+    std::atomic<bool> m_wave_exposing[n_gpio_pin];
+    std::atomic<int> m_wave_done[n_gpio_pin];
+    std::atomic<uint32_t> m_wave_last_us[n_gpio_pin];
+    int m_wave_reported[n_gpio_pin];
+    bool StartTimerWave(int id);
+    void StopTimerWave(int id, bool abort);
+    void ReleaseTimerWave(int id, bool abort);
+    void PollTimerWave(int id);
+    static void TimerWaveEdge(int pi, unsigned user_gpio, unsigned level, uint32_t tick, void *userdata);
     int FindPinIndex(unsigned user_gpio);
     int InitPiModel();
     INDI::Timer timer[n_gpio_pin];
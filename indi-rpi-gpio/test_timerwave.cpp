@@ -0,0 +1,144 @@
+/*******************************************************************************
+  Copyright(c) 2021 Ken Self <ken.kgself AT gmail DOT com>
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <timerwave.h>
+
+// Level of the pin after each pulse and the total time, as the daemon would play the shot
+static void playShot(const std::vector<TimerPulse> &shot, uint32_t mask, bool idleHigh,
+                     std::vector<std::pair<bool, uint64_t>> &levels)
+{
+    bool high = idleHigh;
+    levels.clear();
+    for (const auto &pulse : shot)
+    {
+        // A pulse switches at most our pin, and never both ways at once
+        ASSERT_EQ(pulse.gpioOn & ~mask, 0u);
+        ASSERT_EQ(pulse.gpioOff & ~mask, 0u);
+        ASSERT_FALSE(pulse.gpioOn && pulse.gpioOff);
+        ASSERT_LE(pulse.usDelay, wave_pulse_max_us);
+
+        if (pulse.gpioOn)
+            high = true;
+        if (pulse.gpioOff)
+            high = false;
+        if (!levels.empty() && levels.back().first == high)
+            levels.back().second += pulse.usDelay;
+        else
+            levels.push_back({ high, pulse.usDelay });
+    }
+}
+
+TEST(TimerWave, ShotActiveHigh)
+{
+    std::vector<std::pair<bool, uint64_t>> levels;
+    auto shot = buildTimerShot(17, true, 2500000, 500000);
+    playShot(shot, 1u << 17, false, levels);
+
+    ASSERT_EQ(levels.size(), 3u);
+    EXPECT_EQ(levels[0], std::make_pair(false, uint64_t(500000)));
+    EXPECT_EQ(levels[1], std::make_pair(true, uint64_t(2500000)));
+    EXPECT_EQ(levels[2], std::make_pair(false, uint64_t(0)));
+}
+
+TEST(TimerWave, ShotActiveLow)
+{
+    std::vector<std::pair<bool, uint64_t>> levels;
+    auto shot = buildTimerShot(4, false, 1000, 2000);
+    playShot(shot, 1u << 4, true, levels);
+
+    ASSERT_EQ(levels.size(), 3u);
+    EXPECT_EQ(levels[0], std::make_pair(true, uint64_t(2000)));
+    EXPECT_EQ(levels[1], std::make_pair(false, uint64_t(1000)));
+    EXPECT_EQ(levels[2], std::make_pair(true, uint64_t(0)));
+}
+
+TEST(TimerWave, ShotWithoutDelay)
+{
+    auto shot = buildTimerShot(0, true, 1, 0);
+    ASSERT_EQ(shot.size(), 2u);
+    EXPECT_EQ(shot[0].gpioOn, 1u);
+    EXPECT_EQ(shot[0].usDelay, 1u);
+    EXPECT_EQ(shot[1].gpioOff, 1u);
+    EXPECT_EQ(shot[1].usDelay, 0u);
+}
+
+TEST(TimerWave, LongPhasesAreSplit)
+{
+    const uint32_t exposure_us = 3 * wave_pulse_max_us + 7;
+    const uint32_t delay_us = wave_pulse_max_us;
+    std::vector<std::pair<bool, uint64_t>> levels;
+    auto shot = buildTimerShot(31, true, exposure_us, delay_us);
+    playShot(shot, 1u << 31, false, levels);
+
+    // delay in one pulse, exposure in four, then the return to idle
+    ASSERT_EQ(shot.size(), 6u);
+    ASSERT_EQ(levels.size(), 3u);
+    EXPECT_EQ(levels[0], std::make_pair(false, uint64_t(delay_us)));
+    EXPECT_EQ(levels[1], std::make_pair(true, uint64_t(exposure_us)));
+    EXPECT_EQ(levels[2], std::make_pair(false, uint64_t(0)));
+
+    // only the first pulse of a phase touches the pin
+    EXPECT_EQ(shot[1].gpioOn, 1u << 31);
+    for (int k = 2; k < 5; k++)
+    {
+        EXPECT_EQ(shot[k].gpioOn, 0u);
+        EXPECT_EQ(shot[k].gpioOff, 0u);
+    }
+    EXPECT_EQ(shot[4].usDelay, 7u);
+}
+
+TEST(TimerWave, InvalidShots)
+{
+    EXPECT_TRUE(buildTimerShot(17, true, 0, 1000).empty());
+    EXPECT_TRUE(buildTimerShot(32, true, 1000, 1000).empty());
+}
+
+TEST(TimerWave, ChainSingleShot)
+{
+    auto chain = buildTimerChain(3, 1);
+    ASSERT_EQ(chain, std::vector<char>({ 3 }));
+}
+
+TEST(TimerWave, ChainLoop)
+{
+    for (uint32_t count : { 2u, 255u, 256u, 1000u, 65535u })
+    {
+        auto chain = buildTimerChain(249, count);
+        ASSERT_EQ(chain.size(), 7u) << count;
+        EXPECT_EQ(static_cast<uint8_t>(chain[0]), 255);
+        EXPECT_EQ(chain[1], 0);
+        EXPECT_EQ(static_cast<uint8_t>(chain[2]), 249);
+        EXPECT_EQ(static_cast<uint8_t>(chain[3]), 255);
+        EXPECT_EQ(chain[4], 1);
+        EXPECT_EQ(static_cast<uint8_t>(chain[5]) | static_cast<uint8_t>(chain[6]) << 8, count);
+    }
+}
+
+TEST(TimerWave, InvalidChains)
+{
+    EXPECT_TRUE(buildTimerChain(0, 0).empty());
+    EXPECT_TRUE(buildTimerChain(0, 65536).empty());
+    EXPECT_TRUE(buildTimerChain(250, 1).empty());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,59 @@
+/*******************************************************************************
+  Copyright(c) 2021 Ken Self <ken.kgself AT gmail DOT com>
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <algorithm>
+#include <timerwave.h>
+
+// Append a level lasting us microseconds. Only the first pulse switches the GPIO.
+static void addLevel(std::vector<TimerPulse> &pulses, uint32_t mask, bool high, uint32_t us)
+{
+    uint32_t first = std::min(us, wave_pulse_max_us);
+    pulses.push_back({ high ? mask : 0, high ? 0 : mask, first });
+    for (us -= first; us > 0; us -= std::min(us, wave_pulse_max_us))
+        pulses.push_back({ 0, 0, std::min(us, wave_pulse_max_us) });
+}
+
+std::vector<TimerPulse> buildTimerShot(unsigned user_gpio, bool activeHigh, uint32_t exposure_us, uint32_t delay_us)
+{
+    std::vector<TimerPulse> pulses;
+    if (exposure_us == 0 || user_gpio > 31)
+        return pulses;
+
+    const uint32_t mask = 1u << user_gpio;
+    if (delay_us > 0)
+        addLevel(pulses, mask, !activeHigh, delay_us);
+    addLevel(pulses, mask, activeHigh, exposure_us);
+    addLevel(pulses, mask, !activeHigh, 0);
+    return pulses;
+}
+
+std::vector<char> buildTimerChain(unsigned wave_id, uint32_t count)
+{
+    std::vector<char> chain;
+    if (count == 0 || count > 65535 || wave_id > 249)
+        return chain;
+
+    if (count == 1)
+        chain = { static_cast<char>(wave_id) };
+    else
+        // loop start, wave, loop end repeating count times
+        chain = { static_cast<char>(255), 0, static_cast<char>(wave_id),
+                  static_cast<char>(255), 1, static_cast<char>(count & 0xFF), static_cast<char>(count >> 8)
+                };
+    return chain;
+}
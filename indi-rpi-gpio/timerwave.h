@@ -0,0 +1,51 @@
+/*******************************************************************************
+  Copyright(c) 2021 Ken Self <ken.kgself AT gmail DOT com>
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#ifndef TIMERWAVE_H
+#define TIMERWAVE_H
+
+#include <stdint.h>
+#include <vector>
+
+// Mirrors pigpio's gpioPulse_t one to one, but is kept free of pigpio so sequences can be
+// built and checked without a Pi.
+struct TimerPulse
+{
+    uint32_t gpioOn;
+    uint32_t gpioOff;
+    uint32_t usDelay;
+};
+
+// Longest single pulse. Longer phases are split into several pulses that do not change any level
+// so one DMA delay block never gets too long.
+static const uint32_t wave_pulse_max_us = 10000000;
+
+/**
+ * Build the pulses for one shot of a timed sequence: idle for delay_us, active for exposure_us,
+ * then back to idle. A count of shots is played by repeating this wave with buildTimerChain().
+ * Returns an empty list if exposure_us is zero.
+ */
+std::vector<TimerPulse> buildTimerShot(unsigned user_gpio, bool activeHigh, uint32_t exposure_us, uint32_t delay_us);
+
+/**
+ * Build a wave_chain() buffer that transmits wave_id count times.
+ * Returns an empty buffer if count is zero or above the 65535 loop limit of pigpio.
+ */
+std::vector<char> buildTimerChain(unsigned wave_id, uint32_t count);
+
+#endif
@@ -39,6 +39,7 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 
+#include <algorithm>
 #include <memory>
 #include <deque>
 
@@ -52,6 +53,7 @@
 #define MAX_DEVICES         20   /* Max device cameraCount */
 #define MAX_THREAD_RETRIES  3
 #define MAX_THREAD_WAIT     300000
+#define READOUT_LINE_BATCH  16   /* Lines read per readout scheduler step */
 
 static class Loader
 {
@@ -306,6 +308,7 @@ SBIGCCD::SBIGCCD() : FilterInterface(this)
 
 SBIGCCD::~SBIGCCD()
 {
+    stopReadoutThread();
     CloseDevice();
     CloseDriver();
 }
@@ -383,6 +386,17 @@ bool SBIGCCD::initProperties()
     IUFillSwitchVector(&IgnoreErrorsSP, IgnoreErrorsS, 1, getDeviceName(), "CCD_IGNORE_ERRORS", "Ignore", OPTIONS_TAB, IP_RW,
                        ISR_NOFMANY, 0, IPS_OK);
 
+    // Dark subtraction in the driver
+    IUFillSwitch(&DarkSubtractS[DARK_SUBTRACT_PRIMARY], "PRIMARY", "Primary", ISS_OFF);
+    IUFillSwitch(&DarkSubtractS[DARK_SUBTRACT_GUIDE], "GUIDE", "Guide", ISS_OFF);
+    IUFillSwitchVector(&DarkSubtractSP, DarkSubtractS, 2, getDeviceName(), "CCD_DARK_SUBTRACT", "Dark Subtract",
+                       OPTIONS_TAB, IP_RW, ISR_NOFMANY, 0, IPS_IDLE);
+
+    // Guide readout latency
+    IUFillNumber(&GuideLatencyN[0], "LATENCY", "Latency (ms)", "%.0f", 0, 1e6, 0, 0);
+    IUFillNumberVector(&GuideLatencyNP, GuideLatencyN, 1, getDeviceName(), "GUIDER_READOUT_LATENCY", "Readout",
+                       GUIDE_HEAD_TAB, IP_RO, 0, IPS_IDLE);
+
     // CFW PRODUCT
     IUFillText(&FilterProdcutT[0], "NAME", "Name", "");
     IUFillText(&FilterProdcutT[1], "ID", "ID", "");
@@ -530,6 +544,11 @@ bool SBIGCCD::updateProperties()
             defineProperty(&CoolerNP);
         }
         defineProperty(&IgnoreErrorsSP);
+        defineProperty(&DarkSubtractSP);
+        if (m_hasGuideHead)
+        {
+            defineProperty(&GuideLatencyNP);
+        }
         if (m_hasFilterWheel)
         {
             defineProperty(&FilterConnectionSP);
@@ -572,6 +591,8 @@ bool SBIGCCD::updateProperties()
             deleteProperty(CoolerNP.name);
         }
         deleteProperty(IgnoreErrorsSP.name);
+        deleteProperty(DarkSubtractSP.name);
+        deleteProperty(GuideLatencyNP.name);
 
         if (m_hasAO)
         {
@@ -723,6 +744,15 @@ bool SBIGCCD::ISNewSwitch(const char *dev, const char *name, ISState *states, ch
             saveConfig(true);
             return true;
         }
+        // Dark subtraction
+        else if (!strcmp(name, DarkSubtractSP.name))
+        {
+            IUUpdateSwitch(&DarkSubtractSP, states, names, n);
+            DarkSubtractSP.s = IPS_OK;
+            IDSetSwitch(&DarkSubtractSP, nullptr);
+            saveConfig(true);
+            return true;
+        }
         // Filter connection
         else if (!strcmp(name, FilterConnectionSP.name))
         {
@@ -895,6 +925,8 @@ bool SBIGCCD::Connect()
 
     m_hasAO = AoCenter() == CE_NO_ERROR;
 
+    startReadoutThread();
+
     return true;
 }
 
@@ -902,15 +934,9 @@ bool SBIGCCD::Disconnect()
 {
     if (!isConnected())
         return true;
+    stopReadoutThread();
     m_useExternalTrackingCCD = false;
     m_hasGuideHead           = false;
-#ifdef ASYNC_READOUT
-    pthread_mutex_lock(&condMutex);
-    grabPredicate   = GRAB_PRIMARY_CCD;
-    terminateThread = true;
-    pthread_cond_signal(&cv);
-    pthread_mutex_unlock(&condMutex);
-#endif
     if (FilterConnectionS[0].s == ISS_ON)
         CFWDisconnect();
     if (CloseDevice() == CE_NO_ERROR)
@@ -1196,6 +1222,7 @@ bool SBIGCCD::AbortExposure()
 {
     int res = CE_NO_ERROR;
     LOG_DEBUG("Aborting primary camera exposure...");
+    abortReadout(&PrimaryCCD);
     for (int i = 0; i < MAX_THREAD_RETRIES; i++)
     {
         res = AbortExposure(&PrimaryCCD);
@@ -1219,6 +1246,7 @@ bool SBIGCCD::AbortGuideExposure()
 {
     int res = CE_NO_ERROR;
     LOG_DEBUG("Aborting guide head exposure...");
+    abortReadout(&GuideCCD);
     for (int i = 0; i < MAX_THREAD_RETRIES; i++)
     {
         res = AbortExposure(&GuideCCD);
@@ -1409,51 +1437,14 @@ IPState SBIGCCD::GuideWest(uint32_t ms)
     return (ActivateRelay(&rp) == CE_NO_ERROR ? IPS_BUSY : IPS_ALERT);
 }
 
-#ifdef ASYNC_READOUT
-void *SBIGCCD::grabCCDHelper(void *context)
-{
-    return ((SBIGCCD *)context)->grabCCD();
-}
-
-void *SBIGCCD::grabCCD()
-{
-    LOG_DEBUG("grabCCD thread started...");
-    INDI::CCDChip *targetChip = nullptr;
-    pthread_mutex_lock(&condMutex);
-    while (true)
-    {
-        while (grabPredicate == GRAB_NO_CCD)
-        {
-            pthread_cond_wait(&cv, &condMutex);
-        }
-        targetChip    = (grabPredicate == GRAB_PRIMARY_CCD) ? &PrimaryCCD : &GuideCCD;
-        grabPredicate = GRAB_NO_CCD;
-        if (terminateThread)
-            break;
-        pthread_mutex_unlock(&condMutex);
-        if (grabImage(targetChip) == false)
-        {
-            targetChip->setExposureFailed();
-        }
-        pthread_mutex_lock(&condMutex);
-    }
-    pthread_mutex_unlock(&condMutex);
-    LOG_DEBUG("grabCCD thread finished");
-    return 0;
-}
-#endif
-
 bool SBIGCCD::grabImage(INDI::CCDChip *targetChip)
 {
-    uint16_t left   = targetChip->getSubX() / targetChip->getBinX();
-    uint16_t top    = targetChip->getSubY() / targetChip->getBinX();
-    uint16_t width  = targetChip->getSubW() / targetChip->getBinX();
-    uint16_t height = targetChip->getSubH() / targetChip->getBinY();
-
     LOGF_DEBUG("%s readout in progress...", targetChip == &PrimaryCCD ? "Primary camera" : "Guide head");
 
     if (isSimulation())
     {
+        uint16_t width  = targetChip->getSubW() / targetChip->getBinX();
+        uint16_t height = targetChip->getSubH() / targetChip->getBinY();
         uint8_t *image = targetChip->getFrameBuffer();
         for (int i = 0; i < height * 2; i++)
         {
@@ -1462,29 +1453,13 @@ bool SBIGCCD::grabImage(INDI::CCDChip *targetChip)
                 image[i * width + j] = rand() % 255;
             }
         }
+        LOG_DEBUG("Simulated readout complete");
+        ExposureComplete(targetChip);
+        return true;
     }
-    else
-    {
-        uint16_t *buffer = reinterpret_cast<uint16_t *>(targetChip->getFrameBuffer());
-        int res                = 0;
-        for (int i = 0; i < MAX_THREAD_RETRIES; i++)
-        {
-            res = readoutCCD(left, top, width, height, buffer, targetChip);
-            if (res == CE_NO_ERROR)
-                break;
-            LOGF_DEBUG("Readout error, retrying...", res);
-            usleep(MAX_THREAD_WAIT);
-        }
-        if (res != CE_NO_ERROR)
-        {
-            LOGF_ERROR("%s readout error",
-                       targetChip == &PrimaryCCD ? "Primary camera" : "Guide head");
-            return false;
-        }
-    }
-    LOGF_DEBUG("%s readout complete", targetChip == &PrimaryCCD ? "Primary camera" : "Guide head");
-    ExposureComplete(targetChip);
-    return true;
+
+    // The readout thread completes the exposure once the frame is downloaded
+    return queueReadout(targetChip);
 }
 
 bool SBIGCCD::saveConfigItems(FILE *fp)
@@ -1494,6 +1469,7 @@ bool SBIGCCD::saveConfigItems(FILE *fp)
     IUSaveConfigSwitch(fp, &PortSP);
     IUSaveConfigText(fp, &IpTP);
     IUSaveConfigSwitch(fp, &IgnoreErrorsSP);
+    IUSaveConfigSwitch(fp, &DarkSubtractSP);
 
     if (FilterNameT)
         INDI::FilterInterface::saveConfigItems(fp);
@@ -2641,58 +2617,310 @@ bool SBIGCCD::isExposureDone(INDI::CCDChip *targetChip)
 
 //==========================================================================
 
-int SBIGCCD::readoutCCD(uint16_t left, uint16_t top, uint16_t width, uint16_t height,
-                        uint16_t *buffer, INDI::CCDChip *targetChip)
+int SBIGCCD::getReadoutCCD(INDI::CCDChip *targetChip)
 {
-    int h, ccd, binning, res;
     if (targetChip == &PrimaryCCD)
     {
-        ccd = CCD_IMAGING;
+        return CCD_IMAGING;
     }
-    else
+    return m_useExternalTrackingCCD ? CCD_EXT_TRACKING : CCD_TRACKING;
+}
+
+//==========================================================================
+// Readout scheduler
+//
+// Frames are downloaded on a worker thread, READOUT_LINE_BATCH lines at a time.
+// sbigLock is only held for one batch, so exposure polling, temperature and
+// guide pulses are not starved by a long primary readout. When both chips have
+// a frame pending, the guide chip is always served first.
+//==========================================================================
+
+void SBIGCCD::startReadoutThread()
+{
+    if (m_ReadoutThread.joinable())
     {
-        ccd = m_useExternalTrackingCCD ? CCD_EXT_TRACKING : CCD_TRACKING;
+        return;
+    }
+    m_ReadoutQuit = false;
+    m_ReadoutThread = std::thread(&SBIGCCD::readoutThread, this);
+}
+
+void SBIGCCD::stopReadoutThread()
+{
+    if (!m_ReadoutThread.joinable())
+    {
+        return;
     }
+    std::unique_lock<std::mutex> guard(m_ReadoutMutex);
+    m_ReadoutQuit = true;
+    guard.unlock();
+    m_ReadoutCV.notify_all();
+    m_ReadoutThread.join();
+}
+
+SBIGCCD::ReadoutJob &SBIGCCD::readoutJob(INDI::CCDChip *targetChip)
+{
+    return (targetChip == &PrimaryCCD) ? m_PrimaryReadout : m_GuideReadout;
+}
+
+SBIGCCD::ReadoutJob &SBIGCCD::nextReadoutJob(INDI::CCDChip *targetChip)
+{
+    return (targetChip == &PrimaryCCD) ? m_PrimaryNext : m_GuideNext;
+}
+
+SBIGCCD::DarkFrame &SBIGCCD::darkFrame(INDI::CCDChip *targetChip)
+{
+    return (targetChip == &PrimaryCCD) ? m_PrimaryDark : m_GuideDark;
+}
+
+bool SBIGCCD::queueReadout(INDI::CCDChip *targetChip)
+{
+    int binning, res;
     if ((res = getBinningMode(targetChip, binning)) != CE_NO_ERROR)
     {
-        return res;
+        return false;
+    }
+
+    std::unique_lock<std::mutex> guard(m_ReadoutMutex);
+
+    // An aborted readout of this chip may still be finishing its last batch, the
+    // worker then starts this one as soon as it is done. Never wait for it here.
+    ReadoutJob &job = readoutJob(targetChip).active ? nextReadoutJob(targetChip) : readoutJob(targetChip);
+
+    job.chip     = targetChip;
+    job.ccd      = getReadoutCCD(targetChip);
+    job.binning  = binning;
+    job.left     = targetChip->getSubX() / targetChip->getBinX();
+    job.top      = targetChip->getSubY() / targetChip->getBinY();
+    job.width    = targetChip->getSubW() / targetChip->getBinX();
+    job.height   = targetChip->getSubH() / targetChip->getBinY();
+    job.buffer   = reinterpret_cast<uint16_t *>(targetChip->getFrameBuffer());
+    job.nextLine = 0;
+    job.retries  = 0;
+    job.started  = false;
+    job.abort    = false;
+    job.subtract = false;
+
+    std::chrono::duration<double> exposure((targetChip == &PrimaryCCD) ? ExposureRequest : GuideExposureRequest);
+    job.exposureEnd = ((targetChip == &PrimaryCCD) ? ExpStart : GuideExpStart) +
+                      std::chrono::duration_cast<std::chrono::system_clock::duration>(exposure);
+
+    // Light frames may have the last dark of the same geometry subtracted by the driver.
+    int subtractIndex = (targetChip == &PrimaryCCD) ? DARK_SUBTRACT_PRIMARY : DARK_SUBTRACT_GUIDE;
+    if (DarkSubtractS[subtractIndex].s == ISS_ON && targetChip->getFrameType() == INDI::CCDChip::LIGHT_FRAME)
+    {
+        const DarkFrame &dark = darkFrame(targetChip);
+        job.subtract = dark.binning == job.binning && dark.left == job.left && dark.top == job.top &&
+                       dark.width == job.width && dark.height == job.height;
+        if (!job.subtract)
+        {
+            LOGF_DEBUG("%s has no dark frame matching this readout, reading without dark subtraction.",
+                       targetChip == &PrimaryCCD ? "Primary camera" : "Guide head");
+        }
     }
-    StartReadoutParams srp;
-    srp.ccd         = ccd;
-    srp.readoutMode = binning;
-    srp.left        = left;
-    srp.top         = top;
-    srp.width       = width;
-    srp.height      = height;
+
+    job.active = true;
+    guard.unlock();
+    m_ReadoutCV.notify_all();
+    return true;
+}
+
+void SBIGCCD::abortReadout(INDI::CCDChip *targetChip)
+{
+    std::unique_lock<std::mutex> guard(m_ReadoutMutex);
+    ReadoutJob &job = readoutJob(targetChip);
+    if (job.active)
+    {
+        job.abort = true;
+    }
+    nextReadoutJob(targetChip).active = false;
+}
+
+int SBIGCCD::readoutStep(ReadoutJob &job)
+{
+    int res = CE_NO_ERROR;
     std::unique_lock<std::mutex> guard(sbigLock);
-    res = StartReadout(&srp);
-    if (res != CE_NO_ERROR)
+    if (!job.started)
     {
-        LOGF_ERROR("%s readoutCCD - StartReadout error! (%s)",
-                   (targetChip == &PrimaryCCD) ? "Primary" : "Guide", GetErrorString(res));
-        guard.unlock();
-        return res;
+        // CC_READ_SUBTRACT_LINE subtracts the dark pixels already in the buffer from the line it reads
+        if (job.subtract)
+        {
+            const DarkFrame &dark = darkFrame(job.chip);
+            std::copy(dark.pixels.begin(), dark.pixels.end(), job.buffer);
+        }
+
+        StartReadoutParams srp;
+        srp.ccd         = job.ccd;
+        srp.readoutMode = job.binning;
+        srp.left        = job.left;
+        srp.top         = job.top;
+        srp.width       = job.width;
+        srp.height      = job.height;
+        if ((res = StartReadout(&srp)) != CE_NO_ERROR)
+        {
+            LOGF_ERROR("%s readout - StartReadout error! (%s)",
+                       (job.chip == &PrimaryCCD) ? "Primary" : "Guide", GetErrorString(res));
+            return res;
+        }
+        job.started  = true;
+        job.nextLine = 0;
     }
+
     ReadoutLineParams rlp;
-    rlp.ccd         = ccd;
-    rlp.readoutMode = binning;
-    rlp.pixelStart  = left;
-    rlp.pixelLength = width;
-    for (h = 0; h < height; h++)
+    rlp.ccd         = job.ccd;
+    rlp.readoutMode = job.binning;
+    rlp.pixelStart  = job.left;
+    rlp.pixelLength = job.width;
+    uint16_t lastLine = std::min<int>(job.nextLine + READOUT_LINE_BATCH, job.height);
+    for (; job.nextLine < lastLine; job.nextLine++)
+    {
+        if ((res = ReadoutLine(&rlp, job.buffer + (job.nextLine * job.width), job.subtract)) != CE_NO_ERROR)
+        {
+            return res;
+        }
+    }
+
+    if (job.nextLine == job.height)
     {
-        ReadoutLine(&rlp, buffer + (h * width), false);
+        EndReadoutParams erp;
+        erp.ccd     = job.ccd;
+        job.started = false;
+        if ((res = EndReadout(&erp)) != CE_NO_ERROR)
+        {
+            LOGF_ERROR("%s readout - EndReadout error! (%s)",
+                       (job.chip == &PrimaryCCD) ? "Primary" : "Guide", GetErrorString(res));
+        }
     }
-    EndReadoutParams erp;
-    erp.ccd = ccd;
-    if ((res = EndReadout(&erp)) != CE_NO_ERROR)
+    return res;
+}
+
+void SBIGCCD::finishReadout(ReadoutJob &job)
+{
+    INDI::CCDChip *targetChip = job.chip;
+    int subtractIndex = (targetChip == &PrimaryCCD) ? DARK_SUBTRACT_PRIMARY : DARK_SUBTRACT_GUIDE;
+
+    // Keep dark frames for the light frames that follow
+    if (DarkSubtractS[subtractIndex].s == ISS_ON && targetChip->getFrameType() == INDI::CCDChip::DARK_FRAME)
     {
-        LOGF_ERROR("%s readoutCCD - EndReadout error! (%s)",
-                   (targetChip == &PrimaryCCD) ? "Primary" : "Guide", GetErrorString(res));
+        DarkFrame &dark = darkFrame(targetChip);
+        dark.binning = job.binning;
+        dark.left    = job.left;
+        dark.top     = job.top;
+        dark.width   = job.width;
+        dark.height  = job.height;
+        dark.pixels.assign(job.buffer, job.buffer + (job.width * job.height));
+    }
+
+    if (targetChip == &GuideCCD)
+    {
+        std::chrono::duration<double, std::milli> latency = std::chrono::system_clock::now() - job.exposureEnd;
+        GuideLatencyN[0].value = latency.count();
+        GuideLatencyNP.s       = IPS_OK;
+        IDSetNumber(&GuideLatencyNP, nullptr);
+
+        std::unique_lock<std::mutex> guard(m_ReadoutMutex);
+        if (m_PrimaryReadout.active)
+        {
+            LOGF_DEBUG("Guide frame delivered in %.0f ms during primary readout (%d of %d lines).",
+                       latency.count(), m_PrimaryReadout.nextLine, m_PrimaryReadout.height);
+        }
+    }
+
+    LOGF_DEBUG("%s readout complete", targetChip == &PrimaryCCD ? "Primary camera" : "Guide head");
+    ExposureComplete(targetChip);
+}
+
+void SBIGCCD::readoutThread()
+{
+    LOG_DEBUG("Readout thread started...");
+    std::unique_lock<std::mutex> guard(m_ReadoutMutex);
+    while (true)
+    {
+        m_ReadoutCV.wait(guard, [this]
+        {
+            return m_ReadoutQuit || m_PrimaryReadout.active || m_GuideReadout.active;
+        });
+        if (m_ReadoutQuit)
+        {
+            break;
+        }
+
+        ReadoutJob &job = m_GuideReadout.active ? m_GuideReadout : m_PrimaryReadout;
+        bool aborted = job.abort;
         guard.unlock();
-        return res;
+
+        int res = CE_NO_ERROR;
+        if (!aborted)
+        {
+            res = readoutStep(job);
+        }
+
+        if ((aborted || res != CE_NO_ERROR) && job.started)
+        {
+            EndReadoutParams erp;
+            erp.ccd = job.ccd;
+            std::unique_lock<std::mutex> sbigGuard(sbigLock);
+            EndReadout(&erp);
+            job.started = false;
+        }
+
+        if (aborted)
+        {
+            LOGF_DEBUG("%s readout aborted", job.chip == &PrimaryCCD ? "Primary camera" : "Guide head");
+        }
+        else if (res != CE_NO_ERROR)
+        {
+            if (++job.retries < MAX_THREAD_RETRIES)
+            {
+                LOG_DEBUG("Readout error, retrying...");
+                usleep(MAX_THREAD_WAIT);
+                guard.lock();
+                continue;
+            }
+            LOGF_ERROR("%s readout error", job.chip == &PrimaryCCD ? "Primary camera" : "Guide head");
+            job.chip->setExposureFailed();
+        }
+        else if (job.nextLine < job.height)
+        {
+            // More lines to go, see which chip needs serving next
+            guard.lock();
+            continue;
+        }
+        else
+        {
+            finishReadout(job);
+        }
+
+        guard.lock();
+        ReadoutJob &next = nextReadoutJob(job.chip);
+        if (next.active)
+        {
+            job = next;
+            next.active = false;
+        }
+        else
+        {
+            job.active = false;
+        }
+    }
+
+    // Leave the camera in a sane state if we are disconnecting mid-readout
+    for (ReadoutJob *job : { &m_PrimaryReadout, &m_GuideReadout })
+    {
+        if (job->active && job->started)
+        {
+            EndReadoutParams erp;
+            erp.ccd = job->ccd;
+            std::unique_lock<std::mutex> sbigGuard(sbigLock);
+            EndReadout(&erp);
+        }
+        job->started = false;
+        job->active  = false;
     }
+    m_PrimaryNext.active = false;
+    m_GuideNext.active   = false;
     guard.unlock();
-    return res;
+    LOG_DEBUG("Readout thread finished");
 }
 
 //==========================================================================
@@ -37,7 +37,12 @@
 #include <sbigudrv.h>
 #endif
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #define DEVICE struct usb_device *
 
@@ -133,9 +138,6 @@ class SBIGCCD : public INDI::CCD, public INDI::FilterInterface
         virtual bool ISNewText(const char *dev, const char *name, char *texts[], char *names[], int n) override;
         void updateTemperature();
         static void updateTemperatureHelper(void *);
-#ifdef ASYNC_READOUT
-        static void *grabCCDHelper(void *context);
-#endif
         bool isExposureDone(INDI::CCDChip *targetChip);
 
         static void NSGuideHelper(void *context);
@@ -251,6 +253,19 @@ class SBIGCCD : public INDI::CCD, public INDI::FilterInterface
         ISwitch IgnoreErrorsS[1];
         ISwitchVectorProperty IgnoreErrorsSP;
 
+        // Subtract the last dark frame in the driver with CC_READ_SUBTRACT_LINE
+        ISwitch DarkSubtractS[2];
+        ISwitchVectorProperty DarkSubtractSP;
+        enum
+        {
+            DARK_SUBTRACT_PRIMARY,
+            DARK_SUBTRACT_GUIDE,
+        };
+
+        // Time from the end of a guide exposure until the frame is delivered
+        INumber GuideLatencyN[1];
+        INumberVectorProperty GuideLatencyNP;
+
         /////////////////////////////////////////////////////////////////////////////
         /// Filter Wheel Properties
         /////////////////////////////////////////////////////////////////////////////
@@ -278,6 +293,62 @@ class SBIGCCD : public INDI::CCD, public INDI::FilterInterface
         /////////////////////////////////////////////////////////////////////////////
         std::mutex sbigLock;
 
+        /////////////////////////////////////////////////////////////////////////////
+        /// Readout Scheduler
+        /////////////////////////////////////////////////////////////////////////////
+        // One chip readout in progress. Both chips can be read out at the same time,
+        // the scheduler interleaves their lines and always serves the guide chip first.
+        struct ReadoutJob
+        {
+            INDI::CCDChip *chip { nullptr };
+            bool active { false };
+            bool started { false };
+            bool abort { false };
+            bool subtract { false };
+            int ccd { 0 };
+            int binning { 0 };
+            uint16_t left { 0 };
+            uint16_t top { 0 };
+            uint16_t width { 0 };
+            uint16_t height { 0 };
+            uint16_t nextLine { 0 };
+            int retries { 0 };
+            uint16_t *buffer { nullptr };
+            // When the shutter closed, guide latency is measured from here
+            std::chrono::system_clock::time_point exposureEnd;
+        };
+
+        // The last dark frame read from each chip, used by CC_READ_SUBTRACT_LINE
+        struct DarkFrame
+        {
+            int binning { -1 };
+            uint16_t left { 0 };
+            uint16_t top { 0 };
+            uint16_t width { 0 };
+            uint16_t height { 0 };
+            std::vector<uint16_t> pixels;
+        };
+
+        void startReadoutThread();
+        void stopReadoutThread();
+        void readoutThread();
+        bool queueReadout(INDI::CCDChip *targetChip);
+        void abortReadout(INDI::CCDChip *targetChip);
+        int readoutStep(ReadoutJob &job);
+        void finishReadout(ReadoutJob &job);
+        ReadoutJob &readoutJob(INDI::CCDChip *targetChip);
+        ReadoutJob &nextReadoutJob(INDI::CCDChip *targetChip);
+        DarkFrame &darkFrame(INDI::CCDChip *targetChip);
+
+        ReadoutJob m_PrimaryReadout, m_GuideReadout;
+        // A frame queued while the aborted readout of the same chip is still winding down
+        ReadoutJob m_PrimaryNext, m_GuideNext;
+        DarkFrame m_PrimaryDark, m_GuideDark;
+        std::thread m_ReadoutThread;
+        std::mutex m_ReadoutMutex;
+        std::condition_variable m_ReadoutCV;
+        bool m_ReadoutQuit { false };
+
         /////////////////////////////////////////////////////////////////////////////
         /// Exposure Variables
         /////////////////////////////////////////////////////////////////////////////
@@ -407,8 +478,7 @@ class SBIGCCD : public INDI::CCD, public INDI::FilterInterface
         int getBinningMode(INDI::CCDChip *targetChip, int &binning);
         int getFrameType(INDI::CCDChip *targetChip, INDI::CCDChip::CCD_FRAME *frameType);
         int getShutterMode(INDI::CCDChip *targetChip, int &shutter);
-        int readoutCCD(unsigned short left, unsigned short top, unsigned short width, unsigned short height,
-                       unsigned short *buffer, INDI::CCDChip *targetChip);
+        int getReadoutCCD(INDI::CCDChip *targetChip);
 
         /////////////////////////////////////////////////////////////////////////////
         /// Filter Wheel Functions
@@ -36,6 +36,7 @@
 
 #include <libnova/julian_day.h>
 
+#include <algorithm>
 #include <memory>
 #include <stdlib.h>
 #include <string.h>
@@ -64,6 +65,12 @@ const unsigned int SPECTROMETER_OFFSET = 0x050;
 /* 90 Khz Rest Correction */
 const double SPECTROMETER_REST_CORRECTION = 0.090;
 
+/* Integration settle time after a frequency change */
+const int SPECTROMETER_SETTLE_MS = 500;
+
+/* Publish a partial batch of samples at least this often */
+const int SCAN_PUBLISH_MAX_MS = 5000;
+
 static const char *contFMT = ".ascii_cont";
 static const char *specFMT = ".ascii_spec";
 
@@ -91,6 +98,11 @@ SpectraCyber::SpectraCyber()
     setVersion(SPECTRACYBER_VERSION_MAJOR, SPECTRACYBER_VERSION_MINOR);        
 }
 
+SpectraCyber::~SpectraCyber()
+{
+    stop_scan();
+}
+
 /****************************************************************
 **
 **
@@ -250,6 +262,7 @@ bool SpectraCyber::init_spectrometer()
 *****************************************************************/
 bool SpectraCyber::Disconnect()
 {
+    stop_scan();
     tty_disconnect(fd);
 
     return true;
@@ -446,6 +459,10 @@ bool SpectraCyber::ISNewSwitch(const char *dev, const char *name, ISState *state
         {
             if (sProp.getState() == IPS_BUSY)
             {
+                stop_scan();
+                collect_samples();
+                publish_samples(true);
+
                 sProp.setState(IPS_IDLE);
                 FreqNP.setState(IPS_IDLE);
                 DataStreamBP.setState(IPS_IDLE);
@@ -465,7 +482,7 @@ bool SpectraCyber::ISNewSwitch(const char *dev, const char *name, ISState *state
         DataStreamBP.setState(IPS_BUSY);
 
         // Compute starting freq  = base_freq - low
-        if (sProp[SPEC_CHANNEL].getState() == ISS_ON)
+        if (ChannelSP[SPEC_CHANNEL].getState() == ISS_ON)
         {
             start_freq  = (SPECTROMETER_RF_FREQ + SPECTROMETER_REST_FREQ) - abs((int)ScanNP[0].getValue()) / 1000.;
             target_freq = (SPECTROMETER_RF_FREQ + SPECTROMETER_REST_FREQ) + abs((int)ScanNP[1].getValue()) / 1000.;
@@ -479,6 +496,12 @@ bool SpectraCyber::ISNewSwitch(const char *dev, const char *name, ISState *state
         else
             sProp.apply("Starting continuum scan @ %g MHz...", FreqNP[0].getValue());
 
+        if (start_scan() == false)
+        {
+            abort_scan();
+            return false;
+        }
+
         return true;
     }
 
@@ -622,6 +645,9 @@ bool SpectraCyber::ISNewSwitch(const char *dev, const char *name, ISState *state
     // Reset
     if (sProp.isNameMatch("Reset"))
     {
+        if (ScanSP.getState() == IPS_BUSY)
+            abort_scan();
+
         if (reset() == true)
         {
             sProp.setState(IPS_OK);
@@ -645,6 +671,7 @@ bool SpectraCyber::dispatch_command(SpectrometerCommand command_type)
     int err_code = 0, nbytes_written = 0, final_value = 0;
     // Maximum of 3 hex digits in addition to null terminator
     char hex[5];
+    std::lock_guard<std::mutex> guard(ttyMutex);
 
     tcflush(fd, TCIOFLUSH);
 
@@ -761,8 +788,7 @@ bool SpectraCyber::dispatch_command(SpectrometerCommand command_type)
             // e.g. To set 50.00 Mhz, diff = 50 - 46.4 = 3.6 / 0.005 = 800 = 320h
             //      Freq = 320h + 050h (or 800 + 80) = 370h = 880 decimal
 
-            final_value = (int)((FreqNP[0].getValue() + SPECTROMETER_REST_CORRECTION - FreqNP[0].getMin()) / 0.005 +
-                                SPECTROMETER_OFFSET);
+            final_value = freq_code(FreqNP[0].getValue());
             sprintf(hex, "%03X", (uint32_t)final_value);
             if (isDebug())
                 IDLog("Required Freq is: %.3f --- Min Freq is: %.3f --- Spec Offset is: %d -- Final Value (Dec): %d "
@@ -859,12 +885,14 @@ bool SpectraCyber::update_freq(double nFreq)
         FreqNP.setState(IPS_OK);
 
     FreqNP.apply();
-
-    // Delay 0.5s for INT
-    usleep(500000);
     return true;
 }
 
+int SpectraCyber::freq_code(double freq)
+{
+    return (int)((freq + SPECTROMETER_REST_CORRECTION - FreqNP[0].getMin()) / 0.005 + SPECTROMETER_OFFSET);
+}
+
 bool SpectraCyber::reset()
 {
     int err_code = 0, nbytes_read = 0;
@@ -911,137 +939,305 @@ void SpectraCyber::TimerHit()
     if (!isConnected())
         return;
 
-    char RAStr[16], DecStr[16];
-
-    switch (ScanSP.getState())
+    if (ScanSP.getState() == IPS_BUSY)
     {
-        case IPS_BUSY:
-            if (ChannelSP[CONT_CHANNEL].getState() == ISS_ON)
-                break;
+        bool done, failed;
 
-            if (FreqNP[0].getValue() >= target_freq)
-            {
-                ScanSP.setState(IPS_OK);
-                FreqNP.setState(IPS_OK);
+        {
+            std::lock_guard<std::mutex> lock(scanMutex);
+            done   = scanDone;
+            failed = scanFailed;
+        }
 
-                FreqNP.apply();
-                ScanSP.apply("Scan complete.");
-                SetTimer(getCurrentPollingPeriod());
-                return;
-            }
+        collect_samples();
 
-            if (update_freq(FreqNP[0].getValue()) == false)
-            {
-                abort_scan();
-                SetTimer(getCurrentPollingPeriod());
-                return;
-            }
+        if (failed)
+        {
+            abort_scan();
+            DataStreamBP.setState(IPS_ALERT);
+            DataStreamBP.apply();
+        }
+        else if (done)
+        {
+            stop_scan();
+            collect_samples();
+            publish_samples(true);
 
-            FreqNP[0].setValue(FreqNP[0].getValue() +  sample_rate / 1000.);
-            break;
+            ScanSP.setState(IPS_OK);
+            FreqNP.setState(IPS_OK);
+            DataStreamBP.setState(IPS_IDLE);
 
-        default:
-            break;
+            FreqNP.apply();
+            DataStreamBP.apply();
+            ScanSP.apply("Scan complete.");
+        }
+        else
+            publish_samples(false);
     }
 
-    switch (DataStreamBP.getState())
-    {
-        case IPS_BUSY: {
-            if (ScanSP.getState() != IPS_BUSY)
-            {
-                DataStreamBP.setState(IPS_IDLE);
-                DataStreamBP.apply();
-                break;
-            }
+    SetTimer(getCurrentPollingPeriod());
+}
 
-            if (read_channel() == false)
-            {
-                DataStreamBP.setState(IPS_ALERT);
+void SpectraCyber::abort_scan()
+{
+    stop_scan();
+    collect_samples();
+    publish_samples(true);
 
-                if (ScanSP.getState() == IPS_BUSY)
-                    abort_scan();
+    FreqNP.setState(IPS_IDLE);
+    ScanSP.setState(IPS_ALERT);
 
-                DataStreamBP.apply();
-            }
+    ScanSP.reset();
+    ScanSP[1].setState(ISS_ON);
 
-            JD = ln_get_julian_from_sys();
+    FreqNP.apply();
+    ScanSP.apply("Scan aborted due to errors.");
+}
 
-            // Continuum
-            if (ChannelSP[0].getState() == ISS_ON)
-                DataStreamBP[0].setFormat(contFMT);
-            else
-                DataStreamBP[0].setFormat(specFMT);
+bool SpectraCyber::start_scan()
+{
+    std::vector<double> freqs;
+    std::vector<int> codes;
+    int channel = ChannelSP.findOnSwitchIndex();
+    int intervalMs;
 
-            fs_sexa(RAStr, EquatorialCoordsRN[0].value, 2, 3600);
-            fs_sexa(DecStr, EquatorialCoordsRN[1].value, 2, 3600);
+    stop_scan();
 
-            if (telescopeID && strlen(telescopeID->text) > 0)
-                snprintf(bLine, MAXBLEN, "%.8f %.3f %.3f %s %s", JD, chanValue, FreqNP[0].getValue(), RAStr, DecStr);
-            else
-                snprintf(bLine, MAXBLEN, "%.8f %.3f %.3f", JD, chanValue, FreqNP[0].getValue());
+    if (channel == SPEC_CHANNEL)
+    {
+        // Same steps as before: from start_freq up to, but not including, target_freq
+        double step = sample_rate / 1000.;
+        for (int i = 0; start_freq + i * step < target_freq - 1e-6; i++)
+        {
+            freqs.push_back(start_freq + i * step);
+            codes.push_back(freq_code(freqs.back()));
+        }
+
+        if (freqs.empty())
+        {
+            LOG_ERROR("Scan range is empty.");
+            return false;
+        }
 
-            auto bLineSize = strlen(bLine);
-            DataStreamBP[0].setBlobLen(bLineSize);
-            DataStreamBP[0].setSize(bLineSize);
-            memcpy(DataStreamBP[0].getBlob(), bLine, bLineSize);
+        intervalMs = SPECTROMETER_SETTLE_MS;
+    }
+    else
+    {
+        // Continuum channel stays on the current frequency and is read once per polling period
+        freqs.push_back(FreqNP[0].getValue());
+        intervalMs = getCurrentPollingPeriod();
+    }
 
-            //IDLog("\nSTRLEN: %d -- BLOB:'%s'\n", strlen(bLine), (char *) DataStreamBP->bp[0].blob);
+    scanStop       = false;
+    scanDone       = false;
+    scanFailed     = false;
+    scanSimulation = isSimulation();
+    scanSamples.clear();
+    scanBatch.clear();
+    scanBatchCount = 0;
+    lastPublish    = std::chrono::steady_clock::now();
 
-            DataStreamBP.apply();
+    scanThread = std::thread(&SpectraCyber::scan_thread, this, freqs, codes, channel, intervalMs);
+    return true;
+}
 
-            break;
-        }
-        default:
-            break;
+void SpectraCyber::stop_scan()
+{
+    {
+        std::lock_guard<std::mutex> lock(scanMutex);
+        scanStop = true;
     }
+    scanCV.notify_all();
 
-    SetTimer(getCurrentPollingPeriod());
+    if (scanThread.joinable())
+        scanThread.join();
 }
 
-void SpectraCyber::abort_scan()
+/****************************************************************
+** Scan worker. For a spectral scan every channel read also sends
+** the next frequency, so that step settles while this sample is
+** being queued. The next read is due SPECTROMETER_SETTLE_MS later.
+*****************************************************************/
+void SpectraCyber::scan_thread(std::vector<double> freqs, std::vector<int> codes, int channel, int intervalMs)
 {
-    FreqNP.setState(IPS_IDLE);
-    ScanSP.setState(IPS_ALERT);
+    bool tune = !codes.empty();
+    size_t i  = 0;
+    double value = 0;
+    auto due = std::chrono::steady_clock::now();
 
-    ScanSP.reset();
-    ScanSP[1].setState(ISS_ON);
+    if (tune)
+    {
+        // Tune the first step; later steps ride along with the channel reads
+        if (query_channel(channel, codes[0], nullptr) == false)
+        {
+            std::lock_guard<std::mutex> lock(scanMutex);
+            scanFailed = true;
+            return;
+        }
+        due += std::chrono::milliseconds(SPECTROMETER_SETTLE_MS);
+    }
 
-    FreqNP.apply();
-    ScanSP.apply("Scan aborted due to errors.");
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(scanMutex);
+            if (scanCV.wait_until(lock, due, [this] { return scanStop; }))
+                return;
+        }
+
+        int next   = (tune && i + 1 < codes.size()) ? codes[i + 1] : -1;
+        bool ok    = query_channel(channel, next, &value);
+        double JD  = ln_get_julian_from_sys();
+        due        = std::chrono::steady_clock::now() + std::chrono::milliseconds(intervalMs);
+
+        std::lock_guard<std::mutex> lock(scanMutex);
+        if (!ok)
+        {
+            scanFailed = true;
+            return;
+        }
+
+        scanSamples.push_back({JD, value, freqs[i]});
+
+        if (tune && ++i == freqs.size())
+        {
+            scanDone = true;
+            return;
+        }
+    }
 }
 
-bool SpectraCyber::read_channel()
+/****************************************************************
+** Read one channel value into value, unless it is null. If
+** nextFreqCode is not negative, the RECV_FREQ command for it is
+** written right behind the read command, in the same write.
+*****************************************************************/
+bool SpectraCyber::query_channel(int channel, int nextFreqCode, double *value)
 {
-    int err_code = 0, nbytes_read = 0;
-    char response[SPECTROMETER_CMD_REPLY];
+    char cmd[2 * SPECTROMETER_CMD_LEN + 1];
+    char response[SPECTROMETER_CMD_REPLY + 1] = {0};
     char err_msg[SPECTROMETER_ERROR_BUFFER];
+    int err_code = 0, nbytes = 0, len = 0;
 
-    if (isSimulation())
+    if (scanSimulation)
     {
-        chanValue = ((double)rand()) / ((double)RAND_MAX) * 10.0;
+        if (value)
+            *value = ((double)rand()) / ((double)RAND_MAX) * 10.0;
         return true;
     }
 
-    dispatch_command(READ_CHANNEL);
-    if ((err_code = tty_read(fd, response, SPECTROMETER_CMD_REPLY, 5, &nbytes_read)) != TTY_OK)
+    if (value)
     {
-        tty_error_msg(err_code, err_msg, 32);
-        if (isDebug())
-            IDLog("TTY error detected: %s\n", err_msg);
+        snprintf(cmd, sizeof(cmd), "!D00%c", (channel == SPEC_CHANNEL) ? '1' : '0');
+        len += SPECTROMETER_CMD_LEN;
+    }
+    if (nextFreqCode >= 0)
+    {
+        snprintf(cmd + len, sizeof(cmd) - len, "!F%03X", (uint32_t)nextFreqCode);
+        len += SPECTROMETER_CMD_LEN;
+    }
+
+    std::lock_guard<std::mutex> guard(ttyMutex);
+
+    // Drop stale input, e.g. a late echo, so the next reply is ours
+    tcflush(fd, TCIFLUSH);
+
+    if ((err_code = tty_write(fd, cmd, len, &nbytes)) != TTY_OK)
+    {
+        tty_error_msg(err_code, err_msg, SPECTROMETER_ERROR_BUFFER);
+        LOGF_ERROR("Error writing scan command: %s", err_msg);
         return false;
     }
 
-    if (isDebug())
-        IDLog("Response from Spectrometer: #%s#\n", response);
+    if (value == nullptr)
+        return true;
+
+    if ((err_code = tty_read(fd, response, SPECTROMETER_CMD_REPLY, 5, &nbytes)) != TTY_OK)
+    {
+        tty_error_msg(err_code, err_msg, SPECTROMETER_ERROR_BUFFER);
+        LOGF_ERROR("Error reading channel value: %s", err_msg);
+        return false;
+    }
 
     int result = 0;
     sscanf(response, "D%x", &result);
     // We divide by 409.5 to scale the value to 0 - 10 VDC range
-    chanValue = result / 409.5;
+    *value = result / 409.5;
 
     return true;
 }
 
+/****************************************************************
+** Move the worker's samples into the pending batch as text lines.
+*****************************************************************/
+void SpectraCyber::collect_samples()
+{
+    char RAStr[16], DecStr[16];
+    std::vector<ScanSample> samples;
+
+    {
+        std::lock_guard<std::mutex> lock(scanMutex);
+        samples.swap(scanSamples);
+    }
+
+    if (samples.empty())
+        return;
+
+    fs_sexa(RAStr, EquatorialCoordsRN[0].value, 2, 3600);
+    fs_sexa(DecStr, EquatorialCoordsRN[1].value, 2, 3600);
+
+    for (auto &sample : samples)
+    {
+        if (telescopeID && strlen(telescopeID->text) > 0)
+            snprintf(bLine, MAXBLEN, "%.8f %.3f %.3f %s %s\n", sample.JD, sample.value, sample.freq, RAStr, DecStr);
+        else
+            snprintf(bLine, MAXBLEN, "%.8f %.3f %.3f\n", sample.JD, sample.value, sample.freq);
+
+        scanBatch += bLine;
+        scanBatchCount++;
+    }
+
+    if (ChannelSP[SPEC_CHANNEL].getState() == ISS_ON)
+    {
+        FreqNP[0].setValue(samples.back().freq);
+        FreqNP.apply();
+    }
+}
+
+/****************************************************************
+** Send the pending lines as one Data BLOB once the batch size in
+** Scan Parameters is reached, or SCAN_PUBLISH_MAX_MS after the
+** previous BLOB. Use force to send the batch regardless.
+*****************************************************************/
+void SpectraCyber::publish_samples(bool force)
+{
+    if (scanBatchCount == 0)
+        return;
+
+    auto now  = std::chrono::steady_clock::now();
+    int batch = std::max(1, (int)ScanNP[3].getValue());
+
+    if (!force && scanBatchCount < batch &&
+            now - lastPublish < std::chrono::milliseconds(SCAN_PUBLISH_MAX_MS))
+        return;
+
+    // Continuum
+    if (ChannelSP[0].getState() == ISS_ON)
+        DataStreamBP[0].setFormat(contFMT);
+    else
+        DataStreamBP[0].setFormat(specFMT);
+
+    DataStreamBP[0].setBlob(realloc(DataStreamBP[0].getBlob(), scanBatch.size()));
+    memcpy(DataStreamBP[0].getBlob(), scanBatch.data(), scanBatch.size());
+    DataStreamBP[0].setBlobLen(scanBatch.size());
+    DataStreamBP[0].setSize(scanBatch.size());
+    DataStreamBP.apply();
+
+    scanBatch.clear();
+    scanBatchCount = 0;
+    lastPublish    = now;
+}
+
 const char *SpectraCyber::getDefaultName()
 {
     return mydev;
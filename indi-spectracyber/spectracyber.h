@@ -28,7 +28,12 @@
 
 #include <defaultdevice.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #define MAXBLEN 64
 
@@ -67,6 +72,7 @@ class SpectraCyber : public INDI::DefaultDevice
     };
 
     SpectraCyber();
+    ~SpectraCyber();
 
     // Standard INDI interface functions
     virtual void ISGetProperties(const char *dev) override;
@@ -86,6 +92,13 @@ class SpectraCyber : public INDI::DefaultDevice
     bool update_freq(double nFreq);
 
   private:
+    struct ScanSample
+    {
+        double JD;
+        double value;
+        double freq;
+    };
+
     INDI::PropertyNumber FreqNP       {INDI::Property()};
     INDI::PropertyNumber ScanNP       {INDI::Property()};
     INDI::PropertySwitch ScanSP       {INDI::Property()};
@@ -101,7 +114,13 @@ class SpectraCyber : public INDI::DefaultDevice
     virtual bool initProperties() override;
     bool init_spectrometer();
     void abort_scan();
-    bool read_channel();
+    bool start_scan();
+    void stop_scan();
+    void scan_thread(std::vector<double> freqs, std::vector<int> codes, int channel, int intervalMs);
+    bool query_channel(int channel, int nextFreqCode, double *value);
+    void collect_samples();
+    void publish_samples(bool force);
+    int freq_code(double freq);
     bool dispatch_command(SpectrometerCommand command);
     int get_on_switch(ISwitchVectorProperty *sp);
     bool reset();
@@ -113,5 +132,24 @@ class SpectraCyber : public INDI::DefaultDevice
     int fd;
     char bLine[MAXBLEN];
     char command[5];
-    double start_freq, target_freq, sample_rate, JD, chanValue;
+    double start_freq, target_freq, sample_rate;
+
+    // Scan worker. It tunes and reads the spectrometer; TimerHit collects its
+    // samples and publishes them in batches. scanMutex guards the samples and flags.
+    std::thread scanThread;
+    std::mutex scanMutex;
+    std::condition_variable scanCV;
+    std::vector<ScanSample> scanSamples;
+    bool scanStop {false};
+    bool scanDone {false};
+    bool scanFailed {false};
+    bool scanSimulation {false};
+
+    // Serializes command and reply exchanges on the serial port
+    std::mutex ttyMutex;
+
+    // Sample lines waiting for the next Data BLOB
+    std::string scanBatch;
+    int scanBatchCount {0};
+    std::chrono::steady_clock::time_point lastPublish;
 };
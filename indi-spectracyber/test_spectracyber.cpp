@@ -0,0 +1,268 @@
+/*
+    SpectraCyber scan test
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+// Runs the scan worker against a spectrometer emulated on a pty at 2400 baud. The emulator
+// answers channel reads with the frequency code it is tuned to, so every sample can be
+// checked against the frequency it is labelled with, and it counts reads that arrive before
+// the tuning has settled.
+
+#include <gtest/gtest.h>
+
+#include <indicom.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <stdlib.h>
+#include <string>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// The worker is started by hand instead of through the Scan switch
+#define private public
+#define protected public
+#include "spectracyber.h"
+#undef private
+#undef protected
+
+extern std::unique_ptr<SpectraCyber> spectracyber;
+
+// Lowest frequency of the receiver, as in the skeleton file
+static const double MinFreq = 1418.205;
+
+// Settle time after a frequency change, as in the driver
+static const int SettleMs = 500;
+
+static int freqCode(double freq)
+{
+    return (int)((freq + 0.090 - MinFreq) / 0.005 + 0x050);
+}
+
+// Spectrometer on the master side of a pty, at 2400 baud 8N1 (4.17 ms per byte each way)
+class SpectrometerEmulator
+{
+    public:
+        SpectrometerEmulator()
+        {
+            master = posix_openpt(O_RDWR | O_NOCTTY);
+            EXPECT_GE(master, 0);
+            grantpt(master);
+            unlockpt(master);
+            struct termios tio;
+            tcgetattr(master, &tio);
+            cfmakeraw(&tio);
+            tcsetattr(master, TCSANOW, &tio);
+            slave = ptsname(master);
+            thread = std::thread(&SpectrometerEmulator::run, this);
+        }
+
+        ~SpectrometerEmulator()
+        {
+            quit = true;
+            thread.join();
+            close(master);
+        }
+
+        std::string slave;
+        std::atomic<int> reads { 0 };
+        // Reads less than the settle time after the last tuning command
+        std::atomic<int> unsettled { 0 };
+
+    private:
+        void run()
+        {
+            const auto byteTime = std::chrono::microseconds(4167);
+            std::string command;
+            int code = 0x050;
+            auto tunedAt = std::chrono::steady_clock::now();
+            char c;
+
+            while (!quit)
+            {
+                struct pollfd fds = { master, POLLIN, 0 };
+                if (poll(&fds, 1, 20) <= 0 || read(master, &c, 1) != 1)
+                    continue;
+                std::this_thread::sleep_for(byteTime);
+                if (c == '!')
+                    command.clear();
+                command += c;
+                if (command.size() < 5)
+                    continue;
+
+                if (command[1] == 'F')
+                {
+                    code = strtol(command.substr(2).c_str(), nullptr, 16);
+                    tunedAt = std::chrono::steady_clock::now();
+                }
+                else if (command[1] == 'D')
+                {
+                    reads++;
+                    // Allow for the 10 ms the read command itself takes on the wire
+                    if (std::chrono::steady_clock::now() - tunedAt < std::chrono::milliseconds(SettleMs - 10))
+                        unsettled++;
+                    char reply[8];
+                    snprintf(reply, sizeof(reply), "D%03X", code & 0xFFF);
+                    for (int i = 0; i < 4; i++)
+                    {
+                        std::this_thread::sleep_for(byteTime);
+                        if (write(master, reply + i, 1) != 1)
+                            ADD_FAILURE() << "emulator write failed";
+                    }
+                }
+                command.clear();
+            }
+        }
+
+        int master { -1 };
+        std::thread thread;
+        std::atomic_bool quit { false };
+};
+
+// What a spectral scan step did before: tune, sleep 0.5 s, read, then wait out the polling period
+static bool oldScanStep(int fd, int code, int pollingMs, double *value)
+{
+    char cmd[8], response[5] = {0};
+    int nbytes;
+
+    snprintf(cmd, sizeof(cmd), "!F%03X", code);
+    if (tty_write(fd, cmd, 5, &nbytes) != TTY_OK)
+        return false;
+    usleep(SettleMs * 1000);
+
+    tcflush(fd, TCIFLUSH);
+    if (tty_write(fd, "!D001", 5, &nbytes) != TTY_OK || tty_read(fd, response, 4, 5, &nbytes) != TTY_OK)
+        return false;
+    int result = 0;
+    sscanf(response, "D%x", &result);
+    *value = result / 409.5;
+
+    usleep(pollingMs * 1000);
+    return true;
+}
+
+class SpectraCyberScan : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            ASSERT_EQ(tty_connect(emulator.slave.c_str(), 2400, 8, 0, 1, &spectracyber->fd), TTY_OK);
+            spectracyber->scanStop       = false;
+            spectracyber->scanDone       = false;
+            spectracyber->scanFailed     = false;
+            spectracyber->scanSimulation = false;
+            spectracyber->scanSamples.clear();
+        }
+
+        void TearDown() override
+        {
+            spectracyber->stop_scan();
+            tty_disconnect(spectracyber->fd);
+        }
+
+        // Steps of 5 kHz from 0.6 MHz below the rest frequency
+        void scanSteps(int steps, std::vector<double> &freqs, std::vector<int> &codes)
+        {
+            for (int i = 0; i < steps; i++)
+            {
+                freqs.push_back(1371.805 + 48.6 - 0.6 + i * 0.005);
+                codes.push_back(freqCode(freqs.back()));
+            }
+        }
+
+        SpectrometerEmulator emulator;
+};
+
+TEST_F(SpectraCyberScan, SamplesAreSettledAndLabelled)
+{
+    const int steps = 40, oldSteps = 4;
+    std::vector<double> freqs;
+    std::vector<int> codes;
+    scanSteps(steps, freqs, codes);
+
+    // A few steps the old way, with the default 1 s polling period
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < oldSteps; i++)
+    {
+        double value;
+        ASSERT_TRUE(oldScanStep(spectracyber->fd, codes[i], i + 1 < oldSteps ? 1000 : 0, &value));
+        EXPECT_EQ(lround(value * 409.5), codes[i]);
+    }
+    double oldRate = oldSteps / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    emulator.reads = 0;
+    emulator.unsettled = 0;
+    start = std::chrono::steady_clock::now();
+    spectracyber->scanThread = std::thread(&SpectraCyber::scan_thread, spectracyber.get(), freqs, codes,
+                                           SpectraCyber::SPECTRAL_CHANNEL, SettleMs);
+    spectracyber->scanThread.join();
+    double rate = steps / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    ASSERT_TRUE(spectracyber->scanDone);
+    ASSERT_FALSE(spectracyber->scanFailed);
+    ASSERT_EQ(spectracyber->scanSamples.size(), static_cast<size_t>(steps));
+
+    int mislabelled = 0;
+    for (size_t i = 0; i < spectracyber->scanSamples.size(); i++)
+    {
+        const auto &sample = spectracyber->scanSamples[i];
+        EXPECT_DOUBLE_EQ(sample.freq, freqs[i]);
+        if (lround(sample.value * 409.5) != freqCode(sample.freq))
+            mislabelled++;
+    }
+    EXPECT_EQ(mislabelled, 0);
+    EXPECT_EQ(emulator.reads.load(), steps);
+    EXPECT_EQ(emulator.unsettled.load(), 0);
+    EXPECT_GT(rate, oldRate);
+
+    fprintf(stderr, "%d-step scan: %zu/%d samples, %d mislabelled, %d unsettled; %.2f samples/s, old sequence %.2f samples/s\n",
+            steps, spectracyber->scanSamples.size(), steps, mislabelled, emulator.unsettled.load(), rate, oldRate);
+}
+
+TEST_F(SpectraCyberScan, StopDuringSettleReturnsImmediately)
+{
+    std::vector<double> freqs;
+    std::vector<int> codes;
+    scanSteps(40, freqs, codes);
+
+    spectracyber->scanThread = std::thread(&SpectraCyber::scan_thread, spectracyber.get(), freqs, codes,
+                                           SpectraCyber::SPECTRAL_CHANNEL, SettleMs);
+    // Let the first tuning command go out, the worker is then waiting for the step to settle
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto start = std::chrono::steady_clock::now();
+    spectracyber->stop_scan();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_LT(ms, 50);
+    EXPECT_TRUE(spectracyber->scanSamples.empty());
+    EXPECT_FALSE(spectracyber->scanDone);
+    EXPECT_EQ(emulator.reads.load(), 0);
+
+    fprintf(stderr, "Stop during the settle wait returned after %.2f ms\n", ms);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -2,8 +2,14 @@
 #include "indi_starbook_ten.h"
 #include "config.h"
 
+#include <algorithm>
+
 #define MOUNT_TAB "Mount"
 
+/* Status older than this many polling periods, and at least STATUS_STALE_MIN_MS, is an error */
+#define STATUS_STALE_PERIODS 3
+#define STATUS_STALE_MIN_MS  5000
+
 template <typename Tr>
 Tr retry(int retries, std::function<Tr()> f)
 {
@@ -190,10 +196,16 @@ INDIStarbookTen::updateProperties()
         defineProperty(&GuideRateNP);
         defineProperty(&HomeSP);
 
-        return fetchStartupInfo();
+        if (!fetchStartupInfo())
+            return false;
+
+        starbook->startPolling(std::chrono::milliseconds(getCurrentPollingPeriod()));
+        return true;
     }
     else
     {
+        starbook->stopPolling();
+
         deleteProperty(InfoTP.name);
         deleteProperty(StateTP.name);
         deleteProperty(GuideRateNP.name);
@@ -289,6 +301,15 @@ INDIStarbookTen::ISNewSwitch(const char *dev, const char *name, ISState *states,
 }
 
 
+bool
+INDIStarbookTen::Disconnect()
+{
+    // The poller shares the HTTP client, which the connection plugin deletes
+    starbook->stopPolling();
+    return INDI::Telescope::Disconnect();
+}
+
+
 bool
 INDIStarbookTen::Handshake()
 {
@@ -372,10 +393,37 @@ INDIStarbookTen::fetchStartupInfo()
 bool
 INDIStarbookTen::ReadScopeStatus()
 {
+    StarbookTen::StatusSnapshot snap;
+
+    starbook->setPollPeriod(std::chrono::milliseconds(getCurrentPollingPeriod()));
+    bool current = starbook->getSnapshot(snap);
+
+    if (!snap.valid)
+    {
+        if (snap.error.empty())
+            return true;    // first poll still in flight
+
+        LOGF_ERROR("ReadScopeStatus failed: %s", snap.error.c_str());
+        return false;
+    }
+
+    auto age = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - snap.updated).count();
+    auto staleLimit = std::max<long long>(STATUS_STALE_PERIODS * getCurrentPollingPeriod(), STATUS_STALE_MIN_MS);
+    if (age > staleLimit)
+    {
+        LOGF_ERROR("ReadScopeStatus failed: status is %lld ms old (%s)", static_cast<long long>(age),
+                   snap.error.empty() ? "no response" : snap.error.c_str());
+        return false;
+    }
+
+    // Wait for a poll that started after the last command, or a just started goto could look finished
+    if (!current)
+        return true;
+
     try
     {
-        auto stat = retry<StarbookTen::MountStatus>(2, &StarbookTen::getStatus, starbook);
-        bool isTracking = retry<bool>(2, &StarbookTen::isTracking, starbook);
+        auto &stat = snap.status;
+        bool isTracking = snap.tracking;
 
         updateStarbookState(stat);
 
@@ -412,26 +460,27 @@ INDIStarbookTen::ReadScopeStatus()
 
         NewRaDec(stat.ra, stat.dec);
 
-        auto ps = retry<StarbookTen::PierSide>(2, &StarbookTen::getPierSide, starbook);
-        setPierSide((ps == StarbookTen::PIERSIDE_EAST) ? INDI::Telescope::PIER_EAST : INDI::Telescope::PIER_WEST);
+        setPierSide((snap.pierside == StarbookTen::PIERSIDE_EAST) ? INDI::Telescope::PIER_EAST : INDI::Telescope::PIER_WEST);
 
         if (isPropGuidingRA || isPropGuidingDE)
         {
-            auto gs = retry<std::tuple<bool, bool> >(2, &StarbookTen::getGuidingRaDec, starbook);
-            LOGF_DEBUG("Prop guiding status: RA=%d, DEC=%d", !!(std::get<0>(gs)), !!(std::get<1>(gs)));
-            if (isPropGuidingRA && !std::get<0>(gs))
+            LOGF_DEBUG("Prop guiding status: RA=%d, DEC=%d", snap.guidingRa, snap.guidingDec);
+            if (isPropGuidingRA && !snap.guidingRa)
             {
                 LOG_DEBUG("Prop guiding in RA finished");
                 isPropGuidingRA = false;
                 INDI::GuiderInterface::GuideComplete(AXIS_RA);
             }
 
-            if (isPropGuidingDE && !std::get<1>(gs))
+            if (isPropGuidingDE && !snap.guidingDec)
             {
                 LOG_DEBUG("Prop guiding in DE finished");
                 isPropGuidingDE = false;
                 INDI::GuiderInterface::GuideComplete(AXIS_DE);
             }
+
+            if (!isPropGuidingRA && !isPropGuidingDE)
+                starbook->setPollGuideStatus(false);
         }
 
         return true;
@@ -684,6 +733,7 @@ INDIStarbookTen::GuideNorth(uint32_t ms)
     try
     {
         isPropGuidingDE = true;
+        starbook->setPollGuideStatus(true);
         retry<bool>(1, &StarbookTen::movePulse, starbook, StarbookTen::GUIDE_NORTH, ms);
         return IPS_OK;
     }
@@ -701,6 +751,7 @@ INDIStarbookTen::GuideSouth(uint32_t ms)
     try
     {
         isPropGuidingDE = true;
+        starbook->setPollGuideStatus(true);
         retry<bool>(1, &StarbookTen::movePulse, starbook, StarbookTen::GUIDE_SOUTH, ms);
         return IPS_OK;
     }
@@ -718,6 +769,7 @@ INDIStarbookTen::GuideEast(uint32_t ms)
     try
     {
         isPropGuidingRA = true;
+        starbook->setPollGuideStatus(true);
         retry<bool>(1, &StarbookTen::movePulse, starbook, StarbookTen::GUIDE_EAST, ms);
         return IPS_OK;
     }
@@ -735,6 +787,7 @@ INDIStarbookTen::GuideWest(uint32_t ms)
     try
     {
         isPropGuidingRA = true;
+        starbook->setPollGuideStatus(true);
         retry<bool>(1, &StarbookTen::movePulse, starbook, StarbookTen::GUIDE_WEST, ms);
         return IPS_OK;
     }
@@ -19,6 +19,7 @@ protected:
     virtual bool initProperties() override;
     virtual bool updateProperties() override;
     virtual bool Handshake() override;
+    virtual bool Disconnect() override;
     virtual bool saveConfigItems(FILE *fp) override;
 
     /***************************************************/
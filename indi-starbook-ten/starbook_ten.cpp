@@ -24,6 +24,8 @@ StarbookTen::StarbookTen(const char *base_url) {
 
 
 StarbookTen::~StarbookTen() {
+    stopPolling();
+
     if (destroyClient)
         delete http;
 }
@@ -46,9 +48,45 @@ StarbookTen::setHttpClient(httplib::Client *http) {
 }
 
 
+httplib::Result
+StarbookTen::get(const std::string &path) {
+    std::lock_guard<std::mutex> lock(httpMutex);
+
+    if (!http) {
+        throw std::runtime_error("HTTP client not set");
+    }
+
+    return http->Get(path.c_str());
+}
+
+
+httplib::Result
+StarbookTen::getCommand(const std::string &path) {
+    std::lock_guard<std::mutex> lock(httpMutex);
+
+    if (!http) {
+        throw std::runtime_error("HTTP client not set");
+    }
+
+    auto res = http->Get(path.c_str());
+
+    // Bump only once the mount has answered, still holding the connection, so a poll
+    // that reads the new sequence number cannot have been sent before the command
+    commandSeq++;
+
+    return res;
+}
+
+
 bool
 StarbookTen::sendBasicCmd(const char *cmd) {
-    auto res = http->Get(cmd);
+    auto res = getCommand(cmd);
+
+    {
+        std::lock_guard<std::mutex> lock(pollMutex);
+        pollNow = true;
+    }
+    pollCV.notify_one();
 
     if (!res || res->status != 200) {
         throw std::runtime_error("sendBasicCmd HTTP error");
@@ -64,7 +102,7 @@ StarbookTen::sendBasicCmd(const char *cmd) {
 
 std::tuple<int,int>
 StarbookTen::getFirmwareVersion() {
-    auto res = http->Get("/version");
+    auto res = get("/version");
 
     if (!res || res->status != 200) {
         throw std::runtime_error("HTTP get failed");
@@ -86,16 +124,22 @@ StarbookTen::getFirmwareVersion() {
 
 StarbookTen::PierSide
 StarbookTen::getPierSide() {
-    auto res = http->Get("/get_pierside");
+    auto res = get("/get_pierside");
 
     if (!res || res->status != 200) {
         throw std::runtime_error("HTTP get failed");
     }
 
-    std::regex r(R"(PIERSIDE=([01]))");
+    return parsePierSide(res->body);
+}
+
+
+StarbookTen::PierSide
+StarbookTen::parsePierSide(const std::string &body) {
+    static const std::regex r(R"(PIERSIDE=([01]))");
     std::smatch sm;
 
-    if (std::regex_search(res->body, sm, r)) {
+    if (std::regex_search(body, sm, r)) {
         return static_cast<StarbookTen::PierSide>(std::stoi(sm[1]));
     } else {
         throw std::runtime_error("Could not get pier side");
@@ -107,7 +151,7 @@ StarbookTen::PierSide
 StarbookTen::getNewPierSide(double ra, double dec) {
     std::stringstream cmd_ss;
     cmd_ss << "/calc_sideofpier?ra=" << ra << "&dec=" << dec;
-    auto res = http->Get(cmd_ss.str().c_str());
+    auto res = get(cmd_ss.str());
 
     if (!res || res->status != 200) {
         throw std::runtime_error("HTTP get failed");
@@ -136,7 +180,7 @@ ln_zonedate
 StarbookTen::getDateTime() {
     ln_zonedate zdt;
 
-    auto res = http->Get("/gettime");
+    auto res = get("/gettime");
 
     if (!res || res->status != 200) {
         throw std::runtime_error("HTTP get failed");
@@ -156,7 +200,7 @@ StarbookTen::getDateTime() {
         throw std::runtime_error("Could not get time");
     }
 
-    res = http->Get("/getplace");
+    res = get("/getplace");
 
     if (!res || res->status != 200) {
         throw std::runtime_error("HTTP get failed");
@@ -219,7 +263,7 @@ StarbookTen::setLatLonTz(double lat, double lon, long utc_off_secs) {
 
 std::tuple<double,double>
 StarbookTen::getLatLon() {
-    auto res = http->Get("/getplace");
+    auto res = get("/getplace");
 
     if (!res || res->status != 200) {
         throw std::runtime_error("HTTP get failed");
@@ -250,7 +294,7 @@ StarbookTen::getLatLon() {
 
 StarbookTen::CoordType
 StarbookTen::getCoordType() {
-    auto res = http->Get("/getradectype");
+    auto res = get("/getradectype");
 
     if (!res || res->status != 200) {
         throw std::runtime_error("HTTP get failed");
@@ -275,16 +319,22 @@ StarbookTen::setCoordType(CoordType ct) {
 
 StarbookTen::MountStatus
 StarbookTen::getStatus() {
-    auto res = http->Get("/getstatus2");
+    auto res = get("/getstatus2");
 
     if (!res || res->status != 200) {
         throw std::runtime_error("HTTP get failed");
     }
 
-    std::regex r(R"(<!--RA=(\-?\d+\.\d+)&DEC=(\-?\d+\.\d+)&GOTO=([01])&STATE=([A-Z]+)-->)");
+    return parseStatus(res->body);
+}
+
+
+StarbookTen::MountStatus
+StarbookTen::parseStatus(const std::string &body) {
+    static const std::regex r(R"(<!--RA=(\-?\d+\.\d+)&DEC=(\-?\d+\.\d+)&GOTO=([01])&STATE=([A-Z]+)-->)");
     std::smatch sm;
 
-    if (std::regex_search(res->body, sm, r)) {
+    if (std::regex_search(body, sm, r)) {
         MountStatus stat;
 
         stat.ra = std::stod(sm[1]);
@@ -303,18 +353,24 @@ StarbookTen::getStatus() {
 
 bool
 StarbookTen::isTracking() {
-    auto res = http->Get("/gettrackstatus");
+    auto res = get("/gettrackstatus");
 
     if (!res || res->status != 200) {
         throw std::runtime_error("HTTP get failed");
     }
 
+    return parseTracking(res->body);
+}
+
+
+bool
+StarbookTen::parseTracking(const std::string &body) {
     // TRACK=2 seems to be used during gotos, but since we can already figure
     // gotos out from the getstatus2 call, there's no need to handle it here.
-    std::regex r(R"(<!--TRACK=([012])-->)");
+    static const std::regex r(R"(<!--TRACK=([012])-->)");
     std::smatch sm;
 
-    if (std::regex_search(res->body, sm, r)) {
+    if (std::regex_search(body, sm, r)) {
         return !(sm[1].compare("1"));
     } else {
         throw std::runtime_error("Could not get track status");
@@ -324,16 +380,22 @@ StarbookTen::isTracking() {
 
 std::tuple<bool,bool>
 StarbookTen::getGuidingRaDec() {
-    auto res = http->Get("/getguidestatus");
+    auto res = get("/getguidestatus");
 
     if (!res || res->status != 200) {
         throw std::runtime_error("HTTP get failed");
     }
 
-    std::regex r(R"(<!--RA\+=([01])&RA\-=([01])&DEC\+=([01])&DEC\-=([01])-->)");
+    return parseGuiding(res->body);
+}
+
+
+std::tuple<bool,bool>
+StarbookTen::parseGuiding(const std::string &body) {
+    static const std::regex r(R"(<!--RA\+=([01])&RA\-=([01])&DEC\+=([01])&DEC\-=([01])-->)");
     std::smatch sm;
 
-    if (std::regex_search(res->body, sm, r)) {
+    if (std::regex_search(body, sm, r)) {
         return std::tuple<bool,bool>((!(sm[1].compare("1")) || !(sm[2].compare("1"))),
                                      (!(sm[3].compare("1")) || !(sm[4].compare("1"))));
     } else {
@@ -448,6 +510,119 @@ StarbookTen::move(StarbookTen::Axis axis, double rate) {
 }
 
 
+void
+StarbookTen::startPolling(std::chrono::milliseconds period) {
+    stopPolling();
+
+    {
+        std::lock_guard<std::mutex> lock(pollMutex);
+        pollPeriod = period;
+        pollQuit = false;
+        pollNow = true;
+        snapshot = StatusSnapshot();
+    }
+
+    pollThread = std::thread(&StarbookTen::pollLoop, this);
+}
+
+
+void
+StarbookTen::stopPolling() {
+    {
+        std::lock_guard<std::mutex> lock(pollMutex);
+        pollQuit = true;
+    }
+    pollCV.notify_one();
+
+    if (pollThread.joinable())
+        pollThread.join();
+}
+
+
+void
+StarbookTen::setPollPeriod(std::chrono::milliseconds period) {
+    std::lock_guard<std::mutex> lock(pollMutex);
+    pollPeriod = period;
+}
+
+
+void
+StarbookTen::setPollGuideStatus(bool enabled) {
+    pollGuide = enabled;
+}
+
+
+bool
+StarbookTen::getSnapshot(StatusSnapshot &snap) {
+    std::lock_guard<std::mutex> lock(pollMutex);
+    snap = snapshot;
+    return snapshotSeq == commandSeq;
+}
+
+
+void
+StarbookTen::pollLoop() {
+    std::unique_lock<std::mutex> lock(pollMutex);
+
+    while (!pollQuit) {
+        pollNow = false;
+        lock.unlock();
+        pollOnce();
+        lock.lock();
+
+        // A command wakes the poller early so its effect shows up without waiting a full period
+        pollCV.wait_for(lock, pollPeriod, [this] { return pollQuit || pollNow; });
+    }
+}
+
+
+void
+StarbookTen::pollOnce() {
+    uint64_t seq = commandSeq;
+    StatusSnapshot snap;
+    std::string error;
+
+    try {
+        auto res = get("/getstatus2");
+        if (!res || res->status != 200)
+            throw std::runtime_error("HTTP get getstatus2 failed");
+        snap.status = parseStatus(res->body);
+
+        res = get("/gettrackstatus");
+        if (!res || res->status != 200)
+            throw std::runtime_error("HTTP get gettrackstatus failed");
+        snap.tracking = parseTracking(res->body);
+
+        res = get("/get_pierside");
+        if (!res || res->status != 200)
+            throw std::runtime_error("HTTP get get_pierside failed");
+        snap.pierside = parsePierSide(res->body);
+
+        snap.guidingRa = snap.guidingDec = false;
+        if (pollGuide) {
+            res = get("/getguidestatus");
+            if (!res || res->status != 200)
+                throw std::runtime_error("HTTP get getguidestatus failed");
+            std::tie(snap.guidingRa, snap.guidingDec) = parseGuiding(res->body);
+        }
+    } catch (std::exception &ex) {
+        error = ex.what();
+    }
+
+    std::lock_guard<std::mutex> lock(pollMutex);
+
+    // On failure keep the previous values so readers can judge their age
+    if (error.empty()) {
+        snap.valid = true;
+        snap.updated = std::chrono::steady_clock::now();
+        snapshot = snap;
+        snapshotSeq = seq;
+    } else {
+        snapshot.error = error;
+    }
+}
+
+
 std::string
 StarbookTen::sxfmt(double x) {
     char buf[32];
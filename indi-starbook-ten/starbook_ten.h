@@ -2,6 +2,11 @@
 #define _STARBOOK_TEN_H_
 
 #include <string>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <libnova/julian_day.h>
 #include <libnova/utility.h>
 #include "httplib.h"
@@ -11,7 +16,10 @@
 class StarbookTen {
 private:
     httplib::Client *http;
+    std::mutex httpMutex;
 
+    httplib::Result get(const std::string &path);
+    httplib::Result getCommand(const std::string &path);
     bool sendBasicCmd(const char *cmd);
     std::string sxfmt(double x);
 
@@ -52,6 +60,18 @@ public:
         State  state;
     };
 
+    /* Status fetched by the background poller, see startPolling() */
+    struct StatusSnapshot {
+        MountStatus status;
+        bool        tracking;
+        PierSide    pierside;
+        bool        guidingRa;
+        bool        guidingDec;
+        bool        valid;      // at least one poll has completed
+        std::chrono::steady_clock::time_point updated;
+        std::string error;      // last poll error, empty when the last poll succeeded
+    };
+
     static const double slewRates[];
 
     StarbookTen(httplib::Client *http);
@@ -100,6 +120,37 @@ public:
     bool goTo(double ra, double dec);
 
     bool move(Axis axis, double rate);
+
+    /* Poll all status endpoints back to back on the shared connection every period */
+    void startPolling(std::chrono::milliseconds period);
+    void stopPolling();
+    void setPollPeriod(std::chrono::milliseconds period);
+    void setPollGuideStatus(bool enabled);
+
+    /* Copy the latest snapshot. Returns false if it was fetched before the last command was sent */
+    bool getSnapshot(StatusSnapshot &snap);
+
+private:
+    static MountStatus parseStatus(const std::string &body);
+    static bool parseTracking(const std::string &body);
+    static PierSide parsePierSide(const std::string &body);
+    static std::tuple<bool,bool> parseGuiding(const std::string &body);
+
+    void pollLoop();
+    void pollOnce();
+
+    std::thread pollThread;
+    std::mutex pollMutex;
+    std::condition_variable pollCV;
+    bool pollQuit = false;
+    bool pollNow = false;
+    std::chrono::milliseconds pollPeriod { 1000 };
+    std::atomic<bool> pollGuide { false };
+
+    // Bumped by every command so snapshots that started before it can be told apart
+    std::atomic<uint64_t> commandSeq { 0 };
+    uint64_t snapshotSeq = 0;
+    StatusSnapshot snapshot {};
 };
 
 #endif /* _STARBOOK_TEN_H_ */
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "starbook_ten.h"
+
+/*
+ * Mock mount: every /goto moves RA to the number of gotos handled so far, so a
+ * status snapshot tells exactly which commands the mount had processed.
+ */
+class MockStarbook {
+public:
+    MockStarbook() {
+        server.Get("/gotoradec", [this](const httplib::Request &, httplib::Response &res) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            gotos++;
+            res.set_content("<!--OK-->", "text/html");
+        });
+        server.Get("/getstatus2", [this](const httplib::Request &, httplib::Response &res) {
+            statusCalls++;
+            char body[128];
+            snprintf(body, sizeof(body), "<!--RA=%d.0&DEC=0.0&GOTO=0&STATE=SCOPE-->", gotos.load());
+            res.set_content(body, "text/html");
+        });
+        server.Get("/gettrackstatus", [](const httplib::Request &, httplib::Response &res) {
+            res.set_content("<!--TRACK=1-->", "text/html");
+        });
+        server.Get("/get_pierside", [](const httplib::Request &, httplib::Response &res) {
+            res.set_content("<!--PIERSIDE=1-->", "text/html");
+        });
+
+        server.set_tcp_nodelay(true);
+        port = server.bind_to_any_port("127.0.0.1");
+        thread = std::thread([this] { server.listen_after_bind(); });
+        while (!server.is_running())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ~MockStarbook() {
+        server.stop();
+        thread.join();
+    }
+
+    std::string url() const {
+        return "http://127.0.0.1:" + std::to_string(port);
+    }
+
+    httplib::Server server;
+    std::thread thread;
+    int port;
+    std::atomic<int> gotos { 0 };
+    std::atomic<int> statusCalls { 0 };
+};
+
+
+static bool waitFresh(StarbookTen &sb, StarbookTen::StatusSnapshot &snap) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (sb.getSnapshot(snap))
+            return true;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return false;
+}
+
+
+TEST(StarbookTen, parse_status) {
+    MockStarbook mock;
+    StarbookTen sb(mock.url().c_str());
+
+    auto stat = sb.getStatus();
+    ASSERT_DOUBLE_EQ(stat.ra, 0.0);
+    ASSERT_EQ(stat.state, StarbookTen::STATE_SCOPE);
+    ASSERT_FALSE(stat.goto_busy);
+    ASSERT_TRUE(sb.isTracking());
+    ASSERT_EQ(sb.getPierSide(), StarbookTen::PIERSIDE_EAST);
+}
+
+
+TEST(StarbookTen, snapshot_follows_command) {
+    MockStarbook mock;
+    StarbookTen sb(mock.url().c_str());
+
+    sb.startPolling(std::chrono::milliseconds(1));
+
+    for (int i = 1; i <= 200; i++) {
+        ASSERT_TRUE(sb.goTo(1.0, 2.0));
+
+        // A snapshot reported fresh must have been taken after the mount handled the goto
+        StarbookTen::StatusSnapshot snap;
+        ASSERT_TRUE(waitFresh(sb, snap)) << "iteration " << i;
+        ASSERT_TRUE(snap.valid);
+        ASSERT_TRUE(snap.error.empty());
+        ASSERT_DOUBLE_EQ(snap.status.ra, i) << "stale snapshot reported fresh at iteration " << i;
+    }
+
+    sb.stopPolling();
+}
+
+
+TEST(StarbookTen, poll_timing) {
+    MockStarbook mock;
+    StarbookTen sb(mock.url().c_str());
+
+    // Wake-up latency from a command to a fresh snapshot, with a period far longer than that
+    sb.startPolling(std::chrono::milliseconds(1000));
+
+    StarbookTen::StatusSnapshot snap;
+    ASSERT_TRUE(waitFresh(sb, snap));
+
+    const int rounds = 50;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        sb.goTo(1.0, 2.0);
+        ASSERT_TRUE(waitFresh(sb, snap));
+    }
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    sb.stopPolling();
+
+    std::cerr << "command to fresh snapshot: " << us / rounds << " us, "
+              << mock.statusCalls << " status requests" << std::endl;
+    ASSERT_LT(us / rounds, 500000);
+}
+
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -35,6 +35,7 @@
 
 #include <cmath>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <unistd.h>
 
@@ -46,6 +47,8 @@
 #define SX_CLEAR_WE    0x06
 
 #define TIMER 1000
+// Retry period for exposure steps deferred while a readout holds the USB link
+#define USB_RETRY 10
 
 static class Loader
 {
@@ -83,12 +86,16 @@ void NSGuiderTimerCallback(void *p)
     ((SXCCD *)p)->NSGuiderTimerHit();
 }
 
+void GuidePulseTimerCallback(void *p)
+{
+    ((SXCCD *)p)->GuidePulseTimerHit();
+}
+
 SXCCD::SXCCD(DEVICE device, const char *name)
 {
     this->device          = device;
     handle                = nullptr;
     model                 = 0;
-    oddBuf                = nullptr;
     evenBuf               = nullptr;
     GuideStatus           = 0;
     TemperatureRequest    = 0;
@@ -101,13 +108,24 @@ SXCCD::SXCCD(DEVICE device, const char *name)
     HasGuideHead          = false;
     HasColor              = false;
     ExposureTimerID       = 0;
+    DidClear              = false;
     DidFlush              = false;
     DidLatch              = false;
+    DidGuideClear         = false;
     GuideExposureTimerID  = 0;
+    InExposure            = false;
     InGuideExposure       = false;
+    ExposureGeneration    = 0;
+    GuideExposureGeneration = 0;
     DidGuideLatch         = false;
+    ReadoutAborted        = false;
+    GuideReadoutAborted   = false;
     NSGuiderTimerID       = 0;
     WEGuiderTimerID       = 0;
+    GuidePulseTimerID     = 0;
+    GuidePulseRequest[AXIS_RA] = GuidePulseRequest[AXIS_DE] = 0;
+    GuidePulseDirection[AXIS_RA] = GuidePulseDirection[AXIS_DE] = 0;
+    ShutterRequest        = -1;
     snprintf(this->name, 32, "SX CCD %s", name);
     setDeviceName(this->name);
     setVersion(VERSION_MAJOR, VERSION_MINOR);
@@ -115,6 +133,8 @@ SXCCD::SXCCD(DEVICE device, const char *name)
 
 SXCCD::~SXCCD()
 {
+    readoutWorker.quit();
+    guideReadoutWorker.quit();
     if (handle)
         sxClose(&handle);
 }
@@ -295,6 +315,14 @@ bool SXCCD::Connect()
 
 bool SXCCD::Disconnect()
 {
+    readoutWorker.quit();
+    guideReadoutWorker.quit();
+    if (GuidePulseTimerID)
+    {
+        IERmTimer(GuidePulseTimerID);
+        GuidePulseTimerID = 0;
+    }
+    GuidePulseRequest[AXIS_RA] = GuidePulseRequest[AXIS_DE] = 0;
     if (handle != nullptr)
     {
         sxClose(&handle);
@@ -327,16 +355,7 @@ void SXCCD::SetupParms()
         nbuf *= 2;
     //nbuf += 512;
     PrimaryCCD.setFrameBufferSize(nbuf);
-    if (isInterlaced)
-    {
-        if (evenBuf != nullptr)
-            delete evenBuf;
-        if (oddBuf != nullptr)
-            delete oddBuf;
-        evenBuf      = new char[nbuf / 2];
-        oddBuf       = new char[nbuf / 2];
-    }
-    else if (isICX453)
+    if (isICX453)
     {
         if (evenBuf != nullptr)
             delete evenBuf;
@@ -357,9 +376,17 @@ void SXCCD::SetupParms()
 
 void SXCCD::TimerHit()
 {
-    if (isConnected() && HasCooler)
+    if (isConnected())
     {
-        if (!DidLatch && !DidGuideLatch)
+        // Skip the USB work rather than wait for a readout in progress, the next tick retries it.
+        // Shutter and cooler changes made during a readout are sent from here.
+        std::unique_lock<std::mutex> guard(usbLock, std::try_to_lock);
+        if (guard.owns_lock() && !DidLatch && !DidGuideLatch && ShutterRequest >= 0)
+        {
+            sxSetShutter(handle, ShutterRequest);
+            ShutterRequest = -1;
+        }
+        if (guard.owns_lock() && !DidLatch && !DidGuideLatch && HasCooler)
         {
             unsigned char status;
             unsigned short temperature;
@@ -391,6 +418,16 @@ int SXCCD::SetTemperature(double temperature)
     TemperatureRequest = temperature;
     unsigned char status;
     unsigned short sx_temperature;
+    std::unique_lock<std::mutex> guard(usbLock, std::try_to_lock);
+    if (!guard.owns_lock())
+    {
+        // A readout holds the USB link, TimerHit sends the new set point once it's done
+        CoolerSP.s   = IPS_OK;
+        CoolerS[0].s = ISS_ON;
+        CoolerS[1].s = ISS_OFF;
+        IDSetSwitch(&CoolerSP, nullptr);
+        return 0;
+    }
     sxSetCooler(handle, (unsigned char)(CoolerS[0].s == ISS_ON), (unsigned short)(TemperatureRequest * 10 + 2730),
                 &status, &sx_temperature);
     TemperatureReported =(sx_temperature - 2730) / 10.0;
@@ -411,31 +448,19 @@ int SXCCD::SetTemperature(double temperature)
 
 bool SXCCD::StartExposure(float n)
 {
-    InExposure = true;
-    PrimaryCCD.setExposureDuration(n);
-    if (sxIsInterlaced(model) && PrimaryCCD.getBinY() == 1)
     {
-        sxClearPixels(handle, CCD_EXP_FLAGS_FIELD_EVEN | CCD_EXP_FLAGS_NOWIPE_FRAME, 0);
-        usleep(wipeDelay);
-        sxClearPixels(handle, CCD_EXP_FLAGS_FIELD_ODD | CCD_EXP_FLAGS_NOWIPE_FRAME, 0);
+        std::lock_guard<std::mutex> stateGuard(exposureStateLock);
+        ExposureGeneration++;
+        InExposure = true;
     }
-    else
-        sxClearPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 0);
-    if (HasShutter && PrimaryCCD.getFrameType() != INDI::CCDChip::DARK_FRAME)
-        sxSetShutter(handle, 0);
-    int time = (int)(1000 * n);
-    if (time < 1)
-        time = 1;
-    if (time > 3000)
-    {
-        DidFlush = false;
-        time -= 3000;
-    }
-    else
-        DidFlush = true;
+    PrimaryCCD.setExposureDuration(n);
+    DidClear         = false;
+    DidFlush         = false;
     DidLatch         = false;
     ExposureTimeLeft = n;
-    ExposureTimerID  = IEAddTimer(time, ExposureTimerCallback, this);
+    ExposureTimerID  = 0;
+    // Clears the sensor now, or shortly after a readout in progress releases the USB link
+    ExposureTimerHit();
     return true;
 }
 
@@ -445,10 +470,34 @@ bool SXCCD::AbortExposure()
     {
         if (ExposureTimerID)
             IERmTimer(ExposureTimerID);
-        if (HasShutter)
-            sxSetShutter(handle, 1);
         ExposureTimerID = 0;
+        {
+            // A readout in progress can't be interrupted, its frame is just dropped
+            std::lock_guard<std::mutex> stateGuard(exposureStateLock);
+            if (!InExposure)
+                return false;
+            ExposureGeneration++;
+            if (DidLatch)
+            {
+                ReadoutAborted = true;
+                InExposure     = false;
+            }
+        }
+        if (DidLatch)
+        {
+            PrimaryCCD.setExposureLeft(ExposureTimeLeft = 0);
+            return true;
+        }
+        if (HasShutter && DidClear)
+        {
+            std::unique_lock<std::mutex> guard(usbLock, std::try_to_lock);
+            if (guard.owns_lock())
+                sxSetShutter(handle, 1);
+            else
+                ShutterRequest = 1;
+        }
         PrimaryCCD.setExposureLeft(ExposureTimeLeft = 0);
+        DidClear = false;
         DidLatch = false;
         DidFlush = false;
         return true;
@@ -460,140 +509,209 @@ void SXCCD::ExposureTimerHit()
 {
     if (InExposure)
     {
-        if (!DidFlush)
+        if (!DidClear)
+        {
+            std::unique_lock<std::mutex> guard(usbLock, std::try_to_lock);
+            if (!guard.owns_lock())
+            {
+                ExposureTimerID = IEAddTimer(USB_RETRY, ExposureTimerCallback, this);
+                return;
+            }
+            float n = PrimaryCCD.getExposureDuration();
+            if (sxIsInterlaced(model) && PrimaryCCD.getBinY() == 1)
+            {
+                sxClearPixels(handle, CCD_EXP_FLAGS_FIELD_EVEN | CCD_EXP_FLAGS_NOWIPE_FRAME, 0);
+                usleep(wipeDelay);
+                sxClearPixels(handle, CCD_EXP_FLAGS_FIELD_ODD | CCD_EXP_FLAGS_NOWIPE_FRAME, 0);
+            }
+            else
+                sxClearPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 0);
+            // The exposure sets the shutter itself, drop any change still queued for TimerHit
+            ShutterRequest = -1;
+            if (HasShutter && PrimaryCCD.getFrameType() != INDI::CCDChip::DARK_FRAME)
+                sxSetShutter(handle, 0);
+            int time = (int)(1000 * n);
+            if (time < 1)
+                time = 1;
+            if (time > 3000)
+            {
+                DidFlush = false;
+                time -= 3000;
+            }
+            else
+                DidFlush = true;
+            DidClear        = true;
+            ExposureTimerID = IEAddTimer(time, ExposureTimerCallback, this);
+        }
+        else if (!DidFlush)
         {
+            std::unique_lock<std::mutex> guard(usbLock, std::try_to_lock);
+            if (!guard.owns_lock())
+            {
+                ExposureTimerID = IEAddTimer(USB_RETRY, ExposureTimerCallback, this);
+                return;
+            }
             ExposureTimerID = IEAddTimer(3000, ExposureTimerCallback, this);
             sxClearPixels(handle, CCD_EXP_FLAGS_NOWIPE_FRAME, 0);
             DidFlush = true;
         }
         else
         {
-            int rc;
-            ExposureTimerID   = 0;
-            bool isInterlaced = sxIsInterlaced(model);
-            int subX          = PrimaryCCD.getSubX();
-            int subY          = PrimaryCCD.getSubY();
-            int subW          = PrimaryCCD.getSubW();
-            int subH          = PrimaryCCD.getSubH();
-            int binX          = PrimaryCCD.getBinX();
-            int binY          = PrimaryCCD.getBinY();
-            int subWW         = subW * 2;
-            bool isICX453     = sxIsICX453(model);
-            uint8_t *buf      = PrimaryCCD.getFrameBuffer();
-            int size;
-            if (isInterlaced && binY > 1)
-                size = subW * subH / 2 / binX / (binY / 2);
-            else
-                size = subW * subH / binX / binY;
-            if (HasShutter)
-                sxSetShutter(handle, 1);
-            DidLatch = true;
-            if (isInterlaced)
+            ExposureTimerID = 0;
+            DidLatch        = true;
+            readoutWorker.start(std::bind(&SXCCD::workerReadout, this, std::placeholders::_1, ExposureGeneration));
+        }
+    }
+}
+
+std::unique_lock<std::mutex> SXCCD::lockForReadout()
+{
+    // A pulse in progress is ended by the main thread, it must never wait for a download
+    std::unique_lock<std::mutex> guard(usbLock);
+    while (GuideStatus)
+    {
+        guard.unlock();
+        usleep(1000);
+        guard.lock();
+    }
+    return guard;
+}
+
+void SXCCD::workerReadout(const std::atomic_bool &isAboutToQuit, uint32_t generation)
+{
+    int rc;
+    bool isInterlaced = sxIsInterlaced(model);
+    int subX          = PrimaryCCD.getSubX();
+    int subY          = PrimaryCCD.getSubY();
+    int subW          = PrimaryCCD.getSubW();
+    int subH          = PrimaryCCD.getSubH();
+    int binX          = PrimaryCCD.getBinX();
+    int binY          = PrimaryCCD.getBinY();
+    bool isICX453     = sxIsICX453(model);
+    uint8_t *buf      = PrimaryCCD.getFrameBuffer();
+    int size;
+    if (isInterlaced && binY > 1)
+        size = subW * subH / 2 / binX / (binY / 2);
+    else
+        size = subW * subH / binX / binY;
+
+    std::unique_lock<std::mutex> guard = lockForReadout();
+    if (HasShutter)
+        sxSetShutter(handle, 1);
+    if (isInterlaced)
+    {
+        if (binY > 1)
+        {
+            rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 0, subX, subY / binY, subW, subH / 2, binX,
+                               binY / 2);
+            if (rc)
+                rc = sxReadPixels(handle, buf, size * 2);
+        }
+        else
+        {
+            // Each field is interleaved straight into the frame, odd field rows go first
+            int rowBytes = subW / binX * 2;
+            rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_EVEN | CCD_EXP_FLAGS_SPARE2, 0, subX, subY / 2, subW,
+                               subH / 2, binX, 1);
+            struct timeval tv;
+            gettimeofday(&tv, nullptr);
+            long startTime = tv.tv_sec * 1000000 + tv.tv_usec;
+            if (rc)
+                rc = sxReadPixels(handle, buf + rowBytes, size, rowBytes, rowBytes * 2);
+            gettimeofday(&tv, nullptr);
+            wipeDelay = tv.tv_sec * 1000000 + tv.tv_usec - startTime;
+            if (rc)
+                rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_ODD | CCD_EXP_FLAGS_SPARE2, 0, subX, subY / 2,
+                                   subW, subH / 2, binX, 1);
+            if (rc)
+                rc = sxReadPixels(handle, buf, size, rowBytes, rowBytes * 2);
+        }
+    }
+    else if (isICX453)
+    {
+        rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 0, subX * 2, subY / 2, subW * 2, subH / 2, binX, binY);
+        if (rc)
+        {
+            if (binX == 1 && binY == 1)
             {
-                if (binY > 1)
-                {
-                    rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 0, subX, subY / binY, subW, subH / 2, binX,
-                                       binY / 2);
-                    if (rc)
-                        rc = sxReadPixels(handle, buf, size * 2);
-                }
-                else
+                rc = sxReadPixels(handle, evenBuf, size * 2);
+                if (rc)
                 {
-                    rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_EVEN | CCD_EXP_FLAGS_SPARE2, 0, subX, subY / 2, subW,
-                                       subH / 2, binX, 1);
-                    struct timeval tv;
-                    gettimeofday(&tv, nullptr);
-                    long startTime = tv.tv_sec * 1000000 + tv.tv_usec;
-                    if (rc)
-                        rc = sxReadPixels(handle, evenBuf, size);
-                    gettimeofday(&tv, nullptr);
-                    wipeDelay = tv.tv_sec * 1000000 + tv.tv_usec - startTime;
-                    if (rc)
-                        rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_ODD | CCD_EXP_FLAGS_SPARE2, 0, subX, subY / 2,
-                                           subW, subH / 2, binX, 1);
-                    if (rc)
-                        rc = sxReadPixels(handle, oddBuf, size);
-                    if (rc)
+                    uint16_t *buf16 = reinterpret_cast<uint16_t *>(buf);
+                    uint16_t *evenBuf16 = reinterpret_cast<uint16_t *>(evenBuf);
+
+                    int offset_1 = 2, offset_2 = 3;
+                    if (strstr(getDeviceName(), "SXVF-M25C"))
                     {
-                        for (int i = 0, j = 0; i < subH; i += 2, j++)
-                        {
-                            memcpy(buf + i * subWW, oddBuf + (j * subWW), subWW);
-                            memcpy(buf + ((i + 1) * subWW), evenBuf + (j * subWW), subWW);
-                        }
-                        //            deinterlace((unsigned short *)buf, subW, subH);
+                        // Patch by Greg Bosch on 2020-01-02 to fix bayer pattern
+                        // on SXVF-M25C.
+                        offset_1 = 3;
+                        offset_2 = 2;
                     }
-                }
-            }
-            else if (isICX453)
-            {
-                rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 0, subX * 2, subY / 2, subW * 2, subH / 2, binX, binY);
-                if (rc)
-                {
-                    if (binX == 1 && binY == 1)
+
+                    for (int i = 0; i < subH; i += 2)
                     {
-                        rc = sxReadPixels(handle, evenBuf, size * 2);
-                        if (rc)
+                        for (int j = 0; j < subW; j += 2)
                         {
-                            uint16_t *buf16 = reinterpret_cast<uint16_t *>(buf);
-                            uint16_t *evenBuf16 = reinterpret_cast<uint16_t *>(evenBuf);
-
-                            int offset_1 = 2, offset_2 = 3;
-                            if (strstr(getDeviceName(), "SXVF-M25C"))
-                            {
-                                // Patch by Greg Bosch on 2020-01-02 to fix bayer pattern
-                                // on SXVF-M25C.
-                                offset_1 = 3;
-                                offset_2 = 2;
-                            }
-
-                            for (int i = 0; i < subH; i += 2)
-                            {
-                                for (int j = 0; j < subW; j += 2)
-                                {
-                                    int isubW = i * subW;
-                                    int i1subW = (i + 1) * subW;
-                                    int j2 = j * 2;
-
-                                    buf16[isubW + j]  = evenBuf16[isubW + j2];
-                                    buf16[isubW + j + 1]  = evenBuf16[isubW + j2 + offset_1];
-                                    buf16[i1subW + j]  = evenBuf16[isubW + j2 + 1];
-                                    buf16[i1subW + j + 1]  = evenBuf16[isubW + j2 + offset_2];
-
-                                }
-                            }
+                            int isubW = i * subW;
+                            int i1subW = (i + 1) * subW;
+                            int j2 = j * 2;
+
+                            buf16[isubW + j]  = evenBuf16[isubW + j2];
+                            buf16[isubW + j + 1]  = evenBuf16[isubW + j2 + offset_1];
+                            buf16[i1subW + j]  = evenBuf16[isubW + j2 + 1];
+                            buf16[i1subW + j + 1]  = evenBuf16[isubW + j2 + offset_2];
+
                         }
                     }
-                    else
-                    {
-                        rc = sxReadPixels(handle, buf, size * 2);
-                    }
                 }
             }
             else
             {
-                rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 0, subX, subY, subW, subH, binX, binY);
-                if (rc)
-                    rc = sxReadPixels(handle, buf, size * 2);
+                rc = sxReadPixels(handle, buf, size * 2);
             }
-            DidLatch   = false;
-            InExposure = false;
-            PrimaryCCD.setExposureLeft(ExposureTimeLeft = 0);
-            if (rc)
-                ExposureComplete(&PrimaryCCD);
         }
     }
+    else
+    {
+        rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 0, subX, subY, subW, subH, binX, binY);
+        if (rc)
+            rc = sxReadPixels(handle, buf, size * 2);
+    }
+    bool aborted;
+    {
+        // Checked under both locks, an abort or a new exposure can't slip in before the frame is published
+        std::lock_guard<std::mutex> stateGuard(exposureStateLock);
+        aborted        = isAboutToQuit || ReadoutAborted || generation != ExposureGeneration;
+        ReadoutAborted = false;
+        DidLatch       = false;
+        if (!aborted)
+            InExposure = false;
+    }
+    guard.unlock();
+
+    if (aborted)
+        return;
+    PrimaryCCD.setExposureLeft(ExposureTimeLeft = 0);
+    if (rc)
+        ExposureComplete(&PrimaryCCD);
+    else
+        LOG_ERROR("Failed to read image from the camera.");
 }
 
 bool SXCCD::StartGuideExposure(float n)
 {
-    InGuideExposure = true;
+    {
+        std::lock_guard<std::mutex> stateGuard(exposureStateLock);
+        GuideExposureGeneration++;
+        InGuideExposure = true;
+    }
     GuideCCD.setExposureDuration(n);
-    sxClearPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 1);
-    int time = (int)(1000 * n);
-    if (time < 1)
-        time = 1;
+    DidGuideClear        = false;
     ExposureTimeLeft     = n;
-    GuideExposureTimerID = IEAddTimer(time, GuideExposureTimerCallback, this);
+    GuideExposureTimerID = 0;
+    // Clears the guide sensor now, or shortly after a readout in progress releases the USB link
+    GuideExposureTimerHit();
     return true;
 }
 
@@ -603,9 +721,19 @@ bool SXCCD::AbortGuideExposure()
     {
         if (GuideExposureTimerID)
             IERmTimer(GuideExposureTimerID);
+        {
+            std::lock_guard<std::mutex> stateGuard(exposureStateLock);
+            if (!InGuideExposure)
+                return false;
+            GuideExposureGeneration++;
+            if (DidGuideLatch)
+            {
+                GuideReadoutAborted = true;
+                InGuideExposure     = false;
+            }
+        }
         GuideCCD.setExposureLeft(GuideExposureTimeLeft = 0);
         GuideExposureTimerID = 0;
-        DidGuideLatch        = false;
         return true;
     }
     return false;
@@ -615,140 +743,158 @@ void SXCCD::GuideExposureTimerHit()
 {
     if (InGuideExposure)
     {
-        int rc;
+        if (!DidGuideClear)
+        {
+            std::unique_lock<std::mutex> guard(usbLock, std::try_to_lock);
+            if (!guard.owns_lock())
+            {
+                GuideExposureTimerID = IEAddTimer(USB_RETRY, GuideExposureTimerCallback, this);
+                return;
+            }
+            sxClearPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 1);
+            int time = (int)(1000 * GuideCCD.getExposureDuration());
+            if (time < 1)
+                time = 1;
+            DidGuideClear        = true;
+            GuideExposureTimerID = IEAddTimer(time, GuideExposureTimerCallback, this);
+            return;
+        }
         GuideExposureTimerID = 0;
-        int subX             = GuideCCD.getSubX();
-        int subY             = GuideCCD.getSubY();
-        int subW             = GuideCCD.getSubW();
-        int subH             = GuideCCD.getSubH();
-        int binX             = GuideCCD.getBinX();
-        int binY             = GuideCCD.getBinY();
-        int size             = subW * subH / binX / binY;
-        uint8_t *buf         = GuideCCD.getFrameBuffer();
         DidGuideLatch        = true;
-        rc                   = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 1, subX, subY, subW, subH, binX, binY);
+        guideReadoutWorker.start(std::bind(&SXCCD::workerGuideReadout, this, std::placeholders::_1,
+                                           GuideExposureGeneration));
+    }
+}
+
+void SXCCD::workerGuideReadout(const std::atomic_bool &isAboutToQuit, uint32_t generation)
+{
+    int rc;
+    int subX     = GuideCCD.getSubX();
+    int subY     = GuideCCD.getSubY();
+    int subW     = GuideCCD.getSubW();
+    int subH     = GuideCCD.getSubH();
+    int binX     = GuideCCD.getBinX();
+    int binY     = GuideCCD.getBinY();
+    int size     = subW * subH / binX / binY;
+    uint8_t *buf = GuideCCD.getFrameBuffer();
+    bool aborted;
+    {
+        std::unique_lock<std::mutex> guard = lockForReadout();
+        rc = sxLatchPixels(handle, CCD_EXP_FLAGS_FIELD_BOTH, 1, subX, subY, subW, subH, binX, binY);
         if (rc)
             rc = sxReadPixels(handle, buf, size);
-        DidGuideLatch   = false;
-        InGuideExposure = false;
-        GuideCCD.setExposureLeft(GuideExposureTimeLeft = 0);
-        if (rc)
-            ExposureComplete(&GuideCCD);
-    }
+        std::lock_guard<std::mutex> stateGuard(exposureStateLock);
+        aborted             = isAboutToQuit || GuideReadoutAborted || generation != GuideExposureGeneration;
+        GuideReadoutAborted = false;
+        DidGuideLatch       = false;
+        if (!aborted)
+            InGuideExposure = false;
+    }
+    if (aborted)
+        return;
+    GuideCCD.setExposureLeft(GuideExposureTimeLeft = 0);
+    if (rc)
+        ExposureComplete(&GuideCCD);
 }
 
-IPState SXCCD::GuideWest(uint32_t ms)
+IPState SXCCD::GuidePulse(INDI_EQ_AXIS axis, char direction, uint32_t ms)
 {
     if (!HasST4Port || ms < 1)
     {
         return IPS_ALERT;
     }
-    if (WEGuiderTimerID)
+    int &timerID = axis == AXIS_RA ? WEGuiderTimerID : NSGuiderTimerID;
+    if (timerID)
     {
-        IERmTimer(WEGuiderTimerID);
-        WEGuiderTimerID = 0;
+        IERmTimer(timerID);
+        timerID = 0;
     }
-    GuideStatus &= SX_CLEAR_WE;
-    GuideStatus |= SX_GUIDE_WEST;
-    sxSetSTAR2000(handle, GuideStatus);
-    if (ms < 100)
-    {
-        usleep(ms * 1000);
-        GuideStatus &= SX_CLEAR_WE;
-        sxSetSTAR2000(handle, GuideStatus);
-    }
-    else
-        WEGuiderTimerID = IEAddTimer(ms, WEGuiderTimerCallback, this);
-    return IPS_OK;
+    GuidePulseDirection[axis] = direction;
+    GuidePulseRequest[axis]   = ms;
+    SendGuidePulses(false);
+    // A deferred pulse reports its completion once it has been sent
+    return GuidePulseRequest[axis] ? IPS_BUSY : IPS_OK;
 }
 
-IPState SXCCD::GuideEast(uint32_t ms)
+void SXCCD::SendGuidePulses(bool deferred)
 {
-    if (!HasST4Port || ms < 1)
+    std::unique_lock<std::mutex> guard(usbLock, std::try_to_lock);
+    if (!guard.owns_lock())
     {
-        return IPS_ALERT;
+        if (!GuidePulseTimerID)
+            GuidePulseTimerID = IEAddTimer(USB_RETRY, GuidePulseTimerCallback, this);
+        return;
     }
-    if (WEGuiderTimerID)
+    for (int axis = AXIS_RA; axis <= AXIS_DE; axis++)
     {
-        IERmTimer(WEGuiderTimerID);
-        WEGuiderTimerID = 0;
-    }
-    GuideStatus &= SX_CLEAR_WE;
-    GuideStatus |= SX_GUIDE_EAST;
-    sxSetSTAR2000(handle, GuideStatus);
-    if (ms < 100)
-    {
-        usleep(ms * 1000);
-        GuideStatus &= SX_CLEAR_WE;
+        uint32_t ms = GuidePulseRequest[axis];
+        if (ms == 0)
+            continue;
+        char clear = axis == AXIS_RA ? SX_CLEAR_WE : SX_CLEAR_NS;
+        GuidePulseRequest[axis] = 0;
+        GuideStatus &= clear;
+        GuideStatus |= GuidePulseDirection[axis];
         sxSetSTAR2000(handle, GuideStatus);
+        if (ms < 100)
+        {
+            usleep(ms * 1000);
+            GuideStatus &= clear;
+            sxSetSTAR2000(handle, GuideStatus);
+            if (deferred)
+                GuideComplete(static_cast<INDI_EQ_AXIS>(axis));
+        }
+        else if (axis == AXIS_RA)
+            WEGuiderTimerID = IEAddTimer(ms, WEGuiderTimerCallback, this);
+        else
+            NSGuiderTimerID = IEAddTimer(ms, NSGuiderTimerCallback, this);
     }
-    else
-        WEGuiderTimerID = IEAddTimer(ms, WEGuiderTimerCallback, this);
-    return IPS_OK;
+}
+
+void SXCCD::GuidePulseTimerHit()
+{
+    GuidePulseTimerID = 0;
+    SendGuidePulses(true);
+}
+
+IPState SXCCD::GuideWest(uint32_t ms)
+{
+    return GuidePulse(AXIS_RA, SX_GUIDE_WEST, ms);
+}
+
+IPState SXCCD::GuideEast(uint32_t ms)
+{
+    return GuidePulse(AXIS_RA, SX_GUIDE_EAST, ms);
 }
 
 void SXCCD::WEGuiderTimerHit()
 {
-    GuideStatus &= SX_CLEAR_WE;
-    sxSetSTAR2000(handle, GuideStatus);
+    {
+        // Readouts wait while a pulse is on, so the link is free in a moment
+        std::lock_guard<std::mutex> guard(usbLock);
+        GuideStatus &= SX_CLEAR_WE;
+        sxSetSTAR2000(handle, GuideStatus);
+    }
     WEGuiderTimerID = 0;
     GuideComplete(AXIS_RA);
 }
 
 IPState SXCCD::GuideNorth(uint32_t ms)
 {
-    if (!HasST4Port || ms < 1)
-    {
-        return IPS_ALERT;
-    }
-    if (NSGuiderTimerID)
-    {
-        IERmTimer(NSGuiderTimerID);
-        NSGuiderTimerID = 0;
-    }
-    GuideStatus &= SX_CLEAR_NS;
-    GuideStatus |= SX_GUIDE_NORTH;
-    sxSetSTAR2000(handle, GuideStatus);
-    if (ms < 100)
-    {
-        usleep(ms * 1000);
-        GuideStatus &= SX_CLEAR_NS;
-        sxSetSTAR2000(handle, GuideStatus);
-    }
-    else
-        NSGuiderTimerID = IEAddTimer(ms, NSGuiderTimerCallback, this);
-    return IPS_OK;
+    return GuidePulse(AXIS_DE, SX_GUIDE_NORTH, ms);
 }
 
 IPState SXCCD::GuideSouth(uint32_t ms)
 {
-    if (!HasST4Port || ms < 1)
-    {
-        return IPS_ALERT;
-    }
-    if (NSGuiderTimerID)
-    {
-        IERmTimer(NSGuiderTimerID);
-        NSGuiderTimerID = 0;
-    }
-    GuideStatus &= SX_CLEAR_NS;
-    GuideStatus |= SX_GUIDE_SOUTH;
-    sxSetSTAR2000(handle, GuideStatus);
-    if (ms < 100)
-    {
-        usleep(ms * 1000);
-        GuideStatus &= SX_CLEAR_NS;
-        sxSetSTAR2000(handle, GuideStatus);
-    }
-    else
-        NSGuiderTimerID = IEAddTimer(ms, NSGuiderTimerCallback, this);
-    return IPS_OK;
+    return GuidePulse(AXIS_DE, SX_GUIDE_SOUTH, ms);
 }
 
 void SXCCD::NSGuiderTimerHit()
 {
-    GuideStatus &= SX_CLEAR_NS;
-    sxSetSTAR2000(handle, GuideStatus);
+    {
+        std::lock_guard<std::mutex> guard(usbLock);
+        GuideStatus &= SX_CLEAR_NS;
+        sxSetSTAR2000(handle, GuideStatus);
+    }
     NSGuiderTimerID = 0;
     GuideComplete(AXIS_DE);
 }
@@ -761,7 +907,11 @@ bool SXCCD::ISNewSwitch(const char *dev, const char *name, ISState *states, char
         IUUpdateSwitch(&ShutterSP, states, names, n);
         ShutterSP.s = IPS_OK;
         IDSetSwitch(&ShutterSP, nullptr);
-        sxSetShutter(handle, ShutterS[0].s != ISS_ON);
+        std::unique_lock<std::mutex> guard(usbLock, std::try_to_lock);
+        if (guard.owns_lock())
+            sxSetShutter(handle, ShutterS[0].s != ISS_ON);
+        else
+            ShutterRequest = ShutterS[0].s != ISS_ON;
         result = true;
     }
     else if (strcmp(name, CoolerSP.name) == 0)
@@ -771,10 +921,16 @@ bool SXCCD::ISNewSwitch(const char *dev, const char *name, ISState *states, char
         IDSetSwitch(&CoolerSP, nullptr);
         unsigned char status;
         unsigned short temperature;
-        sxSetCooler(handle, (unsigned char)(CoolerS[0].s == ISS_ON), (unsigned short)(TemperatureRequest * 10 + 2730),
-                    &status, &temperature);
-        TemperatureReported = (temperature - 2730) / 10.0;
-        TemperatureNP[0].setValue((temperature - 2730) / 10.0);
+        std::unique_lock<std::mutex> guard(usbLock, std::try_to_lock);
+        // During a readout TimerHit sends the new cooler state once it's done
+        if (guard.owns_lock())
+        {
+            sxSetCooler(handle, (unsigned char)(CoolerS[0].s == ISS_ON), (unsigned short)(TemperatureRequest * 10 + 2730),
+                        &status, &temperature);
+            guard.unlock();
+            TemperatureReported = (temperature - 2730) / 10.0;
+            TemperatureNP[0].setValue((temperature - 2730) / 10.0);
+        }
 
         TemperatureNP.setState(IPS_OK);
         TemperatureNP.apply();
@@ -34,11 +34,16 @@
 #include "sxccdusb.h"
 
 #include <indiccd.h>
+#include <indisinglethreadpool.h>
+
+#include <atomic>
+#include <mutex>
 
 void ExposureTimerCallback(void *p);
 void GuideExposureTimerCallback(void *p);
 void WEGuiderTimerCallback(void *p);
 void NSGuiderTimerCallback(void *p);
+void GuidePulseTimerCallback(void *p);
 
 class SXCCD : public INDI::CCD
 {
@@ -47,7 +52,7 @@ class SXCCD : public INDI::CCD
         HANDLE handle;
         unsigned short model;
         char name[32];
-        char *evenBuf, *oddBuf;
+        char *evenBuf;
         long wipeDelay;
         ISwitch CoolerS[2];
         ISwitchVectorProperty CoolerSP;
@@ -63,11 +68,40 @@ class SXCCD : public INDI::CCD
         int GuideExposureTimerID;
         int WEGuiderTimerID;
         int NSGuiderTimerID;
+        bool DidClear;
         bool DidFlush;
-        bool DidLatch;
-        bool DidGuideLatch;
-        bool InGuideExposure;
-        char GuideStatus;
+        std::atomic_bool DidLatch;
+        std::atomic_bool DidGuideLatch;
+        // Set by an abort while a readout is queued or running, cleared only by that readout
+        std::atomic_bool ReadoutAborted;
+        std::atomic_bool GuideReadoutAborted;
+        bool DidGuideClear;
+        // Read by TimerHit while the readout workers clear them
+        std::atomic_bool InExposure;
+        std::atomic_bool InGuideExposure;
+        // Bumped by every start and abort, a readout only publishes the exposure it was queued for
+        uint32_t ExposureGeneration;
+        uint32_t GuideExposureGeneration;
+        // Guards the generations and the in-exposure flags, only held for a few instructions
+        std::mutex exposureStateLock;
+        // Shutter state to send from TimerHit when a readout held the USB link, -1 when none
+        int ShutterRequest;
+        // STAR2000 port state, readouts don't take the USB link while a pulse is on
+        std::atomic<char> GuideStatus;
+        // Pulses waiting for a readout to release the USB link, 0 ms when none
+        uint32_t GuidePulseRequest[2];
+        char GuidePulseDirection[2];
+        int GuidePulseTimerID;
+        // Readout runs on worker threads, every latch/read sequence holds usbLock.
+        // The main thread only try-locks it and defers its USB work while a readout runs.
+        std::mutex usbLock;
+        INDI::SingleThreadPool readoutWorker;
+        INDI::SingleThreadPool guideReadoutWorker;
+        std::unique_lock<std::mutex> lockForReadout();
+        void workerReadout(const std::atomic_bool &isAboutToQuit, uint32_t generation);
+        void workerGuideReadout(const std::atomic_bool &isAboutToQuit, uint32_t generation);
+        IPState GuidePulse(INDI_EQ_AXIS axis, char direction, uint32_t ms);
+        void SendGuidePulses(bool deferred);
 
     protected:
         const char *getDefaultName();
@@ -88,6 +122,7 @@ class SXCCD : public INDI::CCD
         void GuideExposureTimerHit();
         void WEGuiderTimerHit();
         void NSGuiderTimerHit();
+        void GuidePulseTimerHit();
         IPState GuideWest(uint32_t ms);
         IPState GuideEast(uint32_t ms);
         IPState GuideNorth(uint32_t ms);
@@ -109,6 +144,7 @@ class SXCCD : public INDI::CCD
         friend void ::GuideExposureTimerCallback(void *p);
         friend void ::WEGuiderTimerCallback(void *p);
         friend void ::NSGuiderTimerCallback(void *p);
+        friend void ::GuidePulseTimerCallback(void *p);
         friend void ::ISGetProperties(const char *dev);
         friend void ::ISNewSwitch(const char *dev, const char *name, ISState *states, char *names[], int num);
         friend void ::ISNewText(const char *dev, const char *name, char *texts[], char *names[], int num);
@@ -734,25 +734,191 @@ int sxExposePixelsGated(HANDLE sxHandle, unsigned short flags, unsigned short ca
     return rc >= 0;
 }
 
-int sxReadPixels(HANDLE sxHandle, void *pixels, unsigned long count)
+/*
+ * Pixel data is read with several bulk transfers in flight, so the next chunk is already
+ * queued in the host controller while the previous one is being stored.
+ */
+#define ASYNC_TRANSFERS  4
+#define ASYNC_CHUNK_SIZE (CHUNK_SIZE / ASYNC_TRANSFERS)
+
+struct t_sx_read_state;
+
+struct t_sx_read_slot
 {
-    int transferred;
-    unsigned long read = 0;
-    int rc             = 0;
-    while (read < count && rc >= 0)
+    struct t_sx_read_state *state;
+    struct libusb_transfer *transfer;
+    unsigned char *staging;
+    unsigned long offset;
+    bool inFlight;
+};
+
+struct t_sx_read_state
+{
+    HANDLE handle;
+    unsigned char *pixels;
+    unsigned long count;
+    unsigned long rowBytes;
+    unsigned long pitch;
+    bool direct;
+    unsigned long submitted;
+    unsigned long received;
+    int pending;
+    int rc;
+    int completed;
+    struct t_sx_read_slot slots[ASYNC_TRANSFERS];
+};
+
+static void sxStoreRows(struct t_sx_read_state *state, unsigned long offset, const unsigned char *data,
+                        unsigned long length)
+{
+    while (length > 0)
+    {
+        unsigned long row    = offset / state->rowBytes;
+        unsigned long column = offset % state->rowBytes;
+        unsigned long size   = state->rowBytes - column;
+        if (size > length)
+            size = length;
+        memcpy(state->pixels + row * state->pitch + column, data, size);
+        offset += size;
+        data += size;
+        length -= size;
+    }
+}
+
+static void LIBUSB_CALL sxReadCallback(struct libusb_transfer *transfer);
+
+static int sxSubmitRead(struct t_sx_read_slot *slot)
+{
+    struct t_sx_read_state *state = slot->state;
+    unsigned long size = state->count - state->submitted;
+    if (size > ASYNC_CHUNK_SIZE)
+        size = ASYNC_CHUNK_SIZE;
+    slot->offset = state->submitted;
+    unsigned char *buffer = state->direct ? state->pixels + slot->offset : slot->staging;
+    libusb_fill_bulk_transfer(slot->transfer, state->handle, BULK_IN, buffer, size, sxReadCallback, slot,
+                              BULK_DATA_TIMEOUT);
+    int rc = libusb_submit_transfer(slot->transfer);
+    DEBUG(log(true, "sxReadPixels: libusb_submit_transfer -> %s\n", rc < 0 ? libusb_error_name(rc) : "OK"));
+    if (rc >= 0)
+    {
+        state->submitted += size;
+        state->pending++;
+        slot->inFlight = true;
+    }
+    return rc;
+}
+
+static void sxCancelReads(struct t_sx_read_state *state)
+{
+    for (int i = 0; i < ASYNC_TRANSFERS; i++)
     {
-        int size = count - read;
-        if (size > CHUNK_SIZE)
-            size = CHUNK_SIZE;
-        rc = libusb_bulk_transfer(sxHandle, BULK_IN, (unsigned char *)pixels + read, size, &transferred,
-                                  BULK_DATA_TIMEOUT);
-        DEBUG(log(true, "sxReadPixels: libusb_control_transfer -> %s\n", rc < 0 ? libusb_error_name(rc) : "OK"));
-        if (transferred >= 0)
+        if (state->slots[i].inFlight)
+            libusb_cancel_transfer(state->slots[i].transfer);
+    }
+}
+
+static void LIBUSB_CALL sxReadCallback(struct libusb_transfer *transfer)
+{
+    struct t_sx_read_slot *slot   = (struct t_sx_read_slot *)transfer->user_data;
+    struct t_sx_read_state *state = slot->state;
+    slot->inFlight = false;
+    state->pending--;
+    if (transfer->status == LIBUSB_TRANSFER_COMPLETED)
+    {
+        DEBUG(log(true, "sxReadPixels: transfer at %lu -> %d bytes\n", slot->offset, transfer->actual_length));
+        if (!state->direct)
+            sxStoreRows(state, slot->offset, transfer->buffer, transfer->actual_length);
+        state->received += transfer->actual_length;
+        // A short packet in the middle of the frame would shift every transfer queued behind it.
+        if (transfer->actual_length < transfer->length && slot->offset + transfer->length < state->count &&
+                state->rc >= 0)
         {
-            read += transferred;
+            log(false, "sxReadPixels: short transfer at %lu (%d of %d bytes)\n", slot->offset, transfer->actual_length,
+                transfer->length);
+            state->rc = LIBUSB_ERROR_IO;
+            sxCancelReads(state);
         }
     }
-    return rc >= 0;
+    else if (transfer->status != LIBUSB_TRANSFER_CANCELLED || state->rc >= 0)
+    {
+        DEBUG(log(true, "sxReadPixels: transfer at %lu -> status %d\n", slot->offset, transfer->status));
+        if (state->rc >= 0)
+        {
+            state->rc = transfer->status == LIBUSB_TRANSFER_TIMED_OUT ? LIBUSB_ERROR_TIMEOUT : LIBUSB_ERROR_IO;
+            sxCancelReads(state);
+        }
+    }
+    if (state->rc >= 0 && state->submitted < state->count)
+    {
+        int rc = sxSubmitRead(slot);
+        if (rc < 0)
+        {
+            state->rc = rc;
+            sxCancelReads(state);
+        }
+    }
+    if (state->pending == 0)
+        state->completed = 1;
+}
+
+int sxReadPixels(HANDLE sxHandle, void *pixels, unsigned long count, unsigned long rowBytes, unsigned long pitch)
+{
+    if (count == 0)
+        return true;
+    struct t_sx_read_state state;
+    memset(&state, 0, sizeof(state));
+    state.handle   = sxHandle;
+    state.pixels   = (unsigned char *)pixels;
+    state.count    = count;
+    state.rowBytes = rowBytes == 0 ? count : rowBytes;
+    state.pitch    = pitch == 0 ? state.rowBytes : pitch;
+    state.direct   = state.rowBytes == state.pitch;
+    for (int i = 0; i < ASYNC_TRANSFERS && state.rc >= 0; i++)
+    {
+        struct t_sx_read_slot *slot = &state.slots[i];
+        slot->state    = &state;
+        slot->transfer = libusb_alloc_transfer(0);
+        if (slot->transfer == nullptr)
+            state.rc = LIBUSB_ERROR_NO_MEM;
+        else if (!state.direct)
+        {
+            slot->staging = (unsigned char *)malloc(ASYNC_CHUNK_SIZE);
+            if (slot->staging == nullptr)
+                state.rc = LIBUSB_ERROR_NO_MEM;
+        }
+    }
+    for (int i = 0; i < ASYNC_TRANSFERS && state.rc >= 0 && state.submitted < state.count; i++)
+    {
+        int rc = sxSubmitRead(&state.slots[i]);
+        if (rc < 0)
+        {
+            state.rc = rc;
+            sxCancelReads(&state);
+        }
+    }
+    if (state.pending == 0)
+        state.completed = 1;
+    while (!state.completed)
+    {
+        int rc = libusb_handle_events_completed(ctx, &state.completed);
+        if (rc < 0 && rc != LIBUSB_ERROR_INTERRUPTED)
+        {
+            DEBUG(log(true, "sxReadPixels: libusb_handle_events_completed -> %s\n", libusb_error_name(rc)));
+            if (state.rc >= 0)
+            {
+                state.rc = rc;
+                sxCancelReads(&state);
+            }
+        }
+    }
+    for (int i = 0; i < ASYNC_TRANSFERS; i++)
+    {
+        libusb_free_transfer(state.slots[i].transfer);
+        free(state.slots[i].staging);
+    }
+    DEBUG(log(true, "sxReadPixels: %lu of %lu bytes -> %s\n", state.received, count,
+              state.rc < 0 ? libusb_error_name(state.rc) : "OK"));
+    return state.rc >= 0 && state.received == count;
 }
 
 int sxSetSTAR2000(HANDLE sxHandle, char star2k)
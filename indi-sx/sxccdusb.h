@@ -154,7 +154,13 @@ int sxExposePixels(HANDLE sxHandle, unsigned short flags, unsigned short camInde
 int sxExposePixelsGated(HANDLE sxHandle, unsigned short flags, unsigned short camIndex, unsigned short xoffset,
                         unsigned short yoffset, unsigned short width, unsigned short height, unsigned short xbin,
                         unsigned short ybin, unsigned long msec);
-int sxReadPixels(HANDLE sxHandle, void *pixels, unsigned long count);
+/*
+ * Reads count bytes of pixel data. If rowBytes and pitch are given, every rowBytes long row of
+ * the incoming stream is stored pitch bytes after the previous one, so a field can be interleaved
+ * straight into the frame as it arrives.
+ */
+int sxReadPixels(HANDLE sxHandle, void *pixels, unsigned long count, unsigned long rowBytes = 0,
+                 unsigned long pitch = 0);
 int sxSetShutter(HANDLE sxHandle, unsigned short state);
 int sxSetTimer(HANDLE sxHandle, unsigned long msec);
 unsigned long sxGetTimer(HANDLE sxHandle);
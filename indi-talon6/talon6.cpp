@@ -23,8 +23,14 @@
 #include <unistd.h>
 #include <math.h>
 #include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <indicom.h>
+#include <eventloop.h>
 #include <connectionplugins/connectionserial.h>
 #include <termios.h>
 
@@ -116,12 +122,13 @@ bool Talon6::Handshake()
         return true;
     }
 
+    startReader();
     return true;
 }
 
 Talon6::~Talon6()
 {
-
+    stopReader();
 }
 
 const char * Talon6::getDefaultName()
@@ -261,6 +268,7 @@ bool Talon6::saveConfigItems(FILE *fp)
 
 bool Talon6::Disconnect()
 {
+    stopReader();
     return INDI::Dome::Disconnect();
 }
 
@@ -279,53 +287,229 @@ void Talon6::getFirmwareVersion()
     WriteString("&V#");
 }
 
-/* Read string from serial connection tty.
- Every string has a # (HEX23) as a trailing char*/
-int Talon6::ReadString(char *buf, int size)
+// Queues a command, the reader thread sends it once the reply to the previous one is in
+int Talon6::WriteString(const char *buf)
 {
-    int count;
-    int bytesRead;
-    char a;
-    int rc;
+    char wake = 0;
+
+    if (!m_ReaderThread.joinable())
+        return -1;
+
+    {
+        std::lock_guard<std::mutex> lock(m_TxMutex);
+        // A status request still waiting in the queue already covers this one
+        if (!strcmp(buf, "&G#") && std::find(m_TxQueue.begin(), m_TxQueue.end(), buf) != m_TxQueue.end())
+            return 0;
+        m_TxQueue.emplace_back(buf);
+    }
 
-    count = 0;
-    buf[count] = 0;
+    if (write(m_WakePipe[1], &wake, 1) < 0)
+        LOGF_DEBUG("Failed to wake serial reader: %s", strerror(errno));
 
-    rc = tty_read(PortFD, &a, 1, 2, &bytesRead);
+    return 0;
+}
 
-    while(rc == TTY_OK)
+void Talon6::startReader()
+{
+    if (m_ReaderThread.joinable() || PortFD < 0)
+        return;
+
+    if (pipe(m_WakePipe) != 0)
+    {
+        LOGF_ERROR("Failed to start serial reader: %s", strerror(errno));
+        return;
+    }
+
+    if (pipe(m_EventPipe) != 0)
     {
+        LOGF_ERROR("Failed to start serial reader: %s", strerror(errno));
+        close(m_WakePipe[0]);
+        close(m_WakePipe[1]);
+        m_WakePipe[0] = m_WakePipe[1] = -1;
+        return;
+    }
+    fcntl(m_EventPipe[0], F_SETFL, fcntl(m_EventPipe[0], F_GETFL) | O_NONBLOCK);
+    m_EventCallbackID = IEAddCallback(m_EventPipe[0], messagesReady, this);
+
+    m_RxHead = m_RxTail = 0;
+    m_TxQueue.clear();
+    m_RxQueue.clear();
+    m_ReaderQuit = false;
+    m_ReaderThread = std::thread(&Talon6::readerThread, this);
+}
+
+void Talon6::stopReader()
+{
+    char wake = 0;
+
+    if (!m_ReaderThread.joinable())
+        return;
+
+    m_ReaderQuit = true;
+    if (write(m_WakePipe[1], &wake, 1) < 0)
+        LOGF_DEBUG("Failed to wake serial reader: %s", strerror(errno));
+    m_ReaderThread.join();
+
+    IERmCallback(m_EventCallbackID);
+    m_EventCallbackID = -1;
 
-        if((a == '\n') || (a == '\r')) return count;
+    close(m_WakePipe[0]);
+    close(m_WakePipe[1]);
+    m_WakePipe[0] = m_WakePipe[1] = -1;
+    close(m_EventPipe[0]);
+    close(m_EventPipe[1]);
+    m_EventPipe[0] = m_EventPipe[1] = -1;
+}
 
-        buf[count] = a;
-        count++;
+void Talon6::messagesReady(int, void *userpointer)
+{
+    static_cast<Talon6 *>(userpointer)->processMessages();
+}
+
+// Runs on the INDI thread, so the messages update properties and roof state like any other handler
+void Talon6::processMessages()
+{
+    char message[MAX_MESSAGE_SIZE + 1];
+    char drain[16];
+    std::deque<std::string> messages;
 
-        if(count == size) return count;
-        rc = tty_read(PortFD, &a, 1, 1, &bytesRead);
-        //fprintf(stderr,"read returns %d %x\n",rc,a&0xFF);
+    while (read(m_EventPipe[0], drain, sizeof(drain)) == sizeof(drain))
+        ;
 
+    {
+        std::lock_guard<std::mutex> lock(m_RxMutex);
+        messages.swap(m_RxQueue);
     }
-    if(rc != TTY_OK)
+
+    for (const std::string &m : messages)
     {
-        //fprintf(stderr,"Readstring returns error %d\n",rc);
-        return -1;
+        memset(message, 0, sizeof(message));
+        strncpy(message, m.c_str(), MAX_MESSAGE_SIZE);
+        ProcessDomeMessage(message);
+        // Finish the roof motion as soon as the status says so
+        if (message[1] == 'G')
+            checkRoofMotion();
     }
-    return count;
 }
 
-// This function sends command to the device through serial connection
-int Talon6::WriteString(const char *buf)
+/* Extracts the next message from the ring. Messages end with CR or LF (a # (HEX23)
+ precedes them), empty ones are skipped and anything longer than MAX_MESSAGE_SIZE
+ is cut like the byte-wise reader used to do.*/
+bool Talon6::nextMessage(char *message)
 {
-    char ReadBuf[40];
-    int bytesWritten;
-    int rc;
+    for (size_t i = m_RxHead; i < m_RxTail; i++)
+    {
+        char a = m_RxRing[i % RX_RING_SIZE];
+        size_t length = i - m_RxHead;
 
-    tty_write(PortFD, buf, strlen(buf), &bytesWritten);
-    rc = ReadString(ReadBuf, 40);
-    ProcessDomeMessage(ReadBuf);
+        if (a != '\n' && a != '\r')
+        {
+            if (length + 1 < MAX_MESSAGE_SIZE)
+                continue;
+            length++;
+        }
 
-    return rc;
+        memset(message, 0, MAX_MESSAGE_SIZE + 1);
+        for (size_t j = 0; j < length; j++)
+            message[j] = m_RxRing[(m_RxHead + j) % RX_RING_SIZE];
+        m_RxHead = i + 1;
+
+        if (length > 0)
+            return true;
+    }
+
+    return false;
+}
+
+void Talon6::readerThread()
+{
+    char message[MAX_MESSAGE_SIZE + 1];
+    char drain[16];
+    char wake = 0;
+    std::string pending;
+    std::chrono::steady_clock::time_point sentAt;
+
+    while (!m_ReaderQuit)
+    {
+        // The device answers one command at a time, only send the next one
+        // when the previous reply arrived or timed out
+        if (pending.empty())
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_TxMutex);
+                if (!m_TxQueue.empty())
+                {
+                    pending = m_TxQueue.front();
+                    m_TxQueue.pop_front();
+                }
+            }
+
+            if (!pending.empty())
+            {
+                int bytesWritten = 0;
+                int rc = tty_write(PortFD, pending.c_str(), pending.size(), &bytesWritten);
+                if (rc != TTY_OK)
+                {
+                    char errstr[MAXRBUF] = {0};
+                    tty_error_msg(rc, errstr, MAXRBUF);
+                    LOGF_ERROR("Serial write error: %s.", errstr);
+                    pending.clear();
+                    continue;
+                }
+                sentAt = std::chrono::steady_clock::now();
+            }
+        }
+
+        int timeout = 500;
+        if (!pending.empty())
+        {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - sentAt).count();
+            if (elapsed >= REPLY_TIMEOUT_MS)
+            {
+                LOGF_DEBUG("No reply to %s", pending.c_str());
+                pending.clear();
+                continue;
+            }
+            timeout = REPLY_TIMEOUT_MS - elapsed;
+        }
+
+        struct pollfd fds[2] = {{PortFD, POLLIN, 0}, {m_WakePipe[0], POLLIN, 0}};
+        if (poll(fds, 2, timeout) <= 0)
+            continue;
+
+        if (fds[1].revents & POLLIN)
+        {
+            while (read(m_WakePipe[0], drain, sizeof(drain)) == sizeof(drain))
+                ;
+        }
+
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR))
+        {
+            size_t offset = m_RxTail % RX_RING_SIZE;
+            size_t space = std::min(RX_RING_SIZE - (m_RxTail - m_RxHead), RX_RING_SIZE - offset);
+            ssize_t bytesRead = read(PortFD, m_RxRing + offset, space);
+            if (bytesRead <= 0)
+            {
+                // Port went away, do not spin until Disconnect stops us
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            m_RxTail += bytesRead;
+
+            bool framed = false;
+            while (nextMessage(message))
+            {
+                pending.clear();
+                framed = true;
+
+                std::lock_guard<std::mutex> lock(m_RxMutex);
+                m_RxQueue.emplace_back(message);
+            }
+
+            if (framed && write(m_EventPipe[1], &wake, 1) < 0)
+                LOGF_DEBUG("Failed to wake INDI thread: %s", strerror(errno));
+        }
+    }
 }
 
 void Talon6::TimerHit()
@@ -333,9 +517,16 @@ void Talon6::TimerHit()
     if (!isConnected())
         return; //  No need to reset timer if we are not connected anymore
 
+    // The reply is handled by processMessages. Status is cheap now,
+    // so poll it faster while the roof moves to catch the end sooner.
     getDeviceStatus();
-    SetTimer(1000);
+    SetTimer(DomeMotionSP.getState() == IPS_BUSY ? MOTION_POLL_MS : 1000);
+
+    checkRoofMotion();
+}
 
+void Talon6::checkRoofMotion()
+{
     if (DomeMotionSP.getState() == IPS_BUSY)
     {
         // Abort called
@@ -824,7 +1015,7 @@ IPState Talon6::DomeGoTo(int GoTo )
     //Transform to char and build command string formatted as to documentation
     char hexTicksChar[paddedHexTicks.size() + 1];
     strcpy(hexTicksChar, paddedHexTicks.c_str());
-    char commandString[8];
+    char commandString[9] = {0};
     commandString[0] = '&';
     commandString[1] = 'A';
     commandString[2] = ShiftChar(hexTicksChar[0]);
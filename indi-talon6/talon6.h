@@ -25,6 +25,12 @@
 #include <math.h>
 #include <sys/time.h>
 
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
 
 class Talon6 : public INDI::Dome
 {
@@ -91,10 +97,37 @@ class Talon6 : public INDI::Dome
         double MotionRequest { 0 };
         void getDeviceStatus();
         void getFirmwareVersion();
-        int ReadString(char *,int);
         int WriteString(const char *);
         void ProcessDomeMessage(char *);
         char ShiftChar(char shiftChar);
+        void checkRoofMotion();
+
+        // Serial I/O runs on its own thread: WriteString queues the commands, the reader sends
+        // them one at a time and queues every message framed from the ring. processMessages
+        // hands them to ProcessDomeMessage on the INDI thread, woken through m_EventPipe.
+        void startReader();
+        void stopReader();
+        void readerThread();
+        bool nextMessage(char *message);
+        void processMessages();
+        static void messagesReady(int fd, void *userpointer);
+
+        static constexpr int RX_RING_SIZE { 256 };
+        static constexpr int MAX_MESSAGE_SIZE { 40 };
+        static constexpr int REPLY_TIMEOUT_MS { 2000 };
+        static constexpr int MOTION_POLL_MS { 250 };
+        char m_RxRing[RX_RING_SIZE] {};
+        size_t m_RxHead { 0 };
+        size_t m_RxTail { 0 };
+        std::deque<std::string> m_TxQueue;
+        std::mutex m_TxMutex;
+        std::deque<std::string> m_RxQueue;
+        std::mutex m_RxMutex;
+        std::thread m_ReaderThread;
+        std::atomic_bool m_ReaderQuit { false };
+        int m_WakePipe[2] { -1, -1 };
+        int m_EventPipe[2] { -1, -1 };
+        int m_EventCallbackID { -1 };
 
 };
 
@@ -0,0 +1,248 @@
+/*******************************************************************************
+ Talon6 serial hand-off test
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+// Drives the driver against a simulated roof on a pty. The reader thread frames the
+// replies, but roof state and properties must only change while the INDI event loop
+// runs on this (the INDI) thread.
+
+#include <gtest/gtest.h>
+
+#include "talon6.h"
+
+#include <eventloop.h>
+
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+extern std::unique_ptr<Talon6> talon6;
+
+static const char *DeviceName = "Talon6";
+
+// Roof controller on the master side of a pty, answering every command with a status frame
+class RoofSimulator
+{
+    public:
+        enum Status { OPEN = 0, CLOSED = 1, OPENING = 2, CLOSING = 3 };
+
+        RoofSimulator()
+        {
+            master = posix_openpt(O_RDWR | O_NOCTTY);
+            EXPECT_GE(master, 0);
+            grantpt(master);
+            unlockpt(master);
+            // Raw from the start, so our replies are never echoed back as commands
+            struct termios tio;
+            tcgetattr(master, &tio);
+            cfmakeraw(&tio);
+            tcsetattr(master, TCSANOW, &tio);
+            slave = ptsname(master);
+            thread = std::thread(&RoofSimulator::run, this);
+        }
+
+        ~RoofSimulator()
+        {
+            quit = true;
+            thread.join();
+            close(master);
+        }
+
+        // Status frame: status and last action, then 14 data bytes. Data bytes carry 7 bits,
+        // 0x80 encodes 0 without putting a NUL or a line end in the frame.
+        std::string frame(int status, int position)
+        {
+            std::string reply = "&G";
+            reply += static_cast<char>((status << 4) | 1);
+            reply += static_cast<char>(0x80 | ((position >> 14) & 0x7F));
+            reply += static_cast<char>(0x80 | ((position >> 7) & 0x7F));
+            reply += static_cast<char>(0x80 | (position & 0x7F));
+            reply += std::string(11, static_cast<char>(0x80));
+            return reply + "#\n";
+        }
+
+        void reply(const std::string &command)
+        {
+            std::string out;
+            if (command == "&V#")
+                out = "&V6.01#\n";
+            else
+            {
+                if (command == "&O#")
+                    status = OPENING;
+                else if (command == "&P#" || command == "&C#")
+                    status = CLOSING;
+                else if (command == "&G#" && limitReached)
+                {
+                    status = (status == OPENING) ? OPEN : (status == CLOSING) ? CLOSED : status.load();
+                    limitReached = false;
+                    limitSentAt = std::chrono::steady_clock::now();
+                    limitSent = true;
+                }
+                out = frame(status, status == OPEN ? Travel : 0);
+            }
+            if (write(master, out.data(), out.size()) != static_cast<ssize_t>(out.size()))
+                ADD_FAILURE() << "simulator write failed";
+        }
+
+        void run()
+        {
+            std::string command;
+            char c;
+            while (!quit)
+            {
+                struct pollfd fds = { master, POLLIN, 0 };
+                if (poll(&fds, 1, 20) <= 0 || read(master, &c, 1) != 1)
+                    continue;
+                command += c;
+                if (c == '#')
+                {
+                    commands++;
+                    reply(command);
+                    command.clear();
+                }
+            }
+        }
+
+        static constexpr int Travel { 1000 };
+        int master { -1 };
+        std::string slave;
+        std::thread thread;
+        std::atomic_bool quit { false };
+        std::atomic<int> status { CLOSED };
+        std::atomic<int> commands { 0 };
+        // Set by the test: the next status reply reports the roof at its limit
+        std::atomic_bool limitReached { false };
+        std::atomic_bool limitSent { false };
+        std::chrono::steady_clock::time_point limitSentAt;
+};
+
+// Runs the INDI event loop on this thread until done() or the timeout
+template <typename Condition>
+static bool pump(Condition done, int timeoutMs = 3000)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!done())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+        int flag = 0;
+        deferLoop(5, &flag);
+    }
+    return true;
+}
+
+static std::string roofStatus()
+{
+    auto status = talon6->getText("STATUSVALUE");
+    return status.isValid() ? status.findWidgetByName("ROOF_STATUS")->getText() : "";
+}
+
+static void newSwitch(const char *name, const char *element)
+{
+    ISState states[] = { ISS_ON };
+    char *names[] = { const_cast<char *>(element) };
+    ISNewSwitch(DeviceName, name, states, names, 1);
+}
+
+TEST(Talon6, MessagesAreHandledOnTheINDIThread)
+{
+    RoofSimulator roof;
+
+    ISGetProperties(nullptr);
+
+    double ticks[] = { RoofSimulator::Travel };
+    char *ticksNames[] = { const_cast<char *>("ENCODER_TICKS") };
+    ISNewNumber(DeviceName, "ENCODER_TICKS", ticks, ticksNames, 1);
+
+    char *port[] = { const_cast<char *>(roof.slave.c_str()) };
+    char *portNames[] = { const_cast<char *>("PORT") };
+    ISNewText(DeviceName, "DEVICE_PORT", port, portNames, 1);
+
+    newSwitch("CONNECTION", "CONNECT");
+    ASSERT_TRUE(talon6->isConnected());
+
+    // The status requested on connect parks the dome, the roof reports closed
+    ASSERT_TRUE(pump([]()
+    {
+        return roofStatus() == "CLOSED" && talon6->getSwitch("DOME_PARK").getState() == IPS_OK;
+    }));
+    ASSERT_EQ(talon6->getSwitch("DOME_PARK").findOnSwitchIndex(), 0);
+
+    // Unpark, then let the roof reach the open limit and time it to the state change
+    newSwitch("DOME_PARK", "UNPARK");
+    ASSERT_TRUE(pump([]()
+    {
+        return roofStatus() == "OPENING";
+    }));
+    roof.limitReached = true;
+    newSwitch("STATUS", "STATUS");
+    ASSERT_TRUE(pump([]()
+    {
+        return talon6->getSwitch("DOME_PARK").getState() == IPS_OK &&
+               talon6->getSwitch("DOME_PARK").findOnSwitchIndex() == 1;
+    }));
+    ASSERT_TRUE(roof.limitSent.load());
+    double latencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - roof.limitSentAt).count();
+    EXPECT_EQ(roofStatus(), "OPEN");
+
+    // Park, and hold the event loop back while the closed limit arrives
+    newSwitch("DOME_PARK", "PARK");
+    ASSERT_TRUE(pump([]()
+    {
+        return roofStatus() == "CLOSING";
+    }));
+    ASSERT_EQ(talon6->getSwitch("DOME_PARK").getState(), IPS_BUSY);
+    roof.limitSent = false;
+    roof.limitReached = true;
+    int commands = roof.commands.load();
+    newSwitch("STATUS", "STATUS");
+    // The command goes out through the reader thread, no event loop needed
+    for (int i = 0; i < 200 && !roof.limitSent.load(); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ASSERT_TRUE(roof.limitSent.load());
+    ASSERT_GT(roof.commands.load(), commands);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    // The reply has been read and framed by now, but only the INDI thread may apply it
+    EXPECT_EQ(roofStatus(), "CLOSING");
+    EXPECT_EQ(talon6->getSwitch("DOME_PARK").getState(), IPS_BUSY);
+
+    ASSERT_TRUE(pump([]()
+    {
+        return talon6->getSwitch("DOME_PARK").getState() == IPS_OK;
+    }));
+    EXPECT_EQ(roofStatus(), "CLOSED");
+    EXPECT_EQ(talon6->getSwitch("DOME_PARK").findOnSwitchIndex(), 0);
+
+    fprintf(stderr, "Open limit reply to unparked state: %.1f ms, %d commands sent\n", latencyMs, roof.commands.load());
+
+    newSwitch("CONNECTION", "DISCONNECT");
+    EXPECT_FALSE(talon6->isConnected());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -24,6 +24,7 @@
 
 #include <sstream>
 #include <cstring>  //for memset
+#include <algorithm>
 
 namespace
 {
@@ -478,6 +479,46 @@ Apg::Status Alta::GetImagingStatus()
 //////////////////////////// 
 // GET  IMAGE 
 void Alta::GetImage( std::vector<uint16_t> & out )
+{
+    uint16_t r=0, c = 0;
+    ExposureAndGetImgRC( r, c );
+    const uint16_t z = GetImageZ();
+    const int32_t numPixels = r*z*GetRoiNumCols();
+
+    if( numPixels != apgHelper::SizeT2Int32( out.size() ) )
+    {
+        out.clear();
+        out.resize( numPixels );
+    }
+
+    DownloadImage( out.data(), r, c, z );
+}
+
+//////////////////////////// 
+// GET  IMAGE 
+void Alta::GetImage( uint16_t * out, const size_t count )
+{
+    uint16_t r=0, c = 0;
+    ExposureAndGetImgRC( r, c );
+    const uint16_t z = GetImageZ();
+    const int32_t numPixels = r*z*GetRoiNumCols();
+
+    if( static_cast<size_t>( numPixels ) > count )
+    {
+        std::stringstream msg;
+        msg << "Output buffer of " << count << " pixels is too small for ";
+        msg << numPixels << " pixels of image data.";
+        apgHelper::throwRuntimeException( m_fileName, msg.str(), 
+            __LINE__, Apg::ErrorType_InvalidUsage );
+    }
+
+    DownloadImage( out, r, c, z );
+}
+
+//////////////////////////// 
+// DOWNLOAD      IMAGE 
+void Alta::DownloadImage( uint16_t * out, const uint16_t r,
+            const uint16_t c, const uint16_t z )
 {
 #ifdef DEBUGGING_CAMERA
     apgHelper::DebugMsg( "Alta::GetImage -> BEGINNING" );
@@ -512,40 +553,31 @@ void Alta::GetImage( std::vector<uint16_t> & out )
         }
     }
 
-    // allocating the buffers for the image
-    // doing this outside of the try / catch, so that
-    // even if the GetImage function throws
-    // we can try to copy whatever data we managed
-    // to fetch from the camera into the user supplied
-    // vector
-    uint16_t r=0, c = 0;
-    ExposureAndGetImgRC( r, c );
-    const uint16_t z = GetImageZ();
-    std::vector<uint16_t> datafromCam( r*c*z, 0 ); 
-
     const int32_t dataLen = r*z;
-    const int32_t numCols = GetRoiNumCols();  
+    const int32_t numCols = GetRoiNumCols();
 
-    if( dataLen*numCols != apgHelper::SizeT2Int32( out.size() ) )
-    {
-        out.clear();
-        out.resize( dataLen*numCols );
-    }
+    // the buffer for the raw data is kept between images,
+    // it is only reallocated when the image size changes.
+    // reserving room for the usb transfer padding,
+    // so CamUsbIo doesn't have to reallocate
+    m_ImgBuffer.reserve( r*c*z + 8 );
+    m_ImgBuffer.resize( r*c*z );
 
     try
     {
-        m_CamIo->GetImageData( datafromCam );
+        m_CamIo->GetImageData( m_ImgBuffer );
     }
     catch(std::exception & err )
     {
         m_ImageInProgress = false;
-        
-        // log and remove the AD garbage pixels at the beginning of every row
-        std::string msg( "Removing AD latency pixels in exception handler" );
+
+        // past whatever arrived the raw buffer still holds the previous
+        // image, so hand back a blank frame rather than stale pixels
+        std::string msg( "Image download failed, returning a zeroed image" );
         ApgLogger::Instance().Write(ApgLogger::LEVEL_RELEASE,"error",
         apgHelper::mkMsg( m_fileName, msg, __LINE__) );
 
-        FixImgFromCamera( datafromCam, out, dataLen, numCols );
+        std::fill( out, out + dataLen*numCols, 0 );
         throw;
     }
     
@@ -580,7 +612,7 @@ void Alta::GetImage( std::vector<uint16_t> & out )
 #endif
 
     // removing the AD garbage pixels at the beginning of every row
-    FixImgFromCamera( datafromCam, out, dataLen, numCols );
+    FixImgFromCamera( m_ImgBuffer, out, dataLen, numCols );
   
     ApgLogger::Instance().Write(ApgLogger::LEVEL_DEBUG,"info","Get Image Completed.");
 
@@ -955,7 +987,7 @@ Apg::FanMode Alta::GetFanMode()
 //////////////////////////// 
 //      FIX      IMG        FROM          CAMERA
 void Alta::FixImgFromCamera( const std::vector<uint16_t> & data,
-                              std::vector<uint16_t> & out,  const int32_t rows, 
+                              uint16_t * out,  const int32_t rows, 
                               const int32_t cols )
 {
     const int32_t offset = m_CcdAcqSettings->GetPixelShift();
@@ -40,6 +40,7 @@ class DLL_EXPORT Alta : public ApogeeCam
         Apg::Status GetImagingStatus();
       
         void GetImage( std::vector<uint16_t> & out );
+        void GetImage( uint16_t * out, size_t count );
 
         void StopExposure( bool Digitize );
 
@@ -206,9 +207,11 @@ class DLL_EXPORT Alta : public ApogeeCam
             const std::string & DeviceAddr);
 
         void FixImgFromCamera( const std::vector<uint16_t> & data,
-            std::vector<uint16_t> & out,  int32_t rows, int32_t cols);
+            uint16_t * out,  int32_t rows, int32_t cols);
 
     private:
+        void DownloadImage( uint16_t * out, uint16_t r,
+            uint16_t c, uint16_t z );
         
         void VerifyCamId();
         void CfgCamFromId( uint16_t CameraId );
@@ -16,10 +16,13 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 
 #include "ICamIo.h" 
 #include "IAltaSerialPortIo.h" 
 
+class CLibCurlWrap;
+
 class AltaEthernetIo : public ICamIo, public IAltaSerialPortIo
 { 
     public: 
@@ -81,10 +84,26 @@ class AltaEthernetIo : public ICamIo, public IAltaSerialPortIo
     private:
         void OpenSession();
         void CloseSession();
+
+        struct ImageStream
+        {
+            uint16_t * out;
+            size_t numPixels;
+            size_t numBytes;
+            uint8_t pendingByte;
+        };
+
+        static size_t ImageStreamWriter( char * data, size_t size,
+            size_t nmemb, void * userData );
+
         const std::string m_url;
         const std::string m_fileName;
         std::vector<uint16_t> m_StatusRegs;
 
+        // one handle for every request, so they share a
+        // kept alive connection to the camera
+        std::shared_ptr<CLibCurlWrap> m_libcurl;
+
         //disabling the copy ctor and assignment operator
         //generated by the compiler - don't want them
         //Effective C++ Item 6
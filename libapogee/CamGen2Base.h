@@ -25,6 +25,7 @@ class DLL_EXPORT CamGen2Base  : public ApogeeCam
         Apg::Status GetImagingStatus();
 
         void GetImage( std::vector<uint16_t> & out );
+        void GetImage( uint16_t * out, size_t count );
 
         void StopExposure( bool Digitize );
 
@@ -52,6 +53,9 @@ class DLL_EXPORT CamGen2Base  : public ApogeeCam
         void DefaultStartExposure( double Duration, bool IsLight, bool IssueReset=true );
 
     private:
+        void DownloadImage( uint16_t * out, uint16_t r,
+            uint16_t c, uint16_t z );
+
         const std::string m_fileName;
 
         //disabling the copy ctor and assignment operator
@@ -29,7 +29,7 @@ void ImgFix::SingleOuputErase( std::vector<uint16_t> & data, const int32_t rows,
 //////////////////////////// 
 //      SINGLE       OUPUT       COPY
 void ImgFix::SingleOuputCopy( const std::vector<uint16_t> & data, 
-      std::vector<uint16_t> & out, const int32_t rows,  const int32_t numImgCols,  
+      uint16_t * out, const int32_t rows,  const int32_t numImgCols,  
       const int32_t numLatencyPixels )
 {
 
@@ -41,8 +41,7 @@ void ImgFix::SingleOuputCopy( const std::vector<uint16_t> & data,
     {
         std::vector<uint16_t>::const_iterator start = data.begin()+actColsOffset;
         std::vector<uint16_t>::const_iterator end = start + numImgCols;
-        std::vector<uint16_t>::iterator outStart = out.begin() + outColsOffset;
-        std::copy( start, end, outStart );
+        std::copy( start, end, out + outColsOffset );
     }
 }
 
@@ -50,7 +49,7 @@ void ImgFix::SingleOuputCopy( const std::vector<uint16_t> & data,
 //////////////////////////// 
 //      QUAD      OUPUT       COPY
 void ImgFix::QuadOuputCopy( const std::vector<uint16_t> & data, 
-      std::vector<uint16_t> & out, const int32_t rows,  const int32_t cols,  
+      uint16_t * out, const int32_t rows,  const int32_t cols,  
       const int32_t numLatencyPixels, const int32_t outputBuffOffset )
 {
     int32_t numGood =  ( cols / 2 ) * 4;
@@ -67,8 +66,7 @@ void ImgFix::QuadOuputCopy( const std::vector<uint16_t> & data,
 
         std::vector<uint16_t>::const_iterator start = data.begin()+badStart;
         std::vector<uint16_t>::const_iterator end = start + len;
-        std::vector<uint16_t>::iterator outStart = out.begin() + outputBuffOffset + goodStart;
-        std::copy( start, end, outStart );
+        std::copy( start, end, out + outputBuffOffset + goodStart );
 
          goodStart += len;
          badStart += (len + numBad);
@@ -79,7 +77,7 @@ void ImgFix::QuadOuputCopy( const std::vector<uint16_t> & data,
 //////////////////////////// 
 //      QUAD       OUPUT       FIX
 void ImgFix::QuadOuputFix( const std::vector<uint16_t> & data, 
-                                             std::vector<uint16_t> & out,
+                                             uint16_t * out,
                                              const int32_t rows,  const int32_t cols,
                                              const int32_t numLatencyPixels)
 {
@@ -121,7 +119,7 @@ void ImgFix::QuadOuputFix( const std::vector<uint16_t> & data,
 //////////////////////////// 
 //      DUAL       OUPUT       FIX
 void ImgFix::DualOuputFix( const std::vector<uint16_t> & data, 
-                                             std::vector<uint16_t> & out,
+                                             uint16_t * out,
                                              const int32_t rows,  const int32_t cols,
                                              const int32_t numLatencyPixels)
 {
@@ -64,6 +64,10 @@ CLibCurlWrap::CLibCurlWrap() : m_curlHandle( 0 ),
          apgHelper::throwRuntimeException( m_fileName, 
              errStr, __LINE__, Apg::ErrorType_Connection );
     }
+
+    // the handle keeps its connection open between requests,
+    // so reusing a wrapper avoids a tcp handshake per request
+    curl_easy_setopt(m_curlHandle, CURLOPT_TCP_KEEPALIVE, 1L);
 } 
 
 //////////////////////////// 
@@ -81,6 +85,7 @@ void CLibCurlWrap::HttpGet(const std::string & url,
                             std::string & result)
 {
     CurlSetupStrWrite ( url );
+    curl_easy_setopt(m_curlHandle, CURLOPT_HTTPGET, 1L);
     result = ExecuteStr();
 }
 
@@ -90,9 +95,33 @@ void CLibCurlWrap::HttpGet(const std::string & url,
             std::vector<uint8_t> & result)
 {
     CurlSetupVectWrite ( url, result );
+    curl_easy_setopt(m_curlHandle, CURLOPT_HTTPGET, 1L);
     ExecuteVect( result );
 }
 
+//////////////////////////// 
+// HTTP GET 
+void CLibCurlWrap::HttpGet(const std::string & url,
+            const WriteFunc writer, void * const userData)
+{
+    curl_easy_setopt(m_curlHandle, CURLOPT_ERRORBUFFER, errorBuffer);  
+    curl_easy_setopt(m_curlHandle, CURLOPT_URL, url.c_str());  
+    curl_easy_setopt(m_curlHandle, CURLOPT_WRITEFUNCTION, writer);  
+    curl_easy_setopt(m_curlHandle, CURLOPT_WRITEDATA, userData); 
+    curl_easy_setopt(m_curlHandle, CURLOPT_TIMEOUT, m_timeout);
+    curl_easy_setopt(m_curlHandle, CURLOPT_HTTPGET, 1L);
+
+    const CURLcode returnCode = curl_easy_perform(m_curlHandle);
+
+    if( CURLE_OK != returnCode )
+    {
+        std::string curlError( errorBuffer );
+
+        apgHelper::throwRuntimeException( m_fileName, curlError, 
+            __LINE__, Apg::ErrorType_Critical );
+    }
+}
+
 //////////////////////////// 
 // HTTP POST 
 void CLibCurlWrap::HttpPost(const std::string & url,
@@ -30,6 +30,17 @@ class CLibCurlWrap
         void HttpGet(const std::string & url,
             std::vector<uint8_t> & result);
 
+        /*!
+         * Streams the response body to writer as it arrives instead of
+         * collecting it in a container first.  writer gets the same
+         * arguments as a CURLOPT_WRITEFUNCTION callback.
+         */
+        typedef size_t (*WriteFunc)( char * data, size_t size,
+            size_t nmemb, void * userData );
+
+        void HttpGet(const std::string & url,
+            WriteFunc writer, void * userData);
+
         void HttpPost(const std::string & url,
             const std::string & postFields, 
             std::string & result);
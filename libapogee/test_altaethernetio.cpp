@@ -0,0 +1,317 @@
+/*!
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+*
+* \brief Image download of AltaEthernetIo against a local HTTP stand-in
+* for the camera, with the throughput of the streamed download.
+*
+*/
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AltaEthernetIo.h"
+#include "libCurlWrap.h"
+
+namespace
+{
+    // Serves the session and image urls the way an Alta ethernet camera does,
+    // keeping connections alive. The image is sent in small writes of
+    // varying (odd) sizes, so pixels straddle the chunks curl hands over.
+    class MockAlta
+    {
+        public:
+            MockAlta() : m_listenFd( -1 ), m_port( 0 ), m_quit( false ),
+                         m_connections( 0 ), m_imageRequests( 0 ), m_missingBytes( 0 ),
+                         m_chunked( true )
+            {
+                m_listenFd = socket( AF_INET, SOCK_STREAM, 0 );
+                int one = 1;
+                setsockopt( m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one) );
+
+                sockaddr_in addr;
+                memset( &addr, 0, sizeof(addr) );
+                addr.sin_family = AF_INET;
+                addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+                EXPECT_EQ( bind( m_listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr) ), 0 );
+                EXPECT_EQ( listen( m_listenFd, 4 ), 0 );
+
+                socklen_t len = sizeof(addr);
+                getsockname( m_listenFd, reinterpret_cast<sockaddr *>(&addr), &len );
+                m_port = ntohs( addr.sin_port );
+
+                m_thread = std::thread( &MockAlta::Run, this );
+            }
+
+            ~MockAlta()
+            {
+                m_quit = true;
+                shutdown( m_listenFd, SHUT_RDWR );
+                close( m_listenFd );
+                m_thread.join();
+            }
+
+            std::string Url() const
+            {
+                return "http://127.0.0.1:" + std::to_string( m_port );
+            }
+
+            // Big endian pixels, as the camera sends them
+            void SetImage( const std::vector<uint16_t> & pixels )
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                m_image.resize( pixels.size() * 2 );
+                for( size_t i = 0; i < pixels.size(); ++i )
+                {
+                    m_image[2*i] = static_cast<char>( pixels[i] >> 8 );
+                    m_image[2*i+1] = static_cast<char>( pixels[i] & 0xFF );
+                }
+            }
+
+            int32_t m_listenFd;
+            uint16_t m_port;
+            std::atomic<bool> m_quit;
+            std::atomic<int32_t> m_connections;
+            std::atomic<int32_t> m_imageRequests;
+            std::atomic<size_t> m_missingBytes;
+            std::atomic<bool> m_chunked;
+
+        private:
+            void Run()
+            {
+                while( !m_quit )
+                {
+                    const int32_t fd = accept( m_listenFd, NULL, NULL );
+                    if( fd < 0 )
+                    {
+                        continue;
+                    }
+                    ++m_connections;
+                    int one = 1;
+                    setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one) );
+                    Serve( fd );
+                    close( fd );
+                }
+            }
+
+            void Serve( const int32_t fd )
+            {
+                std::string request;
+                char buf[4096];
+
+                for(;;)
+                {
+                    const size_t end = request.find( "\r\n\r\n" );
+                    if( std::string::npos == end )
+                    {
+                        const ssize_t n = recv( fd, buf, sizeof(buf), 0 );
+                        if( n <= 0 )
+                        {
+                            return;
+                        }
+                        request.append( buf, n );
+                        continue;
+                    }
+
+                    const std::string head = request.substr( 0, end );
+                    request.erase( 0, end + 4 );
+
+                    const size_t start = head.find( ' ' ) + 1;
+                    const std::string path = head.substr( start, head.find( ' ', start ) - start );
+
+                    if( path == "/UE/image.bin" )
+                    {
+                        ++m_imageRequests;
+                        std::string image;
+                        {
+                            std::lock_guard<std::mutex> lock( m_mutex );
+                            image = m_image.substr( 0, m_image.size() - std::min( m_image.size(), m_missingBytes.load() ) );
+                        }
+                        if( !Reply( fd, image, m_chunked ) )
+                        {
+                            return;
+                        }
+                    }
+                    else if( !Reply( fd, "SessionId=1", false ) )
+                    {
+                        return;
+                    }
+                }
+            }
+
+            static bool SendAll( const int32_t fd, const char * data, size_t len )
+            {
+                while( len )
+                {
+                    const ssize_t n = send( fd, data, len, MSG_NOSIGNAL );
+                    if( n <= 0 )
+                    {
+                        return false;
+                    }
+                    data += n;
+                    len -= n;
+                }
+                return true;
+            }
+
+            static bool Reply( const int32_t fd, const std::string & body, const bool chunked )
+            {
+                const std::string head = "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n"
+                    "Content-Length: " + std::to_string( body.size() ) + "\r\n\r\n";
+                if( !SendAll( fd, head.data(), head.size() ) )
+                {
+                    return false;
+                }
+
+                if( !chunked )
+                {
+                    return SendAll( fd, body.data(), body.size() );
+                }
+
+                const size_t sizes[] = { 1, 3, 2, 7, 1, 4093, 5, 1 };
+                size_t pos = 0;
+                for( size_t k = 0; pos < body.size(); ++k )
+                {
+                    const size_t len = std::min( sizes[k % 8], body.size() - pos );
+                    if( !SendAll( fd, body.data() + pos, len ) )
+                    {
+                        return false;
+                    }
+                    pos += len;
+                    // let each small write reach curl on its own
+                    std::this_thread::sleep_for( std::chrono::microseconds( 200 ) );
+                }
+                return true;
+            }
+
+            std::thread m_thread;
+            std::mutex m_mutex;
+            std::string m_image;
+    };
+
+    std::vector<uint16_t> MkPixels( const size_t num )
+    {
+        std::vector<uint16_t> pixels( num );
+        for( size_t i = 0; i < num; ++i )
+        {
+            pixels[i] = static_cast<uint16_t>( i * 2654435761u >> 7 );
+        }
+        return pixels;
+    }
+
+    double Seconds( const std::chrono::steady_clock::time_point start )
+    {
+        return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    }
+}
+
+TEST(AltaEthernetIo, ImageAcrossOddChunks)
+{
+    MockAlta mock;
+    AltaEthernetIo io( mock.Url() );
+
+    for( size_t num : { 1, 2, 3, 5000, 5001 } )
+    {
+        const std::vector<uint16_t> pixels = MkPixels( num );
+        mock.SetImage( pixels );
+
+        std::vector<uint16_t> data( num, 0xDEAD );
+        io.GetImageData( data );
+        ASSERT_EQ( data, pixels ) << num << " pixels";
+    }
+
+    // session and every image went over one kept alive connection
+    ASSERT_EQ( mock.m_connections, 1 );
+}
+
+TEST(AltaEthernetIo, ShortImageThrows)
+{
+    MockAlta mock;
+    AltaEthernetIo io( mock.Url() );
+
+    mock.SetImage( MkPixels( 1000 ) );
+    mock.m_missingBytes = 3;
+
+    std::vector<uint16_t> data( 1000 );
+    ASSERT_THROW( io.GetImageData( data ), std::runtime_error );
+}
+
+TEST(AltaEthernetIo, EmptyVectorThrows)
+{
+    MockAlta mock;
+    AltaEthernetIo io( mock.Url() );
+
+    mock.SetImage( MkPixels( 16 ) );
+
+    std::vector<uint16_t> data;
+    ASSERT_THROW( io.GetImageData( data ), std::runtime_error );
+    ASSERT_EQ( mock.m_imageRequests, 0 );
+}
+
+TEST(AltaEthernetIo, Throughput)
+{
+    const size_t num = 3072 * 2048;
+    const int32_t rounds = 5;
+    MockAlta mock;
+    mock.m_chunked = false;
+    const std::vector<uint16_t> pixels = MkPixels( num );
+    mock.SetImage( pixels );
+
+    // the download as it was before streaming: whole frame into a string, then
+    // swapped. The stand-in serves one connection at a time, so this goes first.
+    std::vector<uint16_t> data( num );
+    double buffered = 1e9;
+    {
+        CLibCurlWrap curl;
+        for( int32_t r = 0; r < rounds; ++r )
+        {
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::string result;
+            curl.HttpGet( mock.Url() + "/UE/image.bin", result );
+            const uint8_t * in = reinterpret_cast<const uint8_t *>( result.data() );
+            for( size_t i = 0; i < num && 2*i+1 < result.size(); ++i )
+            {
+                data[i] = ( in[2*i] << 8 ) | in[2*i+1];
+            }
+            buffered = std::min( buffered, Seconds( start ) );
+        }
+    }
+    ASSERT_EQ( data, pixels );
+
+    AltaEthernetIo io( mock.Url() );
+    data.assign( num, 0 );
+
+    double streamed = 1e9;
+    for( int32_t r = 0; r < rounds; ++r )
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        io.GetImageData( data );
+        streamed = std::min( streamed, Seconds( start ) );
+    }
+    ASSERT_EQ( data, pixels );
+
+    const double mb = num * sizeof(uint16_t) / 1e6;
+    printf( "%zu pixels: streamed %.2f ms (%.0f MB/s), string then swap %.2f ms (%.0f MB/s)\n",
+        num, streamed * 1e3, mb / streamed, buffered * 1e3, mb / buffered );
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -43,11 +43,16 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <stdarg.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <pthread.h>
 
 #include <libusb.h>
 
 #define MAXRBUF 512
 
+// the image correction routines split the frame into horizontal bands, one per core
+#define FC_MAX_IMAGE_BANDS    8
+#define FC_MIN_ROWS_PER_BAND  64
+
 // globals
 struct libusb_context *gCtx;
 
@@ -1319,40 +1324,203 @@ float fcImage_IBIS_calcFirstBlackRowAverage(UInt16 *frameBufferPtr, int imageWid
     return retValue;
 }
 
-// routine which will subtract out the offset pedestal from the image.  It looks at the
-// first row of black pixels to determine the average of the row.  Then it subtracts out
-// that number from each pixel in the image.
-void fcImage_IBIS_subtractPedestal(UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
+// one horizontal band of an image being corrected.  Each band is handled by its own thread.
+// Rows [startRow, endRow) are written by the band.  Kernel filters also read 'half' rows on
+// either side, which may be rewritten concurrently by the neighbouring bands, so we keep a
+// copy of those in 'top' and 'bottom' before any thread starts.  Rows of our own band that
+// we have already overwritten are kept in the 'ring' of (half + 1) lines.
+typedef struct fcImageBand
+{
+    void (*kernel)(struct fcImageBand *band);
+    UInt16 *frame;
+    int width;
+    int startRow;
+    int endRow;
+    int half;
+    const int *colOffsets;
+    UInt16 *top;
+    UInt16 *bottom;
+    UInt16 *ring;
+    unsigned int *colSum;
+} fcImageBand;
+
+// return the number of bands to split 'numRows' rows of work into
+static int fcImage_numBands(int numRows)
+{
+    long numCpus;
+    int numBands;
+
+    numCpus  = sysconf(_SC_NPROCESSORS_ONLN);
+    numBands = numRows / FC_MIN_ROWS_PER_BAND;
+
+    if (numBands > numCpus)
+        numBands = (int)numCpus;
+
+    if (numBands > FC_MAX_IMAGE_BANDS)
+        numBands = FC_MAX_IMAGE_BANDS;
+
+    if (numBands < 1)
+        numBands = 1;
+
+    return numBands;
+}
+
+// make sure the camera's scratch area is at least 'size' bytes.  It only ever grows so that
+// we do not have to allocate and copy a whole frame for every image we filter
+static UInt8 *fcImage_getScratch(int camNum, size_t size)
+{
+    fc_Camera_Information *cam;
+    UInt8 *newScratch;
+
+    cam = &gCamerasFound[camNum - 1];
+    if (size > cam->imageScratchSize)
+    {
+        newScratch = (UInt8 *)realloc(cam->imageScratch, size);
+        if (newScratch == NULL)
+            return NULL;
+
+        cam->imageScratch     = newScratch;
+        cam->imageScratchSize = size;
+    }
+
+    return cam->imageScratch;
+}
+
+static void fcImage_freeScratch(int camNum)
+{
+    free(gCamerasFound[camNum - 1].imageScratch);
+    gCamerasFound[camNum - 1].imageScratch     = NULL;
+    gCamerasFound[camNum - 1].imageScratchSize = 0;
+}
+
+// split the rows [startRow, endRow) of the frame into bands and set up their scratch lines.
+// returns the number of bands, or 0 if we could not get the scratch memory we needed
+static int fcImage_setupBands(int camNum, fcImageBand *bands, void (*kernel)(fcImageBand *band), UInt16 *frame,
+                              int width, int startRow, int endRow, int half)
+{
+    int numBands, i;
+    int numRows;
+    size_t bandBytes;
+    UInt8 *scratch;
+    fcImageBand *band;
+
+    numRows  = endRow - startRow;
+    numBands = fcImage_numBands(numRows);
+
+    // column sums, ring lines and the two halos.  Rounded up to keep the next band aligned
+    bandBytes = 0;
+    if (half > 0)
+        bandBytes = ((width * sizeof(unsigned int)) + ((3 * half + 1) * width * sizeof(UInt16)) + 15) & ~(size_t)15;
+
+    scratch = NULL;
+    if (bandBytes != 0)
+    {
+        scratch = fcImage_getScratch(camNum, bandBytes * numBands);
+        if (scratch == NULL)
+            return 0;
+    }
+
+    for (i = 0; i < numBands; i++)
+    {
+        band             = &bands[i];
+        band->kernel     = kernel;
+        band->frame      = frame;
+        band->width      = width;
+        band->startRow   = startRow + (int)(((long)numRows * i) / numBands);
+        band->endRow     = startRow + (int)(((long)numRows * (i + 1)) / numBands);
+        band->half       = half;
+        band->colOffsets = NULL;
+        band->top        = NULL;
+        band->bottom     = NULL;
+        band->ring       = NULL;
+        band->colSum     = NULL;
+
+        if (bandBytes != 0)
+        {
+            band->colSum = (unsigned int *)(scratch + (bandBytes * i));
+            band->ring   = (UInt16 *)(band->colSum + width);
+            band->top    = band->ring + ((half + 1) * width);
+            band->bottom = band->top + (half * width);
+
+            // snapshot the rows around this band before anyone starts writing
+            memcpy(band->top, frame + ((band->startRow - half) * width), half * width * sizeof(UInt16));
+            memcpy(band->bottom, frame + (band->endRow * width), half * width * sizeof(UInt16));
+        }
+    }
+
+    return numBands;
+}
+
+// return the original contents of 'row' as seen by a band that has already written
+// every row before 'curRow'
+static const UInt16 *fcImage_bandSrcRow(const fcImageBand *band, int row, int curRow)
+{
+    if (row < band->startRow)
+        return band->top + ((row - (band->startRow - band->half)) * band->width);
+
+    if (row >= band->endRow)
+        return band->bottom + ((row - band->endRow) * band->width);
+
+    if (row < curRow)
+        return band->ring + ((row % (band->half + 1)) * band->width);
+
+    return band->frame + (row * band->width);
+}
+
+static void *fcImage_bandThread(void *arg)
+{
+    fcImageBand *band = (fcImageBand *)arg;
+
+    band->kernel(band);
+
+    return NULL;
+}
+
+// run every band's kernel.  The calling thread takes the first band itself
+static void fcImage_runBands(fcImageBand *bands, int numBands)
+{
+    pthread_t threads[FC_MAX_IMAGE_BANDS];
+    bool started[FC_MAX_IMAGE_BANDS];
+    int i;
+
+    for (i = 1; i < numBands; i++)
+    {
+        started[i] = (pthread_create(&threads[i], NULL, fcImage_bandThread, &bands[i]) == 0);
+
+        // if we could not get a thread just do the work here
+        if (!started[i])
+            bands[i].kernel(&bands[i]);
+    }
+
+    if (numBands > 0)
+        bands[0].kernel(&bands[0]);
+
+    for (i = 1; i < numBands; i++)
+    {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+    }
+}
+
+// add the per column offset to every pixel of the band, clamping to the 16 bit range
+static void fcImage_colOffsetBand(fcImageBand *band)
 {
-    //float reference;
     int row, col;
-    UInt16 *inputPtr;
-    UInt16 aPixel;
-    SInt32 bigPixel;
-    SInt32 thePedestal;
-    //float rowAvg;
-    //float thisColBlack;
-    //float minRowAvg;
-    //float colAvg;
-    float frameAvg;
-    //float rowOffset;
-    //float colOffset;
-    //float floatPixel;
+    int width;
+    UInt16 *rowPtr;
+    const int *colOffsets;
+    int bigPixel;
 
-    // calculate the average of all the black pixels in the first row
-    frameAvg    = fcImage_IBIS_calcFirstBlackRowAverage(frameBufferPtr, imageWidth, imageHeight);
-    thePedestal = (SInt32)frameAvg;
+    width      = band->width;
+    colOffsets = band->colOffsets;
 
-    // don't touch the black row.  Start at row '1'
-    inputPtr = frameBufferPtr;
-    inputPtr = inputPtr + imageWidth;
-    for (col = 0; col < imageWidth; col++)
+    for (row = band->startRow; row < band->endRow; row++)
     {
-        for (row = 1; row < imageHeight; row++)
+        rowPtr = band->frame + (row * width);
+
+        for (col = 0; col < width; col++)
         {
-            aPixel   = *inputPtr;
-            bigPixel = (SInt32)aPixel;
-            bigPixel = bigPixel - thePedestal;
+            bigPixel = (int)rowPtr[col] + colOffsets[col];
 
             if (bigPixel > 65535)
                 bigPixel = 65535;
@@ -1360,15 +1528,58 @@ void fcImage_IBIS_subtractPedestal(UInt16 *frameBufferPtr, int imageWidth, int i
             if (bigPixel < 0)
                 bigPixel = 0;
 
-            // put corrected value back
-            *inputPtr = (UInt16)bigPixel;
-
-            // point to next
-            inputPtr++;
+            rowPtr[col] = (UInt16)bigPixel;
         }
     }
 }
 
+// apply 'colOffsets' to rows [startRow, imageHeight) of the image.  The offsets are plain ints
+// rather than SInt32 (a long) so that the compiler can vectorise the loop
+static void fcImage_applyColOffsets(int camNum, UInt16 *frameBufferPtr, int imageWidth, int startRow,
+                                    int imageHeight, const int *colOffsets)
+{
+    fcImageBand bands[FC_MAX_IMAGE_BANDS];
+    int numBands, i;
+
+    if (startRow >= imageHeight || imageWidth <= 0)
+        return;
+
+    numBands = fcImage_setupBands(camNum, bands, fcImage_colOffsetBand, frameBufferPtr, imageWidth, startRow,
+                                  imageHeight, 0);
+
+    for (i = 0; i < numBands; i++)
+        bands[i].colOffsets = colOffsets;
+
+    fcImage_runBands(bands, numBands);
+}
+
+// routine which will subtract out the offset pedestal from the image.  It looks at the
+// first row of black pixels to determine the average of the row.  Then it subtracts out
+// that number from each pixel in the image.
+void fcImage_IBIS_subtractPedestal(int camNum, UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
+{
+    SInt32 thePedestal;
+    float frameAvg;
+    int *colOffsets;
+    int col;
+
+    // calculate the average of all the black pixels in the first row
+    frameAvg    = fcImage_IBIS_calcFirstBlackRowAverage(frameBufferPtr, imageWidth, imageHeight);
+    thePedestal = (SInt32)frameAvg;
+
+    colOffsets = (int *)malloc(imageWidth * sizeof(int));
+    if (colOffsets == NULL)
+        return;
+
+    for (col = 0; col < imageWidth; col++)
+        colOffsets[col] = (int)-thePedestal;
+
+    // don't touch the black row.  Start at row '1'
+    fcImage_applyColOffsets(camNum, frameBufferPtr, imageWidth, 1, imageHeight, colOffsets);
+
+    free(colOffsets);
+}
+
 // this routine is called everytime the gain setting is changed on the IBIS1300 image sensor.  I takes 8 frames
 // and stores the average of the first black row of pixels in the sensor.  The resulting vector is then used
 // to normalize the columns everytime a new image is readout.
@@ -1432,25 +1643,12 @@ void fcImage_IBIS_computeAvgColOffsets(int camNum)
 // Used to get rid of the camera's fixed pattern noise associated with COLs
 // enter with pointer to 16 bit image
 //
-void fcImage_IBIS_doFullFrameColLevelNormalization(UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
+void fcImage_IBIS_doFullFrameColLevelNormalization(int camNum, UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
 {
-    //float reference;
-    int row, col;
-    UInt16 *inputPtr;
-    UInt16 aPixel;
-    //float rowAvg;
-    SInt32 thisColBlack;
-    //float minRowAvg;
-    //float colAvg;
+    int col;
     float frameAvg;
-    //float rowOffset;
-    SInt32 colOffset;
-    //float floatPixel;
     SInt32 blackAvg;
-    SInt32 bigPixel;
-    //SInt32 theOffset;
-
-    // make sure we are dealing with 16 bit pixels
+    int *colOffsets;
 
     //	printf("fcImage_IBIS_doFullFrameColLevelNormalization\n");
 
@@ -1458,34 +1656,18 @@ void fcImage_IBIS_doFullFrameColLevelNormalization(UInt16 *frameBufferPtr, int i
     frameAvg = fcImage_IBIS_calcFirstBlackRowAverage(frameBufferPtr, imageWidth, imageHeight);
     blackAvg = (SInt32)frameAvg;
 
-    for (col = 0; col < imageWidth; col++)
-    {
-        // first get this cols black pixel from the first row of the image
-        thisColBlack = gBlackOffsets[col];
-
-        colOffset = blackAvg - thisColBlack;
-
-        for (row = 1; row < imageHeight; row++)
-        {
-            // get the pixel for this row/col
-            inputPtr = frameBufferPtr;
-            inputPtr = inputPtr + (row * imageWidth) + col;
-            aPixel   = *inputPtr;
-            bigPixel = (SInt32)aPixel;
-
-            // normalize
-            bigPixel = bigPixel + colOffset;
+    colOffsets = (int *)malloc(imageWidth * sizeof(int));
+    if (colOffsets == NULL)
+        return;
 
-            if (bigPixel > 65535)
-                bigPixel = 65535;
+    // each col is pulled to the average of the black pixels in the first row of the image
+    for (col = 0; col < imageWidth; col++)
+        colOffsets[col] = (int)(blackAvg - gBlackOffsets[col]);
 
-            if (bigPixel < 0)
-                bigPixel = 0;
+    // don't touch the black row.  Start at row '1'
+    fcImage_applyColOffsets(camNum, frameBufferPtr, imageWidth, 1, imageHeight, colOffsets);
 
-            // put corrected value back
-            *inputPtr = (UInt16)bigPixel;
-        }
-    }
+    free(colOffsets);
 }
 
 // routine to compute the column level offsets in the image.
@@ -1559,20 +1741,10 @@ void fcImage_PRO_calcColOffsets(UInt16 *frameBufferPtr, int imageWidth, int imag
 // Used to get rid of the sensor's fixed pattern noise associated with COLs
 // enter with pointer to 16 bit image
 //
-void fcImage_PRO_doFullFrameColLevelNormalization(UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
+void fcImage_PRO_doFullFrameColLevelNormalization(int camNum, UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
 {
-    //float reference;
-    int row, col;
-    UInt16 *inputPtr;
-    UInt16 aPixel;
-    //float rowAvg;
-    //float thisRowAvg;
-    //float minRowAvg;
-    //float colAvg;
-    //float frameAvg;
-    //float rowOffset;
-    float colOffset;
-    float floatPixel;
+    int *colOffsets;
+    int col;
 
     //	printf("fcImage_PRO_doFullFrameColLevelNormalization\n");
     Starfish_Log("fcImage_PRO_doFullFrameColLevelNormalization\n");
@@ -1580,32 +1752,17 @@ void fcImage_PRO_doFullFrameColLevelNormalization(UInt16 *frameBufferPtr, int im
     // calculate the average of all the black pixels in the vertical overscan area
     //	fcImage_PRO_calcColOffsets(frameBufferPtr, imageWidth, imageHeight);
 
-    for (row = 0; row < imageHeight; row++)
-    {
-        inputPtr = frameBufferPtr;
-        inputPtr = inputPtr + (row * imageWidth);
-        for (col = 0; col < imageWidth; col++)
-        {
-            // get the next pixel
-            aPixel = *inputPtr;
-
-            // get the offset for this column
-            colOffset = (float)gProBlackColOffsets[col];
-
-            floatPixel = (float)aPixel;
-
-            floatPixel -= colOffset;
+    colOffsets = (int *)malloc(imageWidth * sizeof(int));
+    if (colOffsets == NULL)
+        return;
 
-            if (floatPixel > 65535.0)
-                floatPixel = 65535.0;
+    // the offsets are whole numbers so integer math gives the same result as subtracting in float
+    for (col = 0; col < imageWidth; col++)
+        colOffsets[col] = (int)-gProBlackColOffsets[col];
 
-            if (floatPixel < 0.0)
-                floatPixel = 0.0;
+    fcImage_applyColOffsets(camNum, frameBufferPtr, imageWidth, 0, imageHeight, colOffsets);
 
-            // put corrected value back
-            *inputPtr++ = (UInt16)floatPixel;
-        }
-    }
+    free(colOffsets);
 }
 
 // this routine is used internally to calibrate the PRO series cameras.  We do this each time
@@ -1667,152 +1824,160 @@ void fcImage_PRO_calibrateProCamera(int camNum, UInt16 *frameBufferPtr, int imag
     gProWantColNormalization = savedWantNorm;
 }
 
-// routine to perform a 3x3 kernel filter on the image buffer
-//
-void fcImage_do_3x3_kernel(UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer)
+// box filter one band of the image.  The vertical sums of each column are kept in colSum
+// and rolled down one row at a time, so each output pixel only costs a horizontal sum.
+// The sums are plain unsigned ints, 25 pixels of 16 bits easily fit.
+static inline void fcImage_boxFilterBand(fcImageBand *band, int half)
 {
-    //float reference;
-    int row, col;
-    UInt16 *inputPtr;
+    int row, col, i;
+    int width;
+    unsigned int kernelSize;
+    unsigned int *colSum;
+    unsigned int accumPixel;
+    const UInt16 *addRow;
+    const UInt16 *subRow;
     UInt16 *outputPtr;
-    UInt16 aPixel;
-    UInt32 accumPixel;
-    UInt16 *tempBuffer;
-    size_t size;
 
-    // this routine will work 'in place'.  We will first allocate a temporary image buffer
-    // we copy the image to it and then fill the original buffer with the filtered image
-    //
-    size       = imageWidth * imageHeight * 2; // 2 bytes/pixel
-    tempBuffer = (UInt16 *)malloc(size);
+    width      = band->width;
+    colSum     = band->colSum;
+    kernelSize = (unsigned int)((2 * half + 1) * (2 * half + 1));
 
-    if (tempBuffer != NULL)
+    // sum up the rows around the first row of the band
+    memset(colSum, 0, width * sizeof(unsigned int));
+    for (row = band->startRow - half; row <= band->startRow + half; row++)
     {
-        // copy the image buffer to my local storage
-        memcpy(tempBuffer, frameBuffer, size);
+        addRow = fcImage_bandSrcRow(band, row, band->startRow);
+        for (col = 0; col < width; col++)
+            colSum[col] += addRow[col];
+    }
 
-        // Start at row '1'
-        for (row = 1; row < (imageHeight - 1); row++)
+    for (row = band->startRow; row < band->endRow; row++)
+    {
+        // roll the column sums down a row
+        if (row > band->startRow)
         {
-            for (col = 1; col < (imageWidth - 1); col++)
-            {
-                inputPtr  = tempBuffer;
-                inputPtr  = inputPtr + (row * imageWidth) + col;
-                outputPtr = frameBuffer;
-                outputPtr = outputPtr + (row * imageWidth) + col;
-
-                accumPixel = 0;
-
-                inputPtr   = inputPtr - imageWidth - 1; // 1
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
+            addRow = fcImage_bandSrcRow(band, row + half, row);
+            subRow = fcImage_bandSrcRow(band, row - half - 1, row);
+            for (col = 0; col < width; col++)
+                colSum[col] = colSum[col] + addRow[col] - subRow[col];
+        }
 
-                inputPtr++; // 2
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
+        // keep the original row around, we are about to overwrite it
+        outputPtr = band->frame + (row * width);
+        memcpy(band->ring + ((row % (half + 1)) * width), outputPtr, width * sizeof(UInt16));
 
-                inputPtr++; // 3
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
+        for (col = half; col < (width - half); col++)
+        {
+            accumPixel = 0;
+            for (i = -half; i <= half; i++)
+                accumPixel += colSum[col + i];
 
-                inputPtr   = inputPtr + imageWidth - 2; // 4
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
+            // divide by the kernel size
+            outputPtr[col] = (UInt16)(accumPixel / kernelSize);
+        }
+    }
+}
 
-                inputPtr++; // 5
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
+static void fcImage_3x3Band(fcImageBand *band)
+{
+    fcImage_boxFilterBand(band, 1);
+}
 
-                inputPtr++; // 6
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
+static void fcImage_5x5Band(fcImageBand *band)
+{
+    fcImage_boxFilterBand(band, 2);
+}
 
-                inputPtr   = inputPtr + imageWidth - 2; // 7
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
+// routine to perform a 3x3 kernel filter on the image buffer
+//
+void fcImage_do_3x3_kernel(int camNum, UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer)
+{
+    fcImageBand bands[FC_MAX_IMAGE_BANDS];
+    int numBands;
 
-                inputPtr++; // 8
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
+    if (imageHeight < 3 || imageWidth < 3)
+        return;
 
-                inputPtr++; // 9
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
+    // the border pixels are left alone.  Start at row '1'
+    numBands = fcImage_setupBands(camNum, bands, fcImage_3x3Band, frameBuffer, imageWidth, 1, imageHeight - 1, 1);
+    fcImage_runBands(bands, numBands);
+}
 
-                // divide by the kernel size
-                accumPixel = accumPixel / 9;
+// routine to perform a 5x5 kernel filter on the image buffer
+//
+void fcImage_do_5x5_kernel(int camNum, UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer)
+{
+    fcImageBand bands[FC_MAX_IMAGE_BANDS];
+    int numBands;
 
-                // put filtered value back
-                *outputPtr = (UInt16)accumPixel;
-            }
-        }
+    if (imageHeight < 5 || imageWidth < 5)
+        return;
 
-        free(tempBuffer);
-    }
+    // the border pixels are left alone.  Start at row '2'
+    numBands = fcImage_setupBands(camNum, bands, fcImage_5x5Band, frameBuffer, imageWidth, 2, imageHeight - 2, 2);
+    fcImage_runBands(bands, numBands);
 }
 
-// routine to perform a 5x5 kernel filter on the image buffer
-//
-void fcImage_do_5x5_kernel(UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer)
+static void fcImage_hotPixelBand(fcImageBand *band)
 {
-    //float reference;
+    float floatBrightPixel;
+    float floatCenterPixel;
     int row, col;
-    UInt16 *inputPtr;
+    int width;
+    const UInt16 *above;
+    const UInt16 *center;
+    const UInt16 *below;
     UInt16 *outputPtr;
-    UInt16 aPixel;
-    UInt32 accumPixel;
-    UInt16 *tempBuffer;
-    size_t size;
-    int x, y;
+    unsigned int accumPixel;
+    UInt16 brightestNeighbor;
 
-    // this routine will work 'in place'.  We will first allocate a temporary image buffer
-    // we copy the image to it and then fill the original buffer with the filtered image
-    //
-    size       = imageWidth * imageHeight * 2; // 2 bytes/pixel
-    tempBuffer = (UInt16 *)malloc(size);
+    width = band->width;
 
-    if (tempBuffer != NULL)
+    for (row = band->startRow; row < band->endRow; row++)
     {
-        // copy the image buffer to my local storage
-        memcpy(tempBuffer, frameBuffer, size);
+        // keep the original row around, we are about to overwrite it
+        outputPtr = band->frame + (row * width);
+        memcpy(band->ring + ((row % 2) * width), outputPtr, width * sizeof(UInt16));
+
+        above  = fcImage_bandSrcRow(band, row - 1, row + 1);
+        center = fcImage_bandSrcRow(band, row, row + 1);
+        below  = fcImage_bandSrcRow(band, row + 1, row + 1);
 
-        // Start at row '2'
-        for (row = 2; row < (imageHeight - 2); row++)
+        for (col = 1; col < (width - 1); col++)
         {
-            for (col = 2; col < (imageWidth - 2); col++)
+            accumPixel = (unsigned int)above[col - 1] + above[col] + above[col + 1] + center[col - 1] +
+                         center[col + 1] + below[col - 1] + below[col] + below[col + 1];
+
+            brightestNeighbor = above[col - 1];
+            if (brightestNeighbor < above[col])
+                brightestNeighbor = above[col];
+            if (brightestNeighbor < above[col + 1])
+                brightestNeighbor = above[col + 1];
+            if (brightestNeighbor < center[col - 1])
+                brightestNeighbor = center[col - 1];
+            if (brightestNeighbor < center[col + 1])
+                brightestNeighbor = center[col + 1];
+            if (brightestNeighbor < below[col - 1])
+                brightestNeighbor = below[col - 1];
+            if (brightestNeighbor < below[col])
+                brightestNeighbor = below[col];
+            if (brightestNeighbor < below[col + 1])
+                brightestNeighbor = below[col + 1];
+
+            // divide by the number of surrounding pixels
+            accumPixel = accumPixel / 8;
+
+            floatBrightPixel = (float)brightestNeighbor;
+            floatBrightPixel = floatBrightPixel * 1.2;
+
+            floatCenterPixel = (float)center[col];
+
+            if (floatCenterPixel > floatBrightPixel)
             {
-                inputPtr  = tempBuffer;
-                inputPtr  = inputPtr + (row * imageWidth) + col;
-                outputPtr = frameBuffer;
-                outputPtr = outputPtr + (row * imageWidth) + col;
-
-                accumPixel = 0;
-
-                inputPtr = inputPtr - (3 * imageWidth) + 2;
-
-                for (y = 0; y < 5; y++)
-                {
-                    inputPtr   = inputPtr + imageWidth - 4;
-                    aPixel     = *inputPtr;
-                    accumPixel = accumPixel + (UInt32)aPixel;
-
-                    for (x = 0; x < 4; x++)
-                    {
-                        inputPtr++;
-                        aPixel     = *inputPtr;
-                        accumPixel = accumPixel + (UInt32)aPixel;
-                    }
-                }
-
-                // divide by the kernel size
-                accumPixel = accumPixel / 25;
-
-                // put filtered value back
-                *outputPtr = (UInt16)accumPixel;
+                // substitute average
+                outputPtr[col] = (UInt16)accumPixel;
             }
         }
-
-        free(tempBuffer);
     }
 }
 
@@ -1822,120 +1987,17 @@ void fcImage_do_5x5_kernel(UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameB
 // brighter than the brightest of the neigboring pixels.  If it is
 // then it will replace it with the average of the neighboring pixels.
 //
-void fcImage_do_hotPixel_kernel(UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer)
+void fcImage_do_hotPixel_kernel(int camNum, UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer)
 {
-    float floatBrightPixel;
-    float floatCenterPixel;
-    int row, col;
-    UInt16 *inputPtr;
-    UInt16 *outputPtr;
-    UInt16 aPixel;
-    UInt32 accumPixel;
-    UInt16 *tempBuffer;
-    size_t size;
-    UInt16 brightestNeighbor;
-    UInt16 thisPixel;
-    int numHotPixels;
+    fcImageBand bands[FC_MAX_IMAGE_BANDS];
+    int numBands;
 
-    // this routine will work 'in place'.  We will first allocate a temporary image buffer
-    // we copy the image to it and then fill the original buffer with the filtered image
-    //
-    size       = imageWidth * imageHeight * 2; // 2 bytes/pixel
-    tempBuffer = (UInt16 *)malloc(size);
-
-    if (tempBuffer != NULL)
-    {
-        numHotPixels = 0;
-
-        // copy the image buffer to my local storage
-        memcpy(tempBuffer, frameBuffer, size);
-
-        // Start at row '1'
-        for (row = 1; row < (imageHeight - 1); row++)
-        {
-            for (col = 1; col < (imageWidth - 1); col++)
-            {
-                inputPtr  = tempBuffer;
-                inputPtr  = inputPtr + (row * imageWidth) + col;
-                outputPtr = frameBuffer;
-                outputPtr = outputPtr + (row * imageWidth) + col;
-
-                accumPixel        = 0;
-                brightestNeighbor = 0;
-
-                inputPtr   = inputPtr - imageWidth - 1; // 1
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr++; // 2
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr++; // 3
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr   = inputPtr + imageWidth - 2; // 4
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr++; // 5 - center pixel
-                aPixel    = *inputPtr;
-                thisPixel = aPixel;
-
-                inputPtr++; // 6
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr   = inputPtr + imageWidth - 2; // 7
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr++; // 8
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr++; // 9
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                // divide by the number of surrounding pixels
-                accumPixel = accumPixel / 8;
-
-                floatBrightPixel = (float)brightestNeighbor;
-                floatBrightPixel = floatBrightPixel * 1.2;
-
-                floatCenterPixel = (float)thisPixel;
-
-                if (floatCenterPixel > floatBrightPixel)
-                {
-                    numHotPixels++;
-                    // substitute average
-                    *outputPtr = (UInt16)accumPixel;
-                }
-            }
-        }
-
-        free(tempBuffer);
-    }
+    if (imageHeight < 3 || imageWidth < 3)
+        return;
 
-    //	Starfish_LogFmt("fcImage_do_hotPixel_kernel numHotPixels = %d\n", numHotPixels);
+    // Start at row '1'
+    numBands = fcImage_setupBands(camNum, bands, fcImage_hotPixelBand, frameBuffer, imageWidth, 1, imageHeight - 1, 1);
+    fcImage_runBands(bands, numBands);
 }
 
 // This is the framework initialization routine and needs to be called once upon application startup
@@ -2040,6 +2102,8 @@ void fcUsb_close(void)
 
     for (i = 0; i < kNumCamsSupported; i++)
     {
+        fcImage_freeScratch(i + 1);
+
         gCamerasFound[i].camVendor       = 0;
         gCamerasFound[i].camRawProduct   = 0;
         gCamerasFound[i].camFinalProduct = 0;
@@ -2630,6 +2694,8 @@ int fcUsb_OpenCamera(int camNum)
 //
 int fcUsb_CloseCamera(int camNum)
 {
+    fcImage_freeScratch(camNum);
+
     if (gDoSimulation)
         return 0;
 
@@ -3784,7 +3850,7 @@ int fcUsb_cmd_getRawFrame(int camNum, UInt16 numRows, UInt16 numCols, UInt16 *fr
         
 
         if (gProWantColNormalization)
-            fcImage_PRO_doFullFrameColLevelNormalization(frameBuffer, numCols, numRows);
+            fcImage_PRO_doFullFrameColLevelNormalization(camNum, frameBuffer, numCols, numRows);
     }
     else
     {
@@ -3793,8 +3859,8 @@ int fcUsb_cmd_getRawFrame(int camNum, UInt16 numRows, UInt16 numCols, UInt16 *fr
             maxBytes     = numRows * numCols * 2; // 2 bytes / pixel
             numBytesRead = RcvUSB(camNum, (unsigned char *)&frameBuffer, maxBytes);
 
-            fcImage_IBIS_doFullFrameColLevelNormalization(frameBuffer, numCols, numRows);
-            fcImage_IBIS_subtractPedestal(frameBuffer, numCols, numRows);
+            fcImage_IBIS_doFullFrameColLevelNormalization(camNum, frameBuffer, numCols, numRows);
+            fcImage_IBIS_subtractPedestal(camNum, frameBuffer, numCols, numRows);
         }
         else
         {
@@ -3823,19 +3889,19 @@ int fcUsb_cmd_getRawFrame(int camNum, UInt16 numRows, UInt16 numCols, UInt16 *fr
     if (gCameraImageFilter[camNum - 1] == fc_filter_3x3)
     {
         // perform 3x3 kernel filter
-        fcImage_do_3x3_kernel(numRows, numCols, frameBuffer);
+        fcImage_do_3x3_kernel(camNum, numRows, numCols, frameBuffer);
     }
 
     if (gCameraImageFilter[camNum - 1] == fc_filter_5x5)
     {
         // perform 5x5 kernel filter
-        fcImage_do_5x5_kernel(numRows, numCols, frameBuffer);
+        fcImage_do_5x5_kernel(camNum, numRows, numCols, frameBuffer);
     }
 
     if (gCameraImageFilter[camNum - 1] == fc_filter_hotPixel)
     {
         // perform hot pixel removal filter
-        fcImage_do_hotPixel_kernel(numRows, numCols, frameBuffer);
+        fcImage_do_hotPixel_kernel(camNum, numRows, numCols, frameBuffer);
     }
 
     return (numBytesRead);
@@ -273,6 +273,8 @@ typedef struct {
     UInt16	camRelease;					// camera serial number
 //	CCyUSBDevice	**camUsbIntfc;		// handle to this camera
 	struct libusb_device_handle *dev;	// handle to this camera
+	UInt8	*imageScratch;				// scratch space of the image correction routines, only ever grows
+	size_t	imageScratchSize;
  	} fc_Camera_Information;
 
 
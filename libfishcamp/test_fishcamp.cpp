@@ -0,0 +1,695 @@
+/*
+ Golden tests of the banded image corrections in libfishcamp: every routine must give
+ exactly the output of the straightforward per pixel code it replaced, whatever the
+ number of bands the frame is split into.
+*/
+
+#include <gtest/gtest.h>
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "fishcamp_common.h"
+
+extern "C"
+{
+    extern SInt32 gBlackOffsets[1280];
+    extern SInt32 gProBlackColOffsets[4096];
+    extern fc_Camera_Information gCamerasFound[kNumCamsSupported];
+
+    float fcImage_IBIS_calcFirstBlackRowAverage(UInt16 *frameBufferPtr, int imageWidth, int imageHeight);
+    void fcImage_IBIS_subtractPedestal(int camNum, UInt16 *frameBufferPtr, int imageWidth, int imageHeight);
+    void fcImage_IBIS_doFullFrameColLevelNormalization(int camNum, UInt16 *frameBufferPtr, int imageWidth, int imageHeight);
+    void fcImage_PRO_doFullFrameColLevelNormalization(int camNum, UInt16 *frameBufferPtr, int imageWidth, int imageHeight);
+    void fcImage_do_3x3_kernel(int camNum, UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer);
+    void fcImage_do_5x5_kernel(int camNum, UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer);
+    void fcImage_do_hotPixel_kernel(int camNum, UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer);
+    int fcUsb_CloseCamera(int camNum);
+
+    // The number of bands follows the number of online CPUs. Answer for them here so that
+    // every band count is exercised whatever machine the tests run on.
+    static long fakeCpus = 0;
+
+    long sysconf(int name)
+    {
+        typedef long (*sysconf_t)(int);
+        static sysconf_t realSysconf = (sysconf_t)dlsym(RTLD_NEXT, "sysconf");
+
+        if (name == _SC_NPROCESSORS_ONLN && fakeCpus > 0)
+            return fakeCpus;
+
+        return realSysconf(name);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// The corrections as they were before banding, unchanged apart from their names
+
+static void old_fcImage_IBIS_subtractPedestal(UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
+{
+    //float reference;
+    int row, col;
+    UInt16 *inputPtr;
+    UInt16 aPixel;
+    SInt32 bigPixel;
+    SInt32 thePedestal;
+    //float rowAvg;
+    //float thisColBlack;
+    //float minRowAvg;
+    //float colAvg;
+    float frameAvg;
+    //float rowOffset;
+    //float colOffset;
+    //float floatPixel;
+
+    // calculate the average of all the black pixels in the first row
+    frameAvg    = fcImage_IBIS_calcFirstBlackRowAverage(frameBufferPtr, imageWidth, imageHeight);
+    thePedestal = (SInt32)frameAvg;
+
+    // don't touch the black row.  Start at row '1'
+    inputPtr = frameBufferPtr;
+    inputPtr = inputPtr + imageWidth;
+    for (col = 0; col < imageWidth; col++)
+    {
+        for (row = 1; row < imageHeight; row++)
+        {
+            aPixel   = *inputPtr;
+            bigPixel = (SInt32)aPixel;
+            bigPixel = bigPixel - thePedestal;
+
+            if (bigPixel > 65535)
+                bigPixel = 65535;
+
+            if (bigPixel < 0)
+                bigPixel = 0;
+
+            // put corrected value back
+            *inputPtr = (UInt16)bigPixel;
+
+            // point to next
+            inputPtr++;
+        }
+    }
+}
+
+static void old_fcImage_IBIS_doFullFrameColLevelNormalization(UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
+{
+    //float reference;
+    int row, col;
+    UInt16 *inputPtr;
+    UInt16 aPixel;
+    //float rowAvg;
+    SInt32 thisColBlack;
+    //float minRowAvg;
+    //float colAvg;
+    float frameAvg;
+    //float rowOffset;
+    SInt32 colOffset;
+    //float floatPixel;
+    SInt32 blackAvg;
+    SInt32 bigPixel;
+    //SInt32 theOffset;
+
+    // make sure we are dealing with 16 bit pixels
+
+    //	printf("fcImage_IBIS_doFullFrameColLevelNormalization\n");
+
+    // calculate the average of all the black pixels
+    frameAvg = fcImage_IBIS_calcFirstBlackRowAverage(frameBufferPtr, imageWidth, imageHeight);
+    blackAvg = (SInt32)frameAvg;
+
+    for (col = 0; col < imageWidth; col++)
+    {
+        // first get this cols black pixel from the first row of the image
+        thisColBlack = gBlackOffsets[col];
+
+        colOffset = blackAvg - thisColBlack;
+
+        for (row = 1; row < imageHeight; row++)
+        {
+            // get the pixel for this row/col
+            inputPtr = frameBufferPtr;
+            inputPtr = inputPtr + (row * imageWidth) + col;
+            aPixel   = *inputPtr;
+            bigPixel = (SInt32)aPixel;
+
+            // normalize
+            bigPixel = bigPixel + colOffset;
+
+            if (bigPixel > 65535)
+                bigPixel = 65535;
+
+            if (bigPixel < 0)
+                bigPixel = 0;
+
+            // put corrected value back
+            *inputPtr = (UInt16)bigPixel;
+        }
+    }
+}
+
+static void old_fcImage_PRO_doFullFrameColLevelNormalization(UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
+{
+    //float reference;
+    int row, col;
+    UInt16 *inputPtr;
+    UInt16 aPixel;
+    //float rowAvg;
+    //float thisRowAvg;
+    //float minRowAvg;
+    //float colAvg;
+    //float frameAvg;
+    //float rowOffset;
+    float colOffset;
+    float floatPixel;
+
+    //	printf("fcImage_PRO_doFullFrameColLevelNormalization\n");
+
+    // calculate the average of all the black pixels in the vertical overscan area
+    //	fcImage_PRO_calcColOffsets(frameBufferPtr, imageWidth, imageHeight);
+
+    for (row = 0; row < imageHeight; row++)
+    {
+        inputPtr = frameBufferPtr;
+        inputPtr = inputPtr + (row * imageWidth);
+        for (col = 0; col < imageWidth; col++)
+        {
+            // get the next pixel
+            aPixel = *inputPtr;
+
+            // get the offset for this column
+            colOffset = (float)gProBlackColOffsets[col];
+
+            floatPixel = (float)aPixel;
+
+            floatPixel -= colOffset;
+
+            if (floatPixel > 65535.0)
+                floatPixel = 65535.0;
+
+            if (floatPixel < 0.0)
+                floatPixel = 0.0;
+
+            // put corrected value back
+            *inputPtr++ = (UInt16)floatPixel;
+        }
+    }
+}
+
+static void old_fcImage_do_3x3_kernel(UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer)
+{
+    //float reference;
+    int row, col;
+    UInt16 *inputPtr;
+    UInt16 *outputPtr;
+    UInt16 aPixel;
+    UInt32 accumPixel;
+    UInt16 *tempBuffer;
+    size_t size;
+
+    // this routine will work 'in place'.  We will first allocate a temporary image buffer
+    // we copy the image to it and then fill the original buffer with the filtered image
+    //
+    size       = imageWidth * imageHeight * 2; // 2 bytes/pixel
+    tempBuffer = (UInt16 *)malloc(size);
+
+    if (tempBuffer != NULL)
+    {
+        // copy the image buffer to my local storage
+        memcpy(tempBuffer, frameBuffer, size);
+
+        // Start at row '1'
+        for (row = 1; row < (imageHeight - 1); row++)
+        {
+            for (col = 1; col < (imageWidth - 1); col++)
+            {
+                inputPtr  = tempBuffer;
+                inputPtr  = inputPtr + (row * imageWidth) + col;
+                outputPtr = frameBuffer;
+                outputPtr = outputPtr + (row * imageWidth) + col;
+
+                accumPixel = 0;
+
+                inputPtr   = inputPtr - imageWidth - 1; // 1
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+
+                inputPtr++; // 2
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+
+                inputPtr++; // 3
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+
+                inputPtr   = inputPtr + imageWidth - 2; // 4
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+
+                inputPtr++; // 5
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+
+                inputPtr++; // 6
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+
+                inputPtr   = inputPtr + imageWidth - 2; // 7
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+
+                inputPtr++; // 8
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+
+                inputPtr++; // 9
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+
+                // divide by the kernel size
+                accumPixel = accumPixel / 9;
+
+                // put filtered value back
+                *outputPtr = (UInt16)accumPixel;
+            }
+        }
+
+        free(tempBuffer);
+    }
+}
+
+static void old_fcImage_do_5x5_kernel(UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer)
+{
+    //float reference;
+    int row, col;
+    UInt16 *inputPtr;
+    UInt16 *outputPtr;
+    UInt16 aPixel;
+    UInt32 accumPixel;
+    UInt16 *tempBuffer;
+    size_t size;
+    int x, y;
+
+    // this routine will work 'in place'.  We will first allocate a temporary image buffer
+    // we copy the image to it and then fill the original buffer with the filtered image
+    //
+    size       = imageWidth * imageHeight * 2; // 2 bytes/pixel
+    tempBuffer = (UInt16 *)malloc(size);
+
+    if (tempBuffer != NULL)
+    {
+        // copy the image buffer to my local storage
+        memcpy(tempBuffer, frameBuffer, size);
+
+        // Start at row '2'
+        for (row = 2; row < (imageHeight - 2); row++)
+        {
+            for (col = 2; col < (imageWidth - 2); col++)
+            {
+                inputPtr  = tempBuffer;
+                inputPtr  = inputPtr + (row * imageWidth) + col;
+                outputPtr = frameBuffer;
+                outputPtr = outputPtr + (row * imageWidth) + col;
+
+                accumPixel = 0;
+
+                inputPtr = inputPtr - (3 * imageWidth) + 2;
+
+                for (y = 0; y < 5; y++)
+                {
+                    inputPtr   = inputPtr + imageWidth - 4;
+                    aPixel     = *inputPtr;
+                    accumPixel = accumPixel + (UInt32)aPixel;
+
+                    for (x = 0; x < 4; x++)
+                    {
+                        inputPtr++;
+                        aPixel     = *inputPtr;
+                        accumPixel = accumPixel + (UInt32)aPixel;
+                    }
+                }
+
+                // divide by the kernel size
+                accumPixel = accumPixel / 25;
+
+                // put filtered value back
+                *outputPtr = (UInt16)accumPixel;
+            }
+        }
+
+        free(tempBuffer);
+    }
+}
+
+static void old_fcImage_do_hotPixel_kernel(UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer)
+{
+    float floatBrightPixel;
+    float floatCenterPixel;
+    int row, col;
+    UInt16 *inputPtr;
+    UInt16 *outputPtr;
+    UInt16 aPixel;
+    UInt32 accumPixel;
+    UInt16 *tempBuffer;
+    size_t size;
+    UInt16 brightestNeighbor;
+    UInt16 thisPixel;
+    int numHotPixels;
+
+    // this routine will work 'in place'.  We will first allocate a temporary image buffer
+    // we copy the image to it and then fill the original buffer with the filtered image
+    //
+    size       = imageWidth * imageHeight * 2; // 2 bytes/pixel
+    tempBuffer = (UInt16 *)malloc(size);
+
+    if (tempBuffer != NULL)
+    {
+        numHotPixels = 0;
+
+        // copy the image buffer to my local storage
+        memcpy(tempBuffer, frameBuffer, size);
+
+        // Start at row '1'
+        for (row = 1; row < (imageHeight - 1); row++)
+        {
+            for (col = 1; col < (imageWidth - 1); col++)
+            {
+                inputPtr  = tempBuffer;
+                inputPtr  = inputPtr + (row * imageWidth) + col;
+                outputPtr = frameBuffer;
+                outputPtr = outputPtr + (row * imageWidth) + col;
+
+                accumPixel        = 0;
+                brightestNeighbor = 0;
+
+                inputPtr   = inputPtr - imageWidth - 1; // 1
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+                if (brightestNeighbor < aPixel)
+                    brightestNeighbor = aPixel;
+
+                inputPtr++; // 2
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+                if (brightestNeighbor < aPixel)
+                    brightestNeighbor = aPixel;
+
+                inputPtr++; // 3
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+                if (brightestNeighbor < aPixel)
+                    brightestNeighbor = aPixel;
+
+                inputPtr   = inputPtr + imageWidth - 2; // 4
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+                if (brightestNeighbor < aPixel)
+                    brightestNeighbor = aPixel;
+
+                inputPtr++; // 5 - center pixel
+                aPixel    = *inputPtr;
+                thisPixel = aPixel;
+
+                inputPtr++; // 6
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+                if (brightestNeighbor < aPixel)
+                    brightestNeighbor = aPixel;
+
+                inputPtr   = inputPtr + imageWidth - 2; // 7
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+                if (brightestNeighbor < aPixel)
+                    brightestNeighbor = aPixel;
+
+                inputPtr++; // 8
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+                if (brightestNeighbor < aPixel)
+                    brightestNeighbor = aPixel;
+
+                inputPtr++; // 9
+                aPixel     = *inputPtr;
+                accumPixel = accumPixel + (UInt32)aPixel;
+                if (brightestNeighbor < aPixel)
+                    brightestNeighbor = aPixel;
+
+                // divide by the number of surrounding pixels
+                accumPixel = accumPixel / 8;
+
+                floatBrightPixel = (float)brightestNeighbor;
+                floatBrightPixel = floatBrightPixel * 1.2;
+
+                floatCenterPixel = (float)thisPixel;
+
+                if (floatCenterPixel > floatBrightPixel)
+                {
+                    numHotPixels++;
+                    // substitute average
+                    *outputPtr = (UInt16)accumPixel;
+                }
+            }
+        }
+
+        free(tempBuffer);
+    }
+
+    //	Starfish_LogFmt("fcImage_do_hotPixel_kernel numHotPixels = %d\n", numHotPixels);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+struct FrameSize
+{
+    int width;
+    int height;
+};
+
+// From frames too small to filter, through odd shapes, to a full IBIS1300 and PRO frame
+static const FrameSize frameSizes[] =
+{
+    { 1, 1 }, { 2, 2 }, { 3, 3 }, { 4, 5 }, { 5, 5 }, { 7, 131 }, { 131, 7 },
+    { 67, 130 }, { 333, 129 }, { 513, 517 }, { 1280, 1024 }, { 2048, 2 }, { 4096, 64 + 5 }
+};
+
+static const long bandCounts[] = { 1, 2, 3, 8, 16 };
+
+// A noisy background with hot pixels and saturated/black spots sprinkled over it
+static std::vector<UInt16> makeFrame(int width, int height, unsigned int seed)
+{
+    std::vector<UInt16> frame(width * height);
+
+    srand(seed);
+    for (size_t i = 0; i < frame.size(); i++)
+    {
+        int r = rand();
+        switch (r % 50)
+        {
+            case 0:
+                frame[i] = 65535;
+                break;
+            case 1:
+                frame[i] = 0;
+                break;
+            case 2:
+            case 3:
+                frame[i] = 3000 + (r >> 8) % 60000;
+                break;
+            default:
+                frame[i] = 1000 + (r >> 8) % 200;
+                break;
+        }
+    }
+
+    return frame;
+}
+
+typedef void (*RowMajorFilter)(UInt16 *frameBufferPtr, int imageWidth, int imageHeight);
+typedef void (*KernelFilter)(UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer);
+typedef void (*CamRowMajorFilter)(int camNum, UInt16 *frameBufferPtr, int imageWidth, int imageHeight);
+typedef void (*CamKernelFilter)(int camNum, UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer);
+
+static void compareKernel(KernelFilter oldFilter, CamKernelFilter newFilter)
+{
+    for (const FrameSize &size : frameSizes)
+    {
+        std::vector<UInt16> expected = makeFrame(size.width, size.height, size.width * 7919 + size.height);
+        oldFilter(size.height, size.width, expected.data());
+
+        for (long bands : bandCounts)
+        {
+            fakeCpus = bands;
+            std::vector<UInt16> frame = makeFrame(size.width, size.height, size.width * 7919 + size.height);
+            newFilter(1, size.height, size.width, frame.data());
+            ASSERT_TRUE(frame == expected) << size.width << "x" << size.height << " in " << bands << " bands";
+        }
+    }
+    fakeCpus = 0;
+}
+
+static void compareRowMajor(RowMajorFilter oldFilter, CamRowMajorFilter newFilter, int maxWidth)
+{
+    for (const FrameSize &size : frameSizes)
+    {
+        if (size.width > maxWidth)
+            continue;
+
+        std::vector<UInt16> expected = makeFrame(size.width, size.height, size.width * 104729 + size.height);
+        oldFilter(expected.data(), size.width, size.height);
+
+        for (long bands : bandCounts)
+        {
+            fakeCpus = bands;
+            std::vector<UInt16> frame = makeFrame(size.width, size.height, size.width * 104729 + size.height);
+            newFilter(1, frame.data(), size.width, size.height);
+            ASSERT_TRUE(frame == expected) << size.width << "x" << size.height << " in " << bands << " bands";
+        }
+    }
+    fakeCpus = 0;
+}
+
+// Black row offsets large enough to push pixels past both ends of the 16 bit range
+static void setBlackOffsets(unsigned int seed)
+{
+    srand(seed);
+    for (int col = 0; col < 1280; col++)
+        gBlackOffsets[col] = (col % 97 == 0) ? 70000 : 800 + rand() % 1500;
+    for (int col = 0; col < 4096; col++)
+        gProBlackColOffsets[col] = (col % 89 == 0) ? -70000 : (col % 83 == 0) ? 70000 : rand() % 4001 - 2000;
+}
+
+TEST(FishcampImage, SubtractPedestal)
+{
+    for (unsigned int seed : { 1u, 2u, 3u })
+    {
+        setBlackOffsets(seed);
+        compareRowMajor(old_fcImage_IBIS_subtractPedestal, fcImage_IBIS_subtractPedestal, 1280);
+    }
+}
+
+TEST(FishcampImage, IBISColLevelNormalization)
+{
+    for (unsigned int seed : { 1u, 2u, 3u })
+    {
+        setBlackOffsets(seed);
+        compareRowMajor(old_fcImage_IBIS_doFullFrameColLevelNormalization,
+                        fcImage_IBIS_doFullFrameColLevelNormalization, 1280);
+    }
+}
+
+TEST(FishcampImage, PROColLevelNormalization)
+{
+    for (unsigned int seed : { 1u, 2u, 3u })
+    {
+        setBlackOffsets(seed);
+        compareRowMajor(old_fcImage_PRO_doFullFrameColLevelNormalization,
+                        fcImage_PRO_doFullFrameColLevelNormalization, 4096);
+    }
+}
+
+TEST(FishcampImage, Kernel3x3)
+{
+    compareKernel(old_fcImage_do_3x3_kernel, fcImage_do_3x3_kernel);
+}
+
+TEST(FishcampImage, Kernel5x5)
+{
+    compareKernel(old_fcImage_do_5x5_kernel, fcImage_do_5x5_kernel);
+}
+
+TEST(FishcampImage, HotPixelKernel)
+{
+    compareKernel(old_fcImage_do_hotPixel_kernel, fcImage_do_hotPixel_kernel);
+}
+
+// Every camera has its own scratch space, so two cameras can filter their frames at the same time
+TEST(FishcampImage, CamerasFilterConcurrently)
+{
+    const int rounds = 20;
+    const FrameSize sizes[2] = { { 640, 512 }, { 1280, 1024 } };
+    std::vector<UInt16> sources[2], expected[2];
+    int failed[2] = { 0, 0 };
+
+    // makeFrame uses rand(), so the frames are all made before the cameras start
+    for (int cam = 0; cam < 2; cam++)
+    {
+        sources[cam]  = makeFrame(sizes[cam].width, sizes[cam].height, 11 + cam);
+        expected[cam] = sources[cam];
+        old_fcImage_do_5x5_kernel(sizes[cam].height, sizes[cam].width, expected[cam].data());
+    }
+
+    auto camera = [&](int cam)
+    {
+        for (int r = 0; r < rounds; r++)
+        {
+            std::vector<UInt16> frame = sources[cam];
+            fcImage_do_5x5_kernel(cam + 1, sizes[cam].height, sizes[cam].width, frame.data());
+            if (frame != expected[cam])
+                failed[cam]++;
+        }
+    };
+    std::thread first(camera, 0), second(camera, 1);
+    first.join();
+    second.join();
+
+    EXPECT_EQ(failed[0], 0);
+    EXPECT_EQ(failed[1], 0);
+    ASSERT_NE(gCamerasFound[1].imageScratch, nullptr);
+    EXPECT_NE(gCamerasFound[0].imageScratch, gCamerasFound[1].imageScratch);
+
+    // Closing one camera frees only its own scratch
+    fcUsb_CloseCamera(2);
+    EXPECT_EQ(gCamerasFound[1].imageScratch, nullptr);
+    EXPECT_NE(gCamerasFound[0].imageScratch, nullptr);
+}
+
+// Time of the old and the banded routine on a full 1280x1024 frame
+TEST(FishcampImage, Throughput)
+{
+    const int width = 1280, height = 1024, rounds = 10;
+    const struct
+    {
+        const char *name;
+        KernelFilter oldFilter;
+        CamKernelFilter newFilter;
+    } kernels[] =
+    {
+        { "3x3", old_fcImage_do_3x3_kernel, fcImage_do_3x3_kernel },
+        { "5x5", old_fcImage_do_5x5_kernel, fcImage_do_5x5_kernel },
+        { "hot pixel", old_fcImage_do_hotPixel_kernel, fcImage_do_hotPixel_kernel },
+    };
+    std::vector<UInt16> source = makeFrame(width, height, 42);
+    std::vector<UInt16> frame;
+
+    for (const auto &kernel : kernels)
+    {
+        double oldTime = 1e9, newTime = 1e9;
+        for (int r = 0; r < rounds; r++)
+        {
+            frame = source;
+            auto start = std::chrono::steady_clock::now();
+            kernel.oldFilter(height, width, frame.data());
+            oldTime = std::min(oldTime, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+            frame = source;
+            start = std::chrono::steady_clock::now();
+            kernel.newFilter(1, height, width, frame.data());
+            newTime = std::min(newTime, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        printf("%s kernel %dx%d: old %.2f ms, banded %.2f ms (%ld cpus)\n", kernel.name, width, height,
+               oldTime * 1e3, newTime * 1e3, sysconf(_SC_NPROCESSORS_ONLN));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
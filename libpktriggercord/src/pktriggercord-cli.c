@@ -122,7 +122,8 @@ static struct option const longopts[] = {
 
 int save_buffer(pslr_handle_t camhandle, int bufno, int fd, pslr_status *status, user_file_format filefmt, int jpeg_stars) {
     pslr_buffer_type imagetype;
-    uint8_t buf[65536];
+    uint8_t *buf;
+    uint32_t blksz;
     uint32_t length;
     uint32_t current;
 
@@ -144,9 +145,16 @@ int save_buffer(pslr_handle_t camhandle, int bufno, int fd, pslr_status *status,
     DPRINT("Buffer length: %d\n", length);
     current = 0;
 
+    blksz = pslr_get_download_block_size(camhandle);
+    buf = malloc(blksz);
+    if (!buf) {
+        pslr_buffer_close(camhandle);
+        return 1;
+    }
+
     while (true) {
         uint32_t bytes;
-        bytes = pslr_buffer_read(camhandle, buf, sizeof (buf));
+        bytes = pslr_buffer_read(camhandle, buf, blksz);
         if (bytes == 0) {
             break;
         }
@@ -160,6 +168,7 @@ int save_buffer(pslr_handle_t camhandle, int bufno, int fd, pslr_status *status,
         }
         current += bytes;
     }
+    free(buf);
     pslr_buffer_close(camhandle);
     return 0;
 }
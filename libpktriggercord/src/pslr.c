@@ -60,8 +60,9 @@
 
 #include "indimacros.h" // INDI modification, reapply for next update
 
-#define POLL_INTERVAL 50000 /* Number of us to wait when polling */
-#define BLKSZ 65536 /* Block size for downloads; if too big, we get
+#define POLL_INTERVAL 50000 /* Maximum number of us to wait when polling */
+#define POLL_INTERVAL_MIN 1000 /* First wait when the camera usually answers at once */
+#define BLKSZ 65536 /* Default block size for downloads; if too big, we get
                      * memory allocation error from sg driver */
 #define BLOCK_RETRY 3 /* Number of retries, since we can occasionally
                        * get SCSI errors when downloading data */
@@ -93,6 +94,9 @@ void hexdump(uint8_t *buf, uint32_t bufLen);
 
 static pslr_progress_callback_t progress_callback = NULL;
 
+/* First poll wait, learned from how long the camera took to get ready */
+static uint32_t poll_start_interval = POLL_INTERVAL_MIN;
+
 user_file_format_t pslr_user_file_formats[3] = {
     { USER_FILE_FORMAT_PEF, "PEF", "pef"},
     { USER_FILE_FORMAT_DNG, "DNG", "dng"},
@@ -667,8 +671,9 @@ int pslr_get_buffer(pslr_handle_t h, int bufno, pslr_buffer_type type, int resol
     }
 
     uint32_t bufpos = 0;
+    uint32_t blksz = pslr_get_download_block_size(h);
     while (true) {
-        uint32_t nextread = size - bufpos > 65536 ? 65536 : size - bufpos;
+        uint32_t nextread = size - bufpos > blksz ? blksz : size - bufpos;
         if (nextread == 0) {
             break;
         }
@@ -1068,13 +1073,14 @@ int pslr_buffer_open(pslr_handle_t h, int bufno, pslr_buffer_type buftype, int b
     } while (i < 9 && info.b != 2);
     p->segment_count = j;
     p->offset = 0;
+    p->segment_index = 0;
+    p->segment_offset = 0;
     return PSLR_OK;
 }
 
 uint32_t pslr_buffer_read(pslr_handle_t h, uint8_t *buf, uint32_t size) {
     ipslr_handle_t *p = (ipslr_handle_t *) h;
     uint32_t i;
-    uint32_t pos = 0;
     uint32_t seg_offs;
     uint32_t addr;
     uint32_t blksz;
@@ -1082,15 +1088,18 @@ uint32_t pslr_buffer_read(pslr_handle_t h, uint8_t *buf, uint32_t size) {
 
     DPRINT("[C]\tpslr_buffer_read(%d)\n", size);
 
-    /* Find current segment */
-    for (i = 0; i < p->segment_count; i++) {
-        if (p->offset < pos + p->segments[i].length) {
-            break;
-        }
-        pos += p->segments[i].length;
+    /* Current segment is tracked as we go, skip the ones already read */
+    while (p->segment_index < p->segment_count &&
+            p->segment_offset >= p->segments[p->segment_index].length) {
+        p->segment_index++;
+        p->segment_offset = 0;
+    }
+    if (p->segment_index >= p->segment_count) {
+        return 0;
     }
 
-    seg_offs = p->offset - pos;
+    i = p->segment_index;
+    seg_offs = p->segment_offset;
     addr = p->segments[i].addr + seg_offs;
 
     /* Compute block size */
@@ -1098,8 +1107,8 @@ uint32_t pslr_buffer_read(pslr_handle_t h, uint8_t *buf, uint32_t size) {
     if (blksz > p->segments[i].length - seg_offs) {
         blksz = p->segments[i].length - seg_offs;
     }
-    if (blksz > BLKSZ) {
-        blksz = BLKSZ;
+    if (blksz > pslr_get_download_block_size(h)) {
+        blksz = pslr_get_download_block_size(h);
     }
 
 //    DPRINT("File offset %d segment: %d offset %d address 0x%x read size %d\n", p->offset,
@@ -1110,6 +1119,7 @@ uint32_t pslr_buffer_read(pslr_handle_t h, uint8_t *buf, uint32_t size) {
         return 0;
     }
     p->offset += blksz;
+    p->segment_offset += blksz;
     return blksz;
 }
 
@@ -1142,6 +1152,24 @@ void pslr_buffer_close(pslr_handle_t h) {
     memset(&p->segments[0], 0, sizeof (p->segments));
     p->offset = 0;
     p->segment_count = 0;
+    p->segment_index = 0;
+    p->segment_offset = 0;
+}
+
+int pslr_set_download_block_size(pslr_handle_t h, uint32_t size) {
+    DPRINT("[C]\tpslr_set_download_block_size(%d)\n", size);
+    ipslr_handle_t *p = (ipslr_handle_t *) h;
+    if (size > PSLR_MAX_DOWNLOAD_BLOCK_SIZE) {
+        size = PSLR_MAX_DOWNLOAD_BLOCK_SIZE;
+    }
+    size -= size % BLKSZ;
+    p->download_block_size = size < BLKSZ ? BLKSZ : size;
+    return PSLR_OK;
+}
+
+uint32_t pslr_get_download_block_size(pslr_handle_t h) {
+    ipslr_handle_t *p = (ipslr_handle_t *) h;
+    return p->download_block_size ? p->download_block_size : BLKSZ;
 }
 
 int pslr_set_selected_af_point(pslr_handle_t h, uint32_t point) {
@@ -1443,8 +1471,9 @@ static int ipslr_download(ipslr_handle_t *p, uint32_t addr, uint32_t length, uin
 
     retry = 0;
     while (length > 0) {
-        if (length > BLKSZ) {
-            block = BLKSZ;
+        uint32_t blksz = pslr_get_download_block_size(p);
+        if (length > blksz) {
+            block = blksz;
         } else {
             block = length;
         }
@@ -1457,6 +1486,12 @@ static int ipslr_download(ipslr_handle_t *p, uint32_t addr, uint32_t length, uin
         n = scsi_read(p->fd, downloadCmd, sizeof (downloadCmd), buf, block);
         get_status(p->fd);
 
+        if (n < 0 && block > BLKSZ) {
+            /* The host could not take a large transfer, stay with the default */
+            DPRINT("\tDownload of %d bytes failed, falling back to %d byte blocks\n", block, BLKSZ);
+            p->download_block_size = BLKSZ;
+            continue;
+        }
         if (n < 0) {
             if (retry < BLOCK_RETRY) {
                 retry++;
@@ -1733,10 +1768,34 @@ static int read_status(FDTYPE fd, uint8_t *buf) {
     return PSLR_OK;
 }
 
+/* Wait before polling the camera again. The first wait is the learned
+ * interval, doubling up to POLL_INTERVAL while the camera stays busy. */
+static void poll_wait(uint32_t *interval, uint32_t *waited) {
+    if (*waited == 0) {
+        *interval = poll_start_interval;
+    }
+    usleep(*interval);
+    *waited += *interval;
+    *interval = *interval * 2 > POLL_INTERVAL ? POLL_INTERVAL : *interval * 2;
+}
+
+/* Move the first wait towards the time the camera needed this time */
+static void poll_learn(uint32_t waited) {
+    uint32_t interval = (3 * poll_start_interval + waited) / 4;
+    if (interval < POLL_INTERVAL_MIN) {
+        interval = POLL_INTERVAL_MIN;
+    } else if (interval > POLL_INTERVAL) {
+        interval = POLL_INTERVAL;
+    }
+    poll_start_interval = interval;
+}
+
 static int get_status(FDTYPE fd) {
     DPRINT("[C]\t\t\tget_status(0x%x)\n", fd);
 
     uint8_t statusbuf[8];
+    uint32_t interval = 0;
+    uint32_t waited = 0;
     memset(statusbuf,0,8);
 
     while (1) {
@@ -1745,8 +1804,9 @@ static int get_status(FDTYPE fd) {
         if (statusbuf[7] != 0x01) {
             break;
         }
-        usleep(POLL_INTERVAL);
+        poll_wait(&interval, &waited);
     }
+    poll_learn(waited);
     if (statusbuf[7] != 0) {
         DPRINT("\tERROR: 0x%x\n", statusbuf[7]);
     }
@@ -1756,6 +1816,8 @@ static int get_status(FDTYPE fd) {
 static int get_result(FDTYPE fd) {
     DPRINT("[C]\t\t\tget_result(0x%x)\n", fd);
     uint8_t statusbuf[8];
+    uint32_t interval = 0;
+    uint32_t waited = 0;
     while (1) {
         //DPRINT("read out status\n");
         CHECK(read_status(fd, statusbuf));
@@ -1765,8 +1827,9 @@ static int get_result(FDTYPE fd) {
         }
         //DPRINT("Waiting for result\n");
         //hexdump_debug(statusbuf, 8);
-        usleep(POLL_INTERVAL);
+        poll_wait(&interval, &waited);
     }
+    poll_learn(waited);
     if ((statusbuf[7] & 0xff) != 0) {
         DPRINT("\tERROR: 0x%x\n", statusbuf[7]);
         return -1;
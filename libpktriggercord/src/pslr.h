@@ -186,6 +186,13 @@ uint32_t pslr_fullmemory_read(pslr_handle_t h, uint8_t *buf, uint32_t offset, ui
 void pslr_buffer_close(pslr_handle_t h);
 uint32_t pslr_buffer_get_size(pslr_handle_t h);
 
+#define PSLR_MAX_DOWNLOAD_BLOCK_SIZE (1024 * 1024)
+/* Bytes transferred per SCSI read when downloading, rounded down to a
+ * multiple of 64 KB and limited to PSLR_MAX_DOWNLOAD_BLOCK_SIZE. Falls back
+ * to 64 KB by itself if the host refuses a large read. */
+int pslr_set_download_block_size(pslr_handle_t h, uint32_t size);
+uint32_t pslr_get_download_block_size(pslr_handle_t h);
+
 int pslr_set_exposure_mode(pslr_handle_t h, pslr_exposure_mode_t mode);
 int pslr_set_selected_af_point(pslr_handle_t h, uint32_t point);
 
@@ -188,6 +188,9 @@ struct ipslr_handle {
     ipslr_segment_t segments[MAX_SEGMENTS];
     uint32_t segment_count;
     uint32_t offset;
+    uint32_t segment_index;        // segment containing offset
+    uint32_t segment_offset;       // offset within that segment
+    uint32_t download_block_size;  // bytes per SCSI read, 0 means BLKSZ
     uint8_t status_buffer[MAX_STATUS_BUF_SIZE];
     uint8_t settings_buffer[SETTINGS_BUFFER_SIZE];
 };
@@ -0,0 +1,309 @@
+/*
+    pkTriggerCord
+    Remote control of Pentax DSLR cameras.
+
+    Buffer download test against a fake SCSI backend
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    and GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The fake backend replaces pslr_scsi.c. It answers the download command sequence like a
+// camera that needs some time to prepare each block, and can refuse large transfers.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "pslr.h"
+#include "pslr_model.h"
+#include "pslr_scsi.h"
+}
+
+typedef std::chrono::steady_clock Clock;
+
+struct FakeCamera
+{
+    uint32_t args[4];
+    uint32_t addr;
+    uint32_t length;
+    Clock::time_point readyAt;
+    std::chrono::microseconds prepareTime { 4000 };
+    uint32_t maxTransfer { 0xFFFFFFFF };
+    int transientFailures { 0 };
+    int downloads { 0 };
+    int refused { 0 };
+
+    static uint8_t pattern(uint32_t address)
+    {
+        return (address * 2654435761u) >> 24;
+    }
+};
+
+static FakeCamera fake;
+
+static uint32_t be32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] << 24 | (uint32_t)buf[1] << 16 | (uint32_t)buf[2] << 8 | buf[3];
+}
+
+extern "C" int scsi_write(FDTYPE, uint8_t *cmd, uint32_t, uint8_t *buf, uint32_t bufLen)
+{
+    if (cmd[0] == 0xf0 && cmd[1] == 0x4f)
+    {
+        // Arguments, one at a time at offset cmd[2] or all at once
+        for (uint32_t i = 0; i < bufLen / 4; i++)
+            fake.args[cmd[2] / 4 + i] = be32(&buf[4 * i]);
+    }
+    else if (cmd[0] == 0xf0 && cmd[1] == 0x24 && cmd[2] == 0x06 && cmd[3] == 0x00)
+    {
+        // Prepare a download of args[1] bytes from args[0]
+        fake.addr = fake.args[0];
+        fake.length = fake.args[1];
+        fake.readyAt = Clock::now() + fake.prepareTime;
+        fake.downloads++;
+    }
+    return PSLR_OK;
+}
+
+extern "C" int scsi_read(FDTYPE, uint8_t *cmd, uint32_t, uint8_t *buf, uint32_t bufLen)
+{
+    if (cmd[0] == 0xf0 && cmd[1] == 0x26)
+    {
+        // Status, busy while the block is being prepared
+        memset(buf, 0, 8);
+        buf[7] = Clock::now() < fake.readyAt ? 0x01 : 0x00;
+        return 8;
+    }
+    if (cmd[0] == 0xf0 && cmd[1] == 0x24 && cmd[2] == 0x06 && cmd[3] == 0x02)
+    {
+        if (bufLen > fake.maxTransfer)
+        {
+            fake.refused++;
+            return -1;
+        }
+        if (fake.transientFailures > 0)
+        {
+            fake.transientFailures--;
+            return -1;
+        }
+        EXPECT_EQ(bufLen, fake.length);
+        for (uint32_t i = 0; i < bufLen; i++)
+            buf[i] = FakeCamera::pattern(fake.addr + i);
+        return bufLen;
+    }
+    return -1;
+}
+
+extern "C" char **get_drives(int *drive_num)
+{
+    *drive_num = 0;
+    return NULL;
+}
+
+extern "C" pslr_result get_drive_info(char *, FDTYPE *, char *, int, char *, int)
+{
+    return PSLR_DEVICE_ERROR;
+}
+
+extern "C" void close_drive(FDTYPE *)
+{
+}
+
+// What pslr_buffer_read did before: find the segment from the file offset, then download in
+// 64 KB blocks, polling the status every 50 ms
+static uint32_t oldBufferRead(ipslr_handle_t *p, uint8_t *buf, uint32_t size)
+{
+    uint32_t i, pos = 0;
+    for (i = 0; i < p->segment_count; i++)
+    {
+        if (p->offset < pos + p->segments[i].length)
+            break;
+        pos += p->segments[i].length;
+    }
+    if (i == p->segment_count)
+        return 0;
+
+    uint32_t seg_offs = p->offset - pos;
+    uint32_t addr = p->segments[i].addr + seg_offs;
+    uint32_t blksz = std::min(std::min(size, p->segments[i].length - seg_offs), 65536u);
+
+    auto getStatus = [p]()
+    {
+        uint8_t cmd[8] = {0xf0, 0x26, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+        uint8_t statusbuf[8];
+        while (true)
+        {
+            scsi_read(p->fd, cmd, 8, statusbuf, 8);
+            if (statusbuf[7] != 0x01)
+                break;
+            usleep(50000);
+        }
+    };
+    uint8_t args[8];
+    uint8_t argsCmd[8] = {0xf0, 0x4f, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00};
+    uint8_t command[8] = {0xf0, 0x24, 0x06, 0x00, 0x08, 0x00, 0x00, 0x00};
+    uint8_t downloadCmd[8] = {0xf0, 0x24, 0x06, 0x02, 0x00, 0x00, 0x00, 0x00};
+    for (int arg = 0; arg < 2; arg++)
+    {
+        uint32_t value = arg ? blksz : addr;
+        uint8_t be[4] = { (uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value };
+        memcpy(args, be, 4);
+        argsCmd[2] = arg * 4;
+        scsi_write(p->fd, argsCmd, 8, args, 4);
+    }
+    scsi_write(p->fd, command, 8, 0, 0);
+    getStatus();
+    int n = scsi_read(p->fd, downloadCmd, 8, buf, blksz);
+    getStatus();
+    if (n < 0)
+        return 0;
+    p->offset += n;
+    return n;
+}
+
+class Download : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            fake = FakeCamera();
+            p = static_cast<ipslr_handle_t *>(calloc(1, sizeof(ipslr_handle_t)));
+            open();
+            for (const auto &segment : segments)
+                for (uint32_t i = 0; i < segment[1]; i++)
+                    expected.push_back(FakeCamera::pattern(segment[0] + i));
+        }
+
+        // What pslr_buffer_open leaves behind
+        void open()
+        {
+            pslr_buffer_close(p);
+            for (const auto &segment : segments)
+            {
+                p->segments[p->segment_count].addr = segment[0];
+                p->segments[p->segment_count].length = segment[1];
+                p->segment_count++;
+            }
+        }
+
+        void TearDown() override
+        {
+            free(p);
+        }
+
+        // Reads the whole buffer like pslr_get_buffer does, returns the elapsed seconds
+        template <typename Read>
+        double readAll(std::vector<uint8_t> &out, Read read)
+        {
+            out.assign(expected.size() + 1024 * 1024, 0);
+            size_t pos = 0;
+            auto start = Clock::now();
+            uint32_t n;
+            while (pos < expected.size() && (n = read(out.data() + pos, pslr_get_download_block_size(p))) > 0)
+                pos += n;
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            out.resize(pos);
+            return seconds;
+        }
+
+        double mbps(double seconds)
+        {
+            return expected.size() / seconds / 1e6;
+        }
+
+        // Segment lengths that are not multiples of the block size
+        const uint32_t segments[3][2] = { {0x10000000, 700001}, {0x20000000, 1048576 + 123}, {0x30000000, 300000} };
+        ipslr_handle_t *p { nullptr };
+        std::vector<uint8_t> expected;
+};
+
+TEST_F(Download, LargeBlocksMatchTheOldDownload)
+{
+    std::vector<uint8_t> old, small, large;
+
+    double oldSeconds = readAll(old, [this](uint8_t *buf, uint32_t size)
+    {
+        return oldBufferRead(p, buf, size);
+    });
+    int oldDownloads = fake.downloads;
+    ASSERT_EQ(old, expected);
+
+    open();
+    fake.downloads = 0;
+    double smallSeconds = readAll(small, [this](uint8_t *buf, uint32_t size)
+    {
+        return pslr_buffer_read(p, buf, size);
+    });
+    ASSERT_EQ(small, expected);
+    EXPECT_EQ(fake.downloads, oldDownloads);
+    // Past the last segment there is nothing left to read
+    uint8_t extra[16];
+    EXPECT_EQ(pslr_buffer_read(p, extra, sizeof(extra)), 0u);
+
+    open();
+    fake.downloads = 0;
+    pslr_set_download_block_size(p, PSLR_MAX_DOWNLOAD_BLOCK_SIZE);
+    double largeSeconds = readAll(large, [this](uint8_t *buf, uint32_t size)
+    {
+        return pslr_buffer_read(p, buf, size);
+    });
+    ASSERT_EQ(large, expected);
+    EXPECT_EQ(fake.downloads, 4);
+
+    printf("%.2f MB in %d blocks, %lld us to prepare each: old %.2f MB/s, adaptive polling %.2f MB/s, "
+           "1 MB blocks %.2f MB/s\n", expected.size() / 1e6, oldDownloads,
+           (long long)fake.prepareTime.count(), mbps(oldSeconds), mbps(smallSeconds), mbps(largeSeconds));
+}
+
+TEST_F(Download, RefusedLargeTransferFallsBackWithoutUsingRetries)
+{
+    std::vector<uint8_t> out;
+    fake.prepareTime = std::chrono::microseconds(0);
+    fake.maxTransfer = 65536;
+    // After the fallback, the block still gets every retry
+    fake.transientFailures = 3;
+
+    pslr_set_download_block_size(p, PSLR_MAX_DOWNLOAD_BLOCK_SIZE);
+    readAll(out, [this](uint8_t *buf, uint32_t size)
+    {
+        return pslr_buffer_read(p, buf, size);
+    });
+    EXPECT_EQ(out, expected);
+    EXPECT_EQ(fake.refused, 1);
+    EXPECT_EQ(pslr_get_download_block_size(p), 65536u);
+}
+
+TEST(DownloadBlockSize, RoundsToWholeBlocks)
+{
+    ipslr_handle_t handle;
+    memset(&handle, 0, sizeof(handle));
+    EXPECT_EQ(pslr_get_download_block_size(&handle), 65536u);
+    pslr_set_download_block_size(&handle, 200000);
+    EXPECT_EQ(pslr_get_download_block_size(&handle), 196608u);
+    pslr_set_download_block_size(&handle, 1000);
+    EXPECT_EQ(pslr_get_download_block_size(&handle), 65536u);
+    pslr_set_download_block_size(&handle, 8 * 1024 * 1024);
+    EXPECT_EQ(pslr_get_download_block_size(&handle), (uint32_t)PSLR_MAX_DOWNLOAD_BLOCK_SIZE);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1086,6 +1086,88 @@ int CCCDCamera::get_ImageArray(double* pVal)
 	return S_OK;
 }
 
+int CCCDCamera::TransferImage(unsigned short* pVal)
+{
+	// 
+	// TransferImage
+	// -------------
+	// 
+	// Syntax
+	//             CCDCamera.TransferImage(short *)
+	// Exceptions
+	//             Must throw exception if data unavailable.
+	// 
+	// Remarks
+	// 
+	// Same result as get_ImageArray(unsigned short*), but the rows of a pending
+	// download are read straight into pVal and drift adjusted in place instead of
+	// going through the internal readout buffer. The image then only exists in
+	// the caller's buffer, so a following get_ImageArray reports no image.
+	// 
+
+	if ( !m_bIsConnected )
+		return Error ( _T("Not Connected"), IID_ICamera, MAKE_HRESULT(1,FACILITY_ITF, QSI_NOTCONNECTED) );
+
+	// A previous get_ImageArray already pulled the image, copy it out as usual
+	if ( !m_DownloadPending )
+		return get_ImageArray(pVal);
+
+	FillImageBuffer(true, pVal);
+
+	if ( !m_bImageValid )
+		return Error ( _T("No Image Available"), IID_ICamera, MAKE_HRESULT(1,FACILITY_ITF, QSI_NOIMAGEAVAILABLE) );
+
+	m_bImageValid = false;
+	m_iError = m_QSIInterface.AdjustZero(pVal, pVal, m_ExposureSettings.ColumnsToRead, m_ExposureSettings.RowsToRead, m_iOverscanAdjustment, m_AutoZeroData.zeroEnable);
+	return S_OK;
+}
+
+int CCCDCamera::WaitForImageReady(void)
+{
+	// 
+	// WaitForImageReady
+	// -----------------
+	// 
+	// Syntax
+	//             CCDCamera.WaitForImageReady( void )
+	// Exceptions
+	//             Same as ImageReady.
+	// 
+	// Remarks
+	// 
+	// Blocks until ImageReady is true. The camera can only be polled, so sleep
+	// through the remaining exposure time and then poll with a growing interval,
+	// leaving the interface free for other requests during readout.
+	// 
+
+	bool bReady = false;
+	int iResult;
+	long lDelayUs = 1000;
+	timeval tvNow;
+
+	if (!m_bIsConnected)
+		return Error ( "Not Connected", IID_ICamera, MAKE_HRESULT(1,FACILITY_ITF, QSI_NOTCONNECTED) );
+
+	if (!m_bExposureTaken)
+		return Error ( _T("No Image Available"), IID_ICamera, MAKE_HRESULT(1,FACILITY_ITF, QSI_NOIMAGEAVAILABLE) );
+
+	if (m_DownloadPending)
+	{
+		gettimeofday(&tvNow, NULL);
+		double dElapsed = (tvNow.tv_sec - m_stStartExposure.tv_sec) + (tvNow.tv_usec - m_stStartExposure.tv_usec) / 1e6;
+		if (m_dLastDuration > dElapsed)
+			usleep((useconds_t)((m_dLastDuration - dElapsed) * 1e6));
+	}
+
+	while ((iResult = get_ImageReady(&bReady)) == S_OK && !bReady)
+	{
+		usleep(lDelayUs);
+		lDelayUs = std::min(lDelayUs * 2, 20000L);
+	}
+
+	return iResult;
+}
+
 int  CCCDCamera::get_ImageReady(bool* pVal)
 {
 	// 
@@ -2770,19 +2852,25 @@ void CCCDCamera::CloseCamera ( void )
 }
 
 int CCCDCamera::FillImageBuffer(bool bMakeRequest)
+{
+	return FillImageBuffer(bMakeRequest, m_pusBuffer);
+}
+
+int CCCDCamera::FillImageBuffer(bool bMakeRequest, USHORT * pBuffer)
 {
 	// This is the common code for reading an image from the camera
 	// and filling the image buffer
 	// The interface methods call this and then transfer the data
 	// from the USHORT buffer and convert it into the appropriate
-	// format
+	// format. TransferImage passes the caller's buffer so the rows
+	// land in their final place.
 
 	int iStride;
 	int iRowsRead;
 	int iPixelSize = sizeof(USHORT); // Always 16 bit pixels for now
 	int	iTotRowsRead;
 
-	if (!m_bIsConnected  || m_pusBuffer == NULL)
+	if (!m_bIsConnected  || pBuffer == NULL)
 		return Error ( "Not connected", IID_ICamera, MAKE_HRESULT(1,FACILITY_ITF, QSI_NOTCONNECTED) );
 
 	if (!m_DownloadPending)
@@ -2798,6 +2886,9 @@ int CCCDCamera::FillImageBuffer(bool bMakeRequest)
 		return Error ( "Image transfer error", IID_ICamera, MAKE_HRESULT(1,FACILITY_ITF, QSI_INVALIDIMAGEPARAMETER) );
 	}
 
+	// Resolve the hot pixel map to image offsets before the data starts flowing
+	m_QSIInterface.HotPixelIndex(0, m_ExposureSettings, m_DeviceDetails, m_HotPixelIndexes);
+
 	if (bMakeRequest)
 	{
 		// Send transfer image command to camera
@@ -2818,7 +2909,7 @@ int CCCDCamera::FillImageBuffer(bool bMakeRequest)
 	while (iTotRowsRead < m_ExposureSettings.RowsToRead)
 	{
 		// ReadImageByRow may return fewer rows than requested.  It is up to the caller to make additional calls to retreive the entire image.
-		m_iError = m_QSIInterface.ReadImageByRow( (BYTE *)m_pusBuffer + (iTotRowsRead * iStride), (m_ExposureSettings.RowsToRead - iTotRowsRead),
+		m_iError = m_QSIInterface.ReadImageByRow( (BYTE *)pBuffer + (iTotRowsRead * iStride), (m_ExposureSettings.RowsToRead - iTotRowsRead),
 													m_ExposureSettings.ColumnsToRead, iStride, iPixelSize, iRowsRead);
 		if (m_iError != ALL_OK)
 		{
@@ -2828,7 +2919,7 @@ int CCCDCamera::FillImageBuffer(bool bMakeRequest)
 		iTotRowsRead += iRowsRead;  // Update the number of pixels read, ReadImage may return less row that we requested.
 	}
 	//
-	// Image is now in m_pusBuffer
+	// Image is now in pBuffer
 	//
 	csQSI.Unlock();
 	
@@ -2837,7 +2928,7 @@ int CCCDCamera::FillImageBuffer(bool bMakeRequest)
 		return Error ( "Auto zero get data error", IID_ICamera, MAKE_HRESULT(1,FACILITY_ITF, m_iError) );
 
 	// Now apply the Hot Pixel map
-	m_QSIInterface.HotPixelRemap((BYTE *)m_pusBuffer, 0, m_ExposureSettings, m_DeviceDetails, m_AutoZeroData.zeroLevel);
+	m_QSIInterface.HotPixelRemap((BYTE *)pBuffer, m_HotPixelIndexes, m_AutoZeroData.zeroLevel);
 	m_bImageValid = true;
 	return S_OK;
 }
@@ -164,6 +164,8 @@ public:
 	int get_ImageArray(unsigned short* pVal);
 	int get_ImageArray(double* pVal);
 	int get_ImageReady(bool* pVal);
+	int TransferImage(unsigned short* pVal);
+	int WaitForImageReady(void);
 	int get_IsPulseGuiding(bool* pVal);
 	int get_LastError(std::string & pVal);
 	int get_LastExposureDuration(double* pVal);
@@ -296,6 +298,7 @@ private:
 	int 	GetFilterConnected(bool * pVal);
 	void 	CloseCamera ( void );
 	int 	FillImageBuffer( bool bMakeRequest );
+	int 	FillImageBuffer( bool bMakeRequest, USHORT * pBuffer );
 	int		GetAutoZeroData(bool bMakeRequest );
 
 	//////////////////////////////////////////////////////////////////////////////////////
@@ -310,6 +313,7 @@ private:
 	QSI_AdvEnabledOptions	m_AdvEnabledOptions;
 
 	unsigned short * 			m_pusBuffer;			// Buffer for readout
+	std::vector<int> 			m_HotPixelIndexes;		// Hot pixel byte offsets for the current frame
 	int 						m_iError;				// Stores any errors and used to detect previous errors
 
 	std::string 				m_USBSerialNumber;
@@ -13,6 +13,7 @@ DRC 03.23.11 Original Version
 ******************************************************************************************/
 #include "HotPixelMap.h"
 #include "QSI_Registry.h"
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -99,31 +100,66 @@ bool HotPixelMap::Save(void)
 	return true;
 }
 
-void HotPixelMap::Remap(	BYTE * Image, int RowPad, QSI_ExposureSettings Exposure,
-							QSI_DeviceDetails Details, USHORT ZeroPixel, QSILog * log)
+// Resolve the map against the exposure frame once, before the image arrives.
+// Indexes are byte offsets into the image, sorted and unique so the patch pass
+// walks the frame front to back.
+void HotPixelMap::BuildIndex(	int RowPad, QSI_ExposureSettings Exposure, QSI_DeviceDetails Details,
+								QSILog * log, std::vector<int> & Indexes)
 {
+	static const int PIXELSPERLOGLINE = 16;
 	int pIndex;
+	int iLogged = 0;
+	bool bLog;
+	std::string line;
 	std::vector<Pixel>::iterator vi;
 
+	Indexes.clear();
 	if (!m_bEnable)
 		return;
 	log->Write(2, _T("Hot Pixel Remap enabled."));
 
+	// Per pixel detail is batched into lines of x,y@index, with '-' for pixels outside the frame
+	bLog = log->LoggingEnabled(2);
 	for (vi = HotMap.begin(); vi != HotMap.end(); vi++)
 	{
-		log->Write(2, _T("Remap pixel: x=%d, y=%d"), (*vi).x, (*vi).y);
+		bool bHit = FindTargetPixelIndex(*vi, RowPad, Exposure, Details, &pIndex);
+		if (bHit)
+			Indexes.push_back(pIndex);
 
-		if (FindTargetPixelIndex(*vi, RowPad, Exposure, Details, log, &pIndex))
+		if (bLog)
 		{
-			log->Write(2, _T("Remap pixel: x=%d, y=%d, old value: %d, new value: %d."),
-							(*vi).x, (*vi).y, *(USHORT*)(&Image[pIndex]), ZeroPixel); 
-			*(USHORT*)(&Image[pIndex]) = ZeroPixel;
+			char entry[40];
+			if (bHit)
+				snprintf(entry, sizeof(entry), " %d,%d@%d", (*vi).x, (*vi).y, pIndex);
+			else
+				snprintf(entry, sizeof(entry), " %d,%d@-", (*vi).x, (*vi).y);
+			line += entry;
+			if (++iLogged == PIXELSPERLOGLINE)
+			{
+				log->Write(2, _T("Remap pixels:%s"), line.c_str());
+				line.clear();
+				iLogged = 0;
+			}
 		}
 	}
+	if (iLogged > 0)
+		log->Write(2, _T("Remap pixels:%s"), line.c_str());
+
+	std::sort(Indexes.begin(), Indexes.end());
+	Indexes.erase(std::unique(Indexes.begin(), Indexes.end()), Indexes.end());
+	log->Write(2, _T("Hot Pixel Remap: %d pixels in image area."), (int)Indexes.size());
+}
+
+void HotPixelMap::Remap(BYTE * Image, const std::vector<int> & Indexes, USHORT ZeroPixel)
+{
+	std::vector<int>::const_iterator vi;
+
+	for (vi = Indexes.begin(); vi != Indexes.end(); vi++)
+		*(USHORT*)(&Image[*vi]) = ZeroPixel;
 }
 
 bool HotPixelMap::FindTargetPixelIndex(	Pixel pxIn, int RowPad, QSI_ExposureSettings Exposure,
-										QSI_DeviceDetails Details, QSILog * log, int * pIndex)
+										QSI_DeviceDetails Details, int * pIndex)
 {
 	int iStartX;
 	int iStartY;
@@ -136,10 +172,7 @@ bool HotPixelMap::FindTargetPixelIndex(	Pixel pxIn, int RowPad, QSI_ExposureSett
 
 	// Is the requested remap pixel in the array range of the camera?
 	if (pxIn.x >= Details.ArrayColumns || pxIn.y >= Details.ArrayRows)
-	{
-		log->Write(2, _T("Remap pixel: x=%d, y=%d not in CCD imager area."), pxIn.x, pxIn.y);
 		return false;
-	}
 
 	// Un-Bin the parameters of the image and check if this pixel is in the requested frame
 	iStartX = Exposure.ColumnOffset * Exposure.BinFactorX;
@@ -160,14 +193,9 @@ bool HotPixelMap::FindTargetPixelIndex(	Pixel pxIn, int RowPad, QSI_ExposureSett
 		iBinnedLocY = (pxIn.y / Exposure.BinFactorY) - Exposure.RowOffset;
 		// Calc image array index in bytes, caller will use that to replace pixel
 		*pIndex = (iBinnedLocX * BYTESPERPIXEL) + ((iRowLen + RowPad) * iBinnedLocY);
-		log->Write(2, _T("Remap pixel: x=%d, y=%d at image index: %d"), pxIn.x, pxIn.y, *pIndex);
 		return true;
 	}
-	else
-	{
-		log->Write(2, _T("Remap pixel: x=%d, y=%d not in image area."), pxIn.x, pxIn.y);
-		return false;
-	}
+	return false;
 }
 
 std::vector<Pixel> HotPixelMap::GetPixels(void)
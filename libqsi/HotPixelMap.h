@@ -29,14 +29,15 @@ public:
 	HotPixelMap(void);
 	HotPixelMap(std::string Serial);
 	~HotPixelMap(void);
-	void Remap(	BYTE * Image, int RowPad, QSI_ExposureSettings Exposure,
-				QSI_DeviceDetails Details, USHORT ZeroPixel, QSILog * log);
+	void BuildIndex(int RowPad, QSI_ExposureSettings Exposure, QSI_DeviceDetails Details,
+					QSILog * log, std::vector<int> & Indexes);
+	static void Remap(BYTE * Image, const std::vector<int> & Indexes, USHORT ZeroPixel);
 	bool Save(void);
 	std::vector<Pixel> GetPixels(void);
 	void SetPixels(std::vector<Pixel> map);
 	bool m_bEnable;
 private:
-	bool FindTargetPixelIndex(	Pixel pxIn, int RowPad, QSI_ExposureSettings Exposure, QSI_DeviceDetails Details, QSILog * log, int * pIndex);
+	bool FindTargetPixelIndex(	Pixel pxIn, int RowPad, QSI_ExposureSettings Exposure, QSI_DeviceDetails Details, int * pIndex);
 	std::vector<Pixel> HotMap;
 	std::string serial;
 };
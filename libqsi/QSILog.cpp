@@ -4,6 +4,8 @@ DESCRIPTION   : Provides registry controlled USB event logging
 COPYRIGHT (C) : QSI (Quantum Scientific Imaging) 2006-2007
 *****************************************************************************************/
 #include "QSILog.h"
+#include <map>
+#include <string>
 
 //****************************************************************************************
 // CLASS FUNCTION DEFINITIONS
@@ -30,10 +32,8 @@ QSILog::QSILog(const char * filename, const char * szValueName, const char * szP
 	}
 	strncpy(m_tszValueName, szValueName, MSGSIZE);
 	strncpy(m_tszPreFixName, szPreFixName, MSGSIZE);
-	m_pfLogFile = NULL;
 	m_bLogging = false;
 	m_logLevel = 0;
-	gettimeofday( &m_tvLastTick, NULL );
 	return;
 }
 
@@ -47,9 +47,9 @@ bool QSILog::Open()
 {
 	if (!IsLogFileOpen())
 	{
-		m_pfLogFile = fopen(m_tszFilename, "a+t");
+		m_Sink = QSILogSink::Acquire(m_tszFilename);
 	}
-	return m_pfLogFile!=NULL?true:false;
+	return IsLogFileOpen();
 }
 
 void QSILog::TestForLogging()
@@ -110,7 +110,7 @@ int QSILog::LogLevel ()
 
 bool QSILog::IsLogFileOpen()
 {
-	return (m_pfLogFile != NULL);
+	return (m_Sink != NULL);
 }
 
 void QSILog::Write(int iReqLevel)
@@ -142,61 +142,184 @@ void QSILog::WriteBuffer(int iReqLevel, void * lpvBuff, unsigned int bufsize, un
 
 void QSILog::Write(int iReqLevel, const char * msg, ...)
 {
-	char pMessage[1024];
 	std::va_list args;
-	char tcsBuf[MSGSIZE];
-	time_t stTime;
-	tm *tmGMT;
-	pid_t PID;
-	timeval tvCurrentTick;
-	long long llNetTick;
 
-	if (!LoggingEnabled(iReqLevel))
+	if (!LoggingEnabled(iReqLevel) || !m_Sink)
 			return;
 
 	va_start(args, msg);
-	vsnprintf(pMessage, 1024, msg, args);
+	m_Sink->Post(m_tszPreFixName, msg, args);
 	va_end(args);
+	return;
+}
 
-	time(&stTime);
-	tmGMT = gmtime(&stTime);
+void QSILog::Close()
+{
+	// The file stays open while other loggers share it, so push out what this one wrote
+	if (m_Sink)
+		m_Sink->Flush();
+	m_Sink.reset();
+	return;
+}
 
-	gettimeofday( &tvCurrentTick, NULL );
-	llNetTick = (tvCurrentTick.tv_sec * 1000000) + tvCurrentTick.tv_usec;
-	llNetTick = llNetTick - ((m_tvLastTick.tv_sec * 1000000) + m_tvLastTick.tv_usec);
+//****************************************************************************************
+// QSILogSink
+//****************************************************************************************
 
-	snprintf(tcsBuf, MSGSIZE, "%04d-%02d-%02d,%02d:%02d:%02d.%03d,delta_usec:%012lld,", 
-				tmGMT->tm_year + 1900, 
-				tmGMT->tm_mon + 1, 
-				tmGMT->tm_mday, 
-				tmGMT->tm_hour, 
-				tmGMT->tm_min, 
-				tmGMT->tm_sec, 
-				0,
-				llNetTick);
+std::shared_ptr<QSILogSink> QSILogSink::Acquire(const char * filename)
+{
+	static std::mutex registryLock;
+	static std::map<std::string, std::weak_ptr<QSILogSink> > registry;
 
-	m_tvLastTick.tv_sec  = tvCurrentTick.tv_sec;
-	m_tvLastTick.tv_usec = tvCurrentTick.tv_usec;
+	std::lock_guard<std::mutex> lock(registryLock);
+	std::shared_ptr<QSILogSink> sink = registry[filename].lock();
+	if (!sink)
+	{
+		FILE * pfLogFile = fopen(filename, "a+t");
+		if (pfLogFile == NULL)
+			return sink;
+		sink.reset(new QSILogSink(pfLogFile));
+		registry[filename] = sink;
+	}
+	return sink;
+}
 
-	fputs(tcsBuf, m_pfLogFile);
-	PID = getpid();
-	snprintf(tcsBuf, MSGSIZE, "Thread:%08u,", PID);
-	fputs(tcsBuf, m_pfLogFile);
-	fputs(m_tszPreFixName, m_pfLogFile);
-	fputs(":", m_pfLogFile);
-	fputs(pMessage, m_pfLogFile);
-	fputs("\n", m_pfLogFile);
-	fflush(m_pfLogFile);
+QSILogSink::QSILogSink(FILE * pfLogFile)
+{
+	m_pfLogFile = pfLogFile;
+	m_Ring.reset(new LogEntry[LOGRINGSIZE]);
+	for (unsigned long i = 0; i < LOGRINGSIZE; i++)
+		m_Ring[i].seq.store(i, std::memory_order_relaxed);
+	m_Head = 0;
+	m_Tail = 0;
+	m_bStop = false;
+	gettimeofday( &m_tvLastTick, NULL );
+	m_Writer = std::thread(&QSILogSink::WriterThread, this);
+	return;
+}
 
+QSILogSink::~QSILogSink()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_WakeLock);
+		m_bStop = true;
+	}
+	m_Wake.notify_one();
+	m_Writer.join();
+
+	Drain();
+	fclose(m_pfLogFile);
 	return;
 }
 
-void QSILog::Close()
+void QSILogSink::Post(const char * prefix, const char * msg, std::va_list args)
 {
-	if (m_pfLogFile != NULL)
+	LogEntry * entry;
+	unsigned long pos;
+	int iLen;
+
+	// Claim a slot. A full ring is drained by the caller itself, so no
+	// message is ever lost; the writer thread keeps this off the I/O path
+	// unless the callers outrun the disk.
+	pos = m_Head.load(std::memory_order_relaxed);
+	for (;;)
 	{
-		fclose(m_pfLogFile);
+		entry = &m_Ring[pos & (LOGRINGSIZE - 1)];
+		long dif = (long)(entry->seq.load(std::memory_order_acquire) - pos);
+		if (dif == 0)
+		{
+			if (m_Head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (dif < 0)
+		{
+			Drain();
+			// The oldest slot may still be claimed by a caller filling it in
+			if (entry->seq.load(std::memory_order_acquire) != pos)
+				std::this_thread::yield();
+			pos = m_Head.load(std::memory_order_relaxed);
+		}
+		else
+			pos = m_Head.load(std::memory_order_relaxed);
 	}
-	m_pfLogFile = NULL;
+
+	gettimeofday(&entry->tv, NULL);
+	iLen = snprintf(entry->text, LOGLINESIZE, "%s:", prefix);
+	if (iLen < 0 || iLen >= LOGLINESIZE)
+		iLen = 0;
+	vsnprintf(entry->text + iLen, LOGLINESIZE - iLen, msg, args);
+	entry->seq.store(pos + 1, std::memory_order_release);
+
+	// Wake the writer early when half the ring has filled up
+	if ((pos & (LOGRINGSIZE / 2 - 1)) == 0)
+		m_Wake.notify_one();
+
+	return;
+}
+
+void QSILogSink::Flush(void)
+{
+	Drain();
+	return;
+}
+
+void QSILogSink::WriterThread(void)
+{
+	std::unique_lock<std::mutex> lock(m_WakeLock);
+
+	while (!m_bStop)
+	{
+		m_Wake.wait_for(lock, std::chrono::milliseconds(LOGFLUSHMS));
+		lock.unlock();
+		Drain();
+		lock.lock();
+	}
+	return;
+}
+
+// Write out every published message in order, then flush once for the batch
+void QSILogSink::Drain(void)
+{
+	char tcsBuf[MSGSIZE];
+	tm tmGMT;
+	pid_t PID;
+	long long llNetTick;
+	int iWritten = 0;
+
+	std::lock_guard<std::mutex> lock(m_DrainLock);
+	PID = getpid();
+	for (;;)
+	{
+		LogEntry * entry = &m_Ring[m_Tail & (LOGRINGSIZE - 1)];
+		if (entry->seq.load(std::memory_order_acquire) != m_Tail + 1)
+			break;
+
+		gmtime_r(&entry->tv.tv_sec, &tmGMT);
+		llNetTick = ((long long)entry->tv.tv_sec * 1000000) + entry->tv.tv_usec;
+		llNetTick = llNetTick - (((long long)m_tvLastTick.tv_sec * 1000000) + m_tvLastTick.tv_usec);
+		m_tvLastTick = entry->tv;
+
+		snprintf(tcsBuf, MSGSIZE, "%04d-%02d-%02d,%02d:%02d:%02d.%03d,delta_usec:%012lld,Thread:%08u,", 
+					tmGMT.tm_year + 1900, 
+					tmGMT.tm_mon + 1, 
+					tmGMT.tm_mday, 
+					tmGMT.tm_hour, 
+					tmGMT.tm_min, 
+					tmGMT.tm_sec, 
+					0,
+					llNetTick,
+					PID);
+
+		fputs(tcsBuf, m_pfLogFile);
+		fputs(entry->text, m_pfLogFile);
+		fputs("\n", m_pfLogFile);
+
+		entry->seq.store(m_Tail + LOGRINGSIZE, std::memory_order_release);
+		m_Tail++;
+		iWritten++;
+	}
+
+	if (iWritten > 0)
+		fflush(m_pfLogFile);
 	return;
 }
@@ -24,7 +24,56 @@ REVISION HISTORY
 #include <grp.h>
 #include <pwd.h>
 #include <cstdarg>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 #define MSGSIZE 256
+#define LOGRINGSIZE 1024	// Messages buffered between the callers and the writer thread, power of 2
+#define LOGLINESIZE 1024
+#define LOGFLUSHMS 50		// Writer thread drains the ring at least this often
+
+//
+// One ring and writer thread per log file, shared by every QSILog writing to
+// that file, so lines from the INT, USB, PACKET... loggers stay in call order.
+//
+class QSILogSink
+{
+public:
+	~QSILogSink(void);
+
+	// Returns the sink for filename, opening the file on first use; NULL if it cannot be opened
+	static std::shared_ptr<QSILogSink> Acquire(const char * filename);
+
+	void Post(const char * prefix, const char * msg, std::va_list args);
+	void Flush(void);
+
+private:
+	// One formatted message waiting for the writer thread. seq tells producers
+	// and the writer whose turn the slot is (bounded MPSC ring).
+	struct LogEntry
+	{
+		std::atomic<unsigned long> seq;
+		timeval tv;
+		char text[LOGLINESIZE];
+	};
+
+	QSILogSink(FILE * pfLogFile);
+	void WriterThread(void);
+	void Drain(void);
+
+	FILE* m_pfLogFile;
+	std::unique_ptr<LogEntry[]> m_Ring;
+	std::atomic<unsigned long> m_Head;	// Next slot to claim by Post
+	unsigned long m_Tail;				// Next slot to drain, under m_DrainLock
+	std::mutex m_DrainLock;
+	timeval m_tvLastTick;
+	std::thread m_Writer;
+	std::mutex m_WakeLock;
+	std::condition_variable m_Wake;
+	bool m_bStop;
+};
 
 class QSILog
 {
@@ -46,13 +95,13 @@ public:
 	char m_Message[MSGSIZE];
 
 private:
+	std::shared_ptr<QSILogSink> m_Sink;
+
 	char m_tszFilename[MAX_PATH+1];
 	char m_tszValueName[MSGSIZE];
 	char m_tszPreFixName[MSGSIZE];
-	FILE* m_pfLogFile;
 	bool m_bLogging;
 	int m_logLevel;
-	timeval m_tvLastTick;
 
 	char szPath[MAX_PATH+1];
 	char* pTmp;
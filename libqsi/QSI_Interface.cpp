@@ -2534,21 +2534,24 @@ int QSI_Interface::AdjustZero(USHORT* pSrc, USHORT* pDst, int iPixelsPerRow, int
 		bAdjust = false;
 	}
 
-	m_log->Write(6, _T("First row of un-adjusted image data (up to the first 512 bytes):"));
+	if (m_log->LoggingEnabled(6))
+	{
+		m_log->Write(6, _T("First row of un-adjusted image data (up to the first 512 bytes):"));
 
-	int iSampleSize = iPixelsPerRow  > 512 ? 512 : iPixelsPerRow;
-	int iLines = (iSampleSize / 16);
-	if (iSampleSize % 16 > 0)
-		iLines++;
+		int iSampleSize = iPixelsPerRow  > 512 ? 512 : iPixelsPerRow;
+		int iLines = (iSampleSize / 16);
+		if (iSampleSize % 16 > 0)
+			iLines++;
 
-	for (int i = 0; i < iLines; i++)
-	{
-		for (int j = 0; j < 16 && iSampleSize > 0; j++)
+		for (int i = 0; i < iLines; i++)
 		{
-			snprintf(m_log->m_Message+(j*6), MSGSIZE, _T("%5u "), ((unsigned short*)pSrc)[(i*16)+j]);
-			iSampleSize--;
+			for (int j = 0; j < 16 && iSampleSize > 0; j++)
+			{
+				snprintf(m_log->m_Message+(j*6), MSGSIZE, _T("%5u "), ((unsigned short*)pSrc)[(i*16)+j]);
+				iSampleSize--;
+			}
+			m_log->Write(6);
 		}
-		m_log->Write(6);
 	}
 
 	//
@@ -2740,21 +2743,24 @@ int QSI_Interface::AdjustZero(USHORT* pSrc, long* pDst, int iPixelsPerRow, int i
 		bAdjust = false;
 	}
 
-	m_log->Write(6, _T("First row of un-adjusted image data (up to the first 512 bytes):"));
+	if (m_log->LoggingEnabled(6))
+	{
+		m_log->Write(6, _T("First row of un-adjusted image data (up to the first 512 bytes):"));
 
-	int iSampleSize = iPixelsPerRow  > 512 ? 512 : iPixelsPerRow;
-	int iLines = (iSampleSize / 16);
-	if (iSampleSize % 16 > 0)
-		iLines++;
+		int iSampleSize = iPixelsPerRow  > 512 ? 512 : iPixelsPerRow;
+		int iLines = (iSampleSize / 16);
+		if (iSampleSize % 16 > 0)
+			iLines++;
 
-	for (int i = 0; i < iLines; i++)
-	{
-		for (int j = 0; j < 16 && iSampleSize > 0; j++)
+		for (int i = 0; i < iLines; i++)
 		{
-			snprintf(m_log->m_Message+(j*6), MSGSIZE, _T("%5u "), ((unsigned short*)pSrc)[(i*16)+j]);
-			iSampleSize--;
+			for (int j = 0; j < 16 && iSampleSize > 0; j++)
+			{
+				snprintf(m_log->m_Message+(j*6), MSGSIZE, _T("%5u "), ((unsigned short*)pSrc)[(i*16)+j]);
+				iSampleSize--;
+			}
+			m_log->Write(6);
 		}
-		m_log->Write(6);
 	}
 
 	//
@@ -2913,11 +2919,16 @@ int QSI_Interface::QSIWriteTimeout(int timeout)
 	return m_iError;
 }
 
-void QSI_Interface::HotPixelRemap(	BYTE * Image, int RowPad, QSI_ExposureSettings Exposure,
-							QSI_DeviceDetails Details, USHORT ZeroPixel)
+void QSI_Interface::HotPixelIndex(	int RowPad, QSI_ExposureSettings Exposure, QSI_DeviceDetails Details,
+									std::vector<int> & Indexes)
+{
+	m_hpmMap.BuildIndex(RowPad, Exposure, Details, m_log, Indexes);
+}
+
+void QSI_Interface::HotPixelRemap(BYTE * Image, const std::vector<int> & Indexes, USHORT ZeroPixel)
 {
 	m_log->Write(2, _T("Hot Pixel Remap started."));
-	m_hpmMap.Remap(Image, RowPad, Exposure, Details, ZeroPixel, m_log);
+	HotPixelMap::Remap(Image, Indexes, ZeroPixel);
 	m_log->Write(2, _T("Hot Pixel Remap complete."));
 }
 
@@ -128,8 +128,9 @@ public:
 	int QSIReadTimeout(int timeout);
 	int QSIWriteTimeout(int timeout);
 	//
-	void HotPixelRemap(	BYTE * Image, int RowPad, QSI_ExposureSettings Exposure,
-							QSI_DeviceDetails Details, USHORT ZeroPixel);
+	void HotPixelIndex(	int RowPad, QSI_ExposureSettings Exposure, QSI_DeviceDetails Details,
+							std::vector<int> & Indexes);
+	void HotPixelRemap(	BYTE * Image, const std::vector<int> & Indexes, USHORT ZeroPixel);
 
 	int CMD_ExtTrigMode( BYTE action, BYTE polarity);
 
@@ -176,6 +176,16 @@ int QSICamera::get_ImageReady(bool* pVal)
 	return ((CCCDCamera *)pCam)->get_ImageReady(pVal);
 }
 
+int QSICamera::TransferImage(unsigned short* pVal)
+{
+	return ((CCCDCamera *)pCam)->TransferImage(pVal);
+}
+
+int QSICamera::WaitForImageReady(void)
+{
+	return ((CCCDCamera *)pCam)->WaitForImageReady();
+}
+
 int QSICamera::put_IsMainCamera(bool newVal)
 {
 	return ((CCCDCamera *)pCam)->put_IsMainCamera(newVal);
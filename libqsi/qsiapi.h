@@ -175,6 +175,8 @@ public:
 	int get_ImageArray(unsigned short* pVal);
 	int get_ImageArray(double * pVal);
 	int get_ImageReady(bool* pVal);
+	int TransferImage(unsigned short* pVal);
+	int WaitForImageReady(void);
 	int get_IsMainCamera(bool* pVal);
 	int put_IsMainCamera(bool newVal);
 	int get_IsPulseGuiding(bool* pVal);
@@ -0,0 +1,333 @@
+/*****************************************************************************************
+NAME          : test_qsicamera
+DESCRIPTION   : Image download through CCCDCamera against a fake camera link (IHostIO)
+*****************************************************************************************/
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <map>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// The download path is set up by hand instead of through a real connect
+#define private public
+#define protected public
+#include "CCDCamera.h"
+#undef private
+#undef protected
+
+// Fake camera link: answers the command packets and streams the recorded
+// image and overscan bytes after TransferImage/GetAutoZero.
+class FakeHost : public IHostIO
+{
+public:
+	std::vector<unsigned char> image, overscan;
+	int level = 0, count = 0;
+
+	int ListDevices(std::vector<CameraID> &) { return 0; }
+	int OpenEx(CameraID) { return 0; }
+	int SetTimeouts(int, int) { return 0; }
+	int Close() { return 0; }
+	int Write(unsigned char *, int n, int * w) { *w = n; return 0; }
+	int Read(unsigned char * b, int n, int * r)
+	{
+		int k = std::min<size_t>(n, m_Stream->size() - m_Pos);
+		memcpy(b, m_Stream->data() + m_Pos, k);
+		m_Pos += k;
+		*r = k;
+		return 0;
+	}
+	int GetReadWriteQueueStatus(int * rx, int * tx) { *rx = 0; *tx = 0; return 0; }
+	int ResetDevice() { return 0; }
+	int Purge() { return 0; }
+	int GetReadQueueStatus(int * rx) { *rx = 0; return 0; }
+	int SetStandardReadTimeout(int) { return 0; }
+	int SetStandardWriteTimeout(int) { return 0; }
+	int SetIOTimeout(IOTimeout) { return 0; }
+	int MaxBytesPerReadBlock() { return 0; }
+	int WritePacket(UCHAR * p, int n, int * w) { m_LastCmd = p[0]; *w = n; return 0; }
+	int ReadPacket(UCHAR * p, int, int * r)
+	{
+		memset(p, 0, 16);
+		p[0] = m_LastCmd;
+		if (m_LastCmd == 0x45)
+		{
+			// TransferImage, the image follows
+			p[1] = 1;
+			m_Stream = &image;
+			m_Pos = 0;
+			*r = 3;
+		}
+		else if (m_LastCmd == 0x4E)
+		{
+			// GetAutoZero, the overscan pixels follow
+			p[1] = 6;
+			p[2] = 1;
+			p[3] = level >> 8;
+			p[4] = level & 0xff;
+			p[5] = count >> 8;
+			p[6] = count & 0xff;
+			m_Stream = &overscan;
+			m_Pos = 0;
+			*r = 8;
+		}
+		else
+		{
+			p[1] = 4;
+			*r = 6;
+		}
+		return 0;
+	}
+	IOType GetTransferType() { return IOType_Stream; }
+
+private:
+	std::vector<unsigned char> * m_Stream = &image;
+	size_t m_Pos = 0;
+	unsigned char m_LastCmd = 0;
+};
+
+// A binned 3000x2000 frame off a 6000x4000 sensor, with hot pixels and overscan
+class FakeCamera
+{
+public:
+	static const int W = 3000, H = 2000, ColumnOffset = 3, RowOffset = 5;
+
+	FakeCamera()
+	{
+		std::mt19937 rng(7);
+
+		raw.resize(W * H);
+		for (USHORT & p : raw)
+			p = rng() % 65536;
+		host.image.resize(raw.size() * 2);
+		memcpy(host.image.data(), raw.data(), host.image.size());
+
+		// Overscan mean ~910 against a zero level of 1000, so the frame is adjusted by ~+90
+		host.count = 1000;
+		host.level = 1000;
+		std::vector<USHORT> overscan(host.count);
+		for (USHORT & p : overscan)
+			p = 900 + rng() % 20;
+		host.overscan.resize(overscan.size() * 2);
+		memcpy(host.overscan.data(), overscan.data(), host.overscan.size());
+
+		for (int i = 0; i < 500; i++)
+			hot.push_back(Pixel(rng() % (W * 2), rng() % (H * 2)));
+		// A duplicate entry and one off the sensor
+		hot.push_back(hot[0]);
+		hot.push_back(Pixel(W * 4, 1));
+	}
+
+	~FakeCamera()
+	{
+		cam.m_QSIInterface.m_HostCon.m_HostIO = NULL;
+	}
+
+	// Arms a pending download, as StartExposure does
+	void Arm()
+	{
+		cam.m_bIsConnected = true;
+		cam.m_DeviceDetails.ArrayColumns = W * 2;
+		cam.m_DeviceDetails.ArrayRows = H * 2;
+		delete [] cam.m_pusBuffer;
+		cam.m_pusBuffer = new USHORT[W * 2 * H * 2];
+		cam.m_ExposureSettings.ColumnsToRead = W;
+		cam.m_ExposureSettings.RowsToRead = H;
+		cam.m_ExposureSettings.ColumnOffset = ColumnOffset;
+		cam.m_ExposureSettings.RowOffset = RowOffset;
+		cam.m_ExposureSettings.BinFactorX = 2;
+		cam.m_ExposureSettings.BinFactorY = 2;
+		cam.m_ExposureNumX = W;
+		cam.m_ExposureNumY = H;
+		cam.m_QSIInterface.m_HostCon.m_HostIO = &host;
+		cam.m_QSIInterface.m_MaxBytesPerReadBlock = 1 << 20;
+		cam.m_QSIInterface.m_hpmMap.SetPixels(hot);
+		cam.m_QSIInterface.m_hpmMap.m_bEnable = true;
+		cam.m_QSIInterface.m_dwAutoZeroMaxADU = 60000;
+		cam.m_DownloadPending = true;
+		cam.m_bImageValid = false;
+		cam.m_bStructuredExceptions = false;
+	}
+
+	// Best time of a few TransferImage calls, in ms
+	double TimeTransfer(std::vector<USHORT> & frame, int reps)
+	{
+		double best = 1e9;
+		frame.assign(W * H, 0);
+		for (int rep = 0; rep < reps; rep++)
+		{
+			Arm();
+			auto start = std::chrono::steady_clock::now();
+			EXPECT_EQ(cam.TransferImage(frame.data()), S_OK);
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	}
+
+	// Best time of a few get_ImageArray calls, in ms
+	double TimeImageArray(std::vector<USHORT> & frame, int reps)
+	{
+		double best = 1e9;
+		frame.assign(W * H, 0);
+		for (int rep = 0; rep < reps; rep++)
+		{
+			Arm();
+			auto start = std::chrono::steady_clock::now();
+			EXPECT_EQ(cam.get_ImageArray(frame.data()), S_OK);
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	}
+
+	// What a download produced before the hot pixel index: each map entry patched in map
+	// order, then the drift adjust and clamp of AdjustZero
+	std::vector<USHORT> OldReference()
+	{
+		std::vector<USHORT> frame = raw;
+		std::vector<Pixel>::iterator vi;
+		int pIndex;
+
+		for (vi = hot.begin(); vi != hot.end(); vi++)
+			if (cam.m_QSIInterface.m_hpmMap.FindTargetPixelIndex(*vi, 0, cam.m_ExposureSettings, cam.m_DeviceDetails, &pIndex))
+				*(USHORT*)((BYTE *)frame.data() + pIndex) = cam.m_AutoZeroData.zeroLevel;
+
+		for (USHORT & p : frame)
+		{
+			int pixel = p + cam.m_iOverscanAdjustment;
+			if (pixel < 0)
+				pixel = 0;
+			if (pixel > (int)cam.m_QSIInterface.m_dwAutoZeroMaxADU)
+				pixel = (int)cam.m_QSIInterface.m_dwAutoZeroMaxADU;
+			p = (USHORT)pixel;
+		}
+		return frame;
+	}
+
+	FakeHost host;
+	CCCDCamera cam;
+	std::vector<USHORT> raw;
+	std::vector<Pixel> hot;
+};
+
+// Points the interface and packet loggers at a scratch file in the home directory
+class DownloadLog
+{
+public:
+	DownloadLog(CCCDCamera & cam) : m_Cam(cam)
+	{
+		m_Name = "QSICAMERATEST-" + std::to_string(getpid()) + ".TXT";
+		m_Path = std::string(getpwuid(getuid())->pw_dir) + "/" + m_Name;
+		Replace(cam.m_QSIInterface.m_log, "INT");
+		Replace(cam.m_QSIInterface.m_PacketWrapper.m_log, "PACKET");
+	}
+
+	~DownloadLog()
+	{
+		SetLevel(0);
+		unlink(m_Path.c_str());
+	}
+
+	void SetLevel(int level)
+	{
+		for (QSILog * log : { m_Cam.m_QSIInterface.m_log, m_Cam.m_QSIInterface.m_PacketWrapper.m_log })
+		{
+			log->m_logLevel = level;
+			log->m_bLogging = level ? log->Open() : false;
+			if (!level)
+				log->Close();
+		}
+	}
+
+	long Lines()
+	{
+		long lines = 0;
+		char tcsLine[LOGLINESIZE + MSGSIZE];
+		FILE * pFile = fopen(m_Path.c_str(), "r");
+		if (pFile == NULL)
+			return 0;
+		while (fgets(tcsLine, sizeof(tcsLine), pFile) != NULL)
+			lines++;
+		fclose(pFile);
+		return lines;
+	}
+
+private:
+	void Replace(QSILog * & log, const char * prefix)
+	{
+		delete log;
+		log = new QSILog(m_Name.c_str(), "QSICAMERATESTNOKEY", prefix);
+	}
+
+	CCCDCamera & m_Cam;
+	std::string m_Name;
+	std::string m_Path;
+};
+
+TEST(QSICamera, TransferImageThroughputWithLogging)
+{
+	FakeCamera fake;
+	DownloadLog log(fake.cam);
+	std::vector<USHORT> quiet, logged;
+
+	double msOff = fake.TimeTransfer(quiet, 5);
+	log.SetLevel(2);
+	double msOn = fake.TimeTransfer(logged, 5);
+	log.SetLevel(0);
+
+	// Logging never changes the frame, and the downloads were logged
+	long lines = log.Lines();
+	ASSERT_EQ(quiet, logged);
+	EXPECT_GT(lines, 0);
+
+	printf("TransferImage %dx%d: logging off %.2f ms, logging on (level 2) %.2f ms, %ld log lines\n",
+			FakeCamera::W, FakeCamera::H, msOff, msOn, lines);
+}
+
+static size_t Mismatches(const std::vector<USHORT> & a, const std::vector<USHORT> & b)
+{
+	return std::inner_product(a.begin(), a.end(), b.begin(), (size_t)0, std::plus<size_t>(), std::not_equal_to<USHORT>());
+}
+
+TEST(QSICamera, TransferImageMatchesTheOldRemapAndAdjust)
+{
+	FakeCamera fake;
+	std::vector<USHORT> copied, direct;
+
+	double msCopied = fake.TimeImageArray(copied, 5);
+	double msDirect = fake.TimeTransfer(direct, 5);
+
+	// The frame is actually drift adjusted and patched
+	ASSERT_TRUE(fake.cam.m_AutoZeroData.zeroEnable && fake.cam.m_QSIInterface.m_bAutoZeroEnable);
+	ASSERT_NE(fake.cam.m_iOverscanAdjustment, 0);
+	std::vector<USHORT> reference = fake.OldReference();
+	EXPECT_NE(Mismatches(reference, fake.raw), 0u);
+
+	size_t copiedMismatches = Mismatches(copied, reference);
+	size_t directMismatches = Mismatches(direct, reference);
+	EXPECT_EQ(copiedMismatches, 0u);
+	EXPECT_EQ(directMismatches, 0u);
+
+	// The image only lived in the caller's buffer
+	EXPECT_NE(fake.cam.get_ImageArray(copied.data()), S_OK);
+
+	printf("%dx%d with %zu hot pixel entries, adjust %+d: get_ImageArray %.2f ms (%zu mismatches), "
+			"TransferImage %.2f ms (%zu mismatches)\n", FakeCamera::W, FakeCamera::H, fake.hot.size(),
+			fake.cam.m_iOverscanAdjustment, msCopied, copiedMismatches, msDirect, directMismatches);
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
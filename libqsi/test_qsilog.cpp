@@ -0,0 +1,178 @@
+/*****************************************************************************************
+NAME          : test_qsilog
+DESCRIPTION   : Ordering and throughput of QSILog when several loggers share one file
+*****************************************************************************************/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "QSILog.h"
+
+static const char * Prefixes[] = { "INT", "USB", "TCP", "CYUSB", "PACKET" };
+static const int NumLoggers = 5;
+
+// Loggers sharing one file in the home directory, enabled through their ~/.<regkey> file
+class SharedLogFile
+{
+public:
+	SharedLogFile(const char * name)
+	{
+		char tszKey[64];
+		const char * home = getpwuid(getuid())->pw_dir;
+
+		m_Name = std::string(name) + "-" + std::to_string(getpid()) + ".TXT";
+		m_Path = std::string(home) + "/" + m_Name;
+		snprintf(tszKey, sizeof(tszKey), "QSILOGTEST%d", getpid());
+		m_KeyPath = std::string(home) + "/." + tszKey;
+
+		FILE * pFile = fopen(m_KeyPath.c_str(), "w");
+		EXPECT_NE(pFile, nullptr);
+		if (pFile)
+		{
+			fputs("1\n", pFile);
+			fclose(pFile);
+		}
+
+		for (int i = 0; i < NumLoggers; i++)
+		{
+			m_Logs.push_back(new QSILog(m_Name.c_str(), tszKey, Prefixes[i]));
+			m_Logs.back()->TestForLogging();
+			EXPECT_TRUE(m_Logs.back()->LoggingEnabled());
+		}
+	}
+
+	~SharedLogFile()
+	{
+		for (QSILog * log : m_Logs)
+			delete log;
+		unlink(m_KeyPath.c_str());
+		unlink(m_Path.c_str());
+	}
+
+	// Closes every logger and returns the lines of the file
+	std::vector<std::string> Lines()
+	{
+		std::vector<std::string> lines;
+		char tcsLine[LOGLINESIZE + MSGSIZE];
+
+		for (QSILog * log : m_Logs)
+			log->Close();
+
+		FILE * pFile = fopen(m_Path.c_str(), "r");
+		EXPECT_NE(pFile, nullptr);
+		if (pFile == NULL)
+			return lines;
+		while (fgets(tcsLine, sizeof(tcsLine), pFile) != NULL)
+			lines.push_back(tcsLine);
+		fclose(pFile);
+		return lines;
+	}
+
+	std::vector<QSILog *> m_Logs;
+
+private:
+	std::string m_Name;
+	std::string m_Path;
+	std::string m_KeyPath;
+};
+
+// Returns the sequence number logged on the line
+static long Sequence(const std::string & line, std::string & prefix)
+{
+	char tcsPrefix[16];
+	long lSeq = -1;
+
+	size_t pos = line.find("Thread:");
+	EXPECT_NE(pos, std::string::npos) << line;
+	pos = line.find(',', pos);
+	EXPECT_EQ(sscanf(line.c_str() + pos + 1, "%15[^:]:seq %ld", tcsPrefix, &lSeq), 2) << line;
+	prefix = tcsPrefix;
+	return lSeq;
+}
+
+TEST(QSILog, SharedFileKeepsCallOrder)
+{
+	const long messages = 20000;
+	SharedLogFile file("QSILOGORDER");
+
+	// One caller going through the loggers in turn, as a transfer does (INT, PACKET, USB...),
+	// fast enough to fill the ring many times over
+	for (long i = 0; i < messages; i++)
+		file.m_Logs[i % NumLoggers]->Write(1, "seq %ld", i);
+
+	long last = -1;
+	long written = 0;
+	for (const std::string & line : file.Lines())
+	{
+		std::string prefix;
+		long seq = Sequence(line, prefix);
+		ASSERT_EQ(seq, last + 1) << "line out of order or missing: " << line;
+		ASSERT_EQ(prefix, Prefixes[seq % NumLoggers]) << line;
+		last = seq;
+		written++;
+	}
+	// Nothing is dropped, a full ring holds the caller up instead
+	ASSERT_EQ(written, messages);
+}
+
+TEST(QSILog, SharedFileThroughput)
+{
+	const long messages = 200000;
+	SharedLogFile file("QSILOGBENCH");
+	std::atomic<long> next(0);
+	std::vector<std::thread> threads;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int t = 0; t < NumLoggers; t++)
+	{
+		threads.push_back(std::thread([&, t]()
+		{
+			long i;
+			while ((i = next++) < messages)
+				file.m_Logs[t]->Write(1, "seq %ld", i);
+		}));
+	}
+	for (std::thread & thread : threads)
+		thread.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	long written = 0;
+	std::vector<long> lastPerLogger(NumLoggers, -1);
+	std::vector<bool> seen(messages, false);
+	for (const std::string & line : file.Lines())
+	{
+		std::string prefix;
+		long seq = Sequence(line, prefix);
+		ASSERT_GE(seq, 0) << line;
+		ASSERT_LT(seq, messages) << line;
+		ASSERT_FALSE(seen[seq]) << "line written twice: " << line;
+		seen[seq] = true;
+		// Each caller's own messages are never reordered
+		for (int t = 0; t < NumLoggers; t++)
+		{
+			if (prefix == Prefixes[t])
+			{
+				ASSERT_GT(seq, lastPerLogger[t]) << line;
+				lastPerLogger[t] = seq;
+			}
+		}
+		written++;
+	}
+	// Every message reaches the file even with five callers outrunning the writer
+	ASSERT_EQ(written, messages);
+
+	printf("%d loggers, one file: %ld messages in %.1f ms, %.0f ns per Write\n",
+			NumLoggers, messages, seconds * 1e3, seconds * 1e9 / messages);
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}